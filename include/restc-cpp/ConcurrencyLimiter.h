@@ -0,0 +1,72 @@
+#pragma once
+#ifndef RESTC_CPP_CONCURRENCY_LIMITER_H_
+#define RESTC_CPP_CONCURRENCY_LIMITER_H_
+
+#include <memory>
+#include <string>
+
+#include "restc-cpp/restc-cpp.h"
+
+namespace restc_cpp {
+
+/*! Limits the requests in flight to each server, and learns the limit
+ *
+ * Assign an instance to Request::Properties::concurrencyLimiter to
+ * enable it for the requests using those properties. The instance can
+ * be shared by several clients.
+ *
+ * A request holds a permit from when it is sent until the response
+ * headers are received. When a server has as many requests in flight
+ * as its limit, new requests wait in a queue for a permit. When the
+ * queue is full, or a request has waited too long, the request fails
+ * with ConcurrencyLimitException.
+ *
+ * The limit is adjusted by AIMD (additive increase, multiplicative
+ * decrease). It grows by one for each round of responses that are
+ * faster than latencyTolerance times the baseline latency. It shrinks
+ * by backoffRatio when a request fails, gets a 429, 502, 503 or 504
+ * response, or is slower than that. The baseline is the lowest
+ * latency in the last latencyWindow responses.
+ *
+ * The servers are identified by "scheme://host:port".
+ *
+ * The implementation is thread-safe.
+ */
+class ConcurrencyLimiter {
+public:
+    using ptr_t = std::shared_ptr<ConcurrencyLimiter>;
+
+    struct Config {
+        std::size_t initialLimit = 20;
+        std::size_t minLimit = 1;
+        std::size_t maxLimit = 1000;
+        // The limit is multiplied with this when the server is overloaded
+        double backoffRatio = 0.9;
+        // Responses slower than the baseline times this are an overload
+        double latencyTolerance = 2.0;
+        // The baseline latency is learned again after this many responses
+        std::size_t latencyWindow = 100;
+        // Requests that may wait for a permit for each server. 0 rejects at once.
+        std::size_t maxQueued = 1000;
+        // Max time to wait for a permit. 0 waits forever.
+        int maxQueueTimeMs = (1000 * 12);
+    };
+
+    virtual ~ConcurrencyLimiter() = default;
+
+    /*! The current limit for the server */
+    virtual std::size_t GetLimit(const std::string& server) const = 0;
+
+    /*! Requests to the server that hold a permit */
+    virtual std::size_t GetInFlight(const std::string& server) const = 0;
+
+    /*! Requests to the server that wait for a permit */
+    virtual std::size_t GetQueued(const std::string& server) const = 0;
+
+    static ptr_t Create();
+    static ptr_t Create(const Config& config);
+};
+
+} // namespace
+
+#endif // RESTC_CPP_CONCURRENCY_LIMITER_H_
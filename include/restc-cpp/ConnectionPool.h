@@ -10,6 +10,10 @@
 
 namespace restc_cpp {
 
+class Http2SessionPool;
+class HttpPipelinePool;
+class LatencyTracker;
+
 class ConnectionPool
 {
 public:
@@ -21,7 +25,35 @@ public:
         const Connection::Type connectionType,
         bool new_connection_please = false) = 0;
 
+    /*! Get a connection, or report Error::TOO_MANY_CONNECTIONS in ec
+     *
+     * \returns nullptr if no connection is available.
+     */
+    virtual Connection::ptr_t GetConnection(
+        const boost::asio::ip::tcp::endpoint ep,
+        const Connection::Type connectionType,
+        boost::system::error_code& ec) = 0;
+
     virtual size_t GetIdleConnections() const = 0;
+
+    /*! The HTTP/2 sessions, shared by the requests to each origin
+     *
+     * This is an internal method.
+     */
+    virtual Http2SessionPool& GetHttp2Sessions() = 0;
+
+    /*! The HTTP/1.1 pipelines to each origin
+     *
+     * This is an internal method.
+     */
+    virtual HttpPipelinePool& GetHttpPipelines() = 0;
+
+    /*! The recent response times from each origin
+     *
+     * This is an internal method.
+     */
+    virtual LatencyTracker& GetLatencies() = 0;
+
     static std::shared_ptr<ConnectionPool> Create(RestClient& owner);
 
     /*! Close the connection-pool
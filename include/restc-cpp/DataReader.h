@@ -37,6 +37,13 @@ public:
     };
 
 
+    /*! Content-Encoding that a body reader can decode in place */
+    enum class Compression {
+        NONE,
+        GZIP,
+        DEFLATE
+    };
+
     using ptr_t = std::unique_ptr<DataReader>;
     using add_header_fn_t = std::function<void(std::string&& name, std::string&& value)>;
 
@@ -47,12 +54,59 @@ public:
     virtual boost_const_buffer ReadSome() = 0;
     virtual void Finish() = 0; // Make sure there are no pending data for the current request
 
+    /*! Give back data that was read past the end of the response
+     *
+     * On a pipelined connection, it is the start of the next response.
+     * The readers that can not use it ignore it.
+     */
+    virtual void Unread(boost_const_buffer /*data*/) {}
+
     static ptr_t CreateIoReader(const Connection::ptr_t& conn,
                                 Context& ctx, const ReadConfig& cfg);
     static ptr_t CreateGzipReader(std::unique_ptr<DataReader>&& source);
     static ptr_t CreateZipReader(std::unique_ptr<DataReader>&& source);
+
+    /*! Decompress 'br'. Requires RESTC_CPP_WITH_BROTLI */
+    static ptr_t CreateBrotliReader(ptr_t&& source);
+
+    /*! Decompress 'zstd'. Requires RESTC_CPP_WITH_ZSTD */
+    static ptr_t CreateZstdReader(ptr_t&& source);
+
+    /*! The Content-Encodings the library can decompress
+     *
+     * Formatted for an Accept-Encoding header, like "gzip, br".
+     * Empty if the library is compiled without any decompressors.
+     */
+    static const std::string& GetAcceptEncoding();
     static ptr_t CreatePlainReader(size_t contentLength, ptr_t&& source);
     static ptr_t CreateChunkedReader(add_header_fn_t, std::unique_ptr<DataReaderStream>&& source);
+
+    /*! Create a fused reader for a body of a known size.
+     *
+     * The body reader, and the decompression if any, are held in one
+     * object, and the calls between them are resolved at compile time.
+     */
+    static ptr_t CreatePlainReader(size_t contentLength,
+                                   std::unique_ptr<DataReaderStream>&& source,
+                                   Compression compression);
+
+    /*! Create a fused reader for a chunked body.
+     *
+     * \see CreatePlainReader
+     */
+    static ptr_t CreateChunkedReader(add_header_fn_t,
+                                     std::unique_ptr<DataReaderStream>&& source,
+                                     Compression compression);
+
+    /*! Create a reader that gathers a compressed body of a known size, and
+     * decompresses it in one pass.
+     *
+     * The first read returns the entire decompressed body.
+     * Requires zlib.
+     */
+    static ptr_t CreateOneShotZipReader(size_t contentLength,
+                                        std::unique_ptr<DataReaderStream>&& source,
+                                        Compression compression);
     static ptr_t CreateNoBodyReader();
 };
 
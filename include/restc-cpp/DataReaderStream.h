@@ -11,6 +11,7 @@
 
 #include "restc-cpp.h"
 #include "DataReader.h"
+#include "internals/RecycledObject.h"
 
 namespace restc_cpp {
 
@@ -18,8 +19,12 @@ namespace restc_cpp {
  *
  * This class allows us to treat the data-source as both a stream
  * and buffer for maximum flexibility and performance.
+ *
+ * The class is final, so that the body readers that own it can
+ * call it without going through the vtable.
  */
-class DataReaderStream : public DataReader {
+class DataReaderStream final : public DataReader,
+                               public RecycledObject<DataReaderStream> {
 public:
 
     DataReaderStream(std::unique_ptr<DataReader>&& source);
@@ -28,10 +33,8 @@ public:
         return eof_;
     }
 
-    void Finish() override {
-        if (source_)
-            source_->Finish();
-    }
+    /*! Finish the source, and give back the data after the response */
+    void Finish() override;
 
     /*! Read whatever we have buffered or can get downstream */
     boost_const_buffer ReadSome() override;
@@ -55,6 +55,21 @@ public:
     /*! Called when all data is written to flush the buffers */
     virtual void Finish() = 0;
 
+    /*! Send any data buffered by this writer, or writers after it
+     *
+     * Use this to push partial data to the server while
+     * streaming, without ending the body. A buffered writer sends
+     * what it has collected, and a compressing writer does a zlib
+     * sync flush, so that the server can decompress all the data
+     * written so far. Each writer passes the call on to the next
+     * writer in the chain.
+     *
+     * Writers that don't buffer anything just pass the call on. The
+     * default implementation does nothing, for writers at the end of
+     * a chain.
+     */
+    virtual void Flush() {}
+
     /*! Set the headers required by the writer.
      *
      * For example, the plain data writer will set the content-length,
@@ -65,10 +80,27 @@ public:
 
     static ptr_t CreateIoWriter(const Connection::ptr_t& conn, Context& ctx,
                                 const WriteConfig& cfg);
-    static ptr_t CreateGzipWriter(std::unique_ptr<DataWriter>&& source);
-    static ptr_t CreateZipWriter(std::unique_ptr<DataWriter>&& source);
+
+    /*! Compresses the data with zlib, and sets the Content-Encoding header
+     *
+     * \param source The next writer. It must be able to send
+     *      a body of unknown length, for example the chunked writer.
+     * \param level zlib compression level 1 - 9, or -1 for the default.
+     */
+    static ptr_t CreateGzipWriter(std::unique_ptr<DataWriter>&& source,
+                                  int level = -1);
+    static ptr_t CreateZipWriter(std::unique_ptr<DataWriter>&& source,
+                                 int level = -1);
     static ptr_t CreatePlainWriter(size_t contentLength, ptr_t&& source);
     static ptr_t CreateChunkedWriter(add_header_fn_t, ptr_t&& source);
+
+    /*! Coalesces small writes
+     *
+     * Data is buffered until highWaterMark bytes are collected, or
+     * Flush() or Finish() is called. Writes larger than the buffer
+     * are passed through.
+     */
+    static ptr_t CreateBufferedWriter(size_t highWaterMark, ptr_t&& source);
     static ptr_t CreateNoBodyWriter();
 };
 
@@ -0,0 +1,329 @@
+#pragma once
+
+#ifndef RESTC_CPP_HEADERS_H_
+#define RESTC_CPP_HEADERS_H_
+
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/iterator/iterator_adaptor.hpp>
+
+namespace restc_cpp {
+
+/*! A header name with its case-folded hash computed once.
+ *
+ * Use the instances in header_names for the well-known headers.
+ */
+class HeaderName {
+public:
+    HeaderName(std::string name);
+
+    [[nodiscard]] const std::string& str() const noexcept { return name_; }
+    [[nodiscard]] std::size_t hash() const noexcept { return hash_; }
+
+    operator const std::string& () const noexcept { return name_; }
+
+private:
+    std::string name_;
+    std::size_t hash_;
+};
+
+/*! Interned names for headers used by the library */
+namespace header_names {
+extern const HeaderName accept_encoding;
+extern const HeaderName age;
+extern const HeaderName authorization;
+extern const HeaderName cache_control;
+extern const HeaderName connection;
+extern const HeaderName content_encoding;
+extern const HeaderName content_length;
+extern const HeaderName content_type;
+extern const HeaderName date;
+extern const HeaderName etag;
+extern const HeaderName expires;
+extern const HeaderName host;
+extern const HeaderName if_modified_since;
+extern const HeaderName if_none_match;
+extern const HeaderName last_modified;
+extern const HeaderName location;
+extern const HeaderName pragma;
+extern const HeaderName retry_after;
+extern const HeaderName transfer_encoding;
+extern const HeaderName vary;
+} // namespace header_names
+
+/*! HTTP headers.
+ *
+ * A flat container with the interface of a
+ * std::multimap<std::string, std::string, ciLessLibC>.
+ * The names are compared case-insensitive, and the entries are sorted
+ * by name. Entries with the same name are in the order they were
+ * inserted.
+ *
+ * The entries are stored in a small vector with room for a typical
+ * request inline, together with a case-folded hash of each name, so
+ * that lookups rarely compare strings. Like in a std::multimap, the
+ * name of an entry is const, so its hash can not go stale.
+ *
+ * Unlike a std::multimap, insert() and erase() invalidate iterators.
+ */
+class Headers {
+public:
+    static constexpr std::size_t inline_capacity = 8;
+
+    using value_type = std::pair<const std::string, std::string>;
+    using key_type = std::string;
+    using mapped_type = std::string;
+    using size_type = std::size_t;
+
+private:
+    /*! Storage for one entry
+     *
+     * A value_type can not be assigned to, since the name is const. The
+     * vector needs that to move the entries around, so an entry is
+     * assigned by constructing a new value_type in its place.
+     */
+    class Entry {
+    public:
+        explicit Entry(value_type&& value) {
+            new (&storage_) value_type(std::move(value));
+        }
+
+        Entry(const Entry& entry) {
+            new (&storage_) value_type(entry.get());
+        }
+
+        Entry(Entry&& entry) {
+            new (&storage_) value_type(entry.get().first, std::move(entry.get().second));
+        }
+
+        ~Entry() {
+            get().~value_type();
+        }
+
+        Entry& operator = (const Entry& entry) {
+            if (this != &entry) {
+                Assign(entry.get().first, entry.get().second);
+            }
+            return *this;
+        }
+
+        Entry& operator = (Entry&& entry) {
+            if (this != &entry) {
+                Assign(entry.get().first, std::move(entry.get().second));
+            }
+            return *this;
+        }
+
+        value_type& get() noexcept {
+            return *std::launder(reinterpret_cast<value_type *>(&storage_));
+        }
+
+        const value_type& get() const noexcept {
+            return *std::launder(reinterpret_cast<const value_type *>(&storage_));
+        }
+
+    private:
+        // The copies are made before the old value is destroyed
+        void Assign(std::string name, std::string value) noexcept {
+            get().~value_type();
+            new (&storage_) value_type(std::move(name), std::move(value));
+        }
+
+        std::aligned_storage_t<sizeof(value_type), alignof(value_type)> storage_;
+    };
+
+    using entries_t = boost::container::small_vector<Entry, inline_capacity>;
+
+    template <typename ValueT, typename BaseT>
+    class Iterator
+        : public boost::iterator_adaptor<Iterator<ValueT, BaseT>, BaseT, ValueT> {
+    public:
+        Iterator() = default;
+
+        explicit Iterator(BaseT base)
+        : Iterator::iterator_adaptor_{base} {}
+
+        // iterator to const_iterator
+        template <typename OtherValueT, typename OtherBaseT,
+                  typename = std::enable_if_t<std::is_convertible_v<OtherBaseT, BaseT>>>
+        Iterator(const Iterator<OtherValueT, OtherBaseT>& it)
+        : Iterator::iterator_adaptor_{it.base()} {}
+
+    private:
+        friend class boost::iterator_core_access;
+
+        ValueT& dereference() const {
+            return this->base_reference()->get();
+        }
+    };
+
+public:
+    using iterator = Iterator<value_type, entries_t::iterator>;
+    using const_iterator = Iterator<const value_type, entries_t::const_iterator>;
+
+    Headers() = default;
+    Headers(const Headers&) = default;
+    Headers(Headers&&) = default;
+    Headers(std::initializer_list<value_type> init);
+
+    Headers& operator = (const Headers&) = default;
+    Headers& operator = (Headers&&) = default;
+
+    [[nodiscard]] iterator begin() noexcept { return iterator{entries_.begin()}; }
+    [[nodiscard]] iterator end() noexcept { return iterator{entries_.end()}; }
+    [[nodiscard]] const_iterator begin() const noexcept { return const_iterator{entries_.begin()}; }
+    [[nodiscard]] const_iterator end() const noexcept { return const_iterator{entries_.end()}; }
+    [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+    [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+    [[nodiscard]] size_type size() const noexcept { return entries_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return entries_.empty(); }
+
+    void clear() noexcept {
+        entries_.clear();
+        hashes_.clear();
+    }
+
+    /*! Find the first header with the name */
+    [[nodiscard]] iterator find(const std::string& key) {
+        return begin() + Offset(IndexOf(key, Hash(key)));
+    }
+
+    [[nodiscard]] const_iterator find(const std::string& key) const {
+        return begin() + Offset(IndexOf(key, Hash(key)));
+    }
+
+    [[nodiscard]] iterator find(const HeaderName& key) {
+        return begin() + Offset(IndexOf(key.str(), key.hash()));
+    }
+
+    [[nodiscard]] const_iterator find(const HeaderName& key) const {
+        return begin() + Offset(IndexOf(key.str(), key.hash()));
+    }
+
+    [[nodiscard]] size_type count(const std::string& key) const {
+        const auto range = equal_range(key);
+        return static_cast<size_type>(range.second - range.first);
+    }
+
+    /*! All the headers with the name */
+    [[nodiscard]] std::pair<iterator, iterator> equal_range(const std::string& key) {
+        const auto range = EqualRange(key);
+        return {begin() + Offset(range.first), begin() + Offset(range.second)};
+    }
+
+    [[nodiscard]] std::pair<const_iterator, const_iterator> equal_range(const std::string& key) const {
+        const auto range = EqualRange(key);
+        return {begin() + Offset(range.first), begin() + Offset(range.second)};
+    }
+
+    /*! The first header that is not sorted before key */
+    [[nodiscard]] iterator lower_bound(const std::string& key) {
+        return begin() + Offset(LowerBound(key));
+    }
+
+    [[nodiscard]] const_iterator lower_bound(const std::string& key) const {
+        return begin() + Offset(LowerBound(key));
+    }
+
+    /*! The first header that is sorted after key */
+    [[nodiscard]] iterator upper_bound(const std::string& key) {
+        return begin() + Offset(UpperBound(key));
+    }
+
+    [[nodiscard]] const_iterator upper_bound(const std::string& key) const {
+        return begin() + Offset(UpperBound(key));
+    }
+
+    /*! Add a header, after any existing headers with the same name */
+    iterator insert(const value_type& value) {
+        return Insert(value_type{value});
+    }
+
+    iterator insert(value_type&& value) {
+        return Insert(std::move(value));
+    }
+
+    /*! Add a header. The hint is not used. */
+    iterator insert(const_iterator /*hint*/, const value_type& value) {
+        return insert(value);
+    }
+
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last) {
+        for(; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    template <typename... ArgsT>
+    iterator emplace(ArgsT&&... args) {
+        return Insert(value_type{std::forward<ArgsT>(args)...});
+    }
+
+    /*! Add a header. The hint is not used. */
+    template <typename... ArgsT>
+    iterator emplace_hint(const_iterator /*hint*/, ArgsT&&... args) {
+        return emplace(std::forward<ArgsT>(args)...);
+    }
+
+    /*! Remove all headers with the name */
+    size_type erase(const std::string& key);
+
+    iterator erase(const_iterator pos);
+
+    iterator erase(iterator pos) {
+        return erase(const_iterator{pos});
+    }
+
+    /*! Operate on headers that can only have one instance per key */
+    std::string& operator[] (const std::string& key) {
+        return Get(key, Hash(key));
+    }
+
+    std::string& operator[] (const HeaderName& key) {
+        return Get(key.str(), key.hash());
+    }
+
+    Headers& operator += (const Headers& nh);
+
+    /*! Case-folded hash of a header name */
+    static std::size_t Hash(const std::string& name) noexcept {
+        // FNV-1a
+        std::size_t hash = static_cast<std::size_t>(14695981039346656037ULL);
+        for(const auto ch : name) {
+            auto lc = static_cast<unsigned char>(ch);
+            if (lc >= 'A' && lc <= 'Z') {
+                lc = static_cast<unsigned char>(lc + ('a' - 'A'));
+            }
+            hash ^= lc;
+            hash *= static_cast<std::size_t>(1099511628211ULL);
+        }
+        return hash;
+    }
+
+private:
+    static std::ptrdiff_t Offset(size_type index) noexcept {
+        return static_cast<std::ptrdiff_t>(index);
+    }
+
+    [[nodiscard]] size_type IndexOf(const std::string& key, std::size_t hash) const noexcept;
+    [[nodiscard]] std::pair<size_type, size_type> EqualRange(const std::string& key) const noexcept;
+    [[nodiscard]] size_type LowerBound(const std::string& key) const noexcept;
+    [[nodiscard]] size_type UpperBound(const std::string& key) const noexcept;
+    std::string& Get(const std::string& key, std::size_t hash);
+    iterator Insert(value_type&& value);
+
+    entries_t entries_;
+    boost::container::small_vector<std::size_t, inline_capacity> hashes_;
+};
+
+} // namespace
+
+#endif // RESTC_CPP_HEADERS_H_
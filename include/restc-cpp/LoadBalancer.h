@@ -0,0 +1,92 @@
+#pragma once
+#ifndef RESTC_CPP_LOAD_BALANCER_H_
+#define RESTC_CPP_LOAD_BALANCER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "restc-cpp/restc-cpp.h"
+
+namespace restc_cpp {
+
+/*! Spreads the connections to a server over its addresses
+ *
+ * Assign an instance to Request::Properties::loadBalancer to enable it
+ * for the requests using those properties. The instance can be shared
+ * by several clients.
+ *
+ * Without a load balancer, the client connects to the first address
+ * of the server that works. With it, all the addresses the server's
+ * host name resolves to, or the static upstreams configured for it,
+ * are used. The strategy chooses the address for each new request,
+ * and idle connections to that address are re-used.
+ *
+ * An address that fails too many times in a row (failed connect,
+ * failed request or a 5xx response) is ejected for a while. Ejected
+ * addresses are only used if the others fail.
+ *
+ * Requests with an affinity key (Request::SetAffinityKey()) ignore the
+ * strategy. The key is mapped to an address with rendezvous hashing,
+ * so requests with the same key go to the same address, as long as it
+ * is healthy, and re-use the idle connections to it. When an address
+ * is added or removed, only the keys that map to it move. The mapping
+ * does not depend on the order of the addresses, and is the same in
+ * all processes.
+ *
+ * HTTP/2 sessions and HTTP/1.1 pipelines are shared by the requests to
+ * a server, so for them, the strategy only chooses the address of a new
+ * connection. Requests with an affinity key are not pipelined.
+ *
+ * The implementation is thread-safe.
+ */
+class LoadBalancer {
+public:
+    using ptr_t = std::shared_ptr<LoadBalancer>;
+
+    enum class Strategy {
+        ROUND_ROBIN,
+        // The address with the fewest requests waiting for a response
+        LEAST_OUTSTANDING,
+        // The best of two random addresses, by latency (EWMA) and requests
+        // waiting for a response
+        P2C_EWMA
+    };
+
+    struct Config {
+        Strategy strategy = Strategy::P2C_EWMA;
+        // Static upstreams, by the host name in the url. The values are
+        // "address:port", where address is an IP address or a host name.
+        std::map<std::string, std::vector<std::string>> upstreams;
+        // Eject an address after this many failures in a row. 0 disables ejection.
+        std::size_t ejectAfterFailures = 5;
+        // How long an address is ejected. Multiplied with the number of
+        // ejections in a row, up to 10.
+        int ejectionTimeMs = (1000 * 30);
+        // The time constant for the moving average of the latency
+        int latencyDecayMs = (1000 * 10);
+        // Forget what we know about an address when it has no requests in
+        // flight, and has not been resolved or used for this long.
+        int endpointTtlMs = (1000 * 60 * 10);
+    };
+
+    struct EndpointStats {
+        std::string endpoint; // "address:port"
+        std::size_t outstanding = 0;
+        double latencyMs = 0; // EWMA
+        bool ejected = false;
+    };
+
+    virtual ~LoadBalancer() = default;
+
+    /*! The addresses that have been used recently */
+    virtual std::vector<EndpointStats> GetStats() const = 0;
+
+    static ptr_t Create();
+    static ptr_t Create(const Config& config);
+};
+
+} // namespace
+
+#endif // RESTC_CPP_LOAD_BALANCER_H_
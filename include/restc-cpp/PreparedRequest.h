@@ -0,0 +1,94 @@
+#pragma once
+#ifndef RESTC_CPP_PREPARED_REQUEST_H_
+#define RESTC_CPP_PREPARED_REQUEST_H_
+
+#include <string>
+#include <vector>
+
+#include "restc-cpp/restc-cpp.h"
+
+namespace restc_cpp {
+
+/*! A reusable template for requests with the same method and URL shape
+ *
+ * The URL, the request-line prefix, the Host and Authorization headers
+ * and the rest of the static header block are parsed, encoded and
+ * formatted once, when the template is created. Each request created
+ * from the template only adds the path parameters, the query arguments
+ * and the headers for the body (Content-Length or Transfer-Encoding).
+ *
+ * The path in the URL can contain placeholders, like
+ * "https://example.com/users/{id}/posts/{post}". The placeholders are
+ * replaced, in order, by the path parameters given to CreateRequest().
+ * The name inside the braces is just documentation.
+ *
+ * The template uses a snapshot of the clients connection properties.
+ * It is immutable, and can be shared between threads and contexts.
+ *
+ * \code
+ *  auto tmpl = PreparedRequest::Create("https://example.com/users/{id}",
+ *                                      Request::Type::GET, *client);
+ *  ...
+ *  auto reply = tmpl->Execute(ctx, {"42"});
+ * \endcode
+ */
+class PreparedRequest {
+public:
+    using ptr_t = std::shared_ptr<PreparedRequest>;
+    using path_params_t = std::vector<std::string>;
+
+    virtual ~PreparedRequest() = default;
+
+    /*! Create a request from the template
+     *
+     * \param pathParams Values for the placeholders in the path. They are
+     *      url-encoded as one path segment each, so '/' is escaped.
+     * \param body Optional body for the request.
+     * \param args Optional query arguments, appended after the arguments in the template.
+     *
+     * \throws ConstraintException if the number of path parameters
+     *      don't match the number of placeholders.
+     */
+    virtual std::unique_ptr<Request>
+    CreateRequest(const path_params_t& pathParams = {},
+                  std::unique_ptr<RequestBody> body = {},
+                  const boost::optional<Request::args_t>& args = {}) const = 0;
+
+    /*! Create a request from the template and execute it */
+    std::unique_ptr<Reply>
+    Execute(Context& ctx,
+            const path_params_t& pathParams = {},
+            std::unique_ptr<RequestBody> body = {},
+            const boost::optional<Request::args_t>& args = {}) const {
+        auto req = CreateRequest(pathParams, std::move(body), args);
+        return ctx.Request(*req);
+    }
+
+    /*! Number of placeholders in the path */
+    virtual size_t GetNumPathParams() const noexcept = 0;
+
+    virtual const Request::Properties& GetProperties() const = 0;
+
+    /*! Create a template
+     *
+     * \param url The URL, optionally with placeholders in the path.
+     * \param requestType The HTTP method.
+     * \param owner The client.
+     * \param args Query arguments to add to all the requests.
+     * \param headers Headers to add to all the requests.
+     * \param auth Basic authentication for all the requests.
+     *
+     * \throws ParseException if the URL is invalid.
+     */
+    static ptr_t
+    Create(const std::string& url,
+           const Request::Type requestType,
+           RestClient& owner,
+           const boost::optional<Request::args_t>& args = {},
+           const boost::optional<Request::headers_t>& headers = {},
+           const boost::optional<Request::auth_t>& auth = {});
+};
+
+} // namespace
+
+#endif // RESTC_CPP_PREPARED_REQUEST_H_
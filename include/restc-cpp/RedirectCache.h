@@ -0,0 +1,81 @@
+#pragma once
+#ifndef RESTC_CPP_REDIRECT_CACHE_H_
+#define RESTC_CPP_REDIRECT_CACHE_H_
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+
+namespace restc_cpp {
+
+/*! Remembers permanent redirects (301 and 308)
+ *
+ * Request::Execute() sends later requests for a URL that was
+ * permanently redirected directly to the new location.
+ *
+ * The redirects are stored by the method and the url of the request,
+ * as "METHOD url" (for example "POST http://example.com/a"), so that a
+ * redirect for one method is not used for another.
+ *
+ * Each RestClient creates one, unless one is assigned to
+ * Request::Properties::redirectCache. Use a cache with room for
+ * 0 entries to disable it.
+ *
+ * The implementation is thread-safe.
+ */
+class RedirectCache {
+public:
+    using ptr_t = std::shared_ptr<RedirectCache>;
+    using clock_t = std::chrono::steady_clock;
+
+    /*!
+     * \param maxEntries Max number of redirects. The least recently used
+     *      redirect is evicted when the cache is full.
+     * \param ttl How long a redirect is used before the server is asked
+     *      again.
+     */
+    explicit RedirectCache(size_t maxEntries,
+                           std::chrono::seconds ttl = std::chrono::hours{24})
+    : max_entries_{maxEntries}, ttl_{ttl}
+    {
+    }
+
+    /*! Get the location the request is redirected to, if any */
+    boost::optional<std::string> Lookup(const std::string& key);
+
+    /*! Remember a permanent redirect */
+    void Add(const std::string& key, const std::string& location);
+
+    void Remove(const std::string& key);
+
+    void Clear();
+
+    size_t GetSize() const;
+
+    static ptr_t Create(size_t maxEntries = 1024,
+                        std::chrono::seconds ttl = std::chrono::hours{24});
+
+private:
+    struct Item {
+        std::string key;
+        std::string location;
+        clock_t::time_point expires;
+    };
+
+    using lru_t = std::list<Item>;
+
+    const size_t max_entries_;
+    const std::chrono::seconds ttl_;
+    lru_t lru_;
+    std::unordered_map<std::string, lru_t::iterator> redirects_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace
+
+#endif // RESTC_CPP_REDIRECT_CACHE_H_
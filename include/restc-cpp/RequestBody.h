@@ -57,6 +57,32 @@ public:
     /*! Create a body with a string in it */
     static std::unique_ptr<RequestBody> CreateStringBody(std::string body);
 
+    /*! Create a body that references memory owned by the caller
+     *
+     * The data is not copied. The caller must keep it unchanged and
+     * alive until the request is finished, including redirects and
+     * retries.
+     */
+    static std::unique_ptr<RequestBody> CreateViewBody(boost::string_ref body);
+
+    /*! Create a body from a shared, immutable buffer
+     *
+     * The data is not copied. The body keeps a reference to the buffer,
+     * so the same payload can be sent to many servers at once.
+     */
+    static std::unique_ptr<RequestBody> CreateSharedBody(
+        std::shared_ptr<const std::string> body);
+
+    /*! Create a body from a list of buffers that are sent in one gather-write
+     *
+     * The data is not copied. If keepAlive is set, the body keeps a
+     * reference to it, until the body is deleted. Otherwise, the caller
+     * must keep the buffers alive until the request is finished.
+     */
+    static std::unique_ptr<RequestBody> CreateGatherBody(
+        write_buffers_t buffers,
+        std::shared_ptr<const void> keepAlive = {});
+
     /*! Create a body from a file
      *
      * This will effectively upload the file.
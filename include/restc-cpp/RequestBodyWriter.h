@@ -7,6 +7,14 @@
 #include "restc-cpp/RequestBody.h"
 #include "restc-cpp/error.h"
 
+/*! Max size of a serialized Json body that is buffered and sent with
+ * a Content-Length header. Larger bodies are streamed with chunked
+ * transfer encoding.
+ */
+#ifndef RESTC_CPP_MAX_BUFFERED_JSON_BODY_SIZE
+#   define RESTC_CPP_MAX_BUFFERED_JSON_BODY_SIZE (1024 * 64)
+#endif
+
 namespace restc_cpp {
 
 /*! The body of the request. */
@@ -29,6 +37,56 @@ private:
     fnT fn_;
 };
 
+/*! DataWriter that collects the data in a string
+ *
+ * Used to serialize a body up front, so that it can be sent
+ * as a fixed size body. If the data exceeds maxSize, the
+ * writer throws Overflow, so that the serialization stops
+ * right away.
+ */
+class BufferedBodyWriter : public DataWriter {
+public:
+    /*! Thrown when the data exceeds maxSize */
+    struct Overflow {};
+
+    BufferedBodyWriter(std::string& buffer, size_t maxSize)
+    : buffer_{buffer}, max_size_{maxSize}
+    {
+        buffer_.clear();
+    }
+
+    void Write(boost_const_buffer buffers) override {
+        Append(boost_buffer_cast(buffers), boost_buffer_size(buffers));
+    }
+
+    void WriteDirect(boost_const_buffer buffers) override {
+        Write(buffers);
+    }
+
+    void Write(const write_buffers_t& buffers) override {
+        for(const auto& b : buffers) {
+            Write(b);
+        }
+    }
+
+    void Finish() override {}
+
+    void SetHeaders(Request::headers_t& /*headers*/) override {}
+
+private:
+    void Append(const char *data, size_t len) {
+        if ((buffer_.size() + len) > max_size_) {
+            buffer_.clear();
+            throw Overflow{};
+        }
+
+        buffer_.append(data, len);
+    }
+
+    std::string& buffer_;
+    const size_t max_size_;
+};
+
 } // restc_cpp
 
 #endif // RESTC_CPP_BODY_WRITER_H_
@@ -9,9 +9,11 @@
 
 #include "restc-cpp/SerializeJson.h"
 //#include "restc-cpp/DataWriter.h"
+#include "restc-cpp/DataReader.h"
 #include "restc-cpp/RequestBody.h"
 #include "restc-cpp/RequestBodyWriter.h"
 #include "restc-cpp/helper.h"
+#include "restc-cpp/error.h"
 #include "rapidjson/writer.h"
 #include "rapidjson/stringbuffer.h"
 
@@ -256,6 +258,51 @@ public:
         return *this;
     }
 
+    /*! Body (data) for the request, without copying it
+     *
+     * \body The data to send as the body. The caller must keep it
+     *      alive and unchanged until the request is finished.
+     */
+    RequestBuilder& DataView(boost::string_ref body) {
+        assert(!body_);
+        body_ = RequestBody::CreateViewBody(body);
+        return *this;
+    }
+
+    /*! Body (data) for the request, without copying it
+     *
+     * \body A shared buffer to send as the body.
+     */
+    RequestBuilder& Data(std::shared_ptr<const std::string> body) {
+        assert(!body_);
+        body_ = RequestBody::CreateSharedBody(std::move(body));
+        return *this;
+    }
+
+    /*! Body (data) for the request, without copying it
+     *
+     * Without this overload, a std::shared_ptr<std::string> would
+     * be serialized as Json by the template below.
+     */
+    RequestBuilder& Data(std::shared_ptr<std::string> body) {
+        return Data(std::shared_ptr<const std::string>{std::move(body)});
+    }
+
+    /*! Body (data) for the request, sent with one gather-write
+     *
+     * \buffers The buffers to send as the body.
+     * \keepAlive Optional owner of the buffers, kept until the
+     *      request is finished. If empty, the caller must keep the
+     *      buffers alive until the request is finished.
+     */
+    RequestBuilder& Data(write_buffers_t buffers,
+                         std::shared_ptr<const void> keepAlive = {}) {
+        assert(!body_);
+        body_ = RequestBody::CreateGatherBody(std::move(buffers),
+                                              std::move(keepAlive));
+        return *this;
+    }
+
     /*! Use a functor to supply the data
      *
      */
@@ -280,6 +327,24 @@ public:
         return *this;
     }
 
+    /*! Compress the request body
+     *
+     * Overrides the compression settings in the properties
+     * for this request. Fixed size bodies smaller than
+     * Request::Properties::bodyCompressionMinSize are still
+     * sent uncompressed. A compressed body is sent with
+     * chunked transfer encoding.
+     *
+     * \param compression Content-Encoding to use.
+     * \param level zlib compression level 1 - 9, or -1 for the default.
+     */
+    RequestBuilder& CompressBody(Request::Compression compression = Request::Compression::GZIP,
+                                 int level = -1) {
+        body_compression_ = compression;
+        body_compression_level_ = level;
+        return *this;
+    }
+
     /*! Disable compression */
     RequestBuilder& DisableCompression() {
         assert(!body_);
@@ -317,6 +382,14 @@ public:
      *      server).
      *
      * Normally used with POST or PUT requests.
+     *
+     * Bodies up to the limit set with JsonBufferLimit() are serialized
+     * here, into a string that is moved into the body, and sent with a
+     * Content-Length header in the same write as the request headers.
+     * If the Json exceeds the limit, the serialization stops at the
+     * limit, and the object is serialized again, while it is sent,
+     * using chunked transfer encoding. In that case, \a data must remain valid until
+     * the request is sent.
      */
     template<typename T>
     RequestBuilder& Data(const T& data,
@@ -336,10 +409,35 @@ public:
             inserter.Done();
         };
 
+        if (json_buffer_limit_ > 0) {
+            std::string json;
+            json.reserve(json_buffer_limit_);
+            try {
+                BufferedBodyWriter buffer{json, json_buffer_limit_};
+                fn(buffer);
+                body_ = RequestBody::CreateStringBody(std::move(json));
+                return *this;
+            } catch(const BufferedBodyWriter::Overflow&) {
+                ; // Stream it instead
+            }
+        }
+
         body_ = std::make_unique<RequestBodyWriter<decltype(fn)>>(fn);
         return *this;
     }
 
+    /*! Max size of a Json body that is sent with a Content-Length header
+     *
+     * Must be called before Data(). The default is
+     * RESTC_CPP_MAX_BUFFERED_JSON_BODY_SIZE. Use 0 to always
+     * stream the Json body with chunked transfer encoding.
+     */
+    RequestBuilder& JsonBufferLimit(size_t maxBytes) {
+        assert(!body_);
+        json_buffer_limit_ = maxBytes;
+        return *this;
+    }
+
     /*! We will use a Chunked request body */
     RequestBuilder& Chunked() {
         static const std::string transfer_encoding{"Transfer-Encoding"};
@@ -347,42 +445,53 @@ public:
         return Header(transfer_encoding, chunked);
     }
 
+    /*! Use these properties instead of the clients default connection properties
+     *
+     * The headers, arguments and authentication set in the builder
+     * are applied on top of them.
+     */
     RequestBuilder& Properties(Request::Properties::ptr_t properties) {
         properties_ = std::move(properties);
         return *this;
     }
 
+    /*! Send the request to the same address as other requests with this key
+     *
+     * \see Request::SetAffinityKey()
+     */
+    RequestBuilder& AffinityKey(std::string key) {
+        affinity_key_ = std::move(key);
+        return *this;
+    }
+
     std::unique_ptr<Request> Build() {
         assert(ctx_);
-        static const std::string accept_encoding{"Accept-Encoding"};
-        static const std::string gzip{"gzip"};
 #ifdef DEBUG
         assert(!built_);
         built_ = true;
 #endif
-#if RESTC_CPP_WITH_ZLIB
-        if (!disable_compression_) {
-            if (!headers_ || (headers_->find(accept_encoding) == headers_->end())) {
-                Header(accept_encoding, gzip);
+        // Ask for the encodings the library is compiled to decompress
+        const auto& encodings = DataReader::GetAcceptEncoding();
+        if (!disable_compression_ && !encodings.empty()) {
+            if (!headers_ || (headers_->find(header_names::accept_encoding) == headers_->end())) {
+                Header(header_names::accept_encoding, encodings);
             }
         }
-#endif
         auto req = Request::Create(
             url_, type_, ctx_->GetClient(), std::move(body_), args_, headers_, auth_);
 
-        auto orig = req->GetProperties();
-
         if (properties_) {
-            // Merge the headers and args to get what we have already
-            // set in Request::Create
-            properties_->headers += orig.headers;
+            // The headers, args and auth set here are kept
+            // on top of the properties.
+            req->SetProperties(properties_);
+        }
 
-            // Add the original args
-            properties_->args.insert(properties_->args.end(),
-                                     orig.args.begin(),
-                                     orig.args.end());
+        if (affinity_key_) {
+            req->SetAffinityKey(std::move(*affinity_key_));
+        }
 
-            req->SetProperties(properties_);
+        if (body_compression_) {
+            req->SetBodyCompression(*body_compression_, body_compression_level_);
         }
 
         return req;
@@ -398,6 +507,22 @@ public:
         return request->Execute(*ctx_);
     }
 
+    /*! Exceute the request, and report errors in ec.
+     *
+     * \see Request::Execute(Context&, boost::system::error_code&)
+     */
+    std::unique_ptr<Reply> Execute(boost::system::error_code& ec) {
+        assert(ctx_);
+        std::unique_ptr<Request> request;
+        try {
+            request = Build();
+        } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+            ec = ToErrorCode(std::current_exception());
+            return {};
+        }
+        return request->Execute(*ctx_, ec);
+    }
+
     /*! Get the body of the request.
      *
      * The function will only be able to return a value when
@@ -423,6 +548,10 @@ private:
     Request::Properties::ptr_t properties_;
     std::unique_ptr<RequestBody> body_;
     bool disable_compression_ = false;
+    boost::optional<Request::Compression> body_compression_;
+    int body_compression_level_ = -1;
+    boost::optional<std::string> affinity_key_;
+    size_t json_buffer_limit_ = RESTC_CPP_MAX_BUFFERED_JSON_BODY_SIZE;
 #ifdef DEBUG
     bool built_ = false;
 #endif
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef RESTC_CPP_REQUEST_COALESCER_H_
+#define RESTC_CPP_REQUEST_COALESCER_H_
+
+#include <memory>
+
+#include "restc-cpp/restc-cpp.h"
+
+namespace restc_cpp {
+
+/*! Coalesces identical GET requests that are in flight at the same time
+ *
+ * Assign an instance to Request::Properties::requestCoalescer to
+ * enable it for the requests using those properties.
+ *
+ * When a GET request is executed while an identical request is in
+ * flight, it does not go to the server. It waits for the first request
+ * to complete, and gets its own Reply with a copy of the buffered
+ * response. If the first request fails, all the waiting requests fail
+ * with the same exception.
+ *
+ * Requests are identical when they have the same URL, arguments and
+ * request headers. Requests with a body are never coalesced.
+ *
+ * Responses with a body larger than maxBodySize are not shared. The
+ * waiting requests are then sent to the server one by one.
+ *
+ * The implementation is thread-safe.
+ */
+class RequestCoalescer {
+public:
+    using ptr_t = std::shared_ptr<RequestCoalescer>;
+
+    virtual ~RequestCoalescer() = default;
+
+    /*! Number of distinct requests that are in flight */
+    virtual size_t GetInFlightCount() const = 0;
+
+    static ptr_t Create(size_t maxBodySize = RESTC_CPP_SANE_DATA_LIMIT);
+};
+
+} // namespace
+
+#endif // RESTC_CPP_REQUEST_COALESCER_H_
@@ -0,0 +1,152 @@
+#pragma once
+#ifndef RESTC_CPP_RESPONSE_CACHE_H_
+#define RESTC_CPP_RESPONSE_CACHE_H_
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <boost/utility/string_ref.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+
+namespace restc_cpp {
+
+/*! A response stored in a ResponseCache
+ *
+ * The instances are immutable once they are stored, and
+ * may be shared by any number of replies and threads.
+ */
+struct CachedResponse {
+    using clock_t = std::chrono::system_clock;
+
+    Reply::HttpResponse response;
+
+    /*! The response headers, as received from the server */
+    headers_t headers;
+
+    /*! The decoded body.
+     *
+     * The data is owned by bodyOwner.
+     */
+    boost::string_ref body;
+    std::shared_ptr<const void> bodyOwner;
+
+    /*! The values of the request headers named by the Vary header
+     *
+     * Headers that were not in the request are stored with an empty value.
+     */
+    headers_t varyHeaders;
+
+    /*! When the response was received */
+    clock_t::time_point responseTime;
+
+    /*! The age of the response when it was received (the Age header) */
+    std::chrono::seconds initialAge{0};
+
+    /*! How long the response is fresh, counted from responseTime - initialAge */
+    std::chrono::seconds freshnessLifetime{0};
+
+    /*! Get the current age of the response */
+    std::chrono::seconds GetAge(const clock_t::time_point now = clock_t::now()) const {
+        const auto resident = std::chrono::duration_cast<std::chrono::seconds>(
+            now - responseTime);
+        return initialAge + std::max(resident, std::chrono::seconds{0});
+    }
+
+    bool IsFresh(const clock_t::time_point now = clock_t::now()) const {
+        return GetAge(now) < freshnessLifetime;
+    }
+
+    /*! Approximate memory used by the response */
+    size_t GetSize() const;
+};
+
+/*! Storage for a private HTTP cache (RFC 9111)
+ *
+ * Assign an instance to Request::Properties::responseCache to
+ * enable caching for the requests using those properties. The cache
+ * can be shared by several clients.
+ *
+ * Only GET requests are looked up in the cache. Fresh responses are
+ * returned without contacting the server. Stale responses that have
+ * an ETag or Last-Modified header are revalidated with a conditional
+ * request, and a '304 Not Modified' reply from the server is turned
+ * into a reply with the cached body.
+ *
+ * Since the cache can be shared, a response to a request with
+ * credentials (Authorization, Proxy-Authorization or Cookie) is only
+ * stored if the server allows it with public, s-maxage or
+ * must-revalidate in Cache-Control.
+ *
+ * The storage only stores and evicts. The caching rules are applied
+ * by the library.
+ *
+ * The implementations are thread-safe.
+ */
+class ResponseCache {
+public:
+    using ptr_t = std::shared_ptr<ResponseCache>;
+    using entry_t = std::shared_ptr<const CachedResponse>;
+
+    virtual ~ResponseCache() = default;
+
+    /*! Get the response stored under the key, if any */
+    virtual entry_t Lookup(const std::string& key) = 0;
+
+    /*! Store a response, replacing any existing response under the key */
+    virtual void Store(const std::string& key, entry_t response) = 0;
+
+    /*! Remove the response stored under the key, if any */
+    virtual void Remove(const std::string& key) = 0;
+
+    /*! Remove all responses */
+    virtual void Clear() = 0;
+
+    /*! Responses with larger bodies are not stored */
+    virtual size_t GetMaxEntrySize() const noexcept = 0;
+
+    /*! Approximate number of bytes used by the stored responses */
+    virtual size_t GetSize() const = 0;
+
+    /*! Create an in-memory cache
+     *
+     * The least recently used responses are evicted when the
+     * responses use more than maxBytes.
+     *
+     * \param maxBytes Memory budget for the cache.
+     * \param maxEntrySize Max size of the body of one response.
+     *      0 for maxBytes / 8.
+     */
+    static ptr_t CreateMemoryCache(size_t maxBytes, size_t maxEntrySize = 0);
+
+    /*! Create a persistent cache on disk
+     *
+     * Each response is stored in a segment file in the directory. The
+     * segments are memory-mapped when they are used, and the bodies are
+     * returned directly from the mappings, without being copied.
+     *
+     * The responses survive restarts. The index is rebuilt from the
+     * segments when the cache is created, and the least recently used
+     * responses are evicted when the segments use more than maxBytes.
+     *
+     * The segments are not synced to disk when they are written. Each
+     * segment has a checksum of its data, which is verified when the
+     * cache is created. After a power failure, segments that were not
+     * completely written out are detected and removed then.
+     *
+     * Only one process at the time should use the directory.
+     *
+     * \param directory Where to store the responses. It is created if it
+     *      does not exist.
+     * \param maxBytes Disk budget for the cache.
+     * \param maxEntrySize Max size of the body of one response.
+     *      0 for maxBytes / 8.
+     */
+    static ptr_t CreateDiskCache(const boost::filesystem::path& directory,
+                                 size_t maxBytes, size_t maxEntrySize = 0);
+};
+
+} // namespace
+
+#endif // RESTC_CPP_RESPONSE_CACHE_H_
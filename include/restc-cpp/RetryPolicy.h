@@ -0,0 +1,90 @@
+#pragma once
+#ifndef RESTC_CPP_RETRY_POLICY_H_
+#define RESTC_CPP_RETRY_POLICY_H_
+
+#include <cstdint>
+#include <memory>
+#include <set>
+
+#include "restc-cpp/restc-cpp.h"
+
+namespace restc_cpp {
+
+/*! Retries failed requests, with backoff and a retry budget
+ *
+ * Assign an instance to Request::Properties::retryPolicy to enable it
+ * for the requests using those properties. Share one instance between
+ * all the requests of a client, so that they share the budget.
+ *
+ * A request is retried when:
+ *  - We failed to connect to the server. The request was not sent,
+ *    so this is safe for all methods.
+ *  - An idempotent request (GET, HEAD, OPTIONS, PUT, DELETE) gets a
+ *    response with one of the retryStatusCodes, or a 429 with a
+ *    Retry-After header.
+ *  - The connection to the server fails while an idempotent request
+ *    is in progress.
+ *
+ * Requests with a body that can not be sent again (not of a fixed
+ * size) are not retried.
+ *
+ * With a policy, each address of the server is tried once per attempt
+ * to connect. Without one, the connect is retried on timeouts only.
+ *
+ * The delay before a retry is random, between 0 and baseDelayMs
+ * doubled for each retry, up to maxDelayMs ("full jitter"). A longer
+ * Retry-After in the response is respected. The coroutine sleeps with
+ * Context::Sleep() while it waits.
+ *
+ * The budget caps the retries to budgetRatio of the requests in the
+ * last budgetWindowMs, plus budgetMinRetriesPerSecond, so that retries
+ * do not multiply the load on a server that is already struggling.
+ * When the budget is spent, the request fails with the error from the
+ * last attempt.
+ *
+ * The implementation is thread-safe.
+ */
+class RetryPolicy {
+public:
+    using ptr_t = std::shared_ptr<RetryPolicy>;
+
+    struct Config {
+        // Retries after the first attempt
+        std::size_t maxRetries = 3;
+        int baseDelayMs = 100;
+        int maxDelayMs = (1000 * 10);
+        bool retryConnectErrors = true;
+        std::set<int> retryStatusCodes = {502, 503, 504};
+        // Retry 429 Too Many Requests, if the response has a Retry-After header
+        bool retryTooManyRequests = true;
+        // Retry when the connection fails after the request was sent
+        bool retryNetworkErrors = true;
+        // Also retry POST and PATCH requests on status codes and network errors
+        bool retryNonIdempotent = false;
+        // Give up if Retry-After asks us to wait longer than this
+        int maxRetryAfterMs = (1000 * 30);
+        // Allow this many retries per request
+        double budgetRatio = 0.1;
+        // Allow this many retries, regardless of the number of requests
+        std::size_t budgetMinRetriesPerSecond = 10;
+        // The period the budget is calculated over
+        int budgetWindowMs = (1000 * 10);
+    };
+
+    struct Stats {
+        std::uint64_t requests = 0;
+        std::uint64_t retries = 0;
+        std::uint64_t budgetExhausted = 0; // Retries refused by the budget
+    };
+
+    virtual ~RetryPolicy() = default;
+
+    virtual Stats GetStats() const = 0;
+
+    static ptr_t Create();
+    static ptr_t Create(const Config& config);
+};
+
+} // namespace
+
+#endif // RESTC_CPP_RETRY_POLICY_H_
@@ -38,6 +38,14 @@ public:
     virtual std::size_t AsyncReadSome(boost_mutable_buffer buffers,
                                         boost::asio::yield_context& yield) = 0;
 
+    /*! Read some data, and report errors in ec rather than throwing
+     *
+     * A time-out is reported as Error::TIME_OUT.
+     */
+    virtual std::size_t AsyncReadSome(boost_mutable_buffer buffers,
+                                      boost::asio::yield_context& yield,
+                                      boost::system::error_code& ec) = 0;
+
     virtual std::size_t AsyncRead(boost_mutable_buffer buffers,
                                     boost::asio::yield_context& yield) = 0;
 
@@ -58,12 +66,35 @@ public:
         bool tcpNodelay,
         boost::asio::yield_context& yield) = 0;
 
+    /*! Connect, and report errors in ec rather than throwing
+     *
+     * A time-out is reported as Error::TIME_OUT. Exceptions from the
+     * after connect callback are not caught.
+     */
+    virtual void AsyncConnect(const boost::asio::ip::tcp::endpoint& ep,
+        const std::string &host,
+        bool tcpNodelay,
+        boost::asio::yield_context& yield,
+        boost::system::error_code& ec) = 0;
+
     virtual void AsyncShutdown(boost::asio::yield_context& yield) = 0;
 
     virtual void Close(Reason reoson = Reason::DONE) = 0;
 
     virtual bool IsOpen() const noexcept = 0;
 
+    /*! Offer application protocols with ALPN in the TLS handshake
+     *
+     * \param protocols The protocols in the wire format of RFC 7301,
+     *      each prefixed by its length.
+     *
+     * Ignored by sockets without TLS.
+     */
+    virtual void SetAlpnProtocols(const std::string& /*protocols*/) {}
+
+    /*! The protocol the server selected with ALPN, or an empty string */
+    virtual std::string GetAlpnProtocol() const { return {}; }
+
     friend std::ostream& operator << (std::ostream& o, const Socket& v) {
         return v.Print(o);
     }
@@ -105,6 +136,23 @@ protected:
         }
     }
 
+    /*! Report a cancel caused by the timer as Error::TIME_OUT */
+    void TranslateError(boost::system::error_code& ec) const noexcept {
+        if ((ec.value() == boost::system::errc::operation_canceled)
+            && (reason_ == Socket::Reason::TIME_OUT)) {
+            ec = Error::TIME_OUT;
+        }
+    }
+
+    static void ThrowOnError(const boost::system::error_code& ec) {
+        if (ec == Error::TIME_OUT) {
+            throw RequestTimeOutException();
+        }
+        if (ec) {
+            throw boost::system::system_error(ec);
+        }
+    }
+
     boost::optional<Socket::Reason> reason_;
 };
 
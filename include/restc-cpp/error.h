@@ -107,6 +107,12 @@ struct NotSupportedException : public RestcCppException
     : RestcCppException(cause) {}
 };
 
+struct ConcurrencyLimitException : public RestcCppException
+{
+    ConcurrencyLimitException(const std::string& cause)
+    : RestcCppException(cause) {}
+};
+
 struct CommunicationException : public RestcCppException
 {
     CommunicationException(const std::string& cause)
@@ -125,6 +131,12 @@ struct DecompressException : public RestcCppException
     : RestcCppException(cause) {}
 };
 
+struct CompressException : public RestcCppException
+{
+    CompressException(const std::string& cause)
+    : RestcCppException(cause) {}
+};
+
 struct NoDataException : public RestcCppException
 {
     NoDataException(const std::string& cause)
@@ -167,6 +179,52 @@ struct FailedToResolveEndpointException : public RestcCppException
     : RestcCppException(what) {}
 };
 
+/*! Error codes used by the non-throwing API
+ *
+ * Request::Execute(ctx, ec), Context::Request(req, ec) and
+ * RequestBuilder::Execute(ec) report errors in a
+ * boost::system::error_code. HTTP errors use http_category(),
+ * where the value is the HTTP status code. Other errors use
+ * restc_cpp_category() with the values below, or the
+ * category of the underlying system error.
+ */
+enum class Error {
+    OK = 0,
+    FAILED = 1, // Some other exception
+    FAILED_TO_CONNECT,
+    FAILED_TO_RESOLVE,
+    TOO_MANY_CONNECTIONS,
+    TOO_MANY_REDIRECTS,
+    TIME_OUT,
+    PROTOCOL_ERROR,
+    CONSTRAINT,
+    CONNECTION_EXPIRED,
+    NOT_SUPPORTED,
+    CONCURRENCY_LIMIT
+};
+
+const boost::system::error_category& restc_cpp_category() noexcept;
+
+/*! Category for HTTP errors. The value is the HTTP status code */
+const boost::system::error_category& http_category() noexcept;
+
+inline boost::system::error_code make_error_code(Error e) noexcept {
+    return {static_cast<int>(e), restc_cpp_category()};
+}
+
+inline boost::system::error_code make_http_error_code(int statusCode) noexcept {
+    return {statusCode, http_category()};
+}
+
+/*! Get the error code for an exception thrown by restc-cpp */
+boost::system::error_code ToErrorCode(const std::exception_ptr& ex) noexcept;
+
 } // namespace
+
+namespace boost::system {
+template <>
+struct is_error_code_enum<restc_cpp::Error> : public std::true_type {};
+} // namespace
+
 #endif // RESTC_CPP_ERROR_H_
 
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+#include "restc-cpp/restc-cpp.h"
+
+namespace restc_cpp {
+
+/*! Recycles the memory of objects that are allocated for each request.
+ *
+ * Derive from this class (CRTP) to give T class-level operator new and
+ * delete. Freed objects are kept in a small per-thread free-list, and
+ * handed out again to the next request on that thread. That way, the
+ * request and reply objects, the reader- and writer chains and their IO
+ * buffers normally don't touch the global allocator once the first few
+ * requests are served.
+ *
+ * Only allocations of exactly sizeof(T) are recycled. Derived classes
+ * (for example in unit tests) fall back to the global allocator.
+ *
+ * An object may be freed from another thread than the one that allocated
+ * it. The memory then simply goes to the free-list of that thread.
+ */
+template <typename T>
+class RecycledObject {
+public:
+    static void *operator new(std::size_t size) {
+        if (size == sizeof(T)) {
+            if (auto *pool = GetPool()) {
+                if (pool->count > 0) {
+                    return pool->free[--pool->count];
+                }
+            }
+        }
+        return ::operator new(size);
+    }
+
+    static void operator delete(void *ptr, std::size_t size) noexcept {
+        if (ptr == nullptr) {
+            return;
+        }
+        if (size == sizeof(T)) {
+            if (auto *pool = GetPool()) {
+                if (pool->count < pool->free.size()) {
+                    pool->free[pool->count++] = ptr;
+                    return;
+                }
+            }
+        }
+        ::operator delete(ptr);
+    }
+
+protected:
+    RecycledObject() = default;
+    ~RecycledObject() = default;
+
+private:
+    struct Pool {
+        Pool() = default;
+        Pool(const Pool&) = delete;
+        Pool& operator = (const Pool&) = delete;
+
+        ~Pool() {
+            IsPoolDestroyed() = true;
+            while(count > 0) {
+                ::operator delete(free[--count]);
+            }
+        }
+
+        std::array<void *, RESTC_CPP_RECYCLE_POOL_SIZE> free = {};
+        std::size_t count = 0;
+    };
+
+    /*! Set when the thread's pool is gone
+     *
+     * Trivially destructible, so it can still be read while the other
+     * thread_local objects of the thread are destroyed.
+     */
+    static bool& IsPoolDestroyed() noexcept {
+        thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    /*! The pool of this thread, or nullptr if it is already destroyed
+     *
+     * Objects that are released by static or thread_local destructors
+     * that run after the pool's destructor use the global allocator.
+     */
+    static Pool *GetPool() noexcept {
+        if (IsPoolDestroyed()) {
+            return nullptr;
+        }
+        thread_local Pool pool;
+        return &pool;
+    }
+};
+
+} // namespace
@@ -12,6 +12,8 @@
 #include <fstream>
 #include <iostream>
 #include <array>
+#include <functional>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <boost/asio/spawn.hpp>
@@ -27,6 +29,7 @@
 
 #include "restc-cpp/boost_compatibility.h"
 #include "restc-cpp/helper.h"
+#include "restc-cpp/Headers.h"
 #include "restc-cpp/Connection.h"
 
 #if defined(_MSC_VER) || defined(__MINGW32__)
@@ -53,6 +56,13 @@
 #   define RESTC_CPP_IO_BUFFER_SIZE (1024 * 16)
 #endif
 
+/*! Max number of freed per-request objects of one type to keep
+ * for re-use in each thread.
+ */
+#ifndef RESTC_CPP_RECYCLE_POOL_SIZE
+#   define RESTC_CPP_RECYCLE_POOL_SIZE 32
+#endif
+
 namespace restc_cpp {
 
 class RestClient;
@@ -66,33 +76,18 @@ class Request;
 class Reply;
 class Context;
 class DataWriter;
+class RedirectCache;
+class RequestCoalescer;
+class ResponseCache;
+class ConcurrencyLimiter;
+class LoadBalancer;
+class RetryPolicy;
 
 /*! Length of lines when we 'pretty-print' */
 constexpr size_t line_length = 80;
 
 using write_buffers_t = std::vector<boost::asio::const_buffer>;
 
-struct Headers : public std::multimap<std::string, std::string, ciLessLibC>  {
-
-    /*! Operate on headers that can only have one instance per key */
-    std::string& operator[] (const std::string& key) {
-        auto it = find(key);
-        if (it != end()) {
-            return it->second;
-        }
-
-        return insert({key, {}})->second;
-    }
-
-    Headers& operator += (const Headers& nh) {
-        for(auto& h: nh) {
-           operator [] (h.first) = h.second;
-        }
-
-        return *this;
-    }
-};
-
 using headers_t = Headers;
 
 class Request {
@@ -153,6 +148,20 @@ public:
         PATCH
     };
 
+    /*! Content-Encoding for request bodies */
+    enum class Compression {
+        NONE,
+        GZIP,
+        DEFLATE
+    };
+
+    /*! Protocol for the requests */
+    enum class HttpVersion {
+        HTTP_1_1,
+        HTTP_2, // For https, if the server agrees with ALPN. Else HTTP/1.1.
+        HTTP_2_PRIOR_KNOWLEDGE // Also for http, to servers known to support HTTP/2
+    };
+
     class Properties {
     public:
         using ptr_t = std::shared_ptr<Properties>;
@@ -166,6 +175,57 @@ public:
         int sendTimeoutMs = (1000 * 12); // For each IO operation
         int replyTimeoutMs =  (1000 * 21); // For the reply header
         int recvTimeout = (1000 * 21); // For each IO operation
+        // Compressed replies with a Content-Length up to this size are read
+        // completely and decompressed in one pass, unless they inflate to more
+        // than RESTC_CPP_SANE_DATA_LIMIT. 0 disables this.
+        std::size_t oneShotDecompressLimit = (1024 * 1024);
+        // Writes from bodies that push their data (RequestBodyWriter,
+        // RequestBuilder::DataProvider() and streamed Json) are coalesced
+        // up to this size before they are sent. 0 sends each write as its
+        // own chunk. Does not apply to the writer returned by SendRequest().
+        std::size_t writeBufferSize = RESTC_CPP_IO_BUFFER_SIZE;
+        // Compress request bodies. Requires zlib.
+        Compression bodyCompression = Compression::NONE;
+        int bodyCompressionLevel = -1; // zlib level 1 - 9, -1 for the default
+        // Fixed size bodies smaller than this are sent uncompressed
+        std::uint64_t bodyCompressionMinSize = 1024;
+        // Cache for the replies to GET requests. See ResponseCache.h
+        std::shared_ptr<ResponseCache> responseCache;
+        // Share one reply between identical GET requests. See RequestCoalescer.h
+        std::shared_ptr<RequestCoalescer> requestCoalescer;
+        // Permanent redirects (301, 308). Created by the RestClient if not set.
+        std::shared_ptr<RedirectCache> redirectCache;
+        // HTTP/2 multiplexes the requests to a server over one connection.
+        // Not used with a proxy.
+        HttpVersion httpVersion = HttpVersion::HTTP_1_1;
+        // Pipeline up to this many GET and HEAD requests on one HTTP/1.1
+        // connection. 0 or 1 disables pipelining. Not used with a proxy.
+        std::size_t pipelineDepth = 0;
+        // Limit the requests in flight to each server. See ConcurrencyLimiter.h
+        std::shared_ptr<ConcurrencyLimiter> concurrencyLimiter;
+        // Spread the requests over the addresses of the server. See LoadBalancer.h
+        std::shared_ptr<LoadBalancer> loadBalancer;
+        // Retry failed requests. See RetryPolicy.h
+        // Without a policy, each address of the server is tried up to
+        // 8 times if the connect times out, and nothing else is retried.
+        std::shared_ptr<RetryPolicy> retryPolicy;
+        // Hedged requests: Send a second, identical GET, HEAD or OPTIONS
+        // request on another connection if the response headers are slow,
+        // and use the first reply. The reply to a hedged request is read
+        // into memory before it is returned. If the body is larger than
+        // RESTC_CPP_SANE_DATA_LIMIT, the request is sent once more without
+        // hedging, and that reply is returned as it is received. With a
+        // responseCache, the cache misses and revalidations are hedged.
+        struct Hedging {
+            // Send the second request after this long. 0 disables hedging,
+            // unless percentile is set.
+            int delayMs = 0;
+            // If > 0, send the second request after this percentile (0 - 100)
+            // of the recent response times from the server. delayMs is used
+            // until we have enough samples.
+            double percentile = 0;
+        };
+        Hedging hedging;
         std::size_t cacheMaxConnectionsPerEndpoint = 16;
         std::size_t cacheMaxConnections = 128;
         int cacheTtlSeconds = 60;
@@ -188,6 +248,25 @@ public:
     virtual const Properties& GetProperties() const = 0;
     virtual void SetProperties(Properties::ptr_t propreties) = 0;
 
+    /*! Send the requests with the same key to the same address of the server
+     *
+     * Used with Properties::loadBalancer, to keep the requests for
+     * the same user, shard or cache entry on the same backend.
+     * Without a load balancer, the key is ignored.
+     *
+     * \see LoadBalancer
+     */
+    virtual void SetAffinityKey(std::string key) = 0;
+
+    /*! Compress the body of this request
+     *
+     * Overrides Properties::bodyCompression and
+     * Properties::bodyCompressionLevel for this request.
+     *
+     * \param level zlib compression level 1 - 9, or -1 for the default.
+     */
+    virtual void SetBodyCompression(Compression compression, int level = -1) = 0;
+
     /*! Manually send the request */
     virtual DataWriter& SendRequest(Context& ctx) = 0;
 
@@ -197,7 +276,8 @@ public:
      * from the server.
      *
      * \Note if you call SendRequest() and GetReply() manually,
-     *      you have to deal with redirects yourself.
+     *      you have to deal with redirects (301, 302, 303, 307
+     *      and 308) yourself.
      *
      * \See RedirectException
      */
@@ -211,6 +291,20 @@ public:
      */
     virtual std::unique_ptr<Reply> Execute(Context& ctx) = 0;
 
+    /*! Execute the request, and report errors in ec rather than throwing
+     *
+     * HTTP errors are reported as make_http_error_code(status) if
+     * Properties::throwOnHttpError is set. The reply is returned as
+     * well, so that the caller can read the body.
+     *
+     * Other errors are reported as restc_cpp::Error values or as
+     * system errors, and nullptr is returned.
+     *
+     * \see Error
+     */
+    virtual std::unique_ptr<Reply> Execute(Context& ctx,
+                                           boost::system::error_code& ec) = 0;
+
     virtual ~Request() = default;
 
     static std::unique_ptr<Request>
@@ -228,7 +322,8 @@ public:
 
     struct HttpResponse {
         enum class HttpVersion {
-            HTTP_1_1
+            HTTP_1_1,
+            HTTP_2
         };
         HttpVersion http_version = HttpVersion::HTTP_1_1;
         int status_code = 0;
@@ -306,12 +401,35 @@ public:
     /*! Send a GET request asynchronously to the server. */
     virtual std::unique_ptr<Reply> Get(std::string url) = 0;
 
+    /*! Send a GET request. Errors are reported in ec.
+     *
+     * \see Request::Execute(Context&, boost::system::error_code&)
+     */
+    virtual std::unique_ptr<Reply> Get(std::string url,
+                                       boost::system::error_code& ec) = 0;
+
     /*! Send a POST request asynchronously to the server. */
     virtual std::unique_ptr<Reply> Post(std::string url, std::string body) = 0;
 
+    /*! Send a POST request asynchronously to the server.
+     *
+     * Use this with the RequestBody factories to send data
+     * without copying it.
+     */
+    virtual std::unique_ptr<Reply> Post(std::string url,
+                                        std::unique_ptr<RequestBody> body) = 0;
+
     /*! Send a PUT request asynchronously to the server. */
     virtual std::unique_ptr<Reply> Put(std::string url, std::string body) = 0;
 
+    /*! Send a PUT request asynchronously to the server.
+     *
+     * Use this with the RequestBody factories to send data
+     * without copying it.
+     */
+    virtual std::unique_ptr<Reply> Put(std::string url,
+                                       std::unique_ptr<RequestBody> body) = 0;
+
     /*! Send a DELETE request asynchronously to the server. */
     virtual std::unique_ptr<Reply> Delete(std::string url) = 0;
 
@@ -332,6 +450,13 @@ public:
      */
     virtual std::unique_ptr<Reply> Request(Request& req) = 0;
 
+    /*! Send a request. Errors are reported in ec.
+     *
+     * \see Request::Execute(Context&, boost::system::error_code&)
+     */
+    virtual std::unique_ptr<Reply> Request(restc_cpp::Request& req,
+                                           boost::system::error_code& ec) = 0;
+
     /*! Asynchronously sleep for a period */
     template<class Rep, class Period>
     void Sleep(const std::chrono::duration<Rep, Period>& duration) {
@@ -344,6 +469,62 @@ public:
     /*! Asynchronously sleep for a period */
     virtual void Sleep(const uint64_t microseconds) = 0;
 
+    /*! The outcome of one of the requests in ExecuteAll() */
+    struct BatchResult {
+        /*! The position of the request in the requests */
+        size_t index = 0;
+
+        /*! The reply, with the body in memory. nullptr if the request failed.
+         *
+         * \see ExecuteAll() for the limit on the size of the body.
+         */
+        std::unique_ptr<Reply> reply;
+
+        /*! The error, also for HTTP errors when throwOnHttpError is set
+         *
+         * \see Request::Execute(Context&, boost::system::error_code&)
+         */
+        boost::system::error_code ec;
+    };
+
+    using requests_t = std::vector<std::unique_ptr<restc_cpp::Request>>;
+    using on_result_fn_t = std::function<void (BatchResult&& result)>;
+
+    /*! Execute the requests concurrently
+     *
+     * The requests are executed in coroutines of their own, on the
+     * client's worker threads. This coroutine is suspended until they
+     * are done.
+     *
+     * The bodies of the replies are read into memory, so the replies
+     * can be used from this coroutine. Each body is limited to
+     * RESTC_CPP_SANE_DATA_LIMIT bytes (16 MB, unless the library is
+     * built with another value). A request with a larger body fails
+     * with Error::CONSTRAINT in BatchResult::ec, and no reply. Execute
+     * requests for larger bodies one by one, and read the bodies as
+     * they are received.
+     *
+     * \param requests The requests. They must not be used by others
+     *      until the method returns.
+     * \param maxConcurrency Max requests in flight at the same time.
+     *      0 uses the cacheMaxConnectionsPerEndpoint property of the client.
+     * \return The results, in the order of the requests.
+     */
+    std::vector<BatchResult> ExecuteAll(const requests_t& requests,
+                                        size_t maxConcurrency = 0);
+
+    /*! Execute the requests concurrently, and handle the results as they complete
+     *
+     * Like ExecuteAll(), but onResult is called from this coroutine
+     * with each result as soon as it is ready.
+     *
+     * If onResult throws, no more requests are started. The method
+     * waits for the requests in flight, and then rethrows the exception.
+     */
+    void ExecuteAsCompleted(const requests_t& requests,
+                            const on_result_fn_t& onResult,
+                            size_t maxConcurrency = 0);
+
     static std::unique_ptr<Context>
         Create(::boost::asio::yield_context& yield,
                RestClient& rc);
@@ -9,8 +9,23 @@
 
 namespace restc_cpp {
 
+/*! Url-encode (%-escape) src */
 std::string url_encode(const boost::string_ref& src);
 
+/*! Url-encode src and append the result to dst */
+void url_encode(const boost::string_ref& src, std::string& dst);
+
+/*! Decode %-escapes in src
+ *
+ * '+' is not translated to space.
+ *
+ * \throws ParseException if src contains an invalid %-escape.
+ */
+std::string url_decode(const boost::string_ref& src);
+
+/*! Decode %-escapes in src and append the result to dst */
+void url_decode(const boost::string_ref& src, std::string& dst);
+
 } // namespace
 
 #endif // RESTC_CPP_URL_ENCODE_H_
@@ -0,0 +1,114 @@
+
+#include <array>
+
+#include <brotli/decode.h>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataReader.h"
+#include "restc-cpp/logging.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+/*! Decompresses 'br' encoded data from the source. */
+class BrotliReaderImpl : public DataReader, public RecycledObject<BrotliReaderImpl> {
+public:
+    BrotliReaderImpl(ptr_t&& source)
+    : source_{std::move(source)}
+    , state_{BrotliDecoderCreateInstance(nullptr, nullptr, nullptr)}
+    {
+        if (state_ == nullptr) {
+            throw DecompressException("Failed to initialize decompression");
+        }
+    }
+
+    BrotliReaderImpl(const BrotliReaderImpl&) = delete;
+    BrotliReaderImpl(BrotliReaderImpl&&) = delete;
+
+    BrotliReaderImpl& operator = (const BrotliReaderImpl&) = delete;
+    BrotliReaderImpl& operator = (BrotliReaderImpl&&) = delete;
+
+    ~BrotliReaderImpl() override {
+        BrotliDecoderDestroyInstance(state_);
+    }
+
+    [[nodiscard]] bool IsEof() const override { return done_; }
+
+    void Finish() override {
+        source_->Finish();
+    }
+
+    ::restc_cpp::boost_const_buffer ReadSome() override {
+        while(!done_) {
+            if (need_input_) {
+                if (!got_input_ && source_->IsEof()) {
+                    // An empty body, like a reply with Content-Length: 0
+                    done_ = true;
+                    break;
+                }
+
+                const auto buffers = source_->ReadSome();
+                next_in_ = reinterpret_cast<const uint8_t *>(boost_buffer_cast(buffers));
+                avail_in_ = boost::asio::buffer_size(buffers);
+
+                if (avail_in_ == 0) {
+                    if (!got_input_ && source_->IsEof()) {
+                        done_ = true;
+                        break;
+                    }
+                    throw DecompressException("Decompression failed - premature end of stream.");
+                }
+                got_input_ = true;
+            }
+
+            auto *next_out = reinterpret_cast<uint8_t *>(out_buffer_.data());
+            size_t avail_out = out_buffer_.size();
+
+            const auto result = BrotliDecoderDecompressStream(
+                state_, &avail_in_, &next_in_, &avail_out, &next_out, nullptr);
+
+            need_input_ = false;
+            switch(result) {
+                case BROTLI_DECODER_RESULT_SUCCESS:
+                    RESTC_CPP_LOG_TRACE_("BrotliReaderImpl::ReadSome(): End of stream. Done.");
+                    done_ = true;
+                    break;
+                case BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT:
+                    need_input_ = true;
+                    break;
+                case BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT:
+                    break;
+                default:
+                    throw DecompressException(
+                        "Decompression failed: "s + BrotliDecoderErrorString(
+                            BrotliDecoderGetErrorCode(state_)));
+            }
+
+            const auto len = out_buffer_.size() - avail_out;
+            if (len > 0) {
+                return {out_buffer_.data(), len};
+            }
+        }
+
+        return {out_buffer_.data(), 0};
+    }
+
+private:
+    ptr_t source_;
+    BrotliDecoderState *state_ = nullptr;
+    const uint8_t *next_in_ = nullptr;
+    size_t avail_in_ = 0;
+    bool need_input_ = true;
+    bool got_input_ = false;
+    bool done_ = false;
+    std::array<char, 1024 * 8> out_buffer_ = {};
+};
+
+DataReader::ptr_t
+DataReader::CreateBrotliReader(ptr_t&& source) {
+    return make_unique<BrotliReaderImpl>(std::move(source));
+}
+
+} // namepsace
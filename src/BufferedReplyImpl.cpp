@@ -0,0 +1,142 @@
+
+#include <cassert>
+
+#include <boost/uuid/nil_generator.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/helper.h"
+
+#include "BufferedReplyImpl.h"
+#include "CachePolicy.h"
+#include "ReplyImpl.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+BufferedReplyImpl::BufferedReplyImpl(ResponseCache::entry_t response,
+                                     std::unique_ptr<Reply> tail)
+: response_{std::move(response)}, tail_{std::move(tail)}
+{
+    assert(response_);
+}
+
+boost::uuids::uuid BufferedReplyImpl::GetConnectionId() const {
+    if (tail_) {
+        return tail_->GetConnectionId();
+    }
+    return boost::uuids::nil_uuid();
+}
+
+string BufferedReplyImpl::GetBodyAsString(const size_t maxSize) {
+    std::string buffer;
+    buffer.reserve(response_->body.size());
+
+    while(MoreDataToRead()) {
+        auto data = GetSomeData();
+
+        const auto buffer_size = boost::asio::buffer_size(data);
+        if ((buffer.size() + buffer_size) >= maxSize) {
+            throw ConstraintException(
+                "Too much data for the curent buffer limit.");
+        }
+
+        buffer.append(boost_buffer_cast(data), buffer_size);
+    }
+
+    return buffer;
+}
+
+void BufferedReplyImpl::fetchAndIgnore() {
+    body_returned_ = true;
+    if (tail_) {
+        tail_->fetchAndIgnore();
+    }
+}
+
+boost_const_buffer BufferedReplyImpl::GetSomeData() {
+    if (!body_returned_) {
+        body_returned_ = true;
+        if (!response_->body.empty()) {
+            return {response_->body.data(), response_->body.size()};
+        }
+    }
+
+    if (tail_) {
+        return tail_->GetSomeData();
+    }
+
+    return {nullptr, 0};
+}
+
+bool BufferedReplyImpl::MoreDataToRead() {
+    if (!body_returned_ && !response_->body.empty()) {
+        return true;
+    }
+    return tail_ && tail_->MoreDataToRead();
+}
+
+boost::optional<string> BufferedReplyImpl::GetHeader(const string& name) {
+    boost::optional<string> rval;
+
+    // The age of a stored response grows while it is in the cache
+    if (ciEqLibC()(name, header_names::age)) {
+        rval = to_string(response_->GetAge().count());
+        return rval;
+    }
+
+    auto it = response_->headers.find(name);
+    if (it != response_->headers.end()) {
+        rval = it->second;
+    }
+
+    return rval;
+}
+
+unique_ptr<Reply> BufferedReplyImpl::Detach(unique_ptr<Reply> reply, const size_t maxSize) {
+    assert(reply);
+
+    auto response = make_shared<CachedResponse>();
+    if (auto *buffered = dynamic_cast<BufferedReplyImpl *>(reply.get())) {
+        if (!buffered->HasTail()) {
+            return reply;
+        }
+        *response = *buffered->GetResponse();
+    } else {
+        response->response = reply->GetHttpResponse();
+        if (auto *impl = dynamic_cast<ReplyImpl *>(reply.get())) {
+            response->headers = GetStoredHeaders(impl->GetAllHeaders());
+        }
+        response->responseTime = CachedResponse::clock_t::now();
+        if (const auto age = reply->GetHeader(header_names::age)) {
+            try {
+                response->initialAge = std::chrono::seconds{stoul(*age)};
+            } catch (const exception&) {
+                ; // Ignore a malformed Age header
+            }
+        }
+    }
+
+    auto body = make_shared<std::string>(reply->GetBodyAsString(maxSize));
+    SetStoredBody(*response, std::move(body));
+    return make_unique<BufferedReplyImpl>(std::move(response));
+}
+
+std::deque<std::string> BufferedReplyImpl::GetHeaders(const std::string& name) {
+    std::deque<std::string> rval;
+
+    if (ciEqLibC()(name, header_names::age)) {
+        rval.push_back(*GetHeader(name));
+        return rval;
+    }
+
+    auto range = response_->headers.equal_range(name);
+    for (auto it = range.first; it != range.second; ++it) {
+        rval.push_back(it->second);
+    }
+
+    return rval;
+}
+
+} // namespace
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/ResponseCache.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+namespace restc_cpp {
+
+/*! A reply with a body that is already in memory
+ *
+ * Used for replies served from a ResponseCache. If the body was too
+ * large to be cached, the part we read is served from memory, and the
+ * rest is read from the original reply.
+ */
+class BufferedReplyImpl : public Reply, public RecycledObject<BufferedReplyImpl> {
+public:
+    BufferedReplyImpl(ResponseCache::entry_t response,
+                      std::unique_ptr<Reply> tail = {});
+
+    boost::uuids::uuid GetConnectionId() const override;
+
+    int GetResponseCode() const override {
+        return response_->response.status_code;
+    }
+
+    const HttpResponse& GetHttpResponse() const override {
+        return response_->response;
+    }
+
+    std::string GetBodyAsString(size_t maxSize
+        = RESTC_CPP_SANE_DATA_LIMIT) override;
+
+    void fetchAndIgnore() override;
+
+    boost_const_buffer GetSomeData() override;
+
+    bool MoreDataToRead() override;
+
+    boost::optional<std::string> GetHeader(const std::string& name) override;
+
+    std::deque<std::string> GetHeaders(const std::string& name) override;
+
+    const ResponseCache::entry_t& GetResponse() const noexcept {
+        return response_;
+    }
+
+    /*! True if some of the body is read from the server */
+    bool HasTail() const noexcept {
+        return static_cast<bool>(tail_);
+    }
+
+    /*! Read the rest of a reply into memory
+     *
+     * The body is read in the coroutine that owns the reply. The
+     * returned reply does not use that coroutine, and can be passed on
+     * to another one.
+     *
+     * \throws ConstraintException if the body is larger than maxSize
+     */
+    static std::unique_ptr<Reply> Detach(std::unique_ptr<Reply> reply, size_t maxSize);
+
+private:
+    const ResponseCache::entry_t response_;
+    std::unique_ptr<Reply> tail_;
+    bool body_returned_ = false;
+};
+
+} // namespace
@@ -0,0 +1,97 @@
+
+#include <vector>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataWriter.h"
+#include "restc-cpp/logging.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+
+class BufferedWriterImpl : public DataWriter, public RecycledObject<BufferedWriterImpl> {
+public:
+    BufferedWriterImpl(size_t highWaterMark, ptr_t&& source)
+    : next_{std::move(source)}, high_water_mark_{highWaterMark}
+    {
+    }
+
+    void WriteDirect(::restc_cpp::boost_const_buffer buffers) override {
+        FlushBuffer();
+        next_->WriteDirect(buffers);
+    }
+
+    void Write(::restc_cpp::boost_const_buffer buffers) override {
+        const auto len = boost::asio::buffer_size(buffers);
+
+        if ((buffer_.size() + len) > high_water_mark_) {
+            FlushBuffer();
+        }
+
+        if (len >= high_water_mark_) {
+            // No point in copying it
+            next_->Write(buffers);
+            return;
+        }
+
+        if (buffer_.capacity() == 0) {
+            buffer_.reserve(high_water_mark_);
+        }
+
+        const auto *data = boost_buffer_cast(buffers);
+        buffer_.insert(buffer_.end(), data, data + len);
+    }
+
+    void Write(const write_buffers_t& buffers) override {
+        if ((buffer_.size() + boost::asio::buffer_size(buffers)) > high_water_mark_) {
+            FlushBuffer();
+            next_->Write(buffers);
+            return;
+        }
+
+        for(const auto& b : buffers) {
+            Write(b);
+        }
+    }
+
+    void Finish() override {
+        FlushBuffer();
+        next_->Finish();
+    }
+
+    void Flush() override {
+        FlushBuffer();
+        next_->Flush();
+    }
+
+    void SetHeaders(Request::headers_t& headers) override {
+        next_->SetHeaders(headers);
+    }
+
+private:
+    void FlushBuffer() {
+        if (buffer_.empty()) {
+            return;
+        }
+
+        RESTC_CPP_LOG_TRACE_("BufferedWriterImpl: Flushing #" << buffer_.size()
+            << " bytes");
+
+        next_->Write({buffer_.data(), buffer_.size()});
+        buffer_.clear();
+    }
+
+    unique_ptr<DataWriter> next_;
+    const size_t high_water_mark_;
+    vector<char> buffer_;
+};
+
+
+DataWriter::ptr_t
+DataWriter::CreateBufferedWriter(size_t highWaterMark, ptr_t&& source) {
+    return make_unique<BufferedWriterImpl>(highWaterMark, std::move(source));
+}
+
+} // namespace
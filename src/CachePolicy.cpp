@@ -0,0 +1,358 @@
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/helper.h"
+
+#include "CachePolicy.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+using clock_t_ = CachedResponse::clock_t;
+
+// Cap for the freshness we guess from Last-Modified
+constexpr std::chrono::seconds max_heuristic_lifetime{60 * 60 * 24};
+constexpr int heuristic_fraction = 10;
+
+boost::string_ref Trim(boost::string_ref value) {
+    while(!value.empty() && isspace(static_cast<unsigned char>(value.front()))) {
+        value.remove_prefix(1);
+    }
+    while(!value.empty() && isspace(static_cast<unsigned char>(value.back()))) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+bool IEquals(boost::string_ref lhs, boost::string_ref rhs) {
+    return (lhs.size() == rhs.size())
+        && (strncasecmp(lhs.data(), rhs.data(), lhs.size()) == 0);
+}
+
+/*! Call fn for each comma-separated, trimmed, non-empty token */
+template <typename FnT>
+void ForEachToken(const std::string& value, const FnT& fn) {
+    boost::string_ref remaining{value};
+    while(!remaining.empty()) {
+        const auto comma = remaining.find(',');
+        const auto token = Trim(remaining.substr(0, comma));
+        if (!token.empty()) {
+            fn(token);
+        }
+        if (comma == boost::string_ref::npos) {
+            break;
+        }
+        remaining.remove_prefix(comma + 1);
+    }
+}
+
+boost::optional<std::chrono::seconds> ParseSeconds(boost::string_ref value) {
+    if (!value.empty() && value.front() == '"' && value.size() >= 2 && value.back() == '"') {
+        value = value.substr(1, value.size() - 2);
+    }
+
+    if (value.empty()) {
+        return {};
+    }
+
+    constexpr int64_t max_seconds = 0x7fffffff; // RFC 9111, section 1.2.2
+    int64_t seconds = 0;
+    for(const auto ch : value) {
+        if (ch < '0' || ch > '9') {
+            return {};
+        }
+        seconds = std::min<int64_t>((seconds * 10) + (ch - '0'), max_seconds);
+    }
+
+    return std::chrono::seconds{seconds};
+}
+
+const std::string *Find(const headers_t& headers, const HeaderName& name) {
+    const auto it = headers.find(name);
+    return (it == headers.end()) ? nullptr : &it->second;
+}
+
+boost::optional<clock_t_::time_point> GetDate(const headers_t& headers, const HeaderName& name) {
+    if (const auto *value = Find(headers, name)) {
+        return ParseHttpDate(*value);
+    }
+    return {};
+}
+
+void SetFreshness(CachedResponse& entry) {
+    using std::chrono::seconds;
+    using std::chrono::duration_cast;
+
+    const auto cc = CacheControl::Parse(entry.headers);
+    const auto date = GetDate(entry.headers, header_names::date);
+    const auto date_value = date ? *date : entry.responseTime;
+
+    // Corrected initial age, RFC 9111, section 4.2.3
+    entry.initialAge = std::max(seconds{0}, duration_cast<seconds>(
+        entry.responseTime - date_value));
+    if (const auto *age = Find(entry.headers, header_names::age)) {
+        if (const auto age_value = ParseSeconds(Trim(*age))) {
+            entry.initialAge = std::max(entry.initialAge, *age_value);
+        }
+    }
+
+    entry.freshnessLifetime = seconds{0};
+    if (cc.noCache) {
+        return;
+    }
+
+    if (cc.maxAge) {
+        entry.freshnessLifetime = *cc.maxAge;
+        return;
+    }
+
+    if (const auto *expires = Find(entry.headers, header_names::expires)) {
+        // Invalid dates, like "0", means already expired
+        if (const auto expires_value = ParseHttpDate(*expires)) {
+            entry.freshnessLifetime = std::max(seconds{0},
+                duration_cast<seconds>(*expires_value - date_value));
+        }
+        return;
+    }
+
+    if (const auto last_modified = GetDate(entry.headers, header_names::last_modified)) {
+        if (*last_modified < date_value) {
+            entry.freshnessLifetime = std::min(max_heuristic_lifetime,
+                duration_cast<seconds>(date_value - *last_modified) / heuristic_fraction);
+        }
+    }
+}
+
+bool IsHeuristicallyCacheable(const int code) {
+    // RFC 9110, section 15.1. The redirects are handled by Execute()
+    switch(code) {
+        case 200:
+        case 203:
+        case 204:
+        case 300:
+        case 404:
+        case 405:
+        case 410:
+        case 414:
+        case 501:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*! The request carries credentials, so the response may be for that user only */
+bool HasCredentials(const find_request_header_fn_t& requestHeaders) {
+    static const std::array<std::string, 3> names = {
+        header_names::authorization.str(), "Proxy-Authorization", "Cookie"};
+
+    return any_of(names.begin(), names.end(), [&requestHeaders](const std::string& name) {
+        return requestHeaders(name) != nullptr;
+    });
+}
+
+bool IsHopByHop(const std::string& name) {
+    return IEquals(name, header_names::connection.str())
+        || IEquals(name, header_names::transfer_encoding.str())
+        || IEquals(name, header_names::content_length.str())
+        || IEquals(name, header_names::content_encoding.str());
+}
+
+} // anonymous namespace
+
+void CacheControl::Parse(const std::string& value) {
+    ForEachToken(value, [this](boost::string_ref directive) {
+        const auto eq = directive.find('=');
+        const auto name = Trim(directive.substr(0, eq));
+
+        if (IEquals(name, "no-store")) {
+            noStore = true;
+        } else if (IEquals(name, "no-cache")) {
+            noCache = true;
+        } else if (IEquals(name, "public")) {
+            isPublic = true;
+        } else if (IEquals(name, "must-revalidate")) {
+            mustRevalidate = true;
+        } else if (IEquals(name, "max-age") && (eq != boost::string_ref::npos)) {
+            const auto seconds = ParseSeconds(Trim(directive.substr(eq + 1)));
+            // An invalid max-age makes the response stale
+            maxAge = seconds ? *seconds : std::chrono::seconds{0};
+        } else if (IEquals(name, "s-maxage") && (eq != boost::string_ref::npos)) {
+            const auto seconds = ParseSeconds(Trim(directive.substr(eq + 1)));
+            sMaxAge = seconds ? *seconds : std::chrono::seconds{0};
+        }
+    });
+}
+
+CacheControl CacheControl::Parse(const headers_t& headers) {
+    CacheControl cc;
+    const auto range = headers.equal_range(header_names::cache_control);
+    for(auto it = range.first; it != range.second; ++it) {
+        cc.Parse(it->second);
+    }
+
+    if (range.first == range.second) {
+        if (const auto *pragma = Find(headers, header_names::pragma)) {
+            if (pragma->find("no-cache") != string::npos) {
+                cc.noCache = true;
+            }
+        }
+    }
+
+    return cc;
+}
+
+boost::optional<CachedResponse::clock_t::time_point>
+ParseHttpDate(const std::string& date) {
+    static const std::array<const char *, 12> months = {
+        "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    // IMF-fixdate: "Sun, 06 Nov 1994 08:49:37 GMT"
+    std::tm tm = {};
+    std::array<char, 4> month = {};
+    if (sscanf(date.c_str(), "%*3s, %2d %3s %4d %2d:%2d:%2d GMT",
+               &tm.tm_mday, month.data(), &tm.tm_year,
+               &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return {};
+    }
+
+    const auto it = find_if(months.begin(), months.end(), [&month](const char *name) {
+        return strcmp(name, month.data()) == 0;
+    });
+    if (it == months.end()) {
+        return {};
+    }
+
+    tm.tm_mon = static_cast<int>(it - months.begin());
+    tm.tm_year -= 1900;
+
+#ifdef _WIN32
+    const auto when = _mkgmtime(&tm);
+#else
+    const auto when = timegm(&tm);
+#endif
+    if (when == static_cast<time_t>(-1)) {
+        return {};
+    }
+
+    return clock_t_::from_time_t(when);
+}
+
+std::shared_ptr<CachedResponse>
+CreateCacheEntry(const Reply::HttpResponse& response,
+                 const headers_t& headers,
+                 const find_request_header_fn_t& requestHeaders,
+                 const CachedResponse::clock_t::time_point now) {
+
+    if (!IsHeuristicallyCacheable(response.status_code)) {
+        return {};
+    }
+
+    const auto cc = CacheControl::Parse(headers);
+    if (cc.noStore) {
+        return {};
+    }
+
+    if (!cc.isPublic && !cc.sMaxAge && !cc.mustRevalidate
+        && HasCredentials(requestHeaders)) {
+        return {};
+    }
+
+    const bool has_validator = (Find(headers, header_names::etag) != nullptr)
+        || (Find(headers, header_names::last_modified) != nullptr);
+    const bool has_lifetime = cc.maxAge
+        || (Find(headers, header_names::expires) != nullptr);
+    if (!has_validator && !has_lifetime) {
+        return {};
+    }
+
+    auto entry = make_shared<CachedResponse>();
+
+    bool vary_all = false;
+    const auto vary = headers.equal_range(header_names::vary);
+    for(auto it = vary.first; it != vary.second; ++it) {
+        ForEachToken(it->second, [&](boost::string_ref name) {
+            if (name == "*") {
+                vary_all = true;
+                return;
+            }
+            const std::string name_str{name.data(), name.size()};
+            const auto *value = requestHeaders(name_str);
+            entry->varyHeaders.emplace(name_str, value ? *value : std::string{});
+        });
+    }
+
+    // Vary: * never matches a later request
+    if (vary_all) {
+        return {};
+    }
+
+    entry->response = response;
+    entry->headers = GetStoredHeaders(headers);
+    entry->responseTime = now;
+    SetFreshness(*entry);
+    return entry;
+}
+
+void UpdateCacheEntry(CachedResponse& entry,
+                      const headers_t& headers,
+                      const CachedResponse::clock_t::time_point now) {
+
+    for(const auto& h : headers) {
+        if (!IsHopByHop(h.first)) {
+            entry.headers.erase(h.first);
+        }
+    }
+
+    for(const auto& h : headers) {
+        if (!IsHopByHop(h.first)) {
+            entry.headers.insert(h);
+        }
+    }
+
+    entry.responseTime = now;
+    SetFreshness(entry);
+}
+
+headers_t GetStoredHeaders(const headers_t& headers) {
+    headers_t stored;
+    for(const auto& h : headers) {
+        if (!IsHopByHop(h.first)) {
+            stored.insert(h);
+        }
+    }
+    return stored;
+}
+
+void SetStoredBody(CachedResponse& entry, std::shared_ptr<std::string> body,
+                   const bool complete) {
+    if (complete) {
+        entry.headers[header_names::content_length] = to_string(body->size());
+    } else {
+        entry.headers.erase(header_names::content_length.str());
+    }
+    entry.body = *body;
+    entry.bodyOwner = std::move(body);
+}
+
+bool VaryMatches(const CachedResponse& entry,
+                 const find_request_header_fn_t& requestHeaders) {
+    for(const auto& v : entry.varyHeaders) {
+        const auto *value = requestHeaders(v.first);
+        if (v.second != (value ? *value : std::string{})) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <boost/optional.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/ResponseCache.h"
+
+namespace restc_cpp {
+
+/*! The cache directives we care about (RFC 9111, section 5.2) */
+struct CacheControl {
+    bool noStore = false;
+    bool noCache = false;
+    bool isPublic = false;
+    bool mustRevalidate = false;
+    boost::optional<std::chrono::seconds> maxAge;
+    boost::optional<std::chrono::seconds> sMaxAge;
+
+    /*! Parse the Cache-Control and Pragma headers */
+    static CacheControl Parse(const headers_t& headers);
+
+    /*! Parse the value of one Cache-Control header */
+    void Parse(const std::string& value);
+};
+
+/*! Parse a HTTP date (IMF-fixdate)
+ *
+ * \return The time, or nothing if the date is invalid.
+ */
+boost::optional<CachedResponse::clock_t::time_point>
+ParseHttpDate(const std::string& date);
+
+/*! Returns the value of a request header, or nullptr */
+using find_request_header_fn_t = std::function<const std::string *(const std::string& name)>;
+
+/*! Create a cache entry for a reply to a GET request
+ *
+ * The body is not set.
+ *
+ * The cache can be shared by several clients, so a response to a
+ * request with credentials (Authorization, Proxy-Authorization or
+ * Cookie) is only stored if it is marked as shareable with public,
+ * s-maxage or must-revalidate (RFC 9111, section 3.5).
+ *
+ * \return The entry, or nullptr if the reply must not be stored.
+ */
+std::shared_ptr<CachedResponse>
+CreateCacheEntry(const Reply::HttpResponse& response,
+                 const headers_t& headers,
+                 const find_request_header_fn_t& requestHeaders,
+                 CachedResponse::clock_t::time_point now = CachedResponse::clock_t::now());
+
+/*! Update a copy of a stored response from a '304 Not Modified' reply */
+void UpdateCacheEntry(CachedResponse& entry,
+                      const headers_t& headers,
+                      CachedResponse::clock_t::time_point now = CachedResponse::clock_t::now());
+
+/*! Copy the headers of a reply, for a response that is stored with a decoded body
+ *
+ * The headers that describe the body on the wire (Content-Encoding,
+ * Transfer-Encoding, Content-Length) and Connection are left out.
+ */
+headers_t GetStoredHeaders(const headers_t& headers);
+
+/*! Set the decoded body of a stored response
+ *
+ * \param complete If false, the body is only the first part of it,
+ *      and there is no Content-Length for it.
+ */
+void SetStoredBody(CachedResponse& entry, std::shared_ptr<std::string> body,
+                   bool complete = true);
+
+/*! Check that the request headers named by Vary are the same as when
+ * the response was stored.
+ */
+bool VaryMatches(const CachedResponse& entry,
+                 const find_request_header_fn_t& requestHeaders);
+
+} // namespace
@@ -7,13 +7,14 @@
 #include "restc-cpp/Socket.h"
 #include "restc-cpp/DataWriter.h"
 #include "restc-cpp/logging.h"
+#include "restc-cpp/internals/RecycledObject.h"
 
 using namespace std;
 
 namespace restc_cpp {
 
 
-class ChunkedWriterImpl : public DataWriter {
+class ChunkedWriterImpl : public DataWriter, public RecycledObject<ChunkedWriterImpl> {
 public:
     ChunkedWriterImpl(add_header_fn_t fn, ptr_t&& source)
         : next_{std::move(source)},  add_header_fn_{std::move(fn)}
@@ -53,11 +54,14 @@ public:
         next_->Finish();
     }
 
+    void Flush() override {
+        next_->Flush();
+    }
+
     void SetHeaders(Request::headers_t& headers) override {
-        static const string transfer_encoding{"Transfer-Encoding"};
         static const string chunked{"chunked"};
 
-        headers[transfer_encoding] = chunked;
+        headers[header_names::transfer_encoding] = chunked;
 
         next_->SetHeaders(headers);
     }
@@ -75,21 +79,31 @@ private:
         
         // The data part of  buffers_ must be properly initialized
         assert(buffers_.size() > 1);
-        std::ostringstream hdr;
+
+        // "\r\n" + up to 16 hex digits + "\r\n"
+        char *p = header_.data() + header_.size();
+        *--p = '\n';
+        *--p = '\r';
+        static const char * const hex_digits{"0123456789abcdef"};
+        auto remaining = len;
+        do {
+            *--p = hex_digits[remaining & 0x0f];
+            remaining >>= 4;
+        } while(remaining != 0u);
 
         if (first_) {
             first_ = false;
         } else {
-            hdr << '\r' << '\n';
+            *--p = '\n';
+            *--p = '\r';
         }
 
-        hdr << hex << len << '\r' << '\n';
-        const auto header = hdr.str();
-
-        buffers_[0] = {header.c_str(), header.size()};
+        const auto header_len = static_cast<size_t>(header_.data() + header_.size() - p);
+        buffers_[0] = {p, header_len};
         next_->Write(buffers_);
     }
 
+    std::array<char, 2 + (sizeof(size_t) * 2) + 2> header_;
     bool first_ = true;
     unique_ptr<DataWriter> next_;
     write_buffers_t buffers_;
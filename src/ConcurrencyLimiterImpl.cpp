@@ -0,0 +1,257 @@
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/logging.h"
+
+#include "ConcurrencyLimiterImpl.h"
+#include "Suspend.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+size_t Capacity(const ConcurrencyLimiterImpl::Server& server) noexcept {
+    return max<size_t>(1, static_cast<size_t>(floor(server.limit)));
+}
+
+} // anonymous namespace
+
+ConcurrencyLimiterImpl::Permit::Permit(std::shared_ptr<ConcurrencyLimiterImpl> limiter,
+                                       std::shared_ptr<Server> server)
+: limiter_{std::move(limiter)}, server_{std::move(server)}
+{
+}
+
+ConcurrencyLimiterImpl::Permit::~Permit() {
+    Release(Outcome::NONE);
+}
+
+ConcurrencyLimiterImpl::Permit&
+ConcurrencyLimiterImpl::Permit::operator = (Permit&& v) noexcept {
+    if (this != &v) {
+        Release(Outcome::NONE);
+        limiter_ = std::move(v.limiter_);
+        server_ = std::move(v.server_);
+        start_ = v.start_;
+    }
+    return *this;
+}
+
+void ConcurrencyLimiterImpl::Permit::OnResponse(int statusCode) {
+    switch(statusCode) {
+        case 429: // Too Many Requests
+        case 502: // Bad Gateway
+        case 503: // Service Unavailable
+        case 504: // Gateway Timeout
+            Release(Outcome::OVERLOAD);
+            break;
+        default:
+            Release(Outcome::SUCCESS);
+    }
+}
+
+void ConcurrencyLimiterImpl::Permit::OnFailure() {
+    Release(Outcome::OVERLOAD);
+}
+
+void ConcurrencyLimiterImpl::Permit::Release(Outcome outcome) {
+    if (limiter_) {
+        auto limiter = std::move(limiter_);
+        auto server = std::move(server_);
+        limiter->Release(*server, start_, outcome);
+    }
+}
+
+ConcurrencyLimiterImpl::ConcurrencyLimiterImpl(const Config& config)
+: config_{config}
+{
+    if (config_.minLimit == 0 || config_.maxLimit < config_.minLimit) {
+        throw ConstraintException("ConcurrencyLimiter: minLimit must be > 0 and <= maxLimit");
+    }
+    if (config_.backoffRatio <= 0.0 || config_.backoffRatio >= 1.0) {
+        throw ConstraintException("ConcurrencyLimiter: backoffRatio must be > 0 and < 1");
+    }
+}
+
+std::size_t ConcurrencyLimiterImpl::GetLimit(const std::string& server) const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (const auto *s = FindServer(server)) {
+        return Capacity(*s);
+    }
+    return clamp(config_.initialLimit, config_.minLimit, config_.maxLimit);
+}
+
+std::size_t ConcurrencyLimiterImpl::GetInFlight(const std::string& server) const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (const auto *s = FindServer(server)) {
+        return s->inFlight;
+    }
+    return 0;
+}
+
+std::size_t ConcurrencyLimiterImpl::GetQueued(const std::string& server) const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (const auto *s = FindServer(server)) {
+        return s->queue.size();
+    }
+    return 0;
+}
+
+ConcurrencyLimiterImpl::Permit
+ConcurrencyLimiterImpl::Acquire(const std::string& server, Context& ctx) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    auto& s = servers_[server];
+    if (!s) {
+        s = make_shared<Server>(static_cast<double>(
+            clamp(config_.initialLimit, config_.minLimit, config_.maxLimit)));
+    }
+
+    if (s->inFlight < Capacity(*s)) {
+        ++s->inFlight;
+        return {shared_from_this(), s};
+    }
+
+    if (s->queue.size() >= config_.maxQueued) {
+        RESTC_CPP_LOG_DEBUG_("ConcurrencyLimiter: The queue for " << server << " is full");
+        throw ConcurrencyLimitException("The queue for " + server + " is full");
+    }
+
+    auto waiter = make_shared<Waiter>();
+    s->queue.push_back(waiter);
+    auto srv = s;
+    lock.unlock();
+
+    RESTC_CPP_LOG_TRACE_("ConcurrencyLimiter: Waiting for a permit to " << server);
+
+    boost::asio::steady_timer timer{ctx.GetClient().GetIoService()};
+    if (config_.maxQueueTimeMs > 0) {
+        timer.RESTC_CPP_STEADY_TIMER_EXPIRES_AFTER(
+            std::chrono::milliseconds{config_.maxQueueTimeMs});
+        timer.async_wait([self = shared_from_this(), srv, waiter]
+                         (const boost::system::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            std::function<void ()> resume;
+            {
+                std::lock_guard<std::mutex> const timer_lock{self->mutex_};
+                if (waiter->granted) {
+                    return;
+                }
+                waiter->timed_out = true;
+                auto& queue = srv->queue;
+                queue.erase(remove(queue.begin(), queue.end(), waiter), queue.end());
+                resume = std::move(waiter->resume);
+            }
+            if (resume) {
+                resume();
+            }
+        });
+    }
+
+    Suspend(ctx, [&](function<void ()> resume) {
+        std::unique_lock<std::mutex> park_lock{mutex_};
+        if (waiter->granted || waiter->timed_out) {
+            park_lock.unlock();
+            resume();
+            return;
+        }
+        waiter->resume = std::move(resume);
+    });
+
+    lock.lock();
+    timer.cancel();
+    if (waiter->granted) {
+        return {shared_from_this(), srv};
+    }
+
+    assert(waiter->timed_out);
+    RESTC_CPP_LOG_DEBUG_("ConcurrencyLimiter: Timed out waiting for a permit to " << server);
+    throw ConcurrencyLimitException("Timed out waiting for a permit to " + server);
+}
+
+void ConcurrencyLimiterImpl::Release(Server& server, clock_t::time_point start,
+                                     Outcome outcome) {
+    const auto now = clock_t::now();
+    std::lock_guard<std::mutex> const lock{mutex_};
+    assert(server.inFlight > 0);
+    const auto inFlight = server.inFlight--;
+
+    if (outcome == Outcome::SUCCESS) {
+        const auto latency = now - start;
+        server.baseline = min(server.baseline, latency);
+        server.windowMin = min(server.windowMin, latency);
+        if (++server.windowSamples >= config_.latencyWindow) {
+            // Forget the old baseline, in case the server got slower for good
+            server.baseline = server.windowMin;
+            server.windowMin = clock_t::duration::max();
+            server.windowSamples = 0;
+        }
+
+        if (chrono::duration<double>(latency).count()
+            > (chrono::duration<double>(server.baseline).count()
+               * config_.latencyTolerance)) {
+            Decrease(server, start);
+        } else if (static_cast<double>(inFlight) * 2 >= server.limit) {
+            // Only grow the limit when we use it. One step for each round.
+            server.limit = min(static_cast<double>(config_.maxLimit),
+                               server.limit + (1.0 / server.limit));
+        }
+    } else if (outcome == Outcome::OVERLOAD) {
+        Decrease(server, start);
+    }
+
+    GrantPermits(server);
+}
+
+const ConcurrencyLimiterImpl::Server *
+ConcurrencyLimiterImpl::FindServer(const std::string& server) const {
+    const auto it = servers_.find(server);
+    if (it == servers_.end()) {
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+void ConcurrencyLimiterImpl::Decrease(Server& server, clock_t::time_point start) {
+    // The requests that were sent before the last decrease saw the old limit
+    if (start < server.lastDecrease) {
+        return;
+    }
+    server.limit = max(static_cast<double>(config_.minLimit),
+                       server.limit * config_.backoffRatio);
+    server.lastDecrease = clock_t::now();
+    RESTC_CPP_LOG_TRACE_("ConcurrencyLimiter: Decreased the limit to " << server.limit);
+}
+
+void ConcurrencyLimiterImpl::GrantPermits(Server& server) {
+    while(!server.queue.empty() && (server.inFlight < Capacity(server))) {
+        auto waiter = std::move(server.queue.front());
+        server.queue.pop_front();
+        waiter->granted = true;
+        ++server.inFlight;
+        if (waiter->resume) {
+            auto resume = std::move(waiter->resume);
+            waiter->resume = nullptr;
+            resume();
+        }
+    }
+}
+
+ConcurrencyLimiter::ptr_t ConcurrencyLimiter::Create() {
+    return Create(Config{});
+}
+
+ConcurrencyLimiter::ptr_t ConcurrencyLimiter::Create(const Config& config) {
+    return make_shared<ConcurrencyLimiterImpl>(config);
+}
+
+} // namespace
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/ConcurrencyLimiter.h"
+
+namespace restc_cpp {
+
+class ConcurrencyLimiterImpl : public ConcurrencyLimiter,
+                               public std::enable_shared_from_this<ConcurrencyLimiterImpl> {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    enum class Outcome {
+        NONE, // Don't learn from the request
+        SUCCESS,
+        OVERLOAD
+    };
+
+    /*! A request waiting for a permit */
+    struct Waiter {
+        std::function<void ()> resume; // Set when the coroutine is suspended
+        bool granted = false;
+        bool timed_out = false;
+    };
+
+    /*! The state of one server. Guarded by the limiter's mutex. */
+    struct Server {
+        explicit Server(double initialLimit)
+        : limit{initialLimit}
+        {
+        }
+
+        double limit;
+        std::size_t inFlight = 0;
+        std::deque<std::shared_ptr<Waiter>> queue;
+        clock_t::duration baseline = clock_t::duration::max();
+        clock_t::duration windowMin = clock_t::duration::max();
+        std::size_t windowSamples = 0;
+        clock_t::time_point lastDecrease;
+    };
+
+    /*! The permission to have a request in flight to a server
+     *
+     * Report the outcome with OnResponse() or OnFailure(). A permit that
+     * is released without an outcome does not change the limit.
+     */
+    class Permit {
+    public:
+        Permit() = default;
+        Permit(std::shared_ptr<ConcurrencyLimiterImpl> limiter,
+               std::shared_ptr<Server> server);
+        Permit(const Permit&) = delete;
+        Permit(Permit&& v) noexcept = default;
+        ~Permit();
+
+        Permit& operator = (const Permit&) = delete;
+        Permit& operator = (Permit&& v) noexcept;
+
+        /*! The response headers are received */
+        void OnResponse(int statusCode);
+
+        /*! The request failed before we got a response */
+        void OnFailure();
+
+        explicit operator bool () const noexcept {
+            return static_cast<bool>(limiter_);
+        }
+
+    private:
+        void Release(Outcome outcome);
+
+        std::shared_ptr<ConcurrencyLimiterImpl> limiter_;
+        std::shared_ptr<Server> server_;
+        clock_t::time_point start_ = clock_t::now();
+    };
+
+    explicit ConcurrencyLimiterImpl(const Config& config);
+
+    std::size_t GetLimit(const std::string& server) const override;
+    std::size_t GetInFlight(const std::string& server) const override;
+    std::size_t GetQueued(const std::string& server) const override;
+
+    /*! Get a permit for a request to the server
+     *
+     * Suspends the coroutine while the server has as many requests in
+     * flight as its limit.
+     *
+     * \throws ConcurrencyLimitException if the queue is full, or we waited
+     *      too long.
+     */
+    Permit Acquire(const std::string& server, Context& ctx);
+
+private:
+    void Release(Server& server, clock_t::time_point start, Outcome outcome);
+
+    // The methods below are called with the mutex locked
+    const Server *FindServer(const std::string& server) const;
+    void Decrease(Server& server, clock_t::time_point start);
+    void GrantPermits(Server& server);
+
+    const Config config_;
+    std::unordered_map<std::string, std::shared_ptr<Server>> servers_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace
@@ -14,9 +14,13 @@
 #include "restc-cpp/error.h"
 #include "restc-cpp/internals/helpers.h"
 #include "restc-cpp/boost_compatibility.h"
+#include "restc-cpp/internals/RecycledObject.h"
 
 #include "ConnectionImpl.h"
 #include "SocketImpl.h"
+#include "Http2Session.h"
+#include "HttpPipeline.h"
+#include "LatencyTracker.h"
 
 #ifdef RESTC_CPP_WITH_TLS
 #   include "TlsSocketImpl.h"
@@ -150,7 +154,8 @@ public:
     };
 
     // Owns the connection
-    class ConnectionWrapper : public Connection
+    class ConnectionWrapper : public Connection,
+                              public RecycledObject<ConnectionWrapper>
     {
     public:
         using release_callback_t = std::function<void (const Entry::ptr_t&)>;
@@ -194,7 +199,7 @@ public:
 
     explicit ConnectionPoolImpl(RestClient& owner)
     : owner_{owner}, properties_{owner.GetConnectionProperties()}
-    , cache_cleanup_timer_{owner.GetIoService()}
+    , cache_cleanup_timer_{owner.GetIoService()}, http2_sessions_{owner}
     {
         on_release_ = [this](const Entry::ptr_t& entry) { OnRelease(entry); };
     }
@@ -204,17 +209,34 @@ public:
                 const Connection::Type connectionType,
                 bool newConnectionPlease) override {
 
-        if (!newConnectionPlease) {
-            if (auto conn = GetFromCache(ep, connectionType)) {
-                RESTC_CPP_LOG_TRACE_("Reusing connection from cache "
-                    << *conn);
-                return conn;
-            }
+        if (newConnectionPlease) {
+            return CreateNew(ep, connectionType);
+        }
 
-            if (!CanCreateNewConnection(ep, connectionType)) {
-                throw ConstraintException(
-                    "Cannot create connection - too many connections");
-            }
+        boost::system::error_code ec;
+        auto conn = GetConnection(ep, connectionType, ec);
+        if (ec) {
+            throw ConstraintException(
+                "Cannot create connection - too many connections");
+        }
+        return conn;
+    }
+
+    Connection::ptr_t
+    GetConnection(const boost::asio::ip::tcp::endpoint ep,
+                const Connection::Type connectionType,
+                boost::system::error_code& ec) override {
+
+        ec = {};
+        if (auto conn = GetFromCache(ep, connectionType)) {
+            RESTC_CPP_LOG_TRACE_("Reusing connection from cache "
+                << *conn);
+            return conn;
+        }
+
+        if (!CanCreateNewConnection(ep, connectionType)) {
+            ec = Error::TOO_MANY_CONNECTIONS;
+            return {};
         }
 
         return CreateNew(ep, connectionType);
@@ -230,6 +252,18 @@ public:
         return idle_.size();
     }
 
+    Http2SessionPool& GetHttp2Sessions() override {
+        return http2_sessions_;
+    }
+
+    HttpPipelinePool& GetHttpPipelines() override {
+        return http_pipelines_;
+    }
+
+    LatencyTracker& GetLatencies() override {
+        return latencies_;
+    }
+
     void Close() override {
         RESTC_CPP_LOG_TRACE_("ConnectionPoolImpl::Close: enter");
         if (!closed_) {
@@ -240,6 +274,8 @@ public:
                 cache_cleanup_timer_.cancel();
                 idle_.clear();
             });
+            http2_sessions_.Close();
+            http_pipelines_.Close();
         }
         RESTC_CPP_LOG_TRACE_("ConnectionPoolImpl::Close: leave");
     }
@@ -295,6 +331,8 @@ private:
             }
         }
 
+        http2_sessions_.CloseIdle(std::chrono::seconds(properties_->cacheTtlSeconds));
+
         RESTC_CPP_LOG_TRACE_("OnCacheCleanup: schedule next");
         ScheduleNextCacheCleanup();
         RESTC_CPP_LOG_TRACE_("OnCacheCleanup: leave");
@@ -454,6 +492,9 @@ private:
     const Request::Properties::ptr_t properties_;
     ConnectionWrapper::release_callback_t on_release_;
     boost::asio::steady_timer cache_cleanup_timer_;
+    Http2SessionPool http2_sessions_;
+    HttpPipelinePool http_pipelines_;
+    LatencyTracker latencies_;
 
     mutable std::mutex mutex_;
 }; // ConnectionPoolImpl
@@ -16,6 +16,20 @@ DataReaderStream::DataReaderStream(std::unique_ptr<DataReader>&& source)
 }
 
 
+void DataReaderStream::Finish() {
+    if (!source_) {
+        return;
+    }
+
+    // curr_ is at the last byte we have used
+    if ((curr_ != nullptr) && ((curr_ + 1) < end_)) {
+        source_->Unread({curr_ + 1, static_cast<size_t>(end_ - curr_ - 1)});
+        curr_ = end_ - 1;
+    }
+
+    source_->Finish();
+}
+
 void DataReaderStream::Fetch() {
     if (++curr_ >= end_) {
         auto buf = source_->ReadSome();
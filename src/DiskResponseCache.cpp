@@ -0,0 +1,483 @@
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/ResponseCache.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/logging.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+namespace fs = boost::filesystem;
+namespace bip = boost::interprocess;
+
+/* Each response is stored in its own segment file:
+ *
+ *   magic | header size (u64) | checksum (u64) | header | body
+ *
+ * The header holds the key and the metadata. The body is mapped into
+ * memory when the response is used, and served directly from the mapping.
+ *
+ * The checksum is a CRC-32 of the header and the body. The segments are
+ * not synced to disk, so after a power failure, a segment can have the
+ * right size, but data that never reached the disk.
+ */
+constexpr std::array<char, 4> magic = {'R', 'C', 'C', '2'};
+constexpr size_t prefix_size = magic.size() + (sizeof(uint64_t) * 2);
+constexpr size_t default_entry_fraction = 8;
+const std::string segment_suffix{".rcc"};
+const std::string temp_suffix{".tmp"};
+
+class Encoder {
+public:
+    explicit Encoder(std::string& out) : out_{out} {}
+
+    void Put(uint64_t value) {
+        out_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void Put(boost::string_ref value) {
+        Put(static_cast<uint64_t>(value.size()));
+        out_.append(value.data(), value.size());
+    }
+
+    void Put(const headers_t& headers) {
+        Put(static_cast<uint64_t>(headers.size()));
+        for(const auto& h : headers) {
+            Put(h.first);
+            Put(h.second);
+        }
+    }
+
+private:
+    std::string& out_;
+};
+
+class Decoder {
+public:
+    explicit Decoder(boost::string_ref in) : in_{in} {}
+
+    uint64_t GetU64() {
+        uint64_t value = 0;
+        memcpy(&value, Take(sizeof(value)).data(), sizeof(value));
+        return value;
+    }
+
+    int64_t GetI64() {
+        return static_cast<int64_t>(GetU64());
+    }
+
+    std::string GetString() {
+        const auto len = GetU64();
+        const auto value = Take(len);
+        return {value.data(), value.size()};
+    }
+
+    headers_t GetHeaders() {
+        headers_t headers;
+        for(auto count = GetU64(); count > 0; --count) {
+            auto name = GetString();
+            headers.emplace(std::move(name), GetString());
+        }
+        return headers;
+    }
+
+private:
+    boost::string_ref Take(uint64_t len) {
+        if (len > in_.size()) {
+            throw ParseException("DiskResponseCache: Truncated segment header");
+        }
+        const auto rval = in_.substr(0, static_cast<size_t>(len));
+        in_.remove_prefix(static_cast<size_t>(len));
+        return rval;
+    }
+
+    boost::string_ref in_;
+};
+
+std::string EncodeHeader(const std::string& key, const CachedResponse& response) {
+    using std::chrono::duration_cast;
+    using std::chrono::seconds;
+
+    std::string header;
+    Encoder enc{header};
+    enc.Put(key);
+    enc.Put(static_cast<uint64_t>(response.response.status_code));
+    enc.Put(response.response.reason_phrase);
+    enc.Put(static_cast<uint64_t>(duration_cast<seconds>(
+        response.responseTime.time_since_epoch()).count()));
+    enc.Put(static_cast<uint64_t>(response.initialAge.count()));
+    enc.Put(static_cast<uint64_t>(response.freshnessLifetime.count()));
+    enc.Put(response.headers);
+    enc.Put(response.varyHeaders);
+    enc.Put(static_cast<uint64_t>(response.body.size()));
+    return header;
+}
+
+uint64_t Checksum(boost::string_ref header, boost::string_ref body) {
+    boost::crc_32_type crc;
+    crc.process_bytes(header.data(), header.size());
+    crc.process_bytes(body.data(), body.size());
+    return crc.checksum();
+}
+
+/*! Keeps a segment mapped as long as a response refers to it */
+struct Mapping {
+    bip::file_mapping file;
+    bip::mapped_region region;
+};
+
+struct Segment {
+    std::string key;
+    std::shared_ptr<CachedResponse> response;
+};
+
+/*! Map a segment file and decode the header
+ *
+ * The body of the returned response points into the mapping.
+ *
+ * \param verify Check the checksum. This reads all of the segment.
+ */
+Segment LoadSegment(const fs::path& path, const bool verify) {
+    auto mapping = make_shared<Mapping>();
+    mapping->file = bip::file_mapping(path.string().c_str(), bip::read_only);
+    mapping->region = bip::mapped_region(mapping->file, bip::read_only);
+
+    const boost::string_ref data{static_cast<const char *>(mapping->region.get_address()),
+                                 mapping->region.get_size()};
+
+    if ((data.size() < prefix_size) || (memcmp(data.data(), magic.data(), magic.size()) != 0)) {
+        throw ParseException("DiskResponseCache: Not a cache segment");
+    }
+
+    Decoder prefix{data.substr(magic.size(), sizeof(uint64_t) * 2)};
+    const auto header_size = prefix.GetU64();
+    const auto checksum = prefix.GetU64();
+    if (header_size > (data.size() - prefix_size)) {
+        throw ParseException("DiskResponseCache: Truncated segment header");
+    }
+
+    Segment segment;
+    auto& response = segment.response = make_shared<CachedResponse>();
+
+    Decoder dec{data.substr(prefix_size, static_cast<size_t>(header_size))};
+    segment.key = dec.GetString();
+    response->response.status_code = static_cast<int>(dec.GetU64());
+    response->response.reason_phrase = dec.GetString();
+    response->responseTime = CachedResponse::clock_t::time_point{
+        std::chrono::seconds{dec.GetI64()}};
+    response->initialAge = std::chrono::seconds{dec.GetI64()};
+    response->freshnessLifetime = std::chrono::seconds{dec.GetI64()};
+    response->headers = dec.GetHeaders();
+    response->varyHeaders = dec.GetHeaders();
+
+    const auto body_offset = prefix_size + static_cast<size_t>(header_size);
+    const auto body_size = dec.GetU64();
+    if (body_size != (data.size() - body_offset)) {
+        throw ParseException("DiskResponseCache: Truncated segment body");
+    }
+
+    response->body = data.substr(body_offset);
+    if (verify && (Checksum(data.substr(prefix_size, static_cast<size_t>(header_size)),
+                            response->body) != checksum)) {
+        throw ParseException("DiskResponseCache: Checksum mismatch");
+    }
+    if (!response->body.empty()) {
+        mapping->region.advise(bip::mapped_region::advice_sequential);
+    }
+    response->bodyOwner = std::move(mapping);
+    return segment;
+}
+
+/*! A stable file name for a key (FNV-1a) */
+std::string SegmentName(const std::string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for(const auto ch : key) {
+        hash ^= static_cast<uint8_t>(ch);
+        hash *= 1099511628211ULL;
+    }
+
+    static const char * const hex{"0123456789abcdef"};
+    std::string name(sizeof(hash) * 2, '0');
+    for(auto it = name.rbegin(); it != name.rend(); ++it, hash >>= 4) {
+        *it = hex[hash & 0x0f];
+    }
+    return name + segment_suffix;
+}
+
+} // anonymous namespace
+
+class DiskResponseCache : public ResponseCache {
+public:
+    DiskResponseCache(fs::path directory, size_t maxBytes, size_t maxEntrySize)
+    : directory_{std::move(directory)}, max_bytes_{maxBytes}
+    , max_entry_size_{maxEntrySize ? maxEntrySize : (maxBytes / default_entry_fraction)}
+    {
+        fs::create_directories(directory_);
+        LoadIndex();
+    }
+
+    entry_t Lookup(const std::string& key) override {
+        const auto name = SegmentName(key);
+        uint64_t version = 0;
+
+        {
+            std::lock_guard<std::mutex> const lock{mutex_};
+
+            auto it = entries_.find(name);
+            if ((it == entries_.end()) || (it->second->key != key)) {
+                return {};
+            }
+
+            lru_.splice(lru_.begin(), lru_, it->second);
+
+            // Share the mapping between concurrent users of the response
+            if (auto loaded = it->second->loaded.lock()) {
+                return loaded;
+            }
+            version = it->second->version;
+        }
+
+        // Map the segment without blocking the other users of the cache
+        Segment segment;
+        try {
+            // It was verified when the cache was created, or written by us
+            segment = LoadSegment(directory_ / name, false);
+        } catch(const std::exception& ex) {
+            RESTC_CPP_LOG_WARN_("DiskResponseCache: Failed to load "
+                << (directory_ / name) << ": " << ex.what());
+        }
+
+        std::lock_guard<std::mutex> const lock{mutex_};
+
+        // The segment may have been replaced or removed while we loaded it
+        auto it = entries_.find(name);
+        if ((it == entries_.end()) || (it->second->version != version)) {
+            return {};
+        }
+
+        if (auto loaded = it->second->loaded.lock()) {
+            return loaded;
+        }
+
+        if (segment.response && (segment.key == key)) {
+            it->second->loaded = segment.response;
+            return segment.response;
+        }
+
+        EraseLocked(it);
+        return {};
+    }
+
+    void Store(const std::string& key, entry_t response) override {
+        if (response->body.size() > max_entry_size_) {
+            Remove(key);
+            return;
+        }
+
+        const auto name = SegmentName(key);
+        const auto path = directory_ / name;
+        const auto temp_path = directory_ / (name + "." + to_string(++temp_counter_) + temp_suffix);
+
+        const auto header = EncodeHeader(key, *response);
+        uint64_t size = 0;
+        {
+            std::ofstream file{temp_path.string(), ios::binary | ios::trunc};
+            const uint64_t header_size = header.size();
+            const uint64_t checksum = Checksum(header, response->body);
+            file.write(magic.data(), magic.size());
+            file.write(reinterpret_cast<const char *>(&header_size), sizeof(header_size));
+            file.write(reinterpret_cast<const char *>(&checksum), sizeof(checksum));
+            file.write(header.data(), static_cast<std::streamsize>(header.size()));
+            file.write(response->body.data(), static_cast<std::streamsize>(response->body.size()));
+            file.close();
+            size = prefix_size + header.size() + response->body.size();
+
+            if (!file) {
+                RESTC_CPP_LOG_WARN_("DiskResponseCache: Failed to write " << temp_path);
+                boost::system::error_code ec;
+                fs::remove(temp_path, ec);
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> const lock{mutex_};
+
+        // Atomic replacement, so that a reader never sees a partial segment.
+        // The segment is not synced to disk. If the system goes down before
+        // it is written out, LoadIndex() finds it by its size or checksum,
+        // and removes it.
+        boost::system::error_code ec;
+        fs::rename(temp_path, path, ec);
+        if (ec) {
+            RESTC_CPP_LOG_WARN_("DiskResponseCache: Failed to rename " << temp_path
+                << ": " << ec.message());
+            fs::remove(temp_path, ec);
+            return;
+        }
+
+        auto it = entries_.find(name);
+        if (it != entries_.end()) {
+            size_ -= it->second->size;
+            it->second->key = key;
+            it->second->size = size;
+            it->second->loaded = response;
+            it->second->version = ++version_;
+            lru_.splice(lru_.begin(), lru_, it->second);
+        } else {
+            lru_.push_front({name, key, size, response, ++version_});
+            entries_.emplace(name, lru_.begin());
+        }
+
+        size_ += size;
+        Evict();
+    }
+
+    void Remove(const std::string& key) override {
+        std::lock_guard<std::mutex> const lock{mutex_};
+
+        auto it = entries_.find(SegmentName(key));
+        if ((it != entries_.end()) && (it->second->key == key)) {
+            EraseLocked(it);
+        }
+    }
+
+    void Clear() override {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        while(!lru_.empty()) {
+            EraseLocked(entries_.find(lru_.back().name));
+        }
+    }
+
+    size_t GetMaxEntrySize() const noexcept override {
+        return max_entry_size_;
+    }
+
+    size_t GetSize() const override {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        return size_;
+    }
+
+private:
+    struct Item {
+        std::string name;
+        std::string key;
+        uint64_t size = 0;
+        std::weak_ptr<const CachedResponse> loaded;
+        uint64_t version = 0; // Changes when the segment is replaced
+    };
+
+    using lru_t = std::list<Item>;
+    using index_t = std::unordered_map<std::string, lru_t::iterator>;
+
+    /*! Build the index from the segments left by earlier runs
+     *
+     * The most recently written segments are the last to be evicted.
+     */
+    void LoadIndex() {
+        struct Found {
+            std::time_t written;
+            Item item;
+        };
+        std::vector<Found> found;
+
+        for(const auto& de : fs::directory_iterator(directory_)) {
+            const auto& path = de.path();
+            const auto ext = path.extension().string();
+            boost::system::error_code ec;
+
+            if (ext == temp_suffix) {
+                // Left by a crash while storing
+                fs::remove(path, ec);
+                continue;
+            }
+
+            if ((ext != segment_suffix) || !fs::is_regular_file(path, ec)) {
+                continue;
+            }
+
+            try {
+                auto segment = LoadSegment(path, true);
+                if (path.filename().string() != SegmentName(segment.key)) {
+                    throw ParseException("DiskResponseCache: Misplaced segment");
+                }
+                found.push_back({fs::last_write_time(path), {
+                    path.filename().string(), std::move(segment.key),
+                    fs::file_size(path), {}}});
+            } catch(const std::exception& ex) {
+                RESTC_CPP_LOG_WARN_("DiskResponseCache: Removing invalid segment "
+                    << path << ": " << ex.what());
+                fs::remove(path, ec);
+            }
+        }
+
+        sort(found.begin(), found.end(), [](const Found& left, const Found& right) {
+            return left.written > right.written;
+        });
+
+        for(auto& f : found) {
+            size_ += f.item.size;
+            lru_.push_back(std::move(f.item));
+            entries_.emplace(lru_.back().name, std::prev(lru_.end()));
+        }
+
+        RESTC_CPP_LOG_DEBUG_("DiskResponseCache: Loaded " << lru_.size()
+            << " responses (" << size_ << " bytes) from " << directory_);
+
+        Evict();
+    }
+
+    // Must be called with the mutex locked
+    void EraseLocked(index_t::iterator it) {
+        boost::system::error_code ec;
+
+        // Mapped segments stay readable after the file is removed (on POSIX)
+        fs::remove(directory_ / it->first, ec);
+        size_ -= it->second->size;
+        lru_.erase(it->second);
+        entries_.erase(it);
+    }
+
+    // Must be called with the mutex locked
+    void Evict() {
+        while((size_ > max_bytes_) && !lru_.empty()) {
+            RESTC_CPP_LOG_TRACE_("DiskResponseCache: Evicting " << lru_.back().key);
+            EraseLocked(entries_.find(lru_.back().name));
+        }
+    }
+
+    const fs::path directory_;
+    const size_t max_bytes_;
+    const size_t max_entry_size_;
+    uint64_t size_ = 0;
+    lru_t lru_;
+    index_t entries_;
+    uint64_t version_ = 0;
+    std::atomic_uint64_t temp_counter_{0};
+    mutable std::mutex mutex_;
+};
+
+ResponseCache::ptr_t
+ResponseCache::CreateDiskCache(const boost::filesystem::path& directory,
+                               size_t maxBytes, size_t maxEntrySize) {
+    return make_shared<DiskResponseCache>(directory, maxBytes, maxEntrySize);
+}
+
+} // namespace
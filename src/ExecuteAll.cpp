@@ -0,0 +1,155 @@
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <mutex>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/logging.h"
+
+#include "BufferedReplyImpl.h"
+#include "Suspend.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+/*! The state shared by the caller and the workers of ExecuteAll() */
+struct Batch {
+    explicit Batch(const Context::requests_t& allRequests)
+    : requests{allRequests}
+    {
+    }
+
+    // Called with the mutex locked
+    void Notify() {
+        if (waiter) {
+            auto resume = std::move(waiter);
+            waiter = nullptr;
+            resume();
+        }
+    }
+
+    const Context::requests_t& requests; // Owned by the caller, who waits for the workers
+    size_t next = 0; // The next request to execute
+    size_t workers = 0; // Running
+    bool stop = false;
+    std::deque<Context::BatchResult> done; // Not yet given to the caller
+    std::function<void ()> waiter; // Resumes the caller
+    std::mutex mutex;
+};
+
+/*! Execute the requests one by one, until there are no more */
+void RunWorker(Batch& batch, Context& ctx) {
+    while(true) {
+        Context::BatchResult result;
+        {
+            std::lock_guard<std::mutex> const lock{batch.mutex};
+            if (batch.stop || (batch.next == batch.requests.size())) {
+                --batch.workers;
+                batch.Notify();
+                return;
+            }
+            result.index = batch.next++;
+        }
+
+        try {
+            auto& request = batch.requests[result.index];
+            assert(request);
+            result.reply = request->Execute(ctx, result.ec);
+            if (result.reply) {
+                // The reply can not be read from this coroutine when we are done.
+                // The limit is documented on Context::ExecuteAll().
+                result.reply = BufferedReplyImpl::Detach(std::move(result.reply),
+                                                         RESTC_CPP_SANE_DATA_LIMIT);
+            }
+        } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+            result.reply.reset();
+            result.ec = ToErrorCode(std::current_exception());
+        }
+
+        RESTC_CPP_LOG_TRACE_("ExecuteAll: Request #" << result.index << " is done: "
+                             << result.ec.message());
+
+        std::lock_guard<std::mutex> const lock{batch.mutex};
+        batch.done.push_back(std::move(result));
+        batch.Notify();
+    }
+}
+
+} // anonymous namespace
+
+std::vector<Context::BatchResult> Context::ExecuteAll(const requests_t& requests,
+                                                       size_t maxConcurrency) {
+    std::vector<BatchResult> results(requests.size());
+    ExecuteAsCompleted(requests, [&results](BatchResult&& result) {
+        const auto index = result.index;
+        results[index] = std::move(result);
+    }, maxConcurrency);
+    return results;
+}
+
+void Context::ExecuteAsCompleted(const requests_t& requests,
+                                 const on_result_fn_t& onResult,
+                                 size_t maxConcurrency) {
+    if (requests.empty()) {
+        return;
+    }
+
+    if (maxConcurrency == 0) {
+        maxConcurrency = max<size_t>(
+            1, GetClient().GetConnectionProperties()->cacheMaxConnectionsPerEndpoint);
+    }
+
+    auto batch = make_shared<Batch>(requests);
+    batch->workers = min(maxConcurrency, requests.size());
+    for(size_t i = 0; i < batch->workers; ++i) {
+        GetClient().Process([batch](Context& ctx) {
+            RunWorker(*batch, ctx);
+        });
+    }
+
+    std::exception_ptr error;
+    bool finished = false;
+    while(!finished) {
+        Suspend(*this, [&batch](function<void ()> resume) {
+            std::unique_lock<std::mutex> lock{batch->mutex};
+            if (!batch->done.empty() || (batch->workers == 0)) {
+                lock.unlock();
+                resume();
+                return;
+            }
+            batch->waiter = std::move(resume);
+        });
+
+        decltype(batch->done) done;
+        {
+            std::lock_guard<std::mutex> const lock{batch->mutex};
+            done.swap(batch->done);
+            finished = batch->workers == 0;
+        }
+
+        for(auto& result : done) {
+            if (error) {
+                break;
+            }
+            try {
+                onResult(std::move(result));
+            } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+                // Wait for the requests in flight. They use the requests.
+                error = std::current_exception();
+                std::lock_guard<std::mutex> const lock{batch->mutex};
+                batch->stop = true;
+            }
+        }
+    }
+
+    if (error) {
+        rethrow_exception(error);
+    }
+}
+
+} // namespace
@@ -0,0 +1,77 @@
+
+#include <cassert>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/logging.h"
+
+#include "RetryPolicyImpl.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+std::unique_ptr<Reply> ExecuteWithRetries(Context& ctx, RetryPolicyImpl& policy,
+                                          const bool idempotent,
+                                          const std::function<std::unique_ptr<Reply> ()>& attempt,
+                                          boost::system::error_code *ec,
+                                          const std::function<std::string ()>& describe) {
+    constexpr auto http_400 = 400;
+
+    policy.OnRequest();
+    for(size_t retries = 0;; ++retries) {
+        unique_ptr<Reply> reply;
+        std::exception_ptr error;
+        boost::system::error_code attempt_ec;
+
+        try {
+            reply = attempt();
+        } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+            error = std::current_exception();
+            attempt_ec = ToErrorCode(error);
+        }
+
+        boost::optional<std::string> retry_after;
+        if (reply) {
+            if (reply->GetResponseCode() >= http_400) {
+                attempt_ec = make_http_error_code(reply->GetResponseCode());
+                retry_after = reply->GetHeader(header_names::retry_after);
+            }
+        } else if (!error) {
+            assert(ec);
+            attempt_ec = *ec;
+        }
+
+        const auto delay = attempt_ec
+            ? policy.GetRetryDelay(retries, idempotent, attempt_ec, retry_after)
+            : boost::none;
+
+        if (!delay) {
+            if (error) {
+                rethrow_exception(error);
+            }
+            return reply;
+        }
+
+        RESTC_CPP_LOG_DEBUG_("Retrying " << describe()
+                             << " in " << delay->count() << " ms after \""
+                             << attempt_ec.message() << "\" (retry #" << (retries + 1) << ")");
+
+        if (reply) {
+            // Let the connection be re-used
+            try {
+                reply->fetchAndIgnore();
+            } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+                // The connection is closed instead
+            }
+            reply.reset();
+        }
+        if (ec) {
+            *ec = {};
+        }
+
+        ctx.Sleep(*delay);
+    }
+}
+
+} // namespace
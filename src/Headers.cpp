@@ -0,0 +1,135 @@
+
+#include <algorithm>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/Headers.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace header_names {
+const HeaderName accept_encoding{"Accept-Encoding"};
+const HeaderName age{"Age"};
+const HeaderName authorization{"Authorization"};
+const HeaderName cache_control{"Cache-Control"};
+const HeaderName connection{"Connection"};
+const HeaderName content_encoding{"Content-Encoding"};
+const HeaderName content_length{"Content-Length"};
+const HeaderName content_type{"Content-Type"};
+const HeaderName date{"Date"};
+const HeaderName etag{"ETag"};
+const HeaderName expires{"Expires"};
+const HeaderName host{"Host"};
+const HeaderName if_modified_since{"If-Modified-Since"};
+const HeaderName if_none_match{"If-None-Match"};
+const HeaderName last_modified{"Last-Modified"};
+const HeaderName location{"Location"};
+const HeaderName pragma{"Pragma"};
+const HeaderName retry_after{"Retry-After"};
+const HeaderName transfer_encoding{"Transfer-Encoding"};
+const HeaderName vary{"Vary"};
+} // namespace header_names
+
+HeaderName::HeaderName(std::string name)
+    : name_{std::move(name)}, hash_{Headers::Hash(name_)}
+{
+}
+
+Headers::Headers(std::initializer_list<value_type> init)
+{
+    for(const auto& h : init) {
+        insert(h);
+    }
+}
+
+Headers::size_type Headers::IndexOf(const std::string& key,
+                                    const std::size_t hash) const noexcept {
+    const auto len = hashes_.size();
+    for(size_type i = 0; i < len; ++i) {
+        if (hashes_[i] == hash) {
+            const auto& name = entries_[i].get().first;
+            if ((name.size() == key.size())
+                && (strcasecmp(name.c_str(), key.c_str()) == 0)) {
+                return i;
+            }
+        }
+    }
+    return len;
+}
+
+pair<Headers::size_type, Headers::size_type>
+Headers::EqualRange(const std::string& key) const noexcept {
+    const auto hash = Hash(key);
+    auto first = IndexOf(key, hash);
+    auto last = first;
+    while((last < size()) && (hashes_[last] == hash)
+          && ciEqLibC()(entries_[last].get().first, key)) {
+        ++last;
+    }
+
+    return {first, last};
+}
+
+Headers::size_type Headers::LowerBound(const std::string& key) const noexcept {
+    const auto it = std::lower_bound(entries_.begin(), entries_.end(), key,
+        [](const Entry& entry, const std::string& k) {
+            return ciLessLibC()(entry.get().first, k);
+        });
+    return static_cast<size_type>(it - entries_.begin());
+}
+
+Headers::size_type Headers::UpperBound(const std::string& key) const noexcept {
+    const auto it = std::upper_bound(entries_.begin(), entries_.end(), key,
+        [](const std::string& k, const Entry& entry) {
+            return ciLessLibC()(k, entry.get().first);
+        });
+    return static_cast<size_type>(it - entries_.begin());
+}
+
+Headers::iterator Headers::Insert(value_type&& value) {
+    // After any headers with the same name
+    const auto pos = Offset(UpperBound(value.first));
+    hashes_.insert(hashes_.begin() + pos, Hash(value.first));
+    return iterator{entries_.insert(entries_.begin() + pos, Entry{std::move(value)})};
+}
+
+Headers::size_type Headers::erase(const std::string& key) {
+    const auto range = EqualRange(key);
+    const auto first = Offset(range.first);
+    const auto count = Offset(range.second - range.first);
+    if (count > 0) {
+        entries_.erase(entries_.begin() + first, entries_.begin() + first + count);
+        hashes_.erase(hashes_.begin() + first, hashes_.begin() + first + count);
+    }
+    return static_cast<size_type>(count);
+}
+
+Headers::iterator Headers::erase(const_iterator pos) {
+    const auto index = pos - cbegin();
+    hashes_.erase(hashes_.begin() + index);
+    return iterator{entries_.erase(entries_.begin() + index)};
+}
+
+std::string& Headers::Get(const std::string& key, const std::size_t hash) {
+    const auto index = IndexOf(key, hash);
+    if (index < size()) {
+        return entries_[index].get().second;
+    }
+
+    const auto pos = Offset(LowerBound(key));
+    hashes_.insert(hashes_.begin() + pos, hash);
+    return entries_.insert(entries_.begin() + pos,
+                           Entry{value_type{key, std::string{}}})->get().second;
+}
+
+Headers& Headers::operator += (const Headers& nh) {
+    for(size_type i = 0; i < nh.size(); ++i) {
+        const auto& entry = nh.entries_[i].get();
+        Get(entry.first, nh.hashes_[i]) = entry.second;
+    }
+
+    return *this;
+}
+
+} // namespace
@@ -0,0 +1,211 @@
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/logging.h"
+#include "restc-cpp/Socket.h"
+
+#include "BufferedReplyImpl.h"
+#include "Hedging.h"
+#include "Suspend.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+/*! Read the body into memory
+ *
+ * \return nullptr if the body is larger than maxBodySize.
+ */
+std::unique_ptr<Reply> ReadIntoMemory(std::unique_ptr<Reply> reply, const size_t maxBodySize) {
+    // Don't read what we will throw away
+    if (const auto len = reply->GetHeader(header_names::content_length.str())) {
+        if (strtoull(len->c_str(), nullptr, 10) > maxBodySize) {
+            return {};
+        }
+    }
+
+    try {
+        return BufferedReplyImpl::Detach(std::move(reply), maxBodySize);
+    } catch(const ConstraintException&) {
+        return {};
+    }
+}
+
+} // anonymous namespace
+
+std::unique_ptr<Reply> Hedge::Execute(Context& ctx, const int delayMs,
+                                      const create_attempt_fn_t& createAttempt,
+                                      boost::system::error_code *ec,
+                                      const size_t maxBodySize) {
+    auto hedge = make_shared<Hedge>(ec != nullptr);
+    hedge->Start(ctx, createAttempt(*hedge, 0), maxBodySize);
+    if (!hedge->Wait(ctx, delayMs)) {
+        hedge->Start(ctx, createAttempt(*hedge, 1), maxBodySize);
+        hedge->Wait(ctx, 0);
+    }
+
+    std::lock_guard<std::mutex> const lock{hedge->mutex_};
+    if (hedge->reply_) {
+        return std::move(hedge->reply_);
+    }
+    if (hedge->error_) {
+        rethrow_exception(hedge->error_);
+    }
+    assert(ec && hedge->ec_);
+    *ec = hedge->ec_;
+    return {};
+}
+
+int Hedge::GetDelayMs(const Request::Properties::Hedging& hedging,
+                      LatencyTracker& latencies, const std::string& origin) {
+    if (hedging.percentile > 0) {
+        if (const auto latency = latencies.GetPercentile(origin, hedging.percentile)) {
+            return max(1, static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(*latency).count()));
+        }
+    }
+
+    return max(0, hedging.delayMs);
+}
+
+void Hedge::Register(const size_t index, Connection::ptr_t connection,
+                     Http2Stream::ptr_t stream) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    auto& attempt = attempts_.at(index);
+    if (attempt.cancelled) {
+        throw RestcCppException("The hedged request was cancelled");
+    }
+    attempt.connection = std::move(connection);
+    attempt.stream = std::move(stream);
+}
+
+void Hedge::Start(Context& ctx, attempt_fn_t run, const size_t maxBodySize) {
+    size_t index = 0;
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        index = started_++;
+        attempts_.at(index).run = std::move(run);
+        ++running_;
+    }
+
+    ctx.GetClient().Process([self = shared_from_this(), index, maxBodySize](Context& actx) {
+        self->Run(index, maxBodySize, actx);
+    });
+}
+
+void Hedge::Run(const size_t index, const size_t maxBodySize, Context& ctx) {
+    boost::system::error_code ec;
+    unique_ptr<Reply> reply;
+    std::exception_ptr error;
+    bool won = false;
+    try {
+        // run is not changed while the attempt runs
+        auto headers_reply = attempts_.at(index).run(ctx, report_in_ec_ ? &ec : nullptr);
+        if (headers_reply) {
+            {
+                std::lock_guard<std::mutex> const lock{mutex_};
+                auto& attempt = attempts_.at(index);
+                attempt.connection.reset();
+                attempt.stream.reset();
+                if (!decided_) {
+                    decided_ = won = true;
+                    for(size_t i = 0; i < started_; ++i) {
+                        if (i != index) {
+                            Cancel(attempts_.at(i));
+                        }
+                    }
+                }
+            }
+
+            if (won) {
+                // The reply can not be read from this coroutine when we are done
+                reply = ReadIntoMemory(std::move(headers_reply), maxBodySize);
+                if (!reply) {
+                    RESTC_CPP_LOG_DEBUG_("Hedge: The body is larger than "
+                                         << maxBodySize << " bytes");
+                    error = make_exception_ptr(HedgedReplyTooLargeException{});
+                }
+            }
+        }
+    } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+        error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> const lock{mutex_};
+    auto& attempt = attempts_.at(index);
+    attempt.connection.reset();
+    attempt.stream.reset();
+    --running_;
+    if (reply) {
+        reply_ = std::move(reply);
+    } else if (won || (!error_ && !ec_)) {
+        error_ = error;
+        ec_ = ec;
+    }
+    Notify();
+}
+
+bool Hedge::Wait(Context& ctx, const int timeoutMs) {
+    auto timed_out = make_shared<bool>(false);
+    boost::asio::steady_timer timer{ctx.GetClient().GetIoService()};
+    if (timeoutMs > 0) {
+        timer.RESTC_CPP_STEADY_TIMER_EXPIRES_AFTER(std::chrono::milliseconds{timeoutMs});
+        timer.async_wait([self = shared_from_this(), timed_out](const boost::system::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            std::lock_guard<std::mutex> const lock{self->mutex_};
+            *timed_out = true;
+            self->Notify();
+        });
+    }
+
+    while(true) {
+        Suspend(ctx, [&](function<void ()> resume) {
+            std::unique_lock<std::mutex> lock{mutex_};
+            if (*timed_out || IsDone()) {
+                lock.unlock();
+                resume();
+                return;
+            }
+            waiter_ = std::move(resume);
+        });
+
+        std::lock_guard<std::mutex> const lock{mutex_};
+        if (IsDone()) {
+            timer.cancel();
+            return true;
+        }
+        if (*timed_out) {
+            return false;
+        }
+    }
+}
+
+void Hedge::Cancel(Attempt& attempt) {
+    attempt.cancelled = true;
+    if (attempt.connection) {
+        attempt.connection->GetSocket().Close();
+    }
+    if (attempt.stream) {
+        attempt.stream->Cancel();
+    }
+}
+
+void Hedge::Notify() {
+    if (waiter_) {
+        auto resume = std::move(waiter_);
+        waiter_ = nullptr;
+        resume();
+    }
+}
+
+} // namespace
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/Connection.h"
+#include "restc-cpp/error.h"
+
+#include "Http2Session.h"
+#include "LatencyTracker.h"
+
+namespace restc_cpp {
+
+/*! The body of the reply to a hedged request is too large to be read
+ * into memory. The request can be sent again without hedging.
+ */
+struct HedgedReplyTooLargeException : public ConstraintException
+{
+    HedgedReplyTooLargeException()
+    : ConstraintException("The reply to the hedged request is too large") {}
+};
+
+/*! A request that is sent again on another connection if the response is slow
+ *
+ * The attempts run in coroutines of their own. The first one to get
+ * the response headers wins, and the other is cancelled.
+ *
+ * The reply of the winner can not be read from the caller's coroutine,
+ * so its body is read into memory before it is returned.
+ */
+class Hedge : public std::enable_shared_from_this<Hedge> {
+public:
+    using ptr_t = std::shared_ptr<Hedge>;
+
+    /*! Send an attempt, and get the reply when the response headers are received
+     *
+     * It is called in the coroutine of the attempt. If ec is set, errors
+     * are reported in it, and nullptr is returned.
+     */
+    using attempt_fn_t = std::function<std::unique_ptr<Reply> (
+        Context& ctx, boost::system::error_code *ec)>;
+
+    /*! Make the attempt with the index (0 or 1)
+     *
+     * The request of the attempt must call Register() when it has its
+     * connection or stream.
+     */
+    using create_attempt_fn_t = std::function<attempt_fn_t (Hedge& hedge, size_t index)>;
+
+    explicit Hedge(bool reportInEc)
+    : report_in_ec_{reportInEc}
+    {
+    }
+
+    Hedge(const Hedge&) = delete;
+    Hedge& operator = (const Hedge&) = delete;
+
+    /*! Send the request, and send it again if there is no response after delayMs
+     *
+     * \param ec If set, errors are reported in it.
+     * \return The reply of the winner. nullptr if it failed, and the
+     *      error is reported in ec.
+     * \throws HedgedReplyTooLargeException If the body is larger than
+     *      maxBodySize.
+     */
+    static std::unique_ptr<Reply> Execute(Context& ctx, int delayMs,
+                                          const create_attempt_fn_t& createAttempt,
+                                          boost::system::error_code *ec,
+                                          size_t maxBodySize = RESTC_CPP_SANE_DATA_LIMIT);
+
+    /*! The delay before the second attempt is sent, or 0 to not hedge
+     *
+     * \param latencies The recent response times, for hedging.percentile
+     */
+    static int GetDelayMs(const Request::Properties::Hedging& hedging,
+                          LatencyTracker& latencies, const std::string& origin);
+
+    /*! Let the other attempt cancel this one while it waits for the response
+     *
+     * \throws RestcCppException if the attempt is already cancelled.
+     */
+    void Register(size_t index, Connection::ptr_t connection, Http2Stream::ptr_t stream);
+
+private:
+    struct Attempt {
+        attempt_fn_t run; // Owns the request of the attempt
+        Connection::ptr_t connection; // While we wait for the HTTP/1.1 response
+        Http2Stream::ptr_t stream; // While we wait for the HTTP/2 response
+        bool cancelled = false;
+    };
+
+    void Start(Context& ctx, attempt_fn_t run, size_t maxBodySize);
+    void Run(size_t index, size_t maxBodySize, Context& ctx);
+
+    /*! Wait for the hedged request to complete
+     *
+     * \param timeoutMs Max time to wait. 0 waits until it is complete.
+     * \return false if we timed out
+     */
+    bool Wait(Context& ctx, int timeoutMs);
+
+    // The methods below are called with the mutex locked
+
+    void Cancel(Attempt& attempt);
+
+    bool IsDone() const noexcept {
+        return reply_ || (running_ == 0);
+    }
+
+    void Notify();
+
+    const bool report_in_ec_;
+    std::array<Attempt, 2> attempts_;
+    size_t started_ = 0;
+    size_t running_ = 0;
+    bool decided_ = false; // An attempt got the response headers first
+    std::unique_ptr<Reply> reply_; // From the winner
+    std::exception_ptr error_; // From the winner, or the first attempt that failed
+    boost::system::error_code ec_; // Like error_, when it was reported in an error_code
+    std::function<void ()> waiter_; // Resumes the caller
+    std::mutex mutex_;
+};
+
+} // namespace
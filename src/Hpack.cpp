@@ -0,0 +1,438 @@
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <numeric>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+
+#include "Hpack.h"
+
+using namespace std;
+
+namespace restc_cpp {
+namespace hpack {
+
+namespace {
+
+// RFC 7541, Appendix A
+const std::array<Table::entry_t, 61> static_table = {{
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""}
+}};
+
+// The length in bits of the Huffman code for each symbol (RFC 7541,
+// Appendix B). The code is canonical, so the codes follow from the
+// lengths.
+constexpr std::array<std::uint8_t, 257> huffman_code_lengths = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30
+};
+
+constexpr size_t huffman_max_bits = 30;
+constexpr size_t huffman_eos = 256;
+
+/*! Tables for canonical Huffman decoding */
+struct HuffmanDecodeTables {
+    HuffmanDecodeTables() {
+        std::iota(symbols.begin(), symbols.end(), 0);
+        std::stable_sort(symbols.begin(), symbols.end(), [](auto a, auto b) {
+            return huffman_code_lengths[a] < huffman_code_lengths[b];
+        });
+
+        for(const auto len : huffman_code_lengths) {
+            ++count[len];
+        }
+
+        std::uint32_t code = 0;
+        std::uint16_t index = 0;
+        for(size_t len = 1; len <= huffman_max_bits; ++len) {
+            first_code[len] = code;
+            first_index[len] = index;
+            code = (code + count[len]) << 1;
+            index += count[len];
+        }
+    }
+
+    std::array<std::uint16_t, huffman_code_lengths.size()> symbols = {};
+    std::array<std::uint32_t, huffman_max_bits + 1> first_code = {};
+    std::array<std::uint16_t, huffman_max_bits + 1> first_index = {};
+    std::array<std::uint16_t, huffman_max_bits + 1> count = {};
+};
+
+[[noreturn]] void Malformed(const char *what) {
+    throw ProtocolException("HPACK: "s + what);
+}
+
+size_t DecodeInt(const std::uint8_t *& p, const std::uint8_t *end, const unsigned prefixBits) {
+    constexpr unsigned max_shift = 28;
+
+    if (p == end) {
+        Malformed("Truncated header block");
+    }
+
+    const size_t max_prefix = (1U << prefixBits) - 1;
+    size_t value = *p++ & max_prefix;
+    if (value < max_prefix) {
+        return value;
+    }
+
+    for(unsigned shift = 0;; shift += 7) {
+        if (p == end) {
+            Malformed("Truncated integer");
+        }
+        if (shift > max_shift) {
+            Malformed("Integer overflow");
+        }
+        const auto b = *p++;
+        value += static_cast<size_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return value;
+        }
+    }
+}
+
+std::string DecodeString(const std::uint8_t *& p, const std::uint8_t *end) {
+    if (p == end) {
+        Malformed("Truncated header block");
+    }
+
+    const bool huffman = (*p & 0x80) != 0;
+    const auto len = DecodeInt(p, end, 7);
+    if (len > static_cast<size_t>(end - p)) {
+        Malformed("Truncated string");
+    }
+
+    std::string value;
+    if (huffman) {
+        HuffmanDecode(p, len, value);
+    } else {
+        value.assign(reinterpret_cast<const char *>(p), len);
+    }
+    p += len;
+    return value;
+}
+
+void EncodeInt(std::string& dst, const std::uint8_t flags,
+               const unsigned prefixBits, size_t value) {
+    const size_t max_prefix = (1U << prefixBits) - 1;
+    if (value < max_prefix) {
+        dst += static_cast<char>(flags | value);
+        return;
+    }
+
+    dst += static_cast<char>(flags | max_prefix);
+    value -= max_prefix;
+    while(value >= 0x80) {
+        dst += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    dst += static_cast<char>(value);
+}
+
+void EncodeString(std::string& dst, const std::string& value) {
+    EncodeInt(dst, 0, 7, value.size());
+    dst += value;
+}
+
+bool IsSensitive(const std::string& name, const std::string& value) {
+    constexpr size_t short_cookie = 20;
+
+    // Short cookies are easy to guess (RFC 7541, section 7.1.3)
+    return (name == "authorization") || (name == "proxy-authorization")
+        || ((name == "cookie") && (value.size() < short_cookie));
+}
+
+bool IsWorthIndexing(const std::string& name) {
+    static const std::array<std::string, 6> unique_values = {
+        ":path", "content-length", "if-modified-since", "if-none-match",
+        "etag", "date"
+    };
+
+    return std::find(unique_values.begin(), unique_values.end(), name)
+        == unique_values.end();
+}
+
+} // anonymous namespace
+
+const Table::entry_t *Table::Get(size_t index) const {
+    if (index == 0) {
+        return nullptr;
+    }
+    if (index <= static_table.size()) {
+        return &static_table[index - 1];
+    }
+    index -= static_table.size() + 1;
+    if (index < entries_.size()) {
+        return &entries_[index];
+    }
+    return nullptr;
+}
+
+void Table::Add(std::string name, std::string value) {
+    const auto entry_size = GetEntrySize(name, value);
+    if (entry_size > max_size_) {
+        // Not an error. The table is just emptied (section 4.4)
+        Evict(0);
+        return;
+    }
+
+    Evict(max_size_ - entry_size);
+    entries_.emplace_front(std::move(name), std::move(value));
+    size_ += entry_size;
+}
+
+void Table::SetMaxSize(size_t maxSize) {
+    max_size_ = maxSize;
+    Evict(maxSize);
+}
+
+std::pair<size_t, bool> Table::Find(const std::string& name, const std::string& value) const {
+    size_t name_index = 0;
+
+    for(size_t i = 0; i < static_table.size(); ++i) {
+        if (static_table[i].first == name) {
+            if (static_table[i].second == value) {
+                return {i + 1, true};
+            }
+            if (name_index == 0) {
+                name_index = i + 1;
+            }
+        }
+    }
+
+    for(size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].first == name) {
+            const auto index = static_table.size() + i + 1;
+            if (entries_[i].second == value) {
+                return {index, true};
+            }
+            if (name_index == 0) {
+                name_index = index;
+            }
+        }
+    }
+
+    return {name_index, false};
+}
+
+void Table::Evict(size_t maxSize) {
+    while(size_ > maxSize) {
+        assert(!entries_.empty());
+        size_ -= GetEntrySize(entries_.back().first, entries_.back().second);
+        entries_.pop_back();
+    }
+}
+
+void Decoder::Decode(const std::uint8_t *data, size_t len, const header_fn_t& fn) {
+    const auto *p = data;
+    const auto *end = data + len;
+    bool have_headers = false;
+
+    while(p != end) {
+        const auto b = *p;
+
+        if (b & 0x80) {
+            // Indexed header field (section 6.1)
+            const auto *entry = table_.Get(DecodeInt(p, end, 7));
+            if (!entry) {
+                Malformed("Invalid index");
+            }
+            fn(std::string{entry->first}, std::string{entry->second});
+            have_headers = true;
+            continue;
+        }
+
+        if ((b & 0xe0) == 0x20) {
+            // Dynamic table size update (section 6.3)
+            if (have_headers) {
+                Malformed("Table size update after a header");
+            }
+            const auto size = DecodeInt(p, end, 5);
+            if (size > max_table_size_) {
+                Malformed("Table size update is too large");
+            }
+            table_.SetMaxSize(size);
+            continue;
+        }
+
+        // Literal header field (section 6.2)
+        const bool add_to_table = (b & 0x40) != 0;
+        const auto index = DecodeInt(p, end, add_to_table ? 6 : 4);
+
+        std::string name;
+        if (index != 0) {
+            const auto *entry = table_.Get(index);
+            if (!entry) {
+                Malformed("Invalid index");
+            }
+            name = entry->first;
+        } else {
+            name = DecodeString(p, end);
+        }
+
+        auto value = DecodeString(p, end);
+        if (add_to_table) {
+            table_.Add(name, value);
+        }
+
+        fn(std::move(name), std::move(value));
+        have_headers = true;
+    }
+}
+
+void Encoder::SetMaxTableSize(size_t maxSize) {
+    maxSize = std::min(maxSize, default_table_size);
+    if (maxSize == table_.GetMaxSize()) {
+        return;
+    }
+
+    table_.SetMaxSize(maxSize);
+    pending_size_update_ = maxSize;
+}
+
+void Encoder::Begin(std::string& dst) {
+    if (pending_size_update_) {
+        EncodeInt(dst, 0x20, 5, *pending_size_update_);
+        pending_size_update_.reset();
+    }
+}
+
+void Encoder::Encode(std::string& dst, const std::string& name, const std::string& value) {
+    const auto [index, match] = table_.Find(name, value);
+    if (match) {
+        EncodeInt(dst, 0x80, 7, index);
+        return;
+    }
+
+    if (IsSensitive(name, value)) {
+        // Literal never indexed
+        EncodeInt(dst, 0x10, 4, index);
+    } else if (IsWorthIndexing(name)
+        && (Table::GetEntrySize(name, value) <= table_.GetMaxSize() / 2)) {
+        // Literal with incremental indexing
+        EncodeInt(dst, 0x40, 6, index);
+        table_.Add(name, value);
+    } else {
+        // Literal without indexing
+        EncodeInt(dst, 0, 4, index);
+    }
+
+    if (index == 0) {
+        EncodeString(dst, name);
+    }
+    EncodeString(dst, value);
+}
+
+void HuffmanDecode(const std::uint8_t *data, size_t len, std::string& dst) {
+    static const HuffmanDecodeTables tables;
+    constexpr size_t max_padding = 7;
+
+    dst.reserve(dst.size() + (len * 8 / 5));
+
+    std::uint32_t code = 0;
+    size_t bits = 0;
+    for(size_t i = 0; i < len; ++i) {
+        for(int bit = 7; bit >= 0; --bit) {
+            code = (code << 1) | ((data[i] >> bit) & 1);
+            ++bits;
+
+            const auto offset = code - tables.first_code[bits];
+            if ((tables.count[bits] != 0) && (code >= tables.first_code[bits])
+                && (offset < tables.count[bits])) {
+                const auto symbol = tables.symbols[tables.first_index[bits] + offset];
+                if (symbol == huffman_eos) {
+                    Malformed("EOS in Huffman encoded string");
+                }
+                dst += static_cast<char>(symbol);
+                code = 0;
+                bits = 0;
+            } else if (bits >= huffman_max_bits) {
+                Malformed("Invalid Huffman code");
+            }
+        }
+    }
+
+    // The padding is the most significant bits of EOS (all ones)
+    if ((bits > max_padding) || (code != (1U << bits) - 1)) {
+        Malformed("Invalid Huffman padding");
+    }
+}
+
+} // namespace hpack
+} // namespace restc_cpp
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include <boost/optional.hpp>
+
+namespace restc_cpp {
+
+/*! HPACK, header compression for HTTP/2 (RFC 7541) */
+namespace hpack {
+
+constexpr size_t default_table_size = 4096;
+
+/*! The static and dynamic table (RFC 7541, section 2.3) */
+class Table {
+public:
+    using entry_t = std::pair<std::string, std::string>;
+
+    explicit Table(size_t maxSize = default_table_size)
+    : max_size_{maxSize}
+    {
+    }
+
+    /*! Get an entry by its index. The static table starts at 1.
+     *
+     * \return nullptr if the index is out of range
+     */
+    const entry_t *Get(size_t index) const;
+
+    void Add(std::string name, std::string value);
+
+    void SetMaxSize(size_t maxSize);
+
+    size_t GetMaxSize() const noexcept {
+        return max_size_;
+    }
+
+    /*! The size of the dynamic table, as defined in section 4.1 */
+    size_t GetSize() const noexcept {
+        return size_;
+    }
+
+    /*! Find an entry
+     *
+     * \return The index, and true if the value matched as well as the name.
+     *      The index is 0 if the name is not in the table.
+     */
+    std::pair<size_t, bool> Find(const std::string& name, const std::string& value) const;
+
+    static size_t GetEntrySize(const std::string& name, const std::string& value) noexcept {
+        return name.size() + value.size() + 32;
+    }
+
+private:
+    void Evict(size_t maxSize);
+
+    std::deque<entry_t> entries_; // Newest first
+    size_t size_ = 0;
+    size_t max_size_;
+};
+
+/*! Decodes header blocks from one peer */
+class Decoder {
+public:
+    using header_fn_t = std::function<void(std::string&& name, std::string&& value)>;
+
+    /*! \param maxTableSize The SETTINGS_HEADER_TABLE_SIZE we announce */
+    explicit Decoder(size_t maxTableSize = default_table_size)
+    : table_{maxTableSize}, max_table_size_{maxTableSize}
+    {
+    }
+
+    /*! Decode a complete header block
+     *
+     * \throws ProtocolException if the block is malformed. The decoder
+     *      can not be used after that.
+     */
+    void Decode(const std::uint8_t *data, size_t len, const header_fn_t& fn);
+
+    const Table& GetTable() const noexcept {
+        return table_;
+    }
+
+private:
+    Table table_;
+    const size_t max_table_size_;
+};
+
+/*! Encodes header blocks for one peer
+ *
+ * Headers are added to the dynamic table unless they are sensitive
+ * or unlikely to be repeated. Strings are not Huffman encoded.
+ */
+class Encoder {
+public:
+    /*! Apply the peer's SETTINGS_HEADER_TABLE_SIZE
+     *
+     * The change is signalled at the start of the next header block.
+     */
+    void SetMaxTableSize(size_t maxSize);
+
+    /*! Start a new header block */
+    void Begin(std::string& dst);
+
+    /*! Append one header to the block. The name must be in lower case. */
+    void Encode(std::string& dst, const std::string& name, const std::string& value);
+
+    const Table& GetTable() const noexcept {
+        return table_;
+    }
+
+private:
+    Table table_;
+    boost::optional<size_t> pending_size_update_;
+};
+
+/*! Decode a Huffman encoded string (RFC 7541, section 5.2)
+ *
+ * \throws ProtocolException if the string is malformed
+ */
+void HuffmanDecode(const std::uint8_t *data, size_t len, std::string& dst);
+
+} // namespace hpack
+} // namespace restc_cpp
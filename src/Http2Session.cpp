@@ -0,0 +1,1274 @@
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/spawn.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/Connection.h"
+#include "restc-cpp/Socket.h"
+#include "restc-cpp/logging.h"
+#include "restc-cpp/error.h"
+
+#include "Http2Session.h"
+#include "Suspend.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+// RFC 9113, section 6
+constexpr uint8_t FRAME_DATA = 0x0;
+constexpr uint8_t FRAME_HEADERS = 0x1;
+constexpr uint8_t FRAME_PRIORITY = 0x2;
+constexpr uint8_t FRAME_RST_STREAM = 0x3;
+constexpr uint8_t FRAME_SETTINGS = 0x4;
+constexpr uint8_t FRAME_PUSH_PROMISE = 0x5;
+constexpr uint8_t FRAME_PING = 0x6;
+constexpr uint8_t FRAME_GOAWAY = 0x7;
+constexpr uint8_t FRAME_WINDOW_UPDATE = 0x8;
+constexpr uint8_t FRAME_CONTINUATION = 0x9;
+
+constexpr uint8_t FLAG_END_STREAM = 0x1;
+constexpr uint8_t FLAG_ACK = 0x1;
+constexpr uint8_t FLAG_END_HEADERS = 0x4;
+constexpr uint8_t FLAG_PADDED = 0x8;
+constexpr uint8_t FLAG_PRIORITY = 0x20;
+
+constexpr uint16_t SETTINGS_HEADER_TABLE_SIZE = 0x1;
+constexpr uint16_t SETTINGS_ENABLE_PUSH = 0x2;
+constexpr uint16_t SETTINGS_MAX_CONCURRENT_STREAMS = 0x3;
+constexpr uint16_t SETTINGS_INITIAL_WINDOW_SIZE = 0x4;
+constexpr uint16_t SETTINGS_MAX_FRAME_SIZE = 0x5;
+
+// RFC 9113, section 7
+constexpr uint32_t NO_ERROR = 0x0;
+constexpr uint32_t PROTOCOL_ERROR = 0x1;
+constexpr uint32_t FLOW_CONTROL_ERROR = 0x3;
+constexpr uint32_t FRAME_SIZE_ERROR = 0x6;
+constexpr uint32_t REFUSED_STREAM = 0x7;
+constexpr uint32_t CANCEL = 0x8;
+constexpr uint32_t COMPRESSION_ERROR = 0x9;
+constexpr uint32_t ENHANCE_YOUR_CALM = 0xb;
+
+constexpr char connection_preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t frame_header_size = 9;
+constexpr size_t default_max_frame_size = 16384;
+constexpr size_t max_frame_size_limit = 16777215;
+constexpr int64_t default_window_size = 65535;
+constexpr int64_t max_window_size = 0x7fffffff;
+constexpr uint32_t max_stream_id = 0x7fffffff;
+constexpr uint32_t stream_id_mask = 0x7fffffff;
+
+// Streams reserved on a new session until the server's SETTINGS tell
+// otherwise. Only one of them is opened before the SETTINGS arrive, so
+// that a lower limit does not make the server refuse the others.
+constexpr size_t assumed_max_concurrent_streams = 100;
+
+// Our receive windows. Large enough to not throttle a fast network.
+constexpr size_t stream_recv_window = 1024 * 1024;
+constexpr size_t connection_recv_window = 16 * 1024 * 1024;
+
+// Limit for the header block of a response, after CONTINUATION frames
+constexpr size_t max_header_block_size = 1024 * 1024;
+
+/*! A connection error (RFC 9113, section 5.4.1)
+ *
+ * The session is failed, and the server gets the code in a GOAWAY frame.
+ */
+struct Http2Error : public ProtocolException {
+    Http2Error(uint32_t errorCode, const string& cause)
+    : ProtocolException("HTTP/2: "s + cause), code{errorCode} {}
+
+    const uint32_t code;
+};
+
+uint32_t Read16(const uint8_t *p) {
+    return (static_cast<uint32_t>(p[0]) << 8) | p[1];
+}
+
+uint32_t Read24(const uint8_t *p) {
+    return (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+}
+
+uint32_t Read32(const uint8_t *p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+        | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+void Append16(string& dst, uint32_t value) {
+    dst += static_cast<char>((value >> 8) & 0xff);
+    dst += static_cast<char>(value & 0xff);
+}
+
+void Append24(string& dst, uint32_t value) {
+    dst += static_cast<char>((value >> 16) & 0xff);
+    Append16(dst, value);
+}
+
+void Append32(string& dst, uint32_t value) {
+    Append16(dst, value >> 16);
+    Append16(dst, value);
+}
+
+void AppendSetting(string& dst, uint16_t id, uint32_t value) {
+    Append16(dst, id);
+    Append32(dst, value);
+}
+
+} // anonymous namespace
+
+struct Http2Session::Stream {
+    uint32_t id = 0; // 0 until the stream is opened
+    bool local_closed = false; // We have sent END_STREAM
+    bool remote_closed = false; // The server has sent END_STREAM, or reset the stream
+    bool reset = false;
+    bool discard_body = false; // The server responded, and wants no more of the body
+    uint32_t error_code = NO_ERROR;
+    bool has_response = false;
+    Reply::HttpResponse response;
+    headers_t headers;
+    std::deque<string> data; // Received, and not yet read by the request
+    int64_t send_window = 0;
+    size_t recv_unacked = 0;
+    size_t recv_consumed = 0;
+    function<void ()> waiter;
+    unsigned wait_id = 0;
+    bool timed_out = false;
+};
+
+Http2Session::Http2Session(Connection::ptr_t connection, ConnectionPool::ptr_t pool,
+                           RestClient& owner)
+: pool_{std::move(pool)}, connection_{std::move(connection)}
+, connection_id_{connection_->GetId()}, owner_{owner}
+, strand_{owner.GetIoService().get_executor()}, wake_writer_{owner.GetIoService()}
+, max_concurrent_streams_{assumed_max_concurrent_streams}
+, send_window_{default_window_size}, initial_send_window_{default_window_size}
+, max_frame_size_{default_max_frame_size}
+{
+}
+
+bool Http2Session::CanOpenStream() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return !closing_ && !going_away_ && !error_
+        && ((streams_.size() + reserved_.size()) < max_concurrent_streams_)
+        && (next_stream_id_ + (reserved_.size() * 2) <= max_stream_id);
+}
+
+bool Http2Session::IsOpen() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return !closing_ && !error_;
+}
+
+size_t Http2Session::GetActiveStreams() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return streams_.size() + reserved_.size();
+}
+
+Http2Session::clock_t::time_point Http2Session::GetLastUsed() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return last_used_;
+}
+
+std::shared_ptr<Http2Stream> Http2Session::CreateStream() {
+    auto stream = make_shared<Stream>();
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        reserved_.insert(stream);
+    }
+    return make_shared<Http2Stream>(shared_from_this(), std::move(stream));
+}
+
+void Http2Session::Close() {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (closing_) {
+        return;
+    }
+
+    RESTC_CPP_LOG_TRACE_("Http2Session: Closing " << *connection_);
+    string payload;
+    Append32(payload, 0);
+    Append32(payload, NO_ERROR);
+    AppendFrame(FRAME_GOAWAY, 0, 0, payload.data(), payload.size());
+    closing_ = true;
+    if (!error_) {
+        error_ = make_exception_ptr(ObjectExpiredException("The HTTP/2 session is closed"));
+    }
+    NotifyAll();
+}
+
+Http2Session::ptr_t Http2Session::Create(Connection::ptr_t connection,
+                                         ConnectionPool::ptr_t pool,
+                                         RestClient& owner) {
+    auto session = make_shared<Http2Session>(std::move(connection), std::move(pool), owner);
+    session->Start();
+    return session;
+}
+
+void Http2Session::Start() {
+    RESTC_CPP_LOG_DEBUG_("Http2Session: Starting HTTP/2 on " << *connection_);
+
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        send_buffer_ = connection_preface;
+
+        string settings;
+        AppendSetting(settings, SETTINGS_ENABLE_PUSH, 0);
+        AppendSetting(settings, SETTINGS_INITIAL_WINDOW_SIZE, stream_recv_window);
+        AppendFrame(FRAME_SETTINGS, 0, 0, settings.data(), settings.size());
+        AppendWindowUpdate(0, connection_recv_window - default_window_size);
+    }
+
+    auto self = shared_from_this();
+    boost::asio::spawn(strand_, [self](boost::asio::yield_context yield) {
+        self->WriteFrames(yield);
+    } RESTC_CPP_SPAWN_TRAILER);
+
+    boost::asio::spawn(strand_, [self](boost::asio::yield_context yield) {
+        self->ReadFrames(yield);
+    } RESTC_CPP_SPAWN_TRAILER);
+}
+
+void Http2Session::ReadFrames(boost::asio::yield_context yield) {
+    // Room for the largest frame we allow, and then some
+    vector<uint8_t> buffer(frame_header_size + default_max_frame_size + RESTC_CPP_IO_BUFFER_SIZE);
+    size_t have = 0;
+
+    try {
+        while(true) {
+            size_t pos = 0;
+            while((have - pos) >= frame_header_size) {
+                const auto *frame = buffer.data() + pos;
+                const size_t len = Read24(frame);
+                if (len > default_max_frame_size) {
+                    throw Http2Error(FRAME_SIZE_ERROR, "The frame is larger than SETTINGS_MAX_FRAME_SIZE");
+                }
+                if ((have - pos) < (frame_header_size + len)) {
+                    break;
+                }
+                HandleFrame(frame[3], frame[4], Read32(frame + 5) & stream_id_mask,
+                            frame + frame_header_size, len);
+                pos += frame_header_size + len;
+            }
+
+            if (pos > 0) {
+                memmove(buffer.data(), buffer.data() + pos, have - pos);
+                have -= pos;
+            }
+
+            boost::system::error_code ec;
+            const auto bytes = connection_->GetSocket().AsyncReadSome(
+                {buffer.data() + have, buffer.size() - have}, yield, ec);
+            if (ec) {
+                throw boost::system::system_error(ec);
+            }
+            have += bytes;
+        }
+    } catch(const Http2Error& ex) {
+        RESTC_CPP_LOG_DEBUG_("Http2Session: Connection error on " << *connection_
+                             << ": " << ex.what());
+        Fail(current_exception(), ex.code);
+    } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+        Fail(current_exception());
+    }
+}
+
+void Http2Session::WriteFrames(boost::asio::yield_context yield) {
+    string buffer;
+
+    try {
+        while(true) {
+            {
+                std::lock_guard<std::mutex> const lock{mutex_};
+                buffer.clear();
+                buffer.swap(send_buffer_);
+                if (buffer.empty()) {
+                    if (closing_) {
+                        break;
+                    }
+                    writer_waiting_ = true;
+                }
+            }
+
+            if (buffer.empty()) {
+                // Cancelled by WakeWriter()
+                wake_writer_.expires_at(boost::asio::steady_timer::time_point::max());
+                boost::system::error_code ec;
+                wake_writer_.async_wait(yield[ec]);
+                continue;
+            }
+
+            connection_->GetSocket().AsyncWrite(boost_const_buffer{buffer.data(), buffer.size()},
+                                                yield);
+        }
+    } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+        Fail(current_exception());
+    }
+
+    RESTC_CPP_LOG_TRACE_("Http2Session: Done with " << *connection_);
+    connection_->GetSocket().Close();
+}
+
+void Http2Session::HandleFrame(uint8_t type, uint8_t flags, uint32_t streamId,
+                               const uint8_t *payload, size_t len) {
+    if ((header_block_stream_ != 0) && (type != FRAME_CONTINUATION)) {
+        throw Http2Error(PROTOCOL_ERROR, "Expected a CONTINUATION frame");
+    }
+
+    switch(type) {
+    case FRAME_DATA:
+        OnData(flags, streamId, payload, len);
+        break;
+    case FRAME_HEADERS:
+        OnHeaders(flags, streamId, payload, len);
+        break;
+    case FRAME_PRIORITY:
+        // Deprecated, and of no use to a client
+        break;
+    case FRAME_RST_STREAM:
+        if (len != 4) {
+            throw Http2Error(FRAME_SIZE_ERROR, "Invalid RST_STREAM frame");
+        }
+        if (streamId == 0) {
+            throw Http2Error(PROTOCOL_ERROR, "RST_STREAM on stream 0");
+        }
+        OnResetStream(streamId, payload);
+        break;
+    case FRAME_SETTINGS:
+        if (streamId != 0) {
+            throw Http2Error(PROTOCOL_ERROR, "SETTINGS on a stream");
+        }
+        if (flags & FLAG_ACK) {
+            if (len != 0) {
+                throw Http2Error(FRAME_SIZE_ERROR, "SETTINGS acknowledgement with a payload");
+            }
+            break;
+        }
+        if (len % 6) {
+            throw Http2Error(FRAME_SIZE_ERROR, "Invalid SETTINGS frame");
+        }
+        OnSettings(payload, len);
+        break;
+    case FRAME_PUSH_PROMISE:
+        throw Http2Error(PROTOCOL_ERROR, "PUSH_PROMISE, but push is disabled");
+    case FRAME_PING:
+        if (len != 8) {
+            throw Http2Error(FRAME_SIZE_ERROR, "Invalid PING frame");
+        }
+        if (streamId != 0) {
+            throw Http2Error(PROTOCOL_ERROR, "PING on a stream");
+        }
+        if (!(flags & FLAG_ACK)) {
+            std::lock_guard<std::mutex> const lock{mutex_};
+            AppendFrame(FRAME_PING, FLAG_ACK, 0, reinterpret_cast<const char *>(payload), len);
+        }
+        break;
+    case FRAME_GOAWAY:
+        if (len < 8) {
+            throw Http2Error(FRAME_SIZE_ERROR, "Invalid GOAWAY frame");
+        }
+        if (streamId != 0) {
+            throw Http2Error(PROTOCOL_ERROR, "GOAWAY on a stream");
+        }
+        OnGoAway(payload);
+        break;
+    case FRAME_WINDOW_UPDATE:
+        if (len != 4) {
+            throw Http2Error(FRAME_SIZE_ERROR, "Invalid WINDOW_UPDATE frame");
+        }
+        OnWindowUpdate(streamId, payload);
+        break;
+    case FRAME_CONTINUATION:
+        if ((header_block_stream_ == 0) || (streamId != header_block_stream_)) {
+            throw Http2Error(PROTOCOL_ERROR, "Unexpected CONTINUATION frame");
+        }
+        header_block_.append(reinterpret_cast<const char *>(payload), len);
+        if (header_block_.size() > max_header_block_size) {
+            throw Http2Error(ENHANCE_YOUR_CALM, "The header block is too large");
+        }
+        if (flags & FLAG_END_HEADERS) {
+            OnHeaderBlock();
+        }
+        break;
+    default:
+        // Unknown frame types are ignored (section 4.1)
+        break;
+    }
+}
+
+void Http2Session::OnData(uint8_t flags, uint32_t streamId, const uint8_t *payload,
+                          size_t len) {
+    if (streamId == 0) {
+        throw Http2Error(PROTOCOL_ERROR, "DATA on stream 0");
+    }
+
+    size_t padding = 0; // Including the pad length field
+    if (flags & FLAG_PADDED) {
+        if ((len < 1) || (payload[0] >= len)) {
+            throw Http2Error(PROTOCOL_ERROR, "Invalid padding");
+        }
+        padding = payload[0] + 1u;
+    }
+
+    std::lock_guard<std::mutex> const lock{mutex_};
+    recv_unacked_ += len;
+    if (recv_unacked_ > connection_recv_window) {
+        throw Http2Error(FLOW_CONTROL_ERROR, "The connection window is exceeded");
+    }
+
+    auto it = streams_.find(streamId);
+    if ((it == streams_.end()) || it->second->remote_closed) {
+        // A stream we have given up. The data still counts against the
+        // connection window.
+        ReleaseWindow(nullptr, len);
+        return;
+    }
+
+    auto stream = it->second;
+    stream->recv_unacked += len;
+    if (!stream->has_response || (stream->recv_unacked > stream_recv_window)) {
+        ResetStream(*stream, stream->has_response ? FLOW_CONTROL_ERROR : PROTOCOL_ERROR);
+        ReleaseWindow(nullptr, len);
+        return;
+    }
+
+    if (len > padding) {
+        stream->data.emplace_back(reinterpret_cast<const char *>(payload) + (padding ? 1 : 0),
+                                  len - padding);
+    }
+
+    if (padding) {
+        ReleaseWindow(stream.get(), padding);
+    }
+
+    if (flags & FLAG_END_STREAM) {
+        stream->remote_closed = true;
+        OnStreamDone(*stream);
+    }
+
+    Notify(*stream);
+}
+
+void Http2Session::OnHeaders(uint8_t flags, uint32_t streamId, const uint8_t *payload,
+                             size_t len) {
+    if (streamId == 0) {
+        throw Http2Error(PROTOCOL_ERROR, "HEADERS on stream 0");
+    }
+
+    size_t offset = 0;
+    size_t padding = 0;
+    if (flags & FLAG_PADDED) {
+        if (len < 1) {
+            throw Http2Error(PROTOCOL_ERROR, "Invalid padding");
+        }
+        padding = payload[0];
+        offset = 1;
+    }
+    if (flags & FLAG_PRIORITY) {
+        offset += 5;
+    }
+    if ((offset + padding) > len) {
+        throw Http2Error(PROTOCOL_ERROR, "Invalid padding");
+    }
+
+    header_block_.assign(reinterpret_cast<const char *>(payload) + offset,
+                         len - offset - padding);
+    header_block_stream_ = streamId;
+    header_block_end_stream_ = (flags & FLAG_END_STREAM) != 0;
+
+    if (flags & FLAG_END_HEADERS) {
+        OnHeaderBlock();
+    }
+}
+
+void Http2Session::OnHeaderBlock() {
+    const auto stream_id = header_block_stream_;
+    header_block_stream_ = 0;
+
+    Reply::HttpResponse response;
+    response.http_version = Reply::HttpResponse::HttpVersion::HTTP_2;
+    headers_t headers;
+    bool malformed = false;
+
+    // The block is decoded even if the stream is gone, to keep the
+    // dynamic table in sync with the server.
+    try {
+        decoder_.Decode(reinterpret_cast<const uint8_t *>(header_block_.data()),
+                        header_block_.size(),
+                        [&](string&& name, string&& value) {
+            if (name == ":status") {
+                if ((value.size() != 3)
+                    || !all_of(value.begin(), value.end(), [](char ch) {
+                        return (ch >= '0') && (ch <= '9');
+                    })) {
+                    malformed = true;
+                    return;
+                }
+                response.status_code = stoi(value);
+            } else if (!name.empty() && (name.front() != ':')) {
+                headers.insert({std::move(name), std::move(value)});
+            }
+        });
+    } catch(const ProtocolException& ex) {
+        throw Http2Error(COMPRESSION_ERROR, ex.what());
+    }
+    header_block_.clear();
+
+    std::lock_guard<std::mutex> const lock{mutex_};
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+        return;
+    }
+
+    auto stream = it->second;
+    if (!stream->has_response) {
+        if (malformed || (response.status_code == 0)) {
+            ResetStream(*stream, PROTOCOL_ERROR);
+            return;
+        }
+        if ((response.status_code / 100) == 1) {
+            // Informational. The final response follows.
+            return;
+        }
+        stream->response = std::move(response);
+        stream->headers = std::move(headers);
+        stream->has_response = true;
+    }
+    // Else it's trailers. They are not exposed to the request.
+
+    if (header_block_end_stream_) {
+        stream->remote_closed = true;
+        OnStreamDone(*stream);
+    }
+
+    Notify(*stream);
+}
+
+void Http2Session::OnResetStream(uint32_t streamId, const uint8_t *payload) {
+    const auto code = Read32(payload);
+
+    std::lock_guard<std::mutex> const lock{mutex_};
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return;
+    }
+
+    auto stream = it->second;
+    RESTC_CPP_LOG_TRACE_("Http2Session: Stream " << streamId << " was reset with error code "
+                         << code);
+
+    if (stream->remote_closed) {
+        // The response is complete, and the server does not want the rest
+        // of the request body (section 8.1).
+        stream->discard_body = true;
+    } else {
+        stream->reset = true;
+        stream->error_code = code;
+        stream->remote_closed = true;
+    }
+    stream->local_closed = true;
+    OnStreamDone(*stream);
+    Notify(*stream);
+}
+
+void Http2Session::OnSettings(const uint8_t *payload, size_t len) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+
+    for(size_t i = 0; i < len; i += 6) {
+        const auto id = Read16(payload + i);
+        const auto value = Read32(payload + i + 2);
+
+        switch(id) {
+        case SETTINGS_HEADER_TABLE_SIZE:
+            encoder_.SetMaxTableSize(value);
+            break;
+        case SETTINGS_MAX_CONCURRENT_STREAMS:
+            max_concurrent_streams_ = value;
+            break;
+        case SETTINGS_INITIAL_WINDOW_SIZE:
+            if (value > max_window_size) {
+                throw Http2Error(FLOW_CONTROL_ERROR, "Invalid SETTINGS_INITIAL_WINDOW_SIZE");
+            }
+            // Applies to the streams in progress as well (section 6.9.2)
+            for(auto& [stream_id, stream] : streams_) {
+                stream->send_window += static_cast<int64_t>(value) - initial_send_window_;
+            }
+            initial_send_window_ = value;
+            break;
+        case SETTINGS_MAX_FRAME_SIZE:
+            if ((value < default_max_frame_size) || (value > max_frame_size_limit)) {
+                throw Http2Error(PROTOCOL_ERROR, "Invalid SETTINGS_MAX_FRAME_SIZE");
+            }
+            max_frame_size_ = value;
+            break;
+        default:
+            break;
+        }
+    }
+
+    AppendFrame(FRAME_SETTINGS, FLAG_ACK, 0, nullptr, 0);
+    has_settings_ = true;
+    NotifyAll();
+}
+
+void Http2Session::OnGoAway(const uint8_t *payload) {
+    const auto last_stream_id = Read32(payload) & stream_id_mask;
+    const auto code = Read32(payload + 4);
+
+    RESTC_CPP_LOG_DEBUG_("Http2Session: GOAWAY on " << *connection_ << ", last stream "
+                         << last_stream_id << ", error code " << code);
+
+    std::lock_guard<std::mutex> const lock{mutex_};
+    going_away_ = true;
+
+    // Streams above the last one were not processed, and will never be
+    vector<stream_ptr_t> refused;
+    for(const auto& [stream_id, stream] : streams_) {
+        if (stream_id > last_stream_id) {
+            refused.push_back(stream);
+        }
+    }
+    for(const auto& stream : refused) {
+        stream->reset = true;
+        stream->error_code = REFUSED_STREAM;
+        stream->local_closed = stream->remote_closed = true;
+        streams_.erase(stream->id);
+    }
+
+    NotifyAll();
+    for(const auto& stream : refused) {
+        Notify(*stream);
+    }
+    OnStreamGone();
+}
+
+void Http2Session::OnWindowUpdate(uint32_t streamId, const uint8_t *payload) {
+    const auto increment = Read32(payload) & 0x7fffffff;
+
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (streamId == 0) {
+        if (increment == 0) {
+            throw Http2Error(PROTOCOL_ERROR, "WINDOW_UPDATE with no increment");
+        }
+        send_window_ += increment;
+        if (send_window_ > max_window_size) {
+            throw Http2Error(FLOW_CONTROL_ERROR, "The connection window is too large");
+        }
+        NotifyAll();
+        return;
+    }
+
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return;
+    }
+
+    auto stream = it->second;
+    stream->send_window += increment;
+    if ((increment == 0) || (stream->send_window > max_window_size)) {
+        ResetStream(*stream, increment ? FLOW_CONTROL_ERROR : PROTOCOL_ERROR);
+        return;
+    }
+    Notify(*stream);
+}
+
+void Http2Session::Fail(exception_ptr error, boost::optional<uint32_t> goAwayCode) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (!error_) {
+        error_ = std::move(error);
+    }
+
+    if (goAwayCode && !closing_) {
+        string payload;
+        Append32(payload, 0); // We don't accept streams from the server
+        Append32(payload, *goAwayCode);
+        AppendFrame(FRAME_GOAWAY, 0, 0, payload.data(), payload.size());
+    }
+
+    closing_ = true;
+    NotifyAll();
+    WakeWriter();
+}
+
+void Http2Session::Open(const stream_ptr_t& stream, const header_list_t& headers,
+                        bool endStream, Context& ctx, int timeoutMs) {
+    auto lock = Wait(stream, ctx, timeoutMs, [this] {
+        return closing_ || going_away_
+            || (streams_.size() < (has_settings_ ? max_concurrent_streams_ : 1));
+    });
+
+    if (error_) {
+        rethrow_exception(error_);
+    }
+    if (closing_ || going_away_ || (next_stream_id_ > max_stream_id)) {
+        throw ObjectExpiredException("The HTTP/2 session is closing");
+    }
+
+    reserved_.erase(stream);
+    stream->id = next_stream_id_;
+    next_stream_id_ += 2;
+    stream->send_window = initial_send_window_;
+    streams_.emplace(stream->id, stream);
+
+    string block;
+    encoder_.Begin(block);
+    for(const auto& [name, value] : headers) {
+        encoder_.Encode(block, name, value);
+    }
+
+    // A large header block continues in CONTINUATION frames
+    size_t offset = 0;
+    auto type = FRAME_HEADERS;
+    uint8_t flags = endStream ? FLAG_END_STREAM : 0;
+    do {
+        const auto len = min(block.size() - offset, max_frame_size_);
+        const bool last = (offset + len) == block.size();
+        AppendFrame(type, flags | (last ? FLAG_END_HEADERS : 0), stream->id,
+                    block.data() + offset, len);
+        offset += len;
+        type = FRAME_CONTINUATION;
+        flags = 0;
+    } while(offset < block.size());
+
+    if (endStream) {
+        stream->local_closed = true;
+    }
+
+    RESTC_CPP_LOG_TRACE_("Http2Session: Opened stream " << stream->id << " on "
+                         << *connection_);
+}
+
+void Http2Session::WaitForResponse(const stream_ptr_t& stream, Context& ctx,
+                                   int timeoutMs, Reply::HttpResponse& response,
+                                   headers_t& headers) {
+    auto lock = Wait(stream, ctx, timeoutMs, [&stream] {
+        return stream->has_response || stream->remote_closed;
+    });
+
+    if (!stream->has_response) {
+        ThrowStreamError(*stream);
+    }
+
+    response = stream->response;
+    headers = std::move(stream->headers);
+}
+
+bool Http2Session::ReadSome(const stream_ptr_t& stream, Context& ctx, int timeoutMs,
+                            string& data) {
+    auto lock = Wait(stream, ctx, timeoutMs, [&stream] {
+        return !stream->data.empty() || stream->remote_closed;
+    });
+
+    if (stream->data.empty()) {
+        if (stream->reset) {
+            ThrowStreamError(*stream);
+        }
+        return false;
+    }
+
+    data = std::move(stream->data.front());
+    stream->data.pop_front();
+    ReleaseWindow(stream.get(), data.size());
+    return true;
+}
+
+bool Http2Session::IsEof(const Stream& stream) const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return stream.data.empty() && stream.remote_closed && !stream.reset;
+}
+
+void Http2Session::SendData(const stream_ptr_t& stream, boost_const_buffer data,
+                            bool endStream, Context& ctx, int timeoutMs) {
+    const auto *p = boost_buffer_cast(data);
+    auto remaining = boost_buffer_size(data);
+
+    if ((remaining == 0) && !endStream) {
+        return;
+    }
+
+    do {
+        auto lock = Wait(stream, ctx, timeoutMs, [this, &stream, remaining] {
+            return stream->local_closed || (remaining == 0)
+                || ((stream->send_window > 0) && (send_window_ > 0));
+        });
+
+        if (stream->discard_body) {
+            return;
+        }
+        if (stream->reset) {
+            ThrowStreamError(*stream);
+        }
+        if (stream->local_closed) {
+            if (remaining == 0) {
+                return; // Finish() after the end of the stream
+            }
+            throw RestcCppException("HTTP/2: Write after the end of the request body");
+        }
+
+        // The windows are positive here unless there is nothing to send
+        const auto window = static_cast<size_t>(max<int64_t>(0, min(stream->send_window,
+                                                                    send_window_)));
+        const auto len = min({remaining, max_frame_size_, window});
+        const bool last = endStream && (len == remaining);
+        AppendFrame(FRAME_DATA, last ? FLAG_END_STREAM : 0, stream->id, p, len);
+        stream->send_window -= static_cast<int64_t>(len);
+        send_window_ -= static_cast<int64_t>(len);
+        p += len;
+        remaining -= len;
+
+        if (last) {
+            stream->local_closed = true;
+            OnStreamDone(*stream);
+        }
+    } while(remaining > 0);
+}
+
+void Http2Session::Release(const stream_ptr_t& stream) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+
+    size_t unread = 0;
+    for(const auto& data : stream->data) {
+        unread += data.size();
+    }
+    stream->data.clear();
+
+    if (stream->id == 0) {
+        reserved_.erase(stream);
+    } else if (streams_.erase(stream->id)) {
+        // Not complete. Tell the server that we are not interested.
+        AppendResetStream(stream->id, CANCEL);
+        stream->local_closed = stream->remote_closed = true;
+    }
+
+    if (unread) {
+        ReleaseWindow(nullptr, unread);
+    }
+    OnStreamGone();
+}
+
+void Http2Session::Cancel(const stream_ptr_t& stream) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if ((stream->id != 0) && !stream->reset && (streams_.count(stream->id) != 0)) {
+        ResetStream(*stream, CANCEL);
+    }
+}
+
+std::unique_lock<std::mutex> Http2Session::Wait(const stream_ptr_t& stream, Context& ctx,
+                                                int timeoutMs,
+                                                const std::function<bool ()>& ready) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (ready()) {
+        return lock;
+    }
+    if (error_) {
+        rethrow_exception(error_);
+    }
+
+    const auto wait_id = ++stream->wait_id;
+    stream->timed_out = false;
+    lock.unlock();
+
+    boost::asio::steady_timer timer{owner_.GetIoService()};
+    if (timeoutMs > 0) {
+        timer.RESTC_CPP_STEADY_TIMER_EXPIRES_AFTER(std::chrono::milliseconds{timeoutMs});
+        timer.async_wait([self = shared_from_this(), stream, wait_id]
+                         (const boost::system::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            std::lock_guard<std::mutex> const timer_lock{self->mutex_};
+            if (stream->wait_id == wait_id) {
+                stream->timed_out = true;
+                self->Notify(*stream);
+            }
+        });
+    }
+
+    while(true) {
+        Suspend(ctx, [&](function<void ()> resume) {
+            std::unique_lock<std::mutex> park_lock{mutex_};
+            if (error_ || stream->timed_out || ready()) {
+                park_lock.unlock();
+                resume();
+                return;
+            }
+            stream->waiter = std::move(resume);
+        });
+
+        lock.lock();
+        if (ready()) {
+            ++stream->wait_id; // Disarm the timer
+            return lock;
+        }
+        if (error_) {
+            rethrow_exception(error_);
+        }
+        if (stream->timed_out) {
+            RESTC_CPP_LOG_DEBUG_("Http2Session: Stream " << stream->id << " on "
+                                 << *connection_ << " timed out");
+            throw RequestTimeOutException();
+        }
+        lock.unlock();
+    }
+}
+
+void Http2Session::AppendFrame(uint8_t type, uint8_t flags, uint32_t streamId,
+                               const char *payload, size_t len) {
+    Append24(send_buffer_, static_cast<uint32_t>(len));
+    send_buffer_ += static_cast<char>(type);
+    send_buffer_ += static_cast<char>(flags);
+    Append32(send_buffer_, streamId);
+    if (len) {
+        send_buffer_.append(payload, len);
+    }
+    WakeWriter();
+}
+
+void Http2Session::AppendWindowUpdate(uint32_t streamId, uint32_t increment) {
+    string payload;
+    Append32(payload, increment);
+    AppendFrame(FRAME_WINDOW_UPDATE, 0, streamId, payload.data(), payload.size());
+}
+
+void Http2Session::AppendResetStream(uint32_t streamId, uint32_t errorCode) {
+    string payload;
+    Append32(payload, errorCode);
+    AppendFrame(FRAME_RST_STREAM, 0, streamId, payload.data(), payload.size());
+}
+
+void Http2Session::ReleaseWindow(Stream *stream, size_t bytes) {
+    // The windows are given back in large steps, to save frames
+    recv_consumed_ += bytes;
+    if (recv_consumed_ >= (connection_recv_window / 2)) {
+        AppendWindowUpdate(0, static_cast<uint32_t>(recv_consumed_));
+        recv_unacked_ -= recv_consumed_;
+        recv_consumed_ = 0;
+    }
+
+    if (stream && (stream->id != 0) && !stream->remote_closed) {
+        stream->recv_consumed += bytes;
+        if (stream->recv_consumed >= (stream_recv_window / 2)) {
+            AppendWindowUpdate(stream->id, static_cast<uint32_t>(stream->recv_consumed));
+            stream->recv_unacked -= stream->recv_consumed;
+            stream->recv_consumed = 0;
+        }
+    }
+}
+
+void Http2Session::ResetStream(Stream& stream, uint32_t errorCode) {
+    RESTC_CPP_LOG_DEBUG_("Http2Session: Resetting stream " << stream.id << " on "
+                         << *connection_ << " with error code " << errorCode);
+    AppendResetStream(stream.id, errorCode);
+    stream.reset = true;
+    stream.error_code = errorCode;
+    stream.local_closed = stream.remote_closed = true;
+    OnStreamDone(stream);
+    Notify(stream);
+}
+
+void Http2Session::OnStreamDone(Stream& stream) {
+    if (stream.local_closed && stream.remote_closed && streams_.erase(stream.id)) {
+        OnStreamGone();
+    }
+}
+
+void Http2Session::OnStreamGone() {
+    last_used_ = clock_t::now();
+
+    // Room for a reserved stream
+    for(const auto& stream : reserved_) {
+        Notify(*stream);
+    }
+
+    if (going_away_ && !closing_ && streams_.empty() && reserved_.empty()) {
+        closing_ = true;
+        WakeWriter();
+    }
+}
+
+void Http2Session::WakeWriter() {
+    if (writer_waiting_) {
+        writer_waiting_ = false;
+        boost::asio::post(strand_, [self = shared_from_this()] {
+            self->wake_writer_.cancel();
+        });
+    }
+}
+
+void Http2Session::Notify(Stream& stream) {
+    if (stream.waiter) {
+        auto resume = std::move(stream.waiter);
+        stream.waiter = nullptr;
+        resume();
+    }
+}
+
+void Http2Session::NotifyAll() {
+    for(const auto& [stream_id, stream] : streams_) {
+        Notify(*stream);
+    }
+    for(const auto& stream : reserved_) {
+        Notify(*stream);
+    }
+}
+
+void Http2Session::ThrowStreamError(const Stream& stream) const {
+    if (stream.error_code == REFUSED_STREAM) {
+        throw ProtocolException("HTTP/2: The server refused stream "s
+                                + to_string(stream.id));
+    }
+    throw ProtocolException("HTTP/2: Stream "s + to_string(stream.id)
+                            + " was reset with error code " + to_string(stream.error_code));
+}
+
+
+Http2Stream::~Http2Stream() {
+    session_->Release(stream_);
+}
+
+uint32_t Http2Stream::GetId() const {
+    std::lock_guard<std::mutex> const lock{session_->mutex_};
+    return stream_->id;
+}
+
+class Http2StreamWriter : public DataWriter {
+public:
+    Http2StreamWriter(Http2Stream::ptr_t stream, Context& ctx, const WriteConfig& cfg)
+    : stream_{std::move(stream)}, ctx_{ctx}, cfg_{cfg}
+    {
+    }
+
+    void WriteDirect(::restc_cpp::boost_const_buffer buffers) override {
+        Write(buffers);
+    }
+
+    void Write(::restc_cpp::boost_const_buffer buffers) override {
+        stream_->session_->SendData(stream_->stream_, buffers, false, ctx_,
+                                    cfg_.msWriteTimeout);
+    }
+
+    void Write(const write_buffers_t& buffers) override {
+        for(const auto& buffer : buffers) {
+            Write(buffer);
+        }
+    }
+
+    void Finish() override {
+        stream_->session_->SendData(stream_->stream_, {nullptr, 0}, true, ctx_,
+                                    cfg_.msWriteTimeout);
+    }
+
+    // The length of the body is given by the DATA frames
+    void SetHeaders(Request::headers_t & /*headers*/) override { ; }
+
+private:
+    const Http2Stream::ptr_t stream_;
+    Context& ctx_;
+    const WriteConfig cfg_;
+};
+
+class Http2StreamReader : public DataReader {
+public:
+    Http2StreamReader(Http2Stream::ptr_t stream, Context& ctx, const ReadConfig& cfg)
+    : stream_{std::move(stream)}, ctx_{ctx}, cfg_{cfg}
+    {
+    }
+
+    bool IsEof() const override {
+        return stream_->session_->IsEof(*stream_->stream_);
+    }
+
+    ::restc_cpp::boost_const_buffer ReadSome() override {
+        if (!stream_->session_->ReadSome(stream_->stream_, ctx_, cfg_.msReadTimeout,
+                                         buffer_)) {
+            buffer_.clear();
+            return {nullptr, 0};
+        }
+        return {buffer_.data(), buffer_.size()};
+    }
+
+    void Finish() override {
+        ;
+    }
+
+private:
+    const Http2Stream::ptr_t stream_;
+    Context& ctx_;
+    const ReadConfig cfg_;
+    string buffer_;
+};
+
+DataWriter::ptr_t Http2Stream::CreateWriter(const ptr_t& stream, Context& ctx,
+                                            const DataWriter::WriteConfig& cfg) {
+    return make_unique<Http2StreamWriter>(stream, ctx, cfg);
+}
+
+DataReader::ptr_t Http2Stream::CreateReader(const ptr_t& stream, Context& ctx,
+                                            const DataReader::ReadConfig& cfg) {
+    return make_unique<Http2StreamReader>(stream, ctx, cfg);
+}
+
+
+Http2Stream::ptr_t Http2SessionPool::GetStream(const string& origin, bool tls,
+                                               Context& ctx, const connect_fn_t& connect,
+                                               Connection::ptr_t& http1Connection) {
+    while(true) {
+        {
+            std::lock_guard<std::mutex> const lock{mutex_};
+            if (closed_) {
+                throw ObjectExpiredException("The connection-pool is closed.");
+            }
+
+            auto& entry = origins_[origin];
+            if (entry.http1Only) {
+                return {};
+            }
+
+            auto& sessions = entry.sessions;
+            sessions.erase(remove_if(sessions.begin(), sessions.end(), [](const auto& session) {
+                return !session->IsOpen();
+            }), sessions.end());
+
+            for(const auto& session : sessions) {
+                if (session->CanOpenStream()) {
+                    return session->CreateStream();
+                }
+            }
+
+            if (!entry.connecting) {
+                entry.connecting = true;
+                break;
+            }
+        }
+
+        // Wait for the connection in progress. It may have room for us.
+        RESTC_CPP_LOG_TRACE_("Http2SessionPool: Waiting for the connection to " << origin);
+        Suspend(ctx, [this, &origin](function<void ()> resume) {
+            std::unique_lock<std::mutex> lock{mutex_};
+            auto& entry = origins_[origin];
+            if (closed_ || !entry.connecting) {
+                lock.unlock();
+                resume();
+                return;
+            }
+            entry.waiters.push_back(std::move(resume));
+        });
+    }
+
+    Connection::ptr_t connection;
+    try {
+        connection = connect();
+    } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+        DoneConnecting(origin, {}, false);
+        throw;
+    }
+
+    if (!connection) {
+        DoneConnecting(origin, {}, false);
+        return {};
+    }
+
+    if (tls && (connection->GetSocket().GetAlpnProtocol() != "h2")) {
+        RESTC_CPP_LOG_DEBUG_("Http2SessionPool: " << origin
+                             << " does not support HTTP/2. Using HTTP/1.1.");
+        DoneConnecting(origin, {}, true);
+        http1Connection = std::move(connection);
+        return {};
+    }
+
+    auto session = Http2Session::Create(std::move(connection),
+                                        owner_.GetConnectionPool(), owner_);
+    auto stream = session->CreateStream();
+    DoneConnecting(origin, std::move(session), false);
+    return stream;
+}
+
+void Http2SessionPool::DoneConnecting(const string& origin, Http2Session::ptr_t session,
+                                      bool http1Only) {
+    decltype(Origin::waiters) waiters;
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        auto& entry = origins_[origin];
+        entry.connecting = false;
+        entry.http1Only = entry.http1Only || http1Only;
+        if (session && !closed_) {
+            entry.sessions.push_back(session);
+            session.reset();
+        }
+        waiters.swap(entry.waiters);
+    }
+
+    if (session) {
+        session->Close();
+    }
+
+    for(const auto& resume : waiters) {
+        resume();
+    }
+}
+
+void Http2SessionPool::CloseIdle(std::chrono::seconds ttl) {
+    vector<Http2Session::ptr_t> expired;
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        const auto idle_since = Http2Session::clock_t::now() - ttl;
+
+        for(auto it = origins_.begin(); it != origins_.end();) {
+            auto& sessions = it->second.sessions;
+            for(auto s = sessions.begin(); s != sessions.end();) {
+                if (!(*s)->IsOpen()
+                    || (((*s)->GetActiveStreams() == 0) && ((*s)->GetLastUsed() < idle_since))) {
+                    expired.push_back(*s);
+                    s = sessions.erase(s);
+                } else {
+                    ++s;
+                }
+            }
+
+            // Forget origins we have nothing to remember about
+            if (sessions.empty() && !it->second.connecting && !it->second.http1Only) {
+                it = origins_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for(const auto& session : expired) {
+        RESTC_CPP_LOG_TRACE_("Http2SessionPool: Closing idle session "
+                             << session->GetConnectionId());
+        session->Close();
+    }
+}
+
+void Http2SessionPool::Close() {
+    decltype(origins_) origins;
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        closed_ = true;
+        origins.swap(origins_);
+    }
+
+    for(const auto& [origin, entry] : origins) {
+        for(const auto& session : entry.sessions) {
+            session->Close();
+        }
+        for(const auto& resume : entry.waiters) {
+            resume();
+        }
+    }
+}
+
+size_t Http2SessionPool::GetSessionCount() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    size_t count = 0;
+    for(const auto& [origin, entry] : origins_) {
+        count += entry.sessions.size();
+    }
+    return count;
+}
+
+} // namespace
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/optional.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/ConnectionPool.h"
+#include "restc-cpp/DataReader.h"
+#include "restc-cpp/DataWriter.h"
+
+#include "Hpack.h"
+
+namespace restc_cpp {
+
+class Http2Stream;
+
+/*! One HTTP/2 connection (RFC 9113), shared by the requests to an origin
+ *
+ * Each request is a stream on the connection. The frames are read and
+ * written by two coroutines on a strand. The requests queue their frames
+ * for the writer, and wait for the reader to update their streams.
+ */
+class Http2Session : public std::enable_shared_from_this<Http2Session> {
+public:
+    using ptr_t = std::shared_ptr<Http2Session>;
+    using header_list_t = std::vector<std::pair<std::string, std::string>>;
+    using clock_t = std::chrono::steady_clock;
+
+    /*! The state of one stream. Guarded by the session's mutex. */
+    struct Stream;
+    using stream_ptr_t = std::shared_ptr<Stream>;
+
+    Http2Session(Connection::ptr_t connection, ConnectionPool::ptr_t pool,
+                 RestClient& owner);
+
+    Http2Session(const Http2Session&) = delete;
+    Http2Session& operator = (const Http2Session&) = delete;
+
+    /*! True if another stream can be opened now */
+    bool CanOpenStream() const;
+
+    /*! False when the session has failed or is closed */
+    bool IsOpen() const;
+
+    /*! Streams that are opened or reserved, and not yet complete */
+    size_t GetActiveStreams() const;
+
+    clock_t::time_point GetLastUsed() const;
+
+    boost::uuids::uuid GetConnectionId() const {
+        return connection_id_;
+    }
+
+    /*! Reserve a stream for a request
+     *
+     * The stream is not sent to the server before Http2Stream::Open()
+     * is called.
+     */
+    std::shared_ptr<Http2Stream> CreateStream();
+
+    /*! Close the session gracefully
+     *
+     * The server gets a GOAWAY frame, and the streams in progress fail
+     * when the connection is closed.
+     */
+    void Close();
+
+    static ptr_t Create(Connection::ptr_t connection, ConnectionPool::ptr_t pool,
+                        RestClient& owner);
+
+private:
+    friend class Http2Stream;
+    friend class Http2StreamWriter;
+    friend class Http2StreamReader;
+
+    void Start();
+    void ReadFrames(boost::asio::yield_context yield);
+    void WriteFrames(boost::asio::yield_context yield);
+    void HandleFrame(std::uint8_t type, std::uint8_t flags, std::uint32_t streamId,
+                     const std::uint8_t *payload, size_t len);
+    void OnData(std::uint8_t flags, std::uint32_t streamId,
+                const std::uint8_t *payload, size_t len);
+    void OnHeaders(std::uint8_t flags, std::uint32_t streamId,
+                   const std::uint8_t *payload, size_t len);
+    void OnHeaderBlock();
+    void OnResetStream(std::uint32_t streamId, const std::uint8_t *payload);
+    void OnSettings(const std::uint8_t *payload, size_t len);
+    void OnGoAway(const std::uint8_t *payload);
+    void OnWindowUpdate(std::uint32_t streamId, const std::uint8_t *payload);
+    void Fail(std::exception_ptr error,
+              boost::optional<std::uint32_t> goAwayCode = {});
+
+    // For Http2Stream
+    void Open(const stream_ptr_t& stream, const header_list_t& headers,
+              bool endStream, Context& ctx, int timeoutMs);
+    void WaitForResponse(const stream_ptr_t& stream, Context& ctx, int timeoutMs,
+                         Reply::HttpResponse& response, headers_t& headers);
+    bool ReadSome(const stream_ptr_t& stream, Context& ctx, int timeoutMs,
+                  std::string& data);
+    bool IsEof(const Stream& stream) const;
+    void SendData(const stream_ptr_t& stream, boost_const_buffer data,
+                  bool endStream, Context& ctx, int timeoutMs);
+    void Release(const stream_ptr_t& stream);
+    void Cancel(const stream_ptr_t& stream);
+
+    /*! Suspend the coroutine until ready() returns true
+     *
+     * ready() is called with the mutex locked.
+     *
+     * \return The lock on the mutex, taken when ready() returned true.
+     * \throws The session's error, or RequestTimeOutException
+     */
+    std::unique_lock<std::mutex> Wait(const stream_ptr_t& stream, Context& ctx,
+                                      int timeoutMs,
+                                      const std::function<bool ()>& ready);
+
+    // The methods below are called with the mutex locked
+    void AppendFrame(std::uint8_t type, std::uint8_t flags, std::uint32_t streamId,
+                     const char *payload, size_t len);
+    void AppendWindowUpdate(std::uint32_t streamId, std::uint32_t increment);
+    void AppendResetStream(std::uint32_t streamId, std::uint32_t errorCode);
+    void ReleaseWindow(Stream *stream, size_t bytes);
+    void ResetStream(Stream& stream, std::uint32_t errorCode);
+    void OnStreamDone(Stream& stream);
+    void OnStreamGone();
+    void WakeWriter();
+    void Notify(Stream& stream);
+    void NotifyAll();
+    [[noreturn]] void ThrowStreamError(const Stream& stream) const;
+
+    ConnectionPool::ptr_t pool_; // The connection must be released before the pool
+    Connection::ptr_t connection_;
+    const boost::uuids::uuid connection_id_;
+    RestClient& owner_;
+    boost::asio::strand<boost_io_service::executor_type> strand_;
+    boost::asio::steady_timer wake_writer_;
+    bool writer_waiting_ = false;
+    std::string send_buffer_;
+    hpack::Encoder encoder_;
+    hpack::Decoder decoder_;
+    std::map<std::uint32_t, stream_ptr_t> streams_; // Opened and not complete
+    std::set<stream_ptr_t> reserved_;
+    std::uint32_t next_stream_id_ = 1;
+    size_t max_concurrent_streams_;
+    bool has_settings_ = false; // The server's first SETTINGS frame is received
+    std::int64_t send_window_;
+    std::int64_t initial_send_window_;
+    size_t max_frame_size_;
+    size_t recv_unacked_ = 0; // Received, and not given back with WINDOW_UPDATE
+    size_t recv_consumed_ = 0;
+    std::string header_block_; // Collects HEADERS and CONTINUATION frames
+    std::uint32_t header_block_stream_ = 0;
+    bool header_block_end_stream_ = false;
+    bool closing_ = false;
+    bool going_away_ = false;
+    std::exception_ptr error_;
+    clock_t::time_point last_used_ = clock_t::now();
+    mutable std::mutex mutex_;
+};
+
+/*! A request on a Http2Session
+ *
+ * Owned by the request, and by the writer and reader it creates. The
+ * stream is reset if it is released before the response is received.
+ */
+class Http2Stream {
+public:
+    using ptr_t = std::shared_ptr<Http2Stream>;
+
+    Http2Stream(Http2Session::ptr_t session, Http2Session::stream_ptr_t stream)
+    : session_{std::move(session)}, stream_{std::move(stream)}
+    {
+    }
+
+    Http2Stream(const Http2Stream&) = delete;
+    Http2Stream& operator = (const Http2Stream&) = delete;
+
+    ~Http2Stream();
+
+    /*! Send the request headers
+     *
+     * Waits if the server's limit for concurrent streams is reached.
+     *
+     * \param endStream true if the request has no body
+     */
+    void Open(const Http2Session::header_list_t& headers, bool endStream,
+              Context& ctx, int timeoutMs) {
+        session_->Open(stream_, headers, endStream, ctx, timeoutMs);
+    }
+
+    /*! Wait for the response headers. Informational responses are skipped. */
+    void WaitForResponse(Context& ctx, int timeoutMs,
+                         Reply::HttpResponse& response, headers_t& headers) {
+        session_->WaitForResponse(stream_, ctx, timeoutMs, response, headers);
+    }
+
+    std::uint32_t GetId() const;
+
+    /*! Reset the stream if it is open
+     *
+     * The request and reader using it fail. Can be called from any thread.
+     */
+    void Cancel() {
+        session_->Cancel(stream_);
+    }
+
+    boost::uuids::uuid GetConnectionId() const {
+        return session_->GetConnectionId();
+    }
+
+    /*! Writes the request body in DATA frames */
+    static DataWriter::ptr_t CreateWriter(const ptr_t& stream, Context& ctx,
+                                          const DataWriter::WriteConfig& cfg);
+
+    /*! Reads the response body from the DATA frames */
+    static DataReader::ptr_t CreateReader(const ptr_t& stream, Context& ctx,
+                                          const DataReader::ReadConfig& cfg);
+
+private:
+    friend class Http2StreamWriter;
+    friend class Http2StreamReader;
+
+    const Http2Session::ptr_t session_;
+    const Http2Session::stream_ptr_t stream_;
+};
+
+/*! The HTTP/2 sessions of a RestClient, by origin
+ *
+ * Requests share a session until the server's limit of concurrent streams
+ * is reached. Only one connection is made to an origin at the time, and
+ * origins that do not agree on HTTP/2 with ALPN are remembered.
+ */
+class Http2SessionPool {
+public:
+    using connect_fn_t = std::function<Connection::ptr_t ()>;
+
+    explicit Http2SessionPool(RestClient& owner)
+    : owner_{owner}
+    {
+    }
+
+    /*! Get a stream on a session to the origin
+     *
+     * \param origin "scheme://host:port"
+     * \param tls True if the connection uses TLS, and HTTP/2 must be
+     *      agreed on with ALPN.
+     * \param connect Makes a new connection for a session. Returns nullptr
+     *      if the connection failed, and the error is reported elsewhere.
+     * \param http1Connection Set to the new connection if the server did
+     *      not agree on HTTP/2.
+     * \return nullptr if HTTP/2 can not be used.
+     */
+    Http2Stream::ptr_t GetStream(const std::string& origin, bool tls, Context& ctx,
+                                 const connect_fn_t& connect,
+                                 Connection::ptr_t& http1Connection);
+
+    /*! Close the sessions that have had no streams for ttl */
+    void CloseIdle(std::chrono::seconds ttl);
+
+    void Close();
+
+    size_t GetSessionCount() const;
+
+private:
+    struct Origin {
+        std::vector<Http2Session::ptr_t> sessions;
+        std::vector<std::function<void ()>> waiters; // For the connection in progress
+        bool connecting = false;
+        bool http1Only = false;
+    };
+
+    void DoneConnecting(const std::string& origin, Http2Session::ptr_t session,
+                        bool http1Only);
+
+    RestClient& owner_;
+    std::unordered_map<std::string, Origin> origins_;
+    bool closed_ = false;
+    mutable std::mutex mutex_;
+};
+
+} // namespace
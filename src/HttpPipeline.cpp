@@ -0,0 +1,364 @@
+
+#include <algorithm>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/Connection.h"
+#include "restc-cpp/Socket.h"
+#include "restc-cpp/logging.h"
+
+#include "HttpPipeline.h"
+#include "Suspend.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+PipelinedRequest::ptr_t HttpPipeline::TryAdd() {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (failed_ || retired_ || (requests_ >= max_depth_)) {
+        return {};
+    }
+    ++requests_;
+    return make_shared<PipelinedRequest>(shared_from_this());
+}
+
+void HttpPipeline::SetConnection(Connection::ptr_t connection) {
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        if (connection && !failed_) {
+            connection_ = std::move(connection);
+        } else {
+            failed_ = true;
+        }
+        NotifyAll();
+    }
+
+    if (connection) {
+        // We failed while connecting. Don't reuse the connection.
+        connection->GetSocket().Close();
+    }
+}
+
+void HttpPipeline::Fail() {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    FailLocked();
+}
+
+bool HttpPipeline::IsUsable() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return !failed_ && !retired_;
+}
+
+void HttpPipeline::FailLocked() {
+    if (!failed_) {
+        failed_ = true;
+        if (connection_) {
+            RESTC_CPP_LOG_DEBUG_("HttpPipeline: Closing " << *connection_
+                                 << ". The pipeline failed.");
+            connection_->GetSocket().Close();
+        }
+    }
+    NotifyAll();
+}
+
+void HttpPipeline::NotifyAll() {
+    for(auto& waiter : waiters_) {
+        waiter();
+    }
+    waiters_.clear();
+}
+
+std::unique_lock<std::mutex> HttpPipeline::Wait(Context& ctx, int timeoutMs,
+                                                const std::function<bool ()>& ready) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (ready()) {
+        return lock;
+    }
+    lock.unlock();
+
+    auto timed_out = make_shared<bool>(false);
+    boost::asio::steady_timer timer{ctx.GetClient().GetIoService()};
+    if (timeoutMs > 0) {
+        timer.RESTC_CPP_STEADY_TIMER_EXPIRES_AFTER(std::chrono::milliseconds{timeoutMs});
+        timer.async_wait([self = shared_from_this(), timed_out]
+                         (const boost::system::error_code& ec) {
+            if (ec) {
+                return;
+            }
+            std::lock_guard<std::mutex> const timer_lock{self->mutex_};
+            *timed_out = true;
+            self->NotifyAll();
+        });
+    }
+
+    while(true) {
+        Suspend(ctx, [&](function<void ()> resume) {
+            std::unique_lock<std::mutex> park_lock{mutex_};
+            if (*timed_out || ready()) {
+                park_lock.unlock();
+                resume();
+                return;
+            }
+            waiters_.push_back(std::move(resume));
+        });
+
+        lock.lock();
+        if (ready()) {
+            timer.cancel();
+            return lock;
+        }
+        if (*timed_out) {
+            throw RequestTimeOutException();
+        }
+        lock.unlock();
+    }
+}
+
+void HttpPipeline::OnRequestDone(const PipelinedRequest& request) {
+    Connection::ptr_t connection;
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        assert(requests_ > 0);
+        --requests_;
+
+        if (request.sending_) {
+            // The request is partially written
+            writing_ = false;
+            FailLocked();
+        } else if (request.ticket_) {
+            if (!request.complete_
+                || !connection_ || !connection_->GetSocket().IsOpen()) {
+                // The response is not read, so we don't know where the next one starts
+                FailLocked();
+            } else {
+                ++reading_ticket_;
+                NotifyAll();
+            }
+        }
+
+        if (requests_ == 0) {
+            retired_ = true;
+            connection = std::move(connection_);
+            if (connection && !unread_.empty()) {
+                RESTC_CPP_LOG_DEBUG_("HttpPipeline: Closing " << *connection
+                                     << ". It has unexpected data.");
+                connection->GetSocket().Close();
+            }
+        }
+    }
+
+    // Back to the connection pool, if it is still open
+    connection.reset();
+}
+
+PipelinedRequest::~PipelinedRequest() {
+    pipeline_->OnRequestDone(*this);
+}
+
+void PipelinedRequest::WaitForTurnToSend(Context& ctx) {
+    auto& pipeline = *pipeline_;
+
+    // The connection, or the request before us, may take a while. The
+    // connect and send timeouts apply to them.
+    auto lock = pipeline.Wait(ctx, 0, [&pipeline] {
+        return pipeline.failed_ || (pipeline.connection_ && !pipeline.writing_);
+    });
+
+    if (pipeline.failed_) {
+        throw PipelineBrokenException();
+    }
+
+    pipeline.writing_ = true;
+    sending_ = true;
+    ticket_ = pipeline.next_ticket_++;
+}
+
+void PipelinedRequest::Sent() {
+    std::lock_guard<std::mutex> const lock{pipeline_->mutex_};
+    assert(sending_);
+    sending_ = false;
+    pipeline_->writing_ = false;
+    pipeline_->NotifyAll();
+}
+
+void PipelinedRequest::Abort() {
+    pipeline_->Fail();
+}
+
+void PipelinedRequest::WaitForTurnToRead(Context& ctx, int timeoutMs) {
+    assert(ticket_);
+    auto& pipeline = *pipeline_;
+    const auto ticket = *ticket_;
+
+    auto lock = pipeline.Wait(ctx, timeoutMs, [&pipeline, ticket] {
+        return pipeline.failed_ || (pipeline.reading_ticket_ == ticket);
+    });
+
+    if (pipeline.failed_) {
+        throw PipelineBrokenException();
+    }
+}
+
+boost::uuids::uuid PipelinedRequest::GetId() const {
+    return pipeline_->connection_->GetId();
+}
+
+Socket& PipelinedRequest::GetSocket() {
+    return pipeline_->connection_->GetSocket();
+}
+
+const Socket& PipelinedRequest::GetSocket() const {
+    return pipeline_->connection_->GetSocket();
+}
+
+/*! Reads a response from the pipeline's connection
+ *
+ * It starts with the data the previous response did not use, and
+ * gives back the data after its own response.
+ */
+class PipelinedReader : public DataReader {
+public:
+    PipelinedReader(PipelinedRequest::ptr_t request, Context& ctx, const ReadConfig& cfg)
+    : request_{request}
+    , pipeline_{request->pipeline_}
+    , source_{DataReader::CreateIoReader(request, ctx, cfg)}
+    {
+        std::lock_guard<std::mutex> const lock{pipeline_->mutex_};
+        buffer_.swap(pipeline_->unread_);
+    }
+
+    bool IsEof() const override {
+        return buffer_.empty() && source_->IsEof();
+    }
+
+    ::restc_cpp::boost_const_buffer ReadSome() override {
+        if (!buffer_.empty()) {
+            // Keep the data alive until the next call
+            pending_.clear();
+            pending_.swap(buffer_);
+            received_ = true;
+            return {pending_.data(), pending_.size()};
+        }
+
+        try {
+            auto data = source_->ReadSome();
+            if (boost::asio::buffer_size(data) > 0) {
+                received_ = true;
+            }
+            return data;
+        } catch(const boost::system::system_error& ex) {
+            if (received_) {
+                throw;
+            }
+
+            // The server closed the connection without responding. It
+            // may only take a limited number of requests on a connection.
+            RESTC_CPP_LOG_DEBUG_("PipelinedReader: No response: " << ex.what());
+            pipeline_->Fail();
+            throw PipelineBrokenException();
+        }
+    }
+
+    void Unread(boost_const_buffer data) override {
+        std::lock_guard<std::mutex> const lock{pipeline_->mutex_};
+        pipeline_->unread_.append(boost_buffer_cast(data),
+                                 boost::asio::buffer_size(data));
+    }
+
+    void Finish() override {
+        source_->Finish();
+        if (auto request = request_.lock()) {
+            std::lock_guard<std::mutex> const lock{pipeline_->mutex_};
+            request->complete_ = true;
+        }
+    }
+
+private:
+    const std::weak_ptr<PipelinedRequest> request_;
+    const HttpPipeline::ptr_t pipeline_;
+    DataReader::ptr_t source_;
+    std::string buffer_; // Unread data from the previous response
+    std::string pending_;
+    bool received_ = false;
+};
+
+DataReader::ptr_t PipelinedRequest::CreateReader(const ptr_t& request, Context& ctx,
+                                                 const DataReader::ReadConfig& cfg) {
+    return make_unique<PipelinedReader>(request, ctx, cfg);
+}
+
+PipelinedRequest::ptr_t HttpPipelinePool::GetRequest(const string& origin, size_t maxDepth,
+                                                     const connect_fn_t& connect) {
+    HttpPipeline::ptr_t pipeline;
+    PipelinedRequest::ptr_t request;
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        if (closed_) {
+            throw ObjectExpiredException("The connection-pool is closed.");
+        }
+
+        auto& pipelines = origins_[origin];
+        pipelines.erase(remove_if(pipelines.begin(), pipelines.end(), [](const auto& p) {
+            return !p->IsUsable();
+        }), pipelines.end());
+
+        for(const auto& p : pipelines) {
+            if (auto r = p->TryAdd()) {
+                return r;
+            }
+        }
+
+        pipeline = make_shared<HttpPipeline>(maxDepth);
+        request = pipeline->TryAdd();
+        pipelines.push_back(pipeline);
+    }
+
+    // The requests that join the pipeline while we connect wait in
+    // WaitForTurnToSend()
+    Connection::ptr_t connection;
+    try {
+        connection = connect();
+    } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+        pipeline->SetConnection({});
+        throw;
+    }
+
+    const bool connected = connection != nullptr;
+    pipeline->SetConnection(std::move(connection));
+    if (!connected) {
+        return {};
+    }
+
+    RESTC_CPP_LOG_TRACE_("HttpPipelinePool: New pipeline to " << origin);
+    return request;
+}
+
+void HttpPipelinePool::Close() {
+    decltype(origins_) origins;
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        closed_ = true;
+        origins.swap(origins_);
+    }
+
+    for(auto& [origin, pipelines] : origins) {
+        for(auto& pipeline : pipelines) {
+            pipeline->Fail();
+        }
+    }
+}
+
+size_t HttpPipelinePool::GetPipelineCount() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    size_t count = 0;
+    for(const auto& [origin, pipelines] : origins_) {
+        count += count_if(pipelines.begin(), pipelines.end(), [](const auto& p) {
+            return p->IsUsable();
+        });
+    }
+    return count;
+}
+
+} // namespace
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/Connection.h"
+#include "restc-cpp/DataReader.h"
+#include "restc-cpp/error.h"
+
+namespace restc_cpp {
+
+class PipelinedRequest;
+
+/*! The server did not respond to a pipelined request, and the pipeline
+ * can not be used any more. The request can be sent again.
+ */
+struct PipelineBrokenException : public CommunicationException
+{
+    PipelineBrokenException()
+    : CommunicationException("The HTTP/1.1 pipeline is broken") {}
+};
+
+/*! HTTP/1.1 requests pipelined on one connection (RFC 9112, section 9.3.2)
+ *
+ * The requests are written back to back, without waiting for the
+ * responses. The responses come in the same order, and each request
+ * reads its response when the ones before it are complete.
+ *
+ * If a request fails, the connection is closed, and the requests that
+ * have not got their responses fail with PipelineBrokenException.
+ *
+ * When the last request is done, the connection goes back to the
+ * connection pool, and the pipeline is retired.
+ */
+class HttpPipeline : public std::enable_shared_from_this<HttpPipeline> {
+public:
+    using ptr_t = std::shared_ptr<HttpPipeline>;
+
+    explicit HttpPipeline(size_t maxDepth)
+    : max_depth_{maxDepth}
+    {
+    }
+
+    HttpPipeline(const HttpPipeline&) = delete;
+    HttpPipeline& operator = (const HttpPipeline&) = delete;
+
+    /*! Add a request, if there is room for it
+     *
+     * \return nullptr if the pipeline is full, failed or retired.
+     */
+    std::shared_ptr<PipelinedRequest> TryAdd();
+
+    /*! Set the connection when it is established
+     *
+     * \param connection nullptr if we failed to connect.
+     */
+    void SetConnection(Connection::ptr_t connection);
+
+    /*! Close the connection, and fail the requests without responses */
+    void Fail();
+
+    /*! False when no more requests can be added */
+    bool IsUsable() const;
+
+    size_t GetMaxDepth() const noexcept {
+        return max_depth_;
+    }
+
+private:
+    friend class PipelinedRequest;
+    friend class PipelinedReader;
+
+    /*! Suspend the coroutine until ready() returns true
+     *
+     * ready() is called with the mutex locked.
+     *
+     * \return The lock on the mutex, taken when ready() returned true.
+     * \throws RequestTimeOutException
+     */
+    std::unique_lock<std::mutex> Wait(Context& ctx, int timeoutMs,
+                                      const std::function<bool ()>& ready);
+
+    void OnRequestDone(const PipelinedRequest& request);
+
+    // Called with the mutex locked
+    void FailLocked();
+    void NotifyAll();
+
+    const size_t max_depth_;
+    Connection::ptr_t connection_;
+    size_t requests_ = 0; // Added, and not done
+    std::uint64_t next_ticket_ = 0; // In the order the requests are written
+    std::uint64_t reading_ticket_ = 0; // The request that reads its response
+    bool writing_ = false;
+    bool failed_ = false;
+    bool retired_ = false;
+    std::string unread_; // Received after the last response that was read
+    std::vector<std::function<void ()>> waiters_;
+    mutable std::mutex mutex_;
+};
+
+/*! A request on a HttpPipeline
+ *
+ * It is the connection for the request and its reply. When the reply
+ * releases it, the next response on the pipeline can be read.
+ */
+class PipelinedRequest : public Connection {
+public:
+    using ptr_t = std::shared_ptr<PipelinedRequest>;
+
+    explicit PipelinedRequest(HttpPipeline::ptr_t pipeline)
+    : pipeline_{std::move(pipeline)}
+    {
+    }
+
+    PipelinedRequest(const PipelinedRequest&) = delete;
+    PipelinedRequest& operator = (const PipelinedRequest&) = delete;
+
+    ~PipelinedRequest() override;
+
+    /*! Wait until the request can be written
+     *
+     * Call Sent() when the request is written.
+     *
+     * \throws PipelineBrokenException
+     */
+    void WaitForTurnToSend(Context& ctx);
+
+    void Sent();
+
+    /*! Give up the pipeline after a failure to write the request */
+    void Abort();
+
+    /*! Wait until the responses before this one are read
+     *
+     * \throws PipelineBrokenException, RequestTimeOutException
+     */
+    void WaitForTurnToRead(Context& ctx, int timeoutMs);
+
+    /*! Reads the response from the connection
+     *
+     * The data after the response is kept for the next request. If the
+     * connection fails before any of the response is received,
+     * PipelineBrokenException is thrown.
+     */
+    static DataReader::ptr_t CreateReader(const ptr_t& request, Context& ctx,
+                                          const DataReader::ReadConfig& cfg);
+
+    boost::uuids::uuid GetId() const override;
+    Socket& GetSocket() override;
+    const Socket& GetSocket() const override;
+
+private:
+    friend class HttpPipeline;
+    friend class PipelinedReader;
+
+    const HttpPipeline::ptr_t pipeline_;
+    boost::optional<std::uint64_t> ticket_; // Set when we start to write
+    bool sending_ = false;
+    bool complete_ = false; // The response is read
+};
+
+/*! The HTTP/1.1 pipelines of a RestClient, by origin */
+class HttpPipelinePool {
+public:
+    using connect_fn_t = std::function<Connection::ptr_t ()>;
+
+    /*! Add a request to a pipeline to the origin
+     *
+     * A new pipeline is made if the others are full.
+     *
+     * \param origin "scheme://host:port"
+     * \param maxDepth Max requests in a new pipeline
+     * \param connect Makes the connection for a new pipeline. Returns
+     *      nullptr if the connection failed, and the error is reported
+     *      elsewhere.
+     * \return nullptr if we failed to connect.
+     */
+    PipelinedRequest::ptr_t GetRequest(const std::string& origin, size_t maxDepth,
+                                       const connect_fn_t& connect);
+
+    void Close();
+
+    size_t GetPipelineCount() const;
+
+private:
+    std::unordered_map<std::string, std::vector<HttpPipeline::ptr_t>> origins_;
+    bool closed_ = false;
+    mutable std::mutex mutex_;
+};
+
+} // namespace
@@ -4,13 +4,14 @@
 #include "restc-cpp/DataReader.h"
 #include "restc-cpp/logging.h"
 #include "restc-cpp/IoTimer.h"
+#include "restc-cpp/internals/RecycledObject.h"
 
 using namespace std;
 
 namespace restc_cpp {
 
 
-class IoReaderImpl : public DataReader {
+class IoReaderImpl : public DataReader, public RecycledObject<IoReaderImpl> {
 public:
     using buffer_t = std::array<char, RESTC_CPP_IO_BUFFER_SIZE>;
 
@@ -31,29 +32,28 @@ public:
                                         conn);
 
             for(size_t retries = 0;; ++retries) {
-                size_t bytes = 0;
-                try {
-                    if (retries != 0u) {
-                        RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: taking a nap");
-                        ctx_.Sleep(retries * 20ms);
-                        RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: Waking up. Will try to read from the socket now.");
-                    }
+                if (retries != 0u) {
+                    RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: taking a nap");
+                    ctx_.Sleep(retries * 20ms);
+                    RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: Waking up. Will try to read from the socket now.");
+                }
 
-                    bytes = conn->GetSocket().AsyncReadSome(
-                        {buffer_.data(), buffer_.size()}, ctx_.GetYield());
-                } catch (const boost::system::system_error& ex) {
-                    if (ex.code() == boost::system::errc::resource_unavailable_try_again) {
-                        if ( retries < 32) {
-                            RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: Caught boost::system::system_error exception: " << ex.what()
-                                                 << ". I will continue the retry loop.");
-                            continue;
-                        }
+                boost::system::error_code ec;
+                const auto bytes = conn->GetSocket().AsyncReadSome(
+                    {buffer_.data(), buffer_.size()}, ctx_.GetYield(), ec);
+
+                if (ec) {
+                    if ((ec == boost::system::errc::resource_unavailable_try_again)
+                        && (retries < 32)) {
+                        RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: " << ec.message()
+                                             << ". I will continue the retry loop.");
+                        continue;
+                    }
+                    RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: " << ec.message());
+                    if (ec == Error::TIME_OUT) {
+                        throw RequestTimeOutException();
                     }
-                    RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: Caught boost::system::system_error exception: " << ex.what());
-                    throw;
-                } catch (const exception& ex) {
-                    RESTC_CPP_LOG_DEBUG_("IoReaderImpl::ReadSome: Caught exception: " << ex.what());
-                    throw;
+                    throw boost::system::system_error(ec);
                 }
 
                 RESTC_CPP_LOG_TRACE_("Read #" << bytes
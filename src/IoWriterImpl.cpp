@@ -5,13 +5,14 @@
 #include "restc-cpp/DataWriter.h"
 #include "restc-cpp/logging.h"
 #include "restc-cpp/IoTimer.h"
+#include "restc-cpp/internals/RecycledObject.h"
 
 using namespace std;
 
 namespace restc_cpp {
 
 
-class IoWriterImpl : public DataWriter {
+class IoWriterImpl : public DataWriter, public RecycledObject<IoWriterImpl> {
 public:
     IoWriterImpl(const Connection::ptr_t& conn, Context& ctx,
                  const WriteConfig& cfg)
@@ -0,0 +1,48 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "LatencyTracker.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+LatencyTracker::LatencyTracker(size_t window, size_t minSamples)
+: window_{max<size_t>(1, window)}, min_samples_{max<size_t>(1, min(minSamples, window_))}
+{
+}
+
+void LatencyTracker::Add(const std::string& origin, duration_t latency) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    auto& samples = origins_[origin];
+    if (samples.ring.size() < window_) {
+        samples.ring.push_back(latency);
+        return;
+    }
+
+    samples.ring[samples.next] = latency;
+    samples.next = (samples.next + 1) % window_;
+}
+
+boost::optional<LatencyTracker::duration_t>
+LatencyTracker::GetPercentile(const std::string& origin, double percentile) const {
+    std::vector<duration_t> sorted;
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        const auto it = origins_.find(origin);
+        if ((it == origins_.end()) || (it->second.ring.size() < min_samples_)) {
+            return {};
+        }
+        sorted = it->second.ring;
+    }
+
+    // Nearest rank
+    const auto fraction = clamp(percentile, 0.0, 100.0) / 100.0;
+    auto rank = static_cast<size_t>(ceil(fraction * static_cast<double>(sorted.size())));
+    rank = clamp<size_t>(rank, 1, sorted.size()) - 1;
+    nth_element(sorted.begin(), sorted.begin() + static_cast<ptrdiff_t>(rank), sorted.end());
+    return sorted[rank];
+}
+
+} // namespace
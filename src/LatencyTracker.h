@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+namespace restc_cpp {
+
+/*! The recent response times from each origin
+ *
+ * Keeps the last samples for each origin in a ring buffer.
+ *
+ * The implementation is thread-safe.
+ */
+class LatencyTracker {
+public:
+    using duration_t = std::chrono::steady_clock::duration;
+
+    /*!
+     * \param window Samples to keep for each origin
+     * \param minSamples Samples we need before we estimate a percentile
+     */
+    explicit LatencyTracker(size_t window = 100, size_t minSamples = 20);
+
+    /*! Add a sample
+     *
+     * \param origin "scheme://host:port"
+     * \param latency Time from the request was sent until the
+     *      response headers arrived.
+     */
+    void Add(const std::string& origin, duration_t latency);
+
+    /*! Get a percentile of the recent samples
+     *
+     * \param percentile 0 - 100
+     * \return The latency, or nothing if we don't have enough samples.
+     */
+    boost::optional<duration_t> GetPercentile(const std::string& origin,
+                                              double percentile) const;
+
+private:
+    struct Samples {
+        std::vector<duration_t> ring;
+        size_t next = 0; // Replaced when the ring is full
+    };
+
+    const size_t window_;
+    const size_t min_samples_;
+    std::unordered_map<std::string, Samples> origins_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace
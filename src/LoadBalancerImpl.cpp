@@ -0,0 +1,318 @@
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/logging.h"
+
+#include "LoadBalancerImpl.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+constexpr size_t max_ejection_factor = 10;
+
+string ToString(const LoadBalancerImpl::endpoint_t& endpoint) {
+    ostringstream out;
+    out << endpoint;
+    return out.str();
+}
+
+/*! Stable across processes, so that all the clients agree on the address for a key */
+uint64_t GetAffinityScore(const std::string& key, const LoadBalancerImpl::endpoint_t& endpoint) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    const auto add = [&hash](const unsigned char *data, size_t len) {
+        for(size_t i = 0; i < len; ++i) {
+            hash ^= data[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    add(reinterpret_cast<const unsigned char *>(key.data()), key.size());
+    const auto address = endpoint.address();
+    if (address.is_v4()) {
+        const auto bytes = address.to_v4().to_bytes();
+        add(bytes.data(), bytes.size());
+    } else {
+        const auto bytes = address.to_v6().to_bytes();
+        add(bytes.data(), bytes.size());
+    }
+    const auto port = endpoint.port();
+    const unsigned char port_bytes[] = {static_cast<unsigned char>(port >> 8),
+                                        static_cast<unsigned char>(port & 0xff)};
+    add(port_bytes, sizeof(port_bytes));
+
+    // FNV-1a mixes the last bytes poorly. Finish with the splitmix64 finalizer.
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+}
+
+} // anonymous namespace
+
+LoadBalancerImpl::Ticket::Ticket(std::shared_ptr<LoadBalancerImpl> balancer,
+                                 endpoint_t endpoint)
+: balancer_{std::move(balancer)}, endpoint_{std::move(endpoint)}
+{
+}
+
+LoadBalancerImpl::Ticket::~Ticket() {
+    Release(Outcome::NONE);
+}
+
+LoadBalancerImpl::Ticket&
+LoadBalancerImpl::Ticket::operator = (Ticket&& v) noexcept {
+    if (this != &v) {
+        Release(Outcome::NONE);
+        balancer_ = std::move(v.balancer_);
+        endpoint_ = v.endpoint_;
+        start_ = v.start_;
+    }
+    return *this;
+}
+
+void LoadBalancerImpl::Ticket::OnResponse(int statusCode) {
+    Release(((statusCode / 100) == 5) ? Outcome::FAILURE : Outcome::SUCCESS);
+}
+
+void LoadBalancerImpl::Ticket::OnFailure() {
+    Release(Outcome::FAILURE);
+}
+
+void LoadBalancerImpl::Ticket::Release(Outcome outcome) {
+    if (balancer_) {
+        auto balancer = std::move(balancer_);
+        balancer->Release(endpoint_, start_, outcome);
+    }
+}
+
+LoadBalancerImpl::LoadBalancerImpl(const Config& config)
+: config_{config}, random_{random_device{}()}
+{
+}
+
+std::vector<LoadBalancer::EndpointStats> LoadBalancerImpl::GetStats() const {
+    const auto now = clock_t::now();
+    std::vector<EndpointStats> stats;
+
+    std::lock_guard<std::mutex> const lock{mutex_};
+    stats.reserve(endpoints_.size());
+    for(const auto& [endpoint, state] : endpoints_) {
+        EndpointStats es;
+        es.endpoint = ToString(endpoint);
+        es.outstanding = state.outstanding;
+        es.latencyMs = state.latencyMs;
+        es.ejected = state.ejectedUntil > now;
+        stats.push_back(std::move(es));
+    }
+    return stats;
+}
+
+const std::vector<std::string> *
+LoadBalancerImpl::GetUpstreams(const std::string& host) const {
+    const auto it = config_.upstreams.find(host);
+    if (it == config_.upstreams.end() || it->second.empty()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+LoadBalancerImpl::endpoints_t
+LoadBalancerImpl::Order(const std::string& host, endpoints_t endpoints,
+                        const std::string& affinityKey) {
+    if (endpoints.size() < 2) {
+        return endpoints;
+    }
+
+    const auto now = clock_t::now();
+    std::lock_guard<std::mutex> const lock{mutex_};
+
+    Prune(now);
+    for(const auto& endpoint : endpoints) {
+        const auto it = endpoints_.find(endpoint);
+        if (it != endpoints_.end()) {
+            it->second.lastSeen = now;
+        }
+    }
+
+    const auto is_ejected = [this, now](const endpoint_t& endpoint) {
+        const auto it = endpoints_.find(endpoint);
+        return (it != endpoints_.end()) && (it->second.ejectedUntil > now);
+    };
+
+    if (!affinityKey.empty()) {
+        // Rendezvous hashing. The address with the highest score for the key
+        // wins. If it goes away, only its keys move, to their second best.
+        std::vector<std::pair<uint64_t, endpoint_t>> scored;
+        scored.reserve(endpoints.size());
+        for(const auto& endpoint : endpoints) {
+            scored.emplace_back(GetAffinityScore(affinityKey, endpoint), endpoint);
+        }
+        sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) {
+            return a.first > b.first;
+        });
+        stable_partition(scored.begin(), scored.end(),
+                         [&](const auto& v) { return !is_ejected(v.second); });
+
+        for(size_t i = 0; i < scored.size(); ++i) {
+            endpoints[i] = scored[i].second;
+        }
+
+        RESTC_CPP_LOG_TRACE_("LoadBalancer: Chose " << endpoints.front() << " for " << host
+                             << " by affinity key");
+        return endpoints;
+    }
+
+    // Start at a different address each time, so that ties are spread out
+    const auto next = next_[host]++;
+    rotate(endpoints.begin(),
+           endpoints.begin() + static_cast<ptrdiff_t>(next % endpoints.size()),
+           endpoints.end());
+
+    const auto healthy_end = stable_partition(endpoints.begin(), endpoints.end(),
+                                              [&](const auto& ep) { return !is_ejected(ep); });
+    const auto healthy = static_cast<size_t>(distance(endpoints.begin(), healthy_end));
+
+    const auto outstanding = [this](const endpoint_t& endpoint) -> size_t {
+        const auto it = endpoints_.find(endpoint);
+        return (it == endpoints_.end()) ? 0 : it->second.outstanding;
+    };
+
+    switch(config_.strategy) {
+    case Strategy::ROUND_ROBIN:
+        break;
+    case Strategy::LEAST_OUTSTANDING:
+        stable_sort(endpoints.begin(), healthy_end, [&](const auto& a, const auto& b) {
+            return outstanding(a) < outstanding(b);
+        });
+        break;
+    case Strategy::P2C_EWMA:
+        if (healthy >= 2) {
+            uniform_int_distribution<size_t> pick(0, healthy - 1);
+            const auto first = pick(random_);
+            auto second = pick(random_);
+            while(second == first) {
+                second = pick(random_);
+            }
+
+            const auto best = (GetCost(endpoints[second]) < GetCost(endpoints[first]))
+                ? second : first;
+            rotate(endpoints.begin(), endpoints.begin() + static_cast<ptrdiff_t>(best),
+                   endpoints.begin() + static_cast<ptrdiff_t>(best + 1));
+        }
+        break;
+    }
+
+    RESTC_CPP_LOG_TRACE_("LoadBalancer: Chose " << endpoints.front() << " for " << host
+                         << " (" << healthy << " of " << endpoints.size()
+                         << " addresses are healthy)");
+    return endpoints;
+}
+
+LoadBalancerImpl::Ticket LoadBalancerImpl::Start(const endpoint_t& endpoint) {
+    const auto now = clock_t::now();
+    std::lock_guard<std::mutex> const lock{mutex_};
+    Prune(now);
+    ++Touch(endpoint, now).outstanding;
+    return {shared_from_this(), endpoint};
+}
+
+void LoadBalancerImpl::OnConnectFailed(const endpoint_t& endpoint) {
+    const auto now = clock_t::now();
+    std::lock_guard<std::mutex> const lock{mutex_};
+    OnFailure(endpoint, Touch(endpoint, now), now);
+}
+
+void LoadBalancerImpl::Release(const endpoint_t& endpoint, clock_t::time_point start,
+                               Outcome outcome) {
+    const auto now = clock_t::now();
+    std::lock_guard<std::mutex> const lock{mutex_};
+    auto& state = Touch(endpoint, now);
+    assert(state.outstanding > 0);
+    --state.outstanding;
+
+    if (outcome == Outcome::SUCCESS) {
+        const auto latency = chrono::duration<double, milli>(now - start).count();
+        if (!state.hasLatency) {
+            state.latencyMs = latency;
+            state.hasLatency = true;
+        } else {
+            // The old samples fade out with time, not with the number of samples
+            const auto elapsed = chrono::duration<double, milli>(now - state.lastSample).count();
+            const auto weight = exp(-elapsed / max(1, config_.latencyDecayMs));
+            state.latencyMs = (state.latencyMs * weight) + (latency * (1.0 - weight));
+        }
+        state.lastSample = now;
+        state.failures = 0;
+        state.ejections = 0;
+    } else if (outcome == Outcome::FAILURE) {
+        OnFailure(endpoint, state, now);
+    }
+}
+
+LoadBalancerImpl::Endpoint&
+LoadBalancerImpl::Touch(const endpoint_t& endpoint, clock_t::time_point now) {
+    auto& state = endpoints_[endpoint];
+    state.lastSeen = now;
+    return state;
+}
+
+void LoadBalancerImpl::Prune(clock_t::time_point now) {
+    if (now < next_prune_) {
+        return;
+    }
+
+    const auto ttl = chrono::milliseconds{max(0, config_.endpointTtlMs)};
+    next_prune_ = now + ttl;
+
+    for(auto it = endpoints_.begin(); it != endpoints_.end();) {
+        if ((it->second.outstanding == 0) && ((now - it->second.lastSeen) >= ttl)) {
+            RESTC_CPP_LOG_TRACE_("LoadBalancer: Forgetting " << it->first);
+            it = endpoints_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LoadBalancerImpl::OnFailure(const endpoint_t& endpoint, Endpoint& state,
+                                 clock_t::time_point now) {
+    if ((config_.ejectAfterFailures == 0) || (++state.failures < config_.ejectAfterFailures)) {
+        return;
+    }
+
+    state.failures = 0;
+    state.ejections = min(state.ejections + 1, max_ejection_factor);
+    state.ejectedUntil = now + (chrono::milliseconds{config_.ejectionTimeMs} * state.ejections);
+
+    RESTC_CPP_LOG_DEBUG_("LoadBalancer: Ejecting " << endpoint << " for "
+                         << (config_.ejectionTimeMs * state.ejections) << " ms");
+}
+
+double LoadBalancerImpl::GetCost(const endpoint_t& endpoint) const {
+    const auto it = endpoints_.find(endpoint);
+    if (it == endpoints_.end()) {
+        return 1.0; // Try the new ones
+    }
+
+    const auto& state = it->second;
+    return (state.latencyMs + 1.0) * static_cast<double>(state.outstanding + 1);
+}
+
+LoadBalancer::ptr_t LoadBalancer::Create() {
+    return Create(Config{});
+}
+
+LoadBalancer::ptr_t LoadBalancer::Create(const Config& config) {
+    return make_shared<LoadBalancerImpl>(config);
+}
+
+} // namespace
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio/ip/tcp.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/LoadBalancer.h"
+
+namespace restc_cpp {
+
+class LoadBalancerImpl : public LoadBalancer,
+                         public std::enable_shared_from_this<LoadBalancerImpl> {
+public:
+    using clock_t = std::chrono::steady_clock;
+    using endpoint_t = boost::asio::ip::tcp::endpoint;
+    using endpoints_t = std::vector<endpoint_t>;
+
+    enum class Outcome {
+        NONE, // Don't learn from the request
+        SUCCESS,
+        FAILURE
+    };
+
+    /*! A request in progress to an address
+     *
+     * Report the outcome with OnResponse() or OnFailure().
+     */
+    class Ticket {
+    public:
+        Ticket() = default;
+        Ticket(std::shared_ptr<LoadBalancerImpl> balancer, endpoint_t endpoint);
+        Ticket(const Ticket&) = delete;
+        Ticket(Ticket&& v) noexcept = default;
+        ~Ticket();
+
+        Ticket& operator = (const Ticket&) = delete;
+        Ticket& operator = (Ticket&& v) noexcept;
+
+        /*! The response headers are received */
+        void OnResponse(int statusCode);
+
+        /*! The request failed before we got a response */
+        void OnFailure();
+
+        explicit operator bool () const noexcept {
+            return static_cast<bool>(balancer_);
+        }
+
+    private:
+        void Release(Outcome outcome);
+
+        std::shared_ptr<LoadBalancerImpl> balancer_;
+        endpoint_t endpoint_;
+        clock_t::time_point start_ = clock_t::now();
+    };
+
+    explicit LoadBalancerImpl(const Config& config);
+
+    std::vector<EndpointStats> GetStats() const override;
+
+    /*! The static upstreams for a host, or nullptr */
+    const std::vector<std::string> *GetUpstreams(const std::string& host) const;
+
+    /*! Order the addresses of a server by preference
+     *
+     * The first is chosen by the strategy, or by rendezvous hashing
+     * if there is an affinity key. The rest are fallbacks, with the
+     * ejected addresses last.
+     *
+     * \param host The host name of the server
+     * \param affinityKey Request::SetAffinityKey(), or empty
+     */
+    endpoints_t Order(const std::string& host, endpoints_t endpoints,
+                      const std::string& affinityKey = {});
+
+    /*! A request starts on a connection to the address */
+    Ticket Start(const endpoint_t& endpoint);
+
+    /*! We failed to connect to the address */
+    void OnConnectFailed(const endpoint_t& endpoint);
+
+private:
+    struct Endpoint {
+        std::size_t outstanding = 0;
+        double latencyMs = 0; // EWMA
+        bool hasLatency = false;
+        clock_t::time_point lastSample;
+        std::size_t failures = 0; // In a row
+        std::size_t ejections = 0; // In a row
+        clock_t::time_point ejectedUntil;
+        clock_t::time_point lastSeen; // Resolved or used
+    };
+
+    void Release(const endpoint_t& endpoint, clock_t::time_point start, Outcome outcome);
+
+    // The methods below are called with the mutex locked
+    Endpoint& Touch(const endpoint_t& endpoint, clock_t::time_point now);
+    void Prune(clock_t::time_point now);
+    void OnFailure(const endpoint_t& endpoint, Endpoint& state, clock_t::time_point now);
+    double GetCost(const endpoint_t& endpoint) const;
+
+    const Config config_;
+    std::map<endpoint_t, Endpoint> endpoints_;
+    std::unordered_map<std::string, std::size_t> next_; // Round-robin, by host
+    clock_t::time_point next_prune_;
+    std::mt19937 random_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace
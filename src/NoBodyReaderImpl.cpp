@@ -1,12 +1,13 @@
 #include "restc-cpp/restc-cpp.h"
 #include "restc-cpp/DataReader.h"
+#include "restc-cpp/internals/RecycledObject.h"
 
 using namespace std;
 
 namespace restc_cpp {
 
 
-class NoBodyReaderImpl : public DataReader {
+class NoBodyReaderImpl : public DataReader, public RecycledObject<NoBodyReaderImpl> {
 public:
     NoBodyReaderImpl() = default;
 
@@ -0,0 +1,195 @@
+
+#include <algorithm>
+#include <cstring>
+
+#include <zlib.h>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataReader.h"
+#include "restc-cpp/DataReaderStream.h"
+#include "restc-cpp/error.h"
+
+#ifdef RESTC_CPP_WITH_LIBDEFLATE
+#   include <libdeflate.h>
+#endif
+
+#include "PlainReaderImpl.h"
+#include "OneShotZipReaderImpl.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+constexpr size_t gzip_trailer_len = 8;
+constexpr size_t min_output_size = 1024;
+constexpr size_t deflate_ratio_guess = 4;
+// We don't trust ISIZE for more than this, before we see the data
+constexpr size_t max_ratio_first_guess = 16;
+
+// The first guess for the size of the output
+size_t GuessOutputSize(const DataReader::Compression format,
+                       const boost::string_ref src, const size_t maxOutput) {
+    size_t guess = src.size() * deflate_ratio_guess;
+
+    if ((format == DataReader::Compression::GZIP) && (src.size() >= gzip_trailer_len)) {
+        // ISIZE, the last 4 bytes, is the size of the uncompressed data
+        // modulo 2^32, in little endian order. It comes from the server,
+        // so it's only a hint, and a small body can't make us allocate
+        // a lot of memory up front.
+        const auto *p = reinterpret_cast<const uint8_t *>(src.data() + src.size() - 4);
+        const auto isize = static_cast<size_t>(p[0])
+            | (static_cast<size_t>(p[1]) << 8)
+            | (static_cast<size_t>(p[2]) << 16)
+            | (static_cast<size_t>(p[3]) << 24);
+        guess = std::min(isize, src.size() * max_ratio_first_guess);
+    }
+
+    return std::min(std::max(guess, min_output_size), maxOutput);
+}
+
+// Returns false if the buffer can't grow any more
+bool Grow(InflatedBuffer& buffer, size_t& capacity, const size_t used,
+          const size_t maxOutput) {
+    if (capacity >= maxOutput) {
+        return false;
+    }
+
+    const auto new_capacity = std::min(capacity * 2, maxOutput);
+    unique_ptr<char[]> data{new char[new_capacity]};
+    memcpy(data.get(), buffer.data.get(), used);
+    buffer.data = std::move(data);
+    capacity = new_capacity;
+    return true;
+}
+
+#ifdef RESTC_CPP_WITH_LIBDEFLATE
+
+struct DecompressorDeleter {
+    void operator()(libdeflate_decompressor *d) const noexcept {
+        libdeflate_free_decompressor(d);
+    }
+};
+
+libdeflate_decompressor& GetDecompressor() {
+    thread_local unique_ptr<libdeflate_decompressor, DecompressorDeleter>
+        decompressor{libdeflate_alloc_decompressor()};
+
+    if (!decompressor) {
+        throw DecompressException("Failed to initialize decompression");
+    }
+
+    return *decompressor;
+}
+
+bool Inflate(const DataReader::Compression format,
+             const boost::string_ref src, const size_t maxOutput,
+             InflatedBuffer& buffer) {
+
+    auto& decompressor = GetDecompressor();
+    auto capacity = GuessOutputSize(format, src, maxOutput);
+    buffer.data.reset(new char[capacity]);
+
+    while(true) {
+        size_t len = 0;
+        const auto result = (format == DataReader::Compression::GZIP)
+            ? libdeflate_gzip_decompress(&decompressor, src.data(), src.size(),
+                                         buffer.data.get(), capacity, &len)
+            : libdeflate_zlib_decompress(&decompressor, src.data(), src.size(),
+                                         buffer.data.get(), capacity, &len);
+
+        switch(result) {
+            case LIBDEFLATE_SUCCESS:
+                buffer.size = len;
+                return true;
+            case LIBDEFLATE_INSUFFICIENT_SPACE:
+                // libdeflate starts over, so there is nothing to copy
+                if (!Grow(buffer, capacity, 0, maxOutput)) {
+                    return false;
+                }
+                break;
+            default:
+                throw DecompressException("Decompression failed");
+        }
+    }
+}
+
+#else
+
+bool Inflate(const DataReader::Compression format,
+             const boost::string_ref src, const size_t maxOutput,
+             InflatedBuffer& buffer) {
+
+    z_stream strm = {};
+    const auto wsize = (format == DataReader::Compression::GZIP) ? (MAX_WBITS | 16) : MAX_WBITS;
+    if (inflateInit2(&strm, wsize) != Z_OK) {
+        throw DecompressException("Failed to initialize decompression");
+    }
+
+    // Make sure inflateEnd() is called
+    unique_ptr<z_stream, int (*)(z_stream *)> guard{&strm, inflateEnd};
+
+    auto capacity = GuessOutputSize(format, src, maxOutput);
+    buffer.data.reset(new char[capacity]);
+
+    strm.next_in = const_cast<Bytef *>(reinterpret_cast<const Bytef *>(src.data()));
+    strm.avail_in = static_cast<decltype(strm.avail_in)>(src.size());
+
+    while(true) {
+        strm.next_out = reinterpret_cast<Bytef *>(buffer.data.get() + strm.total_out);
+        strm.avail_out = static_cast<decltype(strm.avail_out)>(capacity - strm.total_out);
+
+        const auto result = inflate(&strm, Z_FINISH);
+        switch(result) {
+            case Z_STREAM_END:
+                buffer.size = strm.total_out;
+                return true;
+            case Z_OK:
+            case Z_BUF_ERROR:
+                if (strm.avail_out == 0) {
+                    if (!Grow(buffer, capacity, strm.total_out, maxOutput)) {
+                        return false;
+                    }
+                    break;
+                }
+                // Out of input
+                throw DecompressException("Decompression failed - premature end of stream.");
+            default: {
+                std::string errmsg = "Decompression failed";
+                if (strm.msg != nullptr) {
+                    errmsg += ": ";
+                    errmsg += strm.msg;
+                }
+                throw DecompressException(errmsg);
+            }
+        }
+    }
+}
+
+#endif // RESTC_CPP_WITH_LIBDEFLATE
+
+} // anonymous namespace
+
+bool InflateAll(const DataReader::Compression format,
+                const boost::string_ref src, const size_t maxOutput,
+                InflatedBuffer& output) {
+    assert(format != DataReader::Compression::NONE);
+    if (Inflate(format, src, maxOutput, output)) {
+        return true;
+    }
+
+    output = {};
+    return false;
+}
+
+DataReader::ptr_t
+DataReader::CreateOneShotZipReader(size_t contentLength,
+                                   unique_ptr<DataReaderStream>&& source,
+                                   const Compression compression) {
+    assert(compression != Compression::NONE);
+    return make_unique<OneShotZipReaderImpl<PlainReaderImpl<DataReaderStream>>>(
+        compression, contentLength, std::move(source));
+}
+
+} // namespace
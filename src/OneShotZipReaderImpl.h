@@ -0,0 +1,138 @@
+#pragma once
+
+#include <memory>
+
+#include <boost/utility/string_ref.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataReader.h"
+#include "restc-cpp/logging.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+#include "ZipReaderImpl.h"
+
+namespace restc_cpp {
+
+/*! Decompressed data in one contiguous buffer */
+struct InflatedBuffer {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+};
+
+/*! Decompress a complete gzip or deflate body in one pass
+ *
+ * For gzip, the output buffer is pre-sized from the ISIZE field in
+ * the trailer, up to a small multiple of the size of the input. It
+ * grows as required, up to maxOutput bytes.
+ *
+ * \return false if the output exceeds maxOutput.
+ * \throws DecompressException if the data is invalid.
+ */
+bool InflateAll(DataReader::Compression format,
+                boost::string_ref src, size_t maxOutput,
+                InflatedBuffer& output);
+
+/*! A compressed body that is already read, as the source for a ZipReaderImpl */
+class CompressedBodySource {
+public:
+    CompressedBodySource(std::string data)
+    : data_{std::move(data)}
+    {
+    }
+
+    [[nodiscard]] bool IsEof() const noexcept { return eof_; }
+
+    void Finish() {}
+
+    ::restc_cpp::boost_const_buffer ReadSome() {
+        if (eof_) {
+            return {nullptr, 0};
+        }
+        eof_ = true;
+        return {data_.data(), data_.size()};
+    }
+
+private:
+    const std::string data_;
+    bool eof_ = false;
+};
+
+/*! Reads a complete compressed body of a known size, and decompresses it in one go
+ *
+ * The first call to ReadSome() returns the entire decompressed body,
+ * so the consumer get one large, contiguous buffer to work on,
+ * rather than many small pieces.
+ *
+ * If the decompressed body is larger than RESTC_CPP_SANE_DATA_LIMIT,
+ * the body is decompressed in pieces instead, from the compressed
+ * data that is already read.
+ *
+ * SourceT is the concrete body reader, which is held in place.
+ */
+template <typename SourceT>
+class OneShotZipReaderImpl final : public DataReader,
+                                   public RecycledObject<OneShotZipReaderImpl<SourceT>> {
+public:
+
+    template <typename... ArgsT>
+    OneShotZipReaderImpl(const Compression format, const size_t contentLength,
+                         ArgsT&&... args)
+    : source_{contentLength, std::forward<ArgsT>(args)...}
+    , format_{format}, content_length_{contentLength}
+    {
+    }
+
+    [[nodiscard]] bool IsEof() const override {
+        return streaming_ ? streaming_->IsEof() : done_;
+    }
+
+    void Finish() override {
+        source_.Finish();
+    }
+
+    ::restc_cpp::boost_const_buffer ReadSome() override {
+        if (streaming_) {
+            return streaming_->ReadSome();
+        }
+
+        if (done_) {
+            return {nullptr, 0};
+        }
+
+        // Gather the compressed body
+        std::string compressed;
+        compressed.reserve(content_length_);
+        while(!source_.IsEof()) {
+            const auto buffer = source_.ReadSome();
+            compressed.append(boost_buffer_cast(buffer),
+                              boost::asio::buffer_size(buffer));
+        }
+
+        if (!InflateAll(format_, compressed, RESTC_CPP_SANE_DATA_LIMIT, output_)) {
+            RESTC_CPP_LOG_TRACE_("OneShotZipReaderImpl::ReadSome: "
+                << compressed.size() << " bytes inflates to more than "
+                << RESTC_CPP_SANE_DATA_LIMIT << " bytes. Streaming it.");
+
+            streaming_ = std::make_unique<ZipReaderImpl<CompressedBodySource>>(
+                format_, std::move(compressed));
+            return streaming_->ReadSome();
+        }
+
+        done_ = true;
+
+        RESTC_CPP_LOG_TRACE_("OneShotZipReaderImpl::ReadSome: Inflated "
+            << compressed.size() << " bytes to " << output_.size << " bytes");
+
+        return {output_.data.get(), output_.size};
+    }
+
+private:
+    SourceT source_;
+    const Compression format_;
+    const size_t content_length_;
+    InflatedBuffer output_;
+    std::unique_ptr<ZipReaderImpl<CompressedBodySource>> streaming_;
+    bool done_ = false;
+};
+
+} // namespace
@@ -1,54 +1,40 @@
+
 #include "restc-cpp/restc-cpp.h"
-#include "restc-cpp/Connection.h"
-#include "restc-cpp/Socket.h"
 #include "restc-cpp/DataReader.h"
+#include "restc-cpp/DataReaderStream.h"
 #include "restc-cpp/error.h"
 
-using namespace std;
-
-namespace restc_cpp {
-
-class PlainReaderImpl : public DataReader {
-public:
+#include "PlainReaderImpl.h"
 
-    PlainReaderImpl(size_t contentLength, ptr_t&& source)
-    : remaining_{contentLength},
-      source_{std::move(source)} {}
+#ifdef RESTC_CPP_WITH_ZLIB
+#   include "ZipReaderImpl.h"
+#endif
 
-    [[nodiscard]] bool IsEof() const override { return remaining_ == 0; }
-
-    void Finish() override {
-        if (source_) {
-            source_->Finish();
-        }
-    }
+using namespace std;
 
-    ::restc_cpp::boost_const_buffer ReadSome() override {
+namespace restc_cpp {
 
-        if (IsEof()) {
-            return {nullptr, 0};
-        }
+DataReader::ptr_t
+DataReader::CreatePlainReader(size_t contentLength, ptr_t&& source) {
+    return make_unique<PlainReaderImpl<DataReader>>(contentLength, std::move(source));
+}
 
-        auto buffer = source_->ReadSome();
-        const auto bytes = boost::asio::buffer_size(buffer);
+DataReader::ptr_t
+DataReader::CreatePlainReader(size_t contentLength,
+                              unique_ptr<DataReaderStream>&& source,
+                              const Compression compression) {
 
-        if ((static_cast<int64_t>(remaining_)
-            - static_cast<int64_t>(bytes)) < 0) {
-            throw ProtocolException("Body-size exceeds content-size");
-        }
-        remaining_ -= bytes;
-        return buffer;
+    if ((compression == Compression::NONE) || (contentLength == 0)) {
+        return make_unique<PlainReaderImpl<DataReaderStream>>(
+            contentLength, std::move(source));
     }
 
-private:
-    size_t remaining_;
-    ptr_t source_;
-};
-
-DataReader::ptr_t
-DataReader::CreatePlainReader(size_t contentLength, ptr_t&& source) {
-    return make_unique<PlainReaderImpl>(contentLength, std::move(source));
+#ifdef RESTC_CPP_WITH_ZLIB
+    return make_unique<ZipReaderImpl<PlainReaderImpl<DataReaderStream>>>(
+        compression, contentLength, std::move(source));
+#else
+    throw NotSupportedException("Compiled without zlib.");
+#endif
 }
 
-
 } // namespace
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataReader.h"
+#include "restc-cpp/DataReaderStream.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+namespace restc_cpp {
+
+/*! Reads a body of a known size.
+ *
+ * SourceT is DataReader for the generic reader chain. When it is a
+ * final class, like DataReaderStream, the calls to the source are
+ * resolved at compile time.
+ */
+template <typename SourceT>
+class PlainReaderImpl final : public DataReader,
+                              public RecycledObject<PlainReaderImpl<SourceT>> {
+public:
+
+    PlainReaderImpl(size_t contentLength, std::unique_ptr<SourceT>&& source)
+    : remaining_{contentLength},
+      source_{std::move(source)} {}
+
+    [[nodiscard]] bool IsEof() const override { return remaining_ == 0; }
+
+    void Finish() override {
+        if (source_) {
+            source_->Finish();
+        }
+    }
+
+    ::restc_cpp::boost_const_buffer ReadSome() override {
+
+        if (IsEof()) {
+            return {nullptr, 0};
+        }
+
+        auto buffer = ReadFrom(*source_, remaining_);
+        const auto bytes = boost::asio::buffer_size(buffer);
+
+        if ((static_cast<int64_t>(remaining_)
+            - static_cast<int64_t>(bytes)) < 0) {
+            throw ProtocolException("Body-size exceeds content-size");
+        }
+        remaining_ -= bytes;
+        return buffer;
+    }
+
+private:
+    // A stream stops at the end of the body. What follows is the next
+    // response on a pipelined connection.
+    static ::restc_cpp::boost_const_buffer ReadFrom(DataReaderStream& source, size_t maxBytes) {
+        return source.GetData(maxBytes);
+    }
+
+    static ::restc_cpp::boost_const_buffer ReadFrom(DataReader& source, size_t /*maxBytes*/) {
+        return source.ReadSome();
+    }
+
+    size_t remaining_;
+    std::unique_ptr<SourceT> source_;
+};
+
+} // namespace
@@ -4,13 +4,14 @@
 #include "restc-cpp/Socket.h"
 #include "restc-cpp/DataWriter.h"
 #include "restc-cpp/logging.h"
+#include "restc-cpp/internals/RecycledObject.h"
 
 using namespace std;
 
 namespace restc_cpp {
 
 
-class PlainWriterImpl : public DataWriter {
+class PlainWriterImpl : public DataWriter, public RecycledObject<PlainWriterImpl> {
 public:
     PlainWriterImpl(size_t contentLength, ptr_t&& source)
     : next_{std::move(source)},  content_length_{contentLength}
@@ -33,9 +34,12 @@ public:
         next_->Finish();
     }
 
+    void Flush() override {
+        next_->Flush();
+    }
+
     void SetHeaders(Request::headers_t& headers) override {
-        static const string content_length{"Content-Length"};
-        headers[content_length] = to_string(content_length_);
+        headers[header_names::content_length] = to_string(content_length_);
         next_->SetHeaders(headers);
     }
 
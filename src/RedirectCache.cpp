@@ -0,0 +1,88 @@
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RedirectCache.h"
+#include "restc-cpp/logging.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+boost::optional<std::string> RedirectCache::Lookup(const std::string& key) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+
+    auto it = redirects_.find(key);
+    if (it == redirects_.end()) {
+        return {};
+    }
+
+    if (it->second->expires <= clock_t::now()) {
+        RESTC_CPP_LOG_TRACE_("RedirectCache: '" << key << "' has expired");
+        lru_.erase(it->second);
+        redirects_.erase(it);
+        return {};
+    }
+
+    // Most recently used first
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->location;
+}
+
+void RedirectCache::Add(const std::string& key, const std::string& location) {
+    if (max_entries_ == 0) {
+        return;
+    }
+
+    // The key is "METHOD url"
+    const auto space = key.find(' ');
+    if ((space != string::npos) && (key.compare(space + 1, string::npos, location) == 0)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> const lock{mutex_};
+
+    const auto expires = clock_t::now() + ttl_;
+    auto it = redirects_.find(key);
+    if (it != redirects_.end()) {
+        it->second->location = location;
+        it->second->expires = expires;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+
+    if (redirects_.size() >= max_entries_) {
+        RESTC_CPP_LOG_TRACE_("RedirectCache: Evicting '" << lru_.back().key << "'");
+        redirects_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+
+    RESTC_CPP_LOG_TRACE_("RedirectCache: '" << key << "' is moved to '" << location << "'");
+    lru_.push_front({key, location, expires});
+    redirects_.emplace(key, lru_.begin());
+}
+
+void RedirectCache::Remove(const std::string& key) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+
+    auto it = redirects_.find(key);
+    if (it != redirects_.end()) {
+        lru_.erase(it->second);
+        redirects_.erase(it);
+    }
+}
+
+void RedirectCache::Clear() {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    redirects_.clear();
+    lru_.clear();
+}
+
+size_t RedirectCache::GetSize() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return redirects_.size();
+}
+
+RedirectCache::ptr_t RedirectCache::Create(size_t maxEntries, std::chrono::seconds ttl) {
+    return make_shared<RedirectCache>(maxEntries, ttl);
+}
+
+} // namespace
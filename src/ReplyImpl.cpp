@@ -28,6 +28,14 @@ boost::optional<string> ReplyImpl::GetHeader(const string& name) {
     return rval;
 }
 
+const std::string *ReplyImpl::FindHeader(const HeaderName& name) const {
+    auto it = headers_.find(name);
+    if (it != headers_.end()) {
+        return &it->second;
+    }
+    return nullptr;
+}
+
 std::deque<std::string> ReplyImpl::GetHeaders(const std::string& name) {
     std::deque<std::string> rval;
 
@@ -66,6 +74,18 @@ ReplyImpl::ReplyImpl(Connection::ptr_t connection,
 {
 }
 
+ReplyImpl::ReplyImpl(const boost::uuids::uuid& connectionId,
+                     Context& ctx,
+                     RestClient& owner,
+                     Request::Properties::ptr_t& properties,
+                     Request::Type type)
+: ctx_{ctx}
+, properties_{properties}
+, owner_{owner}
+, connection_id_(connectionId)
+, request_type_{type}
+{
+}
 
 ReplyImpl::~ReplyImpl() {
     if (connection_ && connection_->GetSocket().IsOpen()) {
@@ -106,35 +126,96 @@ void ReplyImpl::StartReceiveFromServer(DataReader::ptr_t&& reader) {
     CheckIfWeAreDone();
 }
 
+void ReplyImpl::StartReceiveFromStream(HttpResponse&& response, headers_t&& headers,
+                                       DataReader::ptr_t&& reader) {
+    if (reader_) {
+        throw RestcCppException("StartReceiveFromStream() is already called.");
+    }
+
+    assert(reader);
+    response_ = std::move(response);
+    headers_ = std::move(headers);
+    reader_ = std::move(reader);
+
+    if (const auto cl = FindHeader(header_names::content_length)) {
+        content_length_ = stoi(*cl);
+    }
+
+    // The stream ends after the headers if there is no body
+    content_encoding_handled_ = request_type_ == Request::Type::HEAD;
+
+    HandleDecompression();
+    CheckIfWeAreDone();
+}
+
 void ReplyImpl::HandleContentType(unique_ptr<DataReaderStream>&& stream) {
-    static const std::string content_len_name{"Content-Length"};
-    static const std::string transfer_encoding_name{"Transfer-Encoding"};
     static const std::string chunked_name{"chunked"};
 
     if (request_type_ == Request::Type::HEAD) {
         reader_ = DataReader::CreateNoBodyReader();
-    } else if (const auto cl = GetHeader(content_len_name)) {
+        content_encoding_handled_ = true;
+    } else if (const auto cl = FindHeader(header_names::content_length)) {
+        const auto compression = GetInPlaceCompression();
         content_length_ = stoi(*cl);
-        reader_ = DataReader::CreatePlainReader(*content_length_, std::move(stream));
+#ifdef RESTC_CPP_WITH_ZLIB
+        if ((compression != DataReader::Compression::NONE)
+            && (*content_length_ > 0)
+            && (*content_length_ <= properties_->oneShotDecompressLimit)) {
+            reader_ = DataReader::CreateOneShotZipReader(*content_length_, std::move(stream),
+                                                         compression);
+        } else
+#endif
+        {
+            reader_ = DataReader::CreatePlainReader(*content_length_, std::move(stream),
+                                                    compression);
+        }
+        content_encoding_handled_ = compression != DataReader::Compression::NONE;
     } else {
-        auto te = GetHeader(transfer_encoding_name);
+        const auto te = FindHeader(header_names::transfer_encoding);
         if (te && ciEqLibC()(*te, chunked_name)) {
+            const auto compression = GetInPlaceCompression();
             reader_ = DataReader::CreateChunkedReader([this](string&& name, string&& value) {
                 headers_[name] = std::move(value);
-            },  std::move(stream));
+            },  std::move(stream), compression);
+            content_encoding_handled_ = compression != DataReader::Compression::NONE;
         } else {
             reader_ = DataReader::CreateNoBodyReader();
+            content_encoding_handled_ = true;
         }
     }
+
+    if (stream) {
+        // No body. The stream is done with the response.
+        stream->Finish();
+    }
+}
+
+DataReader::Compression ReplyImpl::GetInPlaceCompression() {
+#ifdef RESTC_CPP_WITH_ZLIB
+    static const std::string gzip{"gzip"};
+    static const std::string deflate{"deflate"};
+
+    // The fused readers handle one encoding. Anything else goes
+    // through the generic reader chain in HandleDecompression()
+    const auto ce_hdr = FindHeader(header_names::content_encoding);
+    if (ce_hdr) {
+        if (ciEqLibC()(gzip, *ce_hdr)) {
+            return DataReader::Compression::GZIP;
+        }
+        if (ciEqLibC()(deflate, *ce_hdr)) {
+            return DataReader::Compression::DEFLATE;
+        }
+    }
+#endif // RESTC_CPP_WITH_ZLIB
+    return DataReader::Compression::NONE;
 }
 
 void ReplyImpl::HandleConnectionLifetime() {
-    static const std::string connection_name{"Connection"};
     static const std::string close_name{"close"};
 
     // Check for Connection: close header and tag the
     // connection for close
-    const auto conn_hdr = GetHeader(connection_name);
+    const auto conn_hdr = FindHeader(header_names::connection);
     if (conn_hdr && ciEqLibC()(*conn_hdr, close_name)) {
         if (connection_) {
             RESTC_CPP_LOG_TRACE_("'Connection: close' header. "
@@ -144,12 +225,42 @@ void ReplyImpl::HandleConnectionLifetime() {
     }
 }
 
+// Keep this in sync with HandleDecompression()
+const std::string& DataReader::GetAcceptEncoding() {
+    static const std::string encodings = [] {
+        std::string rval;
+        const auto add = [&rval](const char *name) {
+            if (!rval.empty()) {
+                rval += ", ";
+            }
+            rval += name;
+        };
+#ifdef RESTC_CPP_WITH_ZSTD
+        add("zstd");
+#endif
+#ifdef RESTC_CPP_WITH_BROTLI
+        add("br");
+#endif
+#ifdef RESTC_CPP_WITH_ZLIB
+        add("gzip");
+#endif
+        return rval;
+    }();
+
+    return encodings;
+}
+
 void ReplyImpl::HandleDecompression() {
-    static const std::string content_encoding{"Content-Encoding"};
     static const std::string gzip{"gzip"};
     static const std::string deflate{"deflate"};
+    static const std::string br{"br"};
+    static const std::string zstd{"zstd"};
 
-    const auto te_hdr = GetHeader(content_encoding);
+    if (content_encoding_handled_) {
+        return;
+    }
+
+    const auto te_hdr = FindHeader(header_names::content_encoding);
     if (!te_hdr) {
         return;
     }
@@ -158,17 +269,29 @@ void ReplyImpl::HandleDecompression() {
     for(auto it = tok.begin(); it != tok.end(); ++it) {
 #ifdef RESTC_CPP_WITH_ZLIB
         if (ciEqLibC()(gzip, *it)) {
-            RESTC_CPP_LOG_TRACE_("Adding gzip reader to " << *connection_);
+            RESTC_CPP_LOG_TRACE_("Adding gzip reader to " << connection_id_);
             reader_ = DataReader::CreateGzipReader(std::move(reader_));
         } else if (ciEqLibC()(deflate, *it)) {
-            RESTC_CPP_LOG_TRACE_("Adding deflate reader to " << *connection_);
+            RESTC_CPP_LOG_TRACE_("Adding deflate reader to " << connection_id_);
             reader_ = DataReader::CreateZipReader(std::move(reader_));
         } else
 #endif // RESTC_CPP_WITH_ZLIB
+#ifdef RESTC_CPP_WITH_BROTLI
+        if (ciEqLibC()(br, *it)) {
+            RESTC_CPP_LOG_TRACE_("Adding brotli reader to " << connection_id_);
+            reader_ = DataReader::CreateBrotliReader(std::move(reader_));
+        } else
+#endif // RESTC_CPP_WITH_BROTLI
+#ifdef RESTC_CPP_WITH_ZSTD
+        if (ciEqLibC()(zstd, *it)) {
+            RESTC_CPP_LOG_TRACE_("Adding zstd reader to " << connection_id_);
+            reader_ = DataReader::CreateZstdReader(std::move(reader_));
+        } else
+#endif // RESTC_CPP_WITH_ZSTD
         {
             RESTC_CPP_LOG_ERROR_("Unsupported compression: '"
                 << url_encode(*it)
-                << "' from server on " << *connection_);
+                << "' from server on " << connection_id_);
             throw NotSupportedException("Unsupported compression.");
         }
     }
@@ -201,7 +324,7 @@ string ReplyImpl::GetBodyAsString(const size_t maxSize) {
                       buffer_size);
     }
 
-    ReleaseConnection();
+    CheckIfWeAreDone();
     return buffer;
 }
 
@@ -211,7 +334,7 @@ void ReplyImpl::fetchAndIgnore()
         reader_->ReadSome();
     }
 
-    ReleaseConnection();
+    CheckIfWeAreDone();
 }
 
 void ReplyImpl::CheckIfWeAreDone() {
@@ -13,12 +13,13 @@
 #include "restc-cpp/Socket.h"
 #include "restc-cpp/IoTimer.h"
 #include "restc-cpp/DataReader.h"
+#include "restc-cpp/internals/RecycledObject.h"
 
 using namespace std;
 
 namespace restc_cpp {
 
-class ReplyImpl : public Reply {
+class ReplyImpl : public Reply, public RecycledObject<ReplyImpl> {
 public:
     enum class ChunkedState
         { NOT_CHUNKED, GET_SIZE, IN_SEGMENT, IN_TRAILER, DONE };
@@ -30,6 +31,11 @@ public:
     ReplyImpl(Connection::ptr_t connection, Context& ctx,
               RestClient& owner, Request::Type type);
 
+    /*! A reply that is not read from a connection of its own */
+    ReplyImpl(const boost::uuids::uuid& connectionId, Context& ctx,
+              RestClient& owner, Request::Properties::ptr_t& properties,
+              Request::Type type);
+
     ~ReplyImpl();
 
     boost::optional<string> GetHeader(const string& name) override;
@@ -37,6 +43,13 @@ public:
 
     void StartReceiveFromServer(DataReader::ptr_t&& reader);
 
+    /*! Start a reply where the status and headers are already received
+     *
+     * \param reader Reads the body, as sent by the server.
+     */
+    void StartReceiveFromStream(HttpResponse&& response, headers_t&& headers,
+                                DataReader::ptr_t&& reader);
+
     int GetResponseCode() const override {
         return response_.status_code;
     }
@@ -76,12 +89,18 @@ public:
         return !reader_ || reader_->IsEof();
     }
 
+    const headers_t& GetAllHeaders() const noexcept {
+        return headers_;
+    }
+
 
 protected:
     void CheckIfWeAreDone();
     void ReleaseConnection();
     void HandleDecompression();
     void HandleContentType(std::unique_ptr<DataReaderStream>&& stream);
+    DataReader::Compression GetInPlaceCompression();
+    const std::string *FindHeader(const HeaderName& name) const;
     void HandleConnectionLifetime();
 
     Connection::ptr_t connection_;
@@ -91,6 +110,7 @@ protected:
     Reply::HttpResponse response_;
     headers_t headers_;
     bool do_close_connection_ = false;
+    bool content_encoding_handled_ = false;
     boost::optional<size_t> content_length_;
     const boost::uuids::uuid connection_id_;
     std::unique_ptr<DataReader> reader_;
@@ -0,0 +1,88 @@
+#include <cassert>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RequestBody.h"
+#include "restc-cpp/DataWriter.h"
+
+using namespace std;
+
+
+namespace restc_cpp {
+namespace impl {
+
+/*! A body that references memory owned by someone else.
+ *
+ * The buffers are handed to the writer as they are. If keep_alive is
+ * set, the body holds a reference to it until the body is deleted.
+ */
+class RequestBodyBufferImpl : public RequestBody
+{
+public:
+    RequestBodyBufferImpl(write_buffers_t buffers,
+                          std::shared_ptr<const void> keepAlive)
+        : buffers_{std::move(buffers)}, keep_alive_{std::move(keepAlive)}
+        , size_{boost::asio::buffer_size(buffers_)}
+    {
+    }
+
+    [[nodiscard]] Type GetType() const noexcept override { return Type::FIXED_SIZE; }
+
+    [[nodiscard]] std::uint64_t GetFixedSize() const override { return size_; }
+
+    bool GetData(write_buffers_t & buffers) override {
+        if (eof_) {
+            return false;
+        }
+
+        buffers.insert(buffers.end(), buffers_.begin(), buffers_.end());
+        eof_ = true;
+        return true;
+    }
+
+    void Reset() override {
+        eof_ = false;
+    }
+
+    [[nodiscard]] std::string GetCopyOfData() const override {
+        std::string data;
+        data.reserve(size_);
+        for(const auto& b : buffers_) {
+            data.append(static_cast<const char *>(b.data()), b.size());
+        }
+        return data;
+    }
+
+private:
+    const write_buffers_t buffers_;
+    const std::shared_ptr<const void> keep_alive_;
+    const std::uint64_t size_;
+    bool eof_ = false;
+};
+
+
+} // impl
+
+std::unique_ptr<RequestBody> RequestBody::CreateViewBody(
+    boost::string_ref body) {
+
+    return make_unique<impl::RequestBodyBufferImpl>(
+        write_buffers_t{{body.data(), body.size()}}, nullptr);
+}
+
+std::unique_ptr<RequestBody> RequestBody::CreateSharedBody(
+    std::shared_ptr<const std::string> body) {
+
+    assert(body);
+    write_buffers_t buffers{{body->data(), body->size()}};
+    return make_unique<impl::RequestBodyBufferImpl>(
+        std::move(buffers), std::move(body));
+}
+
+std::unique_ptr<RequestBody> RequestBody::CreateGatherBody(
+    write_buffers_t buffers, std::shared_ptr<const void> keepAlive) {
+
+    return make_unique<impl::RequestBodyBufferImpl>(
+        std::move(buffers), std::move(keepAlive));
+}
+
+} // restc_cpp
@@ -0,0 +1,154 @@
+
+#include <atomic>
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/logging.h"
+
+#include "RequestCoalescerImpl.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+size_t RequestCoalescerImpl::GetInFlightCount() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return flights_.size();
+}
+
+std::pair<RequestCoalescerImpl::flight_ptr_t, bool>
+RequestCoalescerImpl::Join(const std::string& key) {
+    std::lock_guard<std::mutex> const lock{mutex_};
+
+    auto it = flights_.find(key);
+    if (it != flights_.end()) {
+        return {it->second, false};
+    }
+
+    auto flight = make_shared<Flight>();
+    flights_.emplace(key, flight);
+    return {std::move(flight), true};
+}
+
+void RequestCoalescerImpl::Complete(const std::string& key, Flight& flight,
+                                    ResponseCache::entry_t response,
+                                    std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        auto it = flights_.find(key);
+        if ((it != flights_.end()) && (it->second.get() == &flight)) {
+            flights_.erase(it);
+        }
+    }
+
+    decltype(flight.waiters) waiters;
+    {
+        std::lock_guard<std::mutex> const lock{flight.mutex};
+        flight.done = true;
+        flight.response = std::move(response);
+        flight.error = std::move(error);
+        waiters.swap(flight.waiters);
+    }
+
+    RESTC_CPP_LOG_TRACE_("RequestCoalescer: " << waiters.size()
+        << " requests are waiting for " << key);
+
+    for(auto& resume : waiters) {
+        resume();
+    }
+}
+
+RequestCoalescerImpl::Leader::~Leader() {
+    if (!completed_) {
+        RESTC_CPP_LOG_DEBUG_("RequestCoalescer: The request for " << key_
+            << " left without a result");
+        coalescer_.Complete(key_, *flight_, {});
+    }
+}
+
+void RequestCoalescerImpl::Leader::Complete(ResponseCache::entry_t response,
+                                            std::exception_ptr error) {
+    completed_ = true;
+    coalescer_.Complete(key_, *flight_, std::move(response), std::move(error));
+}
+
+ResponseCache::entry_t RequestCoalescerImpl::Wait(Flight& flight, Context& ctx,
+                                                  const int timeoutMs) {
+    const auto result = [&flight]() -> ResponseCache::entry_t {
+        if (flight.error) {
+            rethrow_exception(flight.error);
+        }
+        return flight.response;
+    };
+
+    {
+        std::lock_guard<std::mutex> const lock{flight.mutex};
+        if (flight.done) {
+            return result();
+        }
+    }
+
+    boost::asio::steady_timer timer{ctx.GetClient().GetIoService()};
+
+    // The completion handler of the coroutine is kept by the flight and
+    // the timer, and posted to the coroutine's executor by the first of
+    // them.
+    const auto suspend = [&flight, &timer, timeoutMs](auto handler) {
+        auto handler_ptr = make_shared<decltype(handler)>(std::move(handler));
+        auto resumed = make_shared<std::atomic_bool>(false);
+        const auto resume = [handler_ptr, resumed] {
+            if (!resumed->exchange(true)) {
+                boost::asio::post(std::move(*handler_ptr));
+            }
+        };
+
+        std::unique_lock<std::mutex> lock{flight.mutex};
+        if (flight.done) {
+            lock.unlock();
+            resume();
+            return;
+        }
+        flight.waiters.emplace_back(resume);
+
+        if (timeoutMs > 0) {
+            timer.RESTC_CPP_STEADY_TIMER_EXPIRES_AFTER(std::chrono::milliseconds{timeoutMs});
+            timer.async_wait([resume](const boost::system::error_code& ec) {
+                if (!ec) {
+                    resume();
+                }
+            });
+        }
+    };
+
+    // async_initiate() moves from the token, so it gets a copy of the
+    // context's yield, which is used by the coroutine after this.
+    auto yield = ctx.GetYield();
+#if BOOST_VERSION >= 107000
+    boost::asio::async_initiate<boost::asio::yield_context, void()>(
+        suspend, yield);
+#else
+    boost::asio::async_completion<boost::asio::yield_context, void()> init{yield};
+    suspend(std::move(init.completion_handler));
+    init.result.get();
+#endif
+
+    timer.cancel();
+
+    std::lock_guard<std::mutex> const lock{flight.mutex};
+    if (!flight.done) {
+        RESTC_CPP_LOG_DEBUG_("RequestCoalescer: Timed out after " << timeoutMs
+            << " ms. Sending the request.");
+        return {};
+    }
+    return result();
+}
+
+RequestCoalescer::ptr_t RequestCoalescer::Create(size_t maxBodySize) {
+    return make_shared<RequestCoalescerImpl>(maxBodySize);
+}
+
+} // namespace
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RequestCoalescer.h"
+#include "restc-cpp/ResponseCache.h"
+
+namespace restc_cpp {
+
+class RequestCoalescerImpl : public RequestCoalescer {
+public:
+    /*! One request to the server, and the requests waiting for it */
+    struct Flight {
+        std::mutex mutex;
+        bool done = false;
+        ResponseCache::entry_t response;
+        std::exception_ptr error;
+        std::vector<std::function<void()>> waiters;
+    };
+
+    using flight_ptr_t = std::shared_ptr<Flight>;
+
+    /*! The request that was first, and sends the request for the flight
+     *
+     * If it goes away without calling Complete(), for example when its
+     * coroutine is unwound, the waiting requests are told to send the
+     * request themselves.
+     */
+    class Leader {
+    public:
+        Leader(RequestCoalescerImpl& coalescer, std::string key, flight_ptr_t flight)
+        : coalescer_{coalescer}, key_{std::move(key)}, flight_{std::move(flight)}
+        {
+        }
+
+        Leader(const Leader&) = delete;
+        Leader& operator = (const Leader&) = delete;
+
+        ~Leader();
+
+        /*! \see RequestCoalescerImpl::Complete() */
+        void Complete(ResponseCache::entry_t response, std::exception_ptr error = {});
+
+    private:
+        RequestCoalescerImpl& coalescer_;
+        const std::string key_;
+        const flight_ptr_t flight_;
+        bool completed_ = false;
+    };
+
+    explicit RequestCoalescerImpl(size_t maxBodySize)
+    : max_body_size_{maxBodySize}
+    {
+    }
+
+    size_t GetInFlightCount() const override;
+
+    /*! Join the flight for the key
+     *
+     * \return The flight, and true if we are the first, and must
+     *      send the request and call Complete().
+     */
+    std::pair<flight_ptr_t, bool> Join(const std::string& key);
+
+    /*! Hand the result to the waiting requests
+     *
+     * \param response The buffered response, or nullptr if the
+     *      waiting requests must send the request themselves.
+     * \param error The exception the request failed with, if any.
+     */
+    void Complete(const std::string& key, Flight& flight,
+                  ResponseCache::entry_t response,
+                  std::exception_ptr error = {});
+
+    /*! Suspend the coroutine until the flight is complete
+     *
+     * \param timeoutMs Max time to wait. 0 waits until it is complete.
+     * \return The buffered response, or nullptr if the request
+     *      must be sent to the server. That includes when we time out.
+     * \throws The exception the request failed with.
+     */
+    static ResponseCache::entry_t Wait(Flight& flight, Context& ctx, int timeoutMs);
+
+    size_t GetMaxBodySize() const noexcept {
+        return max_body_size_;
+    }
+
+private:
+    const size_t max_body_size_;
+    std::unordered_map<std::string, flight_ptr_t> flights_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace
@@ -5,6 +5,7 @@
 #include <array>
 
 #include <boost/utility/string_ref.hpp>
+#include <boost/algorithm/string.hpp>
 
 #include "restc-cpp/restc-cpp.h"
 #include "restc-cpp/logging.h"
@@ -15,7 +16,24 @@
 #include "restc-cpp/error.h"
 #include "restc-cpp/url_encode.h"
 #include "restc-cpp/RequestBody.h"
+#include "restc-cpp/PreparedRequest.h"
+#include "restc-cpp/RedirectCache.h"
+#include "restc-cpp/RequestCoalescer.h"
+#include "restc-cpp/ResponseCache.h"
+#include "restc-cpp/ConcurrencyLimiter.h"
+#include "restc-cpp/LoadBalancer.h"
+#include "restc-cpp/internals/RecycledObject.h"
 #include "ReplyImpl.h"
+#include "BufferedReplyImpl.h"
+#include "CachePolicy.h"
+#include "RequestCoalescerImpl.h"
+#include "Http2Session.h"
+#include "Hedging.h"
+#include "HttpPipeline.h"
+#include "ConcurrencyLimiterImpl.h"
+#include "LatencyTracker.h"
+#include "LoadBalancerImpl.h"
+#include "RetryPolicyImpl.h"
 
 using namespace std;
 using namespace std::string_literals;
@@ -294,9 +312,137 @@ void DoSocks5Handshake(Connection& connection,
     }
     RESTC_CPP_LOG_TRACE_("DoSocks5Handshake - done");
 }
+
+/*! Url-encode src as one path segment, and append it to dst
+ *
+ * Unlike url_encode(), '/' is escaped, and so are the dot segments
+ * "." and "..", so that the value can not add or remove segments.
+ */
+void AppendPathSegment(const std::string& src, std::string& dst) {
+    if ((src == ".") || (src == "..")) {
+        for(size_t i = 0; i < src.size(); ++i) {
+            dst += "%2E";
+        }
+        return;
+    }
+
+    size_t start = 0;
+    for(auto pos = src.find('/'); pos != string::npos; pos = src.find('/', start)) {
+        url_encode({src.data() + start, pos - start}, dst);
+        dst += "%2F";
+        start = pos + 1;
+    }
+    url_encode({src.data() + start, src.size() - start}, dst);
+}
+
+/*! Remove the "." and ".." segments from an absolute path (RFC 3986, section 5.2.4)
+ *
+ * The query and fragment, if any, are left as they are.
+ */
+std::string RemoveDotSegments(const std::string& src) {
+    const auto end = std::min(src.find_first_of("?#"), src.size());
+
+    std::vector<std::string> segments;
+    bool directory = false;
+    for(size_t start = 1; start <= end;) {
+        auto pos = std::min(src.find('/', start), end);
+        const auto segment = src.substr(start, pos - start);
+        directory = (segment == ".") || (segment == "..");
+        if (segment == "..") {
+            if (!segments.empty()) {
+                segments.pop_back();
+            }
+        } else if (!directory) {
+            segments.push_back(segment);
+        }
+        start = pos + 1;
+    }
+
+    std::string path;
+    for(const auto& segment : segments) {
+        path += '/';
+        path += segment;
+    }
+    if (directory || path.empty()) {
+        path += '/';
+    }
+
+    path.append(src, end, string::npos);
+    return path;
+}
+
 } // anonumous ns
 
-class RequestImpl : public Request {
+class PreparedRequestImpl final
+    : public PreparedRequest
+    , public std::enable_shared_from_this<PreparedRequestImpl> {
+public:
+    using Properties = Request::Properties;
+    using Type = Request::Type;
+
+    PreparedRequestImpl(std::string url,
+                        Type requestType,
+                        RestClient& owner,
+                        const boost::optional<Request::args_t>& args,
+                        const boost::optional<Request::headers_t>& headers,
+                        const boost::optional<Request::auth_t>& auth);
+
+    std::unique_ptr<Request>
+    CreateRequest(const path_params_t& pathParams,
+                  std::unique_ptr<RequestBody> body,
+                  const boost::optional<Request::args_t>& args) const override;
+
+    [[nodiscard]] size_t GetNumPathParams() const noexcept override {
+        return path_segments_.size() - 1;
+    }
+
+    [[nodiscard]] const Properties& GetProperties() const override {
+        return *properties_;
+    }
+
+    [[nodiscard]] const Properties::ptr_t& GetPropertiesPtr() const noexcept {
+        return properties_;
+    }
+
+    [[nodiscard]] const Url& GetParsedUrl() const noexcept { return parsed_url_; }
+    [[nodiscard]] Type GetType() const noexcept { return request_type_; }
+    [[nodiscard]] RestClient& GetOwner() const noexcept { return owner_; }
+
+    /*! Verb, space and, for HTTP proxies, the origin */
+    [[nodiscard]] const std::string& GetRequestLinePrefix() const noexcept {
+        return request_line_prefix_;
+    }
+
+    /*! Host and all the static headers, each terminated by CRLF */
+    [[nodiscard]] const std::string& GetHeaderBlock() const noexcept {
+        return header_block_;
+    }
+
+    /*! "scheme://host:port", for logging and diagnostics. */
+    [[nodiscard]] const std::string& GetOrigin() const noexcept {
+        return origin_;
+    }
+
+private:
+    void ParsePath();
+    void BuildRequestLinePrefix();
+    void BuildStaticQuery();
+    void BuildHeaderBlock();
+
+    const std::string url_;
+    const Url parsed_url_;
+    const Type request_type_;
+    RestClient& owner_;
+    Properties::ptr_t properties_;
+    std::string origin_;
+    std::string request_line_prefix_;
+    std::vector<std::string> path_segments_; // url-encoded
+    std::string static_query_; // url-encoded, including the leading '?'
+    std::string header_block_;
+};
+
+class RequestImpl : public Request, public RecycledObject<RequestImpl> {
+    friend class PreparedRequestImpl;
 public:
 
     struct RedirectException{
@@ -331,28 +477,40 @@ public:
                 const boost::optional<headers_t>& headers,
                 const boost::optional<auth_t>& auth = {})
         : url_{std::move(url)}, parsed_url_{url_.c_str()} , request_type_{requestType}
-    , body_{std::move(body)}, owner_{owner}
+    , body_{std::move(body)}, properties_{owner.GetConnectionProperties()}
+    , owner_{owner}
     {
-       if (args || headers || auth) {
-           Properties::ptr_t const props = owner_.GetConnectionProperties();
-           assert(props);
-           properties_ = make_shared<Properties>(*props);
-
-           if (args) {
-               properties_->args.insert(properties_->args.end(), args->begin(), args->end());
-            }
+        assert(properties_);
 
-            merge_map(headers, properties_->headers);
+        // The request specific args and headers are kept on top of the
+        // shared properties, instead of in a private copy of them.
+        if (args) {
+            args_ = *args;
+        }
 
-            if (auth) {
-                SetAuth(*auth);
-            }
+        if (headers) {
+            headers_ = *headers;
+        }
 
-        } else {
-            properties_ = owner_.GetConnectionProperties();
+        if (auth) {
+            SetAuth(*auth);
         }
     }
 
+    /*! Request from a template
+     *
+     * \param target The url-encoded path and query
+     */
+    RequestImpl(std::shared_ptr<const PreparedRequestImpl> prepared,
+                std::string target,
+                std::unique_ptr<RequestBody> body)
+        : parsed_url_{prepared->GetParsedUrl()}, request_type_{prepared->GetType()}
+    , body_{std::move(body)}, properties_{prepared->GetPropertiesPtr()}
+    , owner_{prepared->GetOwner()}, prepared_{std::move(prepared)}
+    , prepared_target_{std::move(target)}
+    {
+    }
+
     // modified from http://stackoverflow.com/questions/180947/base64-decode-snippet-in-c
     static std::string Base64Encode(const std::string &in) {
         // Silence the cursed clang-tidy...
@@ -384,11 +542,15 @@ public:
     }
 
     void SetAuth(const Auth& auth) {
-        static const string authorization{"Authorization"};
+        SetAuth(auth, headers_);
+        effective_properties_.reset();
+    }
+
+    static void SetAuth(const Auth& auth, headers_t& headers) {
         static const string basic_sp{"Basic "};
 
         std::string pre_base = auth.name + ':' + auth.passwd;
-        properties_->headers[authorization]
+        headers[header_names::authorization]
             = basic_sp + Base64Encode(pre_base);
 #if __cplusplus >= 201703L  // C++17 or later
         std::memset(pre_base.data(), 0, pre_base.capacity());
@@ -400,10 +562,47 @@ public:
         pre_base.clear();
     }
 
-    [[nodiscard]] const Properties &GetProperties() const override { return *properties_; }
+    /*! The properties, with the request specific headers and args applied
+     *
+     * The merged copy is only made if someone asks for it.
+     */
+    [[nodiscard]] const Properties &GetProperties() const override {
+        if (headers_.empty() && args_.empty()) {
+            return *properties_;
+        }
+
+        if (!effective_properties_) {
+            effective_properties_ = make_shared<Properties>(*properties_);
+            auto& headers = effective_properties_->headers;
+            for(const auto& it : headers_) {
+                headers.erase(it.first);
+            }
+            headers.insert(headers_.begin(), headers_.end());
+            effective_properties_->args.insert(effective_properties_->args.end(),
+                                               args_.begin(), args_.end());
+        }
+
+        return *effective_properties_;
+    }
 
+    /*! Replaces the shared properties.
+     *
+     * The request specific headers, args and authentication
+     * still applies on top of them.
+     */
     void SetProperties(Properties::ptr_t propreties) override {
         properties_ = std::move(propreties);
+        effective_properties_.reset();
+        use_prepared_headers_ = false;
+    }
+
+    void SetAffinityKey(std::string key) override {
+        affinity_key_ = std::move(key);
+    }
+
+    void SetBodyCompression(Compression compression, int level) override {
+        body_compression_ = compression;
+        body_compression_level_ = level;
     }
 
     static const std::string &Verb(const Type requestType)
@@ -422,43 +621,195 @@ public:
     }
 
     unique_ptr<Reply> Execute(Context& ctx) override {
+        if (properties_->requestCoalescer && (request_type_ == Type::GET) && !body_) {
+            return CoalescedExecute(ctx, static_cast<RequestCoalescerImpl&>(
+                *properties_->requestCoalescer));
+        }
+
+        return ExecuteWithRedirects(ctx);
+    }
+
+    unique_ptr<Reply> Execute(Context& ctx, boost::system::error_code& ec) override {
+        ec = {};
+        ec_ = &ec;
+
+        unique_ptr<Reply> reply;
+        try {
+            reply = Execute(ctx);
+        } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+            // The errors we don't report in ec
+            ec = ToErrorCode(std::current_exception());
+        }
+        ec_ = nullptr;
+
+        if (reply && !ec && properties_->throwOnHttpError) {
+            const auto& response = reply->GetHttpResponse();
+            if (IsHttpError(response.status_code)) {
+                ec = make_http_error_code(response.status_code);
+            }
+        }
+
+        return reply;
+    }
+
+
+private:
+    unique_ptr<Reply> ExecuteWithRedirects(Context& ctx) {
+        constexpr auto http_303 = 303;
+
         int redirects = 0;
+        FollowCachedRedirects();
+
         while(true) {
-            try {
-                return DoExecute((ctx));
-            } catch(const RedirectException& ex) {
-                
-                auto url = ex.GetUrl();
-                
-                if (properties_->redirectFn) {
-                    properties_->redirectFn(ex.GetCode(), url, ex.GetRedirectReply());
-                }
-                
-                if ((properties_->maxRedirects >= 0)
-                    && (++redirects > properties_->maxRedirects)) {
-                    throw ConstraintException("Too many redirects.");
+            auto reply = ExecuteWithRetries(ctx);
+            if (!reply) {
+                return reply; // Error reported in ec_
+            }
+
+            const auto code = reply->GetResponseCode();
+            if (!IsRedirect(code)) {
+                return reply;
+            }
+
+            auto url = GetRedirectLocation(*reply);
+
+            if (properties_->redirectFn) {
+                properties_->redirectFn(code, url, *reply);
+            }
+
+            if ((properties_->maxRedirects >= 0)
+                && (++redirects > properties_->maxRedirects)) {
+                if (ec_) {
+                    *ec_ = Error::TOO_MANY_REDIRECTS;
+                    return {};
                 }
+                throw ConstraintException("Too many redirects.");
+            }
+
+            if (IsPermanentRedirect(code) && properties_->redirectCache) {
+                properties_->redirectCache->Add(GetRedirectKey(), url);
+            }
 
-                RESTC_CPP_LOG_DEBUG_("Redirecting ("
-                    << ex.GetCode()
-                    << ") '" << url_
-                    << "' --> '"
-                    << url
-                    << "') ");
-                url_ = std::move(url);
-                parsed_url_ = url_.c_str();
-                add_url_args_ = false; // Use whatever arguments we got in the redirect
+            // Let the connection be re-used
+            reply->fetchAndIgnore();
+            reply.reset();
+
+            // See other: Get the result from the new location
+            if ((code == http_303) && (request_type_ != Type::HEAD)) {
+                request_type_ = Type::GET;
+                body_.reset();
             }
+
+            RESTC_CPP_LOG_DEBUG_("Redirecting ("
+                << code
+                << ") '" << GetUrlForLog()
+                << "' --> '"
+                << url
+                << "') ");
+            SetRedirectUrl(std::move(url));
         }
     }
 
+    /*! Go directly to where the url was permanently redirected to earlier */
+    void FollowCachedRedirects() {
+        constexpr int max_unlimited_redirects = 20;
+
+        if (!properties_->redirectCache || (properties_->maxRedirects == 0)) {
+            return;
+        }
+
+        const auto max_redirects = (properties_->maxRedirects < 0)
+            ? max_unlimited_redirects : properties_->maxRedirects;
+
+        for(int i = 0; i < max_redirects; ++i) {
+            auto url = properties_->redirectCache->Lookup(GetRedirectKey());
+            if (!url) {
+                return;
+            }
+
+            RESTC_CPP_LOG_TRACE_("Using cached redirect '" << GetUrlForLog()
+                << "' --> '" << *url << "'");
+            SetRedirectUrl(std::move(*url));
+        }
+    }
+
+    void SetRedirectUrl(std::string url) {
+        url_ = std::move(url);
+        parsed_url_ = url_.c_str();
+        add_url_args_ = false; // Use whatever arguments we got in the redirect
+        prepared_.reset(); // The template is for the original host
+    }
+
+    static bool IsRedirect(const int code) noexcept {
+        switch(code) {
+            case 301:
+            case 302:
+            case 303:
+            case 307:
+            case 308:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static bool IsPermanentRedirect(const int code) noexcept {
+        return (code == 301) || (code == 308);
+    }
+
+    /*! The absolute url from the Location header of a redirect */
+    std::string GetRedirectLocation(Reply& reply) const {
+        auto location = reply.GetHeader(header_names::location);
+        if (!location) {
+            throw ProtocolException(
+                "No Location header in redirect reply");
+        }
+
+        if ((location->compare(0, 7, "http://") == 0)
+            || (location->compare(0, 8, "https://") == 0)) {
+            return std::move(*location);
+        }
+
+        // A relative reference (RFC 3986, section 4.2)
+        std::string url;
+        Append(url, parsed_url_.GetProtocolName());
+        if (location->compare(0, 2, "//") == 0) {
+            url.append(*location, 2, string::npos);
+            return url;
+        }
+
+        Append(url, parsed_url_.GetHost());
+        url += ':';
+        Append(url, parsed_url_.GetPort());
+
+        std::string path;
+        if (location->empty() || (location->front() != '/')) {
+            const auto base = parsed_url_.GetPath();
+            if (location->empty() || (location->front() == '?')
+                || (location->front() == '#')) {
+                Append(path, base);
+            } else {
+                Append(path, base.substr(0, base.rfind('/') + 1));
+            }
+            if (path.empty() || (path.front() != '/')) {
+                path.insert(0, 1, '/');
+            }
+        }
+        path += *location;
+
+        url += RemoveDotSegments(path);
+        return url;
+    }
+
+    static bool IsHttpError(const int code) noexcept {
+        constexpr auto magic_2 = 2;
+        constexpr auto magic_100 = 100;
+        return (code / magic_100) > magic_2;
+    }
 
-private:
     static void ValidateReply(const Reply &reply)
     {
         // Silence the cursed clang tidy!
-        constexpr auto magic_2 = 2;
-        constexpr auto magic_100 = 100;
         constexpr auto http_401 = 401;
         constexpr auto http_403 = 403;
         constexpr auto http_404 = 404;
@@ -468,7 +819,7 @@ private:
         constexpr auto http_408 = 408;
 
         const auto& response = reply.GetHttpResponse();
-        if ((response.status_code / magic_100) > magic_2) {
+        if (IsHttpError(response.status_code)) {
             switch (response.status_code) {
             case http_401:
                 throw HttpAuthenticationException(response);
@@ -493,62 +844,214 @@ private:
     std::string BuildOutgoingRequest() {
         static const std::string crlf{"\r\n"};
         static const std::string column{": "};
-        static const string host{"Host"};
 
-        std::ostringstream request_buffer;
+        // Appending to one pre-sized string is a lot cheaper than
+        // going through a std::ostringstream.
+        std::string request_buffer;
+        request_buffer.reserve(estimated_header_size_);
 
-        // Build the request-path
-        request_buffer << Verb(request_type_) << ' ';
+        if (prepared_) {
+            // Only the target and the body headers varies between
+            // requests made from the same template.
+            if (use_prepared_headers_) {
+                request_buffer += prepared_->GetRequestLinePrefix();
+            } else {
+                AppendRequestLinePrefix(request_buffer);
+            }
+            request_buffer += prepared_target_;
+        } else {
+            AppendRequestLinePrefix(request_buffer);
+
+            // Add arguments to the path as ?name=value&name=value...
+
+            if (add_url_args_) {
+                 bool first_arg = true;
+                // Normal processing.
+                url_encode(parsed_url_.GetPath(), request_buffer);
+                for(const auto *args : {&properties_->args, &args_}) {
+                    for(const auto& arg : *args) {
+                        if (first_arg) {
+                            first_arg = false;
+                            request_buffer += '?';
+                        } else {
+                            request_buffer += '&';
+                        }
 
-        if (properties_->proxy.type == Request::Proxy::Type::HTTP) {
-            request_buffer << parsed_url_.GetProtocolName() << parsed_url_.GetHost() << ":" << parsed_url_.GetPort();
+                        url_encode(arg.name, request_buffer);
+                        request_buffer += '=';
+                        url_encode(arg.value, request_buffer);
+                    }
+                }
+            } else {
+                // After a redirect. We The redirect-url in parsed_url_ should be encoded,
+                // and may be exactly what the target expects - so we do nothing here.
+                Append(request_buffer, parsed_url_.GetPath());
+                if (!parsed_url_.GetArgs().empty()) {
+                    request_buffer += '?';
+                    Append(request_buffer, parsed_url_.GetArgs());
+                }
+            }
         }
 
-        // Add arguments to the path as ?name=value&name=value...
+        request_buffer += " HTTP/1.1";
+        request_buffer += crlf;
 
-        if (add_url_args_) {
-             bool first_arg = true;
-            // Normal processing.
-            request_buffer << url_encode(parsed_url_.GetPath());
-            for(const auto& arg : properties_->args) {
-                if (first_arg) {
-                    first_arg = false;
-                    request_buffer << '?';
-                } else {
-                    request_buffer << '&';
+        assert(writer_);
+
+        // Let the writers set their individual headers.
+        headers_t body_headers;
+        writer_->SetHeaders(body_headers);
+
+        if (prepared_ && use_prepared_headers_) {
+            request_buffer += prepared_->GetHeaderBlock();
+        } else {
+            const auto& headers = properties_->headers;
+
+            if (!FindHeader(header_names::host)) {
+                request_buffer += header_names::host.str();
+                request_buffer += column;
+                Append(request_buffer, parsed_url_.GetHost());
+                request_buffer += crlf;
+            }
+
+            // The request headers replace the ones in the properties, and
+            // the headers from the writers replace them both.
+            for(const auto& it : headers) {
+                if ((headers_.find(it.first) == headers_.end())
+                    && (body_headers.find(it.first) == body_headers.end())) {
+                    AppendHeader(request_buffer, it);
                 }
+            }
 
-                request_buffer
-                    << url_encode(arg.name)
-                    << '=' << url_encode(arg.value);
+            for(const auto& it : headers_) {
+                if (body_headers.find(it.first) == body_headers.end()) {
+                    AppendHeader(request_buffer, it);
+                }
             }
-        } else {
-            // After a redirect. We The redirect-url in parsed_url_ should be encoded,
-            // and may be exactly what the target expects - so we do nothing here.
-            request_buffer << parsed_url_.GetPath();
         }
 
-        request_buffer << " HTTP/1.1" << crlf;
+        AppendHeaders(request_buffer, conditional_headers_);
+        AppendHeaders(request_buffer, body_headers);
 
-        // Build the header buffers
-        headers_t headers = properties_->headers;
-        assert(writer_);
+        // End the header section.
+        request_buffer += crlf;
 
-        // Let the writers set their individual headers.
-        writer_->SetHeaders(headers);
+        // Remember the size, in case we are redirected
+        estimated_header_size_ = std::max(estimated_header_size_,
+                                          request_buffer.size());
+        return request_buffer;
+    }
 
-        if (headers.find(host) == headers.end()) {
-            request_buffer << host << ": " << parsed_url_.GetHost().to_string() << crlf;
-        }
+    static void Append(std::string& dst, const boost::string_ref& src) {
+        dst.append(src.data(), src.size());
+    }
 
+    static void AppendHeader(std::string& dst, const headers_t::value_type& header) {
+        dst += header.first;
+        dst += ": ";
+        dst += header.second;
+        dst += "\r\n";
+    }
+
+    static void AppendHeaders(std::string& dst, const headers_t& headers) {
         for(const auto& it : headers) {
-            request_buffer << it.first << column << it.second << crlf;
+            AppendHeader(dst, it);
         }
+    }
 
-        // End the header section.
-        request_buffer << crlf;
+    void AppendRequestLinePrefix(std::string& dst) const {
+        AppendRequestLinePrefix(dst, request_type_, parsed_url_, *properties_);
+    }
+
+    static void AppendRequestLinePrefix(std::string& dst,
+                                        const Type requestType,
+                                        const Url& url,
+                                        const Properties& properties) {
+        dst += Verb(requestType);
+        dst += ' ';
+
+        if (properties.proxy.type == Request::Proxy::Type::HTTP) {
+            Append(dst, url.GetProtocolName());
+            Append(dst, url.GetHost());
+            dst += ':';
+            Append(dst, url.GetPort());
+        }
+    }
+
+    /*! Find a header in the request specific headers or the properties */
+    [[nodiscard]] const std::string *FindHeader(const HeaderName& name) const {
+        auto it = headers_.find(name);
+        if (it != headers_.end()) {
+            return &it->second;
+        }
+
+        it = properties_->headers.find(name);
+        if (it != properties_->headers.end()) {
+            return &it->second;
+        }
+
+        return nullptr;
+    }
+
+    [[nodiscard]] const std::string *FindHeader(const std::string& name) const {
+        auto it = headers_.find(name);
+        if (it != headers_.end()) {
+            return &it->second;
+        }
+
+        it = properties_->headers.find(name);
+        if (it != properties_->headers.end()) {
+            return &it->second;
+        }
+
+        return nullptr;
+    }
+
+    /*! The key for the response in a ResponseCache */
+    [[nodiscard]] std::string GetCacheKey() const {
+        if (prepared_) {
+            return prepared_->GetOrigin() + prepared_target_;
+        }
+
+        std::string key = url_;
+        if (add_url_args_) {
+            char separator = (url_.find('?') == string::npos) ? '?' : '&';
+            for(const auto *args : {static_cast<const args_t *>(&properties_->args), &args_}) {
+                for(const auto& arg : *args) {
+                    key += separator;
+                    separator = '&';
+                    url_encode(arg.name, key);
+                    key += '=';
+                    url_encode(arg.value, key);
+                }
+            }
+        }
+        return key;
+    }
+
+    /*! The key for the request in a RedirectCache */
+    [[nodiscard]] std::string GetRedirectKey() const {
+        return Verb(request_type_) + ' ' + GetCacheKey();
+    }
+
+    /*! The key for identical requests in a RequestCoalescer */
+    [[nodiscard]] std::string GetCoalescingKey() const {
+        auto key = GetCacheKey();
+        key += '\n';
+        for(const auto& it : properties_->headers) {
+            if (headers_.find(it.first) == headers_.end()) {
+                AppendHeader(key, it);
+            }
+        }
+        AppendHeaders(key, headers_);
+        return key;
+    }
 
-        return request_buffer.str();
+    [[nodiscard]] std::string GetUrlForLog() const {
+        if (prepared_) {
+            return prepared_->GetOrigin() + prepared_target_;
+        }
+        return url_;
     }
 
     std::pair<std::string, std::string> GetRequestEndpoint() {
@@ -673,9 +1176,15 @@ private:
         return p;
     }
 
-    Connection::ptr_t Connect(Context& ctx) {
+    /*! Connect to the server
+     *
+     * \param http2 Make a new connection for a HTTP/2 session, and offer
+     *      HTTP/2 with ALPN if it's https.
+     */
+    Connection::ptr_t Connect(Context& ctx, bool http2 = false) {
 
         static const auto timer_name = "Connect"s;
+        static const std::string alpn_protocols{"\x02h2\x08http/1.1"};
 
         auto prot_filter = GetBindProtocols(properties_->bindToLocalAddress, ctx);
 
@@ -688,20 +1197,77 @@ private:
         // Resolve the hostname
         const auto [host, service] = GetRequestEndpoint();
 
-        RESTC_CPP_LOG_TRACE_("Resolving " << host << ":" << service);
-        auto results = boost_resolve(resolver, host, service, ctx.GetYield());
+        auto *balancer = static_cast<LoadBalancerImpl *>(properties_->loadBalancer.get());
+        const auto *upstreams = balancer ? balancer->GetUpstreams(host) : nullptr;
+
+        boost::system::error_code ec;
+        LoadBalancerImpl::endpoints_t endpoints;
+        const auto resolve = [&](const std::string& name, const std::string& port) {
+            RESTC_CPP_LOG_TRACE_("Resolving " << name << ":" << port);
+            auto results = boost_resolve(resolver, name, port, ctx.GetYield()[ec]);
+            if (ec) {
+                RESTC_CPP_LOG_DEBUG_("Failed to resolve " << name << ": " << ec.message());
+                return;
+            }
+            for (auto it = results.begin(); it != results.end(); ++it) {
+                endpoints.push_back(it->endpoint());
+            }
+        };
 
-        for (auto it = results.begin(); it != results.end(); ++it) {
-            const auto endpoint = it->endpoint();
+        if (upstreams) {
+            for(const auto& upstream : *upstreams) {
+                const auto [name, port] = ParseAddress(upstream);
+                resolve(name, to_string(port));
+            }
+            if (!endpoints.empty()) {
+                ec = {}; // Use the upstreams that we could resolve
+            }
+        } else {
+            resolve(host, service);
+        }
+
+        if (ec) {
+            if (ec_) {
+                *ec_ = ec;
+                return {};
+            }
+            throw boost::system::system_error(ec);
+        }
+
+        if (balancer) {
+            endpoints = balancer->Order(host, std::move(endpoints), affinity_key_);
+        }
+
+        // Without Properties::retryPolicy, each address is tried up to 8
+        // times on timeouts and EAGAIN. With a policy, each address is tried
+        // once, and the policy decides if, and when, we try again.
+        const size_t max_tries = properties_->retryPolicy ? 1 : 8;
+        for (const auto& endpoint : endpoints) {
             RESTC_CPP_LOG_TRACE_("Trying endpoint " << endpoint);
 
-            for(size_t retries = 0; retries < 8; ++retries) {
+            bool filtered = false;
+            for(size_t tries = 0; tries < max_tries; ++tries) {
+                if (tries != 0u) {
+                    RESTC_CPP_LOG_DEBUG_("RequestImpl::Connect: taking a nap");
+                    ctx.Sleep(tries * 20ms);
+                }
+
                 // Get a connection from the pool
-                auto connection = owner_.GetConnectionPool()->GetConnection(
-                    endpoint, protocol_type);
+                auto connection = http2
+                    ? owner_.GetConnectionPool()->GetConnection(endpoint, protocol_type, true)
+                    : owner_.GetConnectionPool()->GetConnection(endpoint, protocol_type, ec);
+                if (!connection) {
+                    if (ec_) {
+                        *ec_ = ec;
+                        return {};
+                    }
+                    throw ConstraintException(
+                        "Cannot create connection - too many connections");
+                }
 
                 // Connect if the connection is new.
                 if (connection->GetSocket().IsOpen()) {
+                    StartOnEndpoint(balancer, endpoint, http2);
                     return connection;
                 }
 
@@ -715,14 +1281,14 @@ private:
                                 == prot_filter.end()) {
                             RESTC_CPP_LOG_TRACE_("Filtered out (protocol mismatch) local address: "
                                 << properties_->bindToLocalAddress);
-                            break; // Break out of retry loop, re-enter endpoint loop
+                            filtered = true;
+                            break; // Go to the next endpoint
                         }
                     }
 
                     RESTC_CPP_LOG_TRACE_("Binding to local address: "
                         << properties_->bindToLocalAddress);
 
-                    boost::system::error_code ec;
                     auto local_ep = ToEp(properties_->bindToLocalAddress, endpoint.protocol(), ctx);
                     auto& sck = connection->GetSocket().GetSocket();
                     sck.open(local_ep.protocol());
@@ -744,12 +1310,6 @@ private:
                     properties_->connectTimeoutMs, connection);
 
                 try {
-                    if (retries != 0u) {
-                        RESTC_CPP_LOG_DEBUG_("RequestImpl::Connect: taking a nap");
-                        ctx.Sleep(retries * 20ms);
-                        RESTC_CPP_LOG_DEBUG_("RequestImpl::Connect: Waking up. Will try to read from the socket now.");
-                    }
-
                     if (properties_->proxy.type == Proxy::Type::SOCKS5) {
                         connection->GetSocket().SetAfterConnectCallback([&]() {
                             RESTC_CPP_LOG_TRACE_("RequestImpl::Connect: In Socks5 callback");
@@ -760,6 +1320,10 @@ private:
                         });
                     }
 
+                    if (http2 && (protocol_type == Connection::Type::HTTPS)) {
+                        connection->GetSocket().SetAlpnProtocols(alpn_protocols);
+                    }
+
                     RESTC_CPP_LOG_TRACE_("RequestImpl::Connect: calling AsyncConnect --> " << endpoint);
 
                     // 2025-01-18: [jgaa] Changing the hostname from the one digged up by the resolver in older versions of boost
@@ -767,29 +1331,7 @@ private:
                     // I believe this is the correct way to do it.
                     connection->GetSocket().AsyncConnect(
                         endpoint, host,
-                        properties_->tcpNodelay, ctx.GetYield());
-                    RESTC_CPP_LOG_TRACE_("RequestImpl::Connect: OK AsyncConnect --> " << endpoint);
-                    return connection;
-                } catch (const boost::system::system_error& ex) {
-                    RESTC_CPP_LOG_TRACE_("RequestImpl::Connect:: Caught boost::system::system_error exception: \"" << ex.what()
-                                         << "\". Will close connection " << *connection);
-                    connection->GetSocket().GetSocket().close();
-
-                    if (ex.code() == boost::system::errc::resource_unavailable_try_again) {
-                        if ( retries < 8) {
-                            RESTC_CPP_LOG_DEBUG_(
-                                "RequestImpl::Connect:: Caught boost::system::system_error exception: \""
-                                    << ex.what()
-                                    << "\" while connecting to " << endpoint
-                                    << ". I will continue the retry loop.");
-                            continue;
-                        }
-                    }
-                    RESTC_CPP_LOG_DEBUG_(
-                        "RequestImpl::Connect:: Caught boost::system::system_error exception: \""
-                            << ex.what()
-                            << "\" while connecting to " << endpoint);
-                    break; // Go to the next endpoint
+                        properties_->tcpNodelay, ctx.GetYield(), ec);
                 } catch(const exception& ex) {
                     RESTC_CPP_LOG_WARN_("Connect to "
                         << endpoint
@@ -798,20 +1340,66 @@ private:
                         << ", message: " << ex.what());
 
                     connection->GetSocket().GetSocket().close();
+                    continue;
+                }
+
+                if (!ec) {
+                    RESTC_CPP_LOG_TRACE_("RequestImpl::Connect: OK AsyncConnect --> " << endpoint);
+                    StartOnEndpoint(balancer, endpoint, http2);
+                    return connection;
+                }
+
+                RESTC_CPP_LOG_DEBUG_(
+                    "RequestImpl::Connect: \""
+                        << ec.message()
+                        << "\" while connecting to " << endpoint
+                        << ". Will close connection " << *connection);
+                connection->GetSocket().GetSocket().close();
+
+                if ((ec != Error::TIME_OUT)
+                    && (ec != boost::system::errc::resource_unavailable_try_again)) {
+                    break; // Go to the next endpoint
                 }
+            } // tries
 
-            } // retries
+            if (balancer && !filtered) {
+                balancer->OnConnectFailed(endpoint);
+            }
         } // endpoints
 
+        if (ec_) {
+            *ec_ = Error::FAILED_TO_CONNECT;
+            return {};
+        }
         throw FailedToConnectException("Failed to connect (exhausted all options)");
     }
 
+    /*! Let the load balancer know that the request uses the endpoint
+     *
+     * A new HTTP/2 session is not a request.
+     */
+    void StartOnEndpoint(LoadBalancerImpl *balancer,
+                         const boost::asio::ip::tcp::endpoint& endpoint, bool http2) {
+        if (balancer && !http2) {
+            lb_ticket_ = balancer->Start(endpoint);
+        }
+    }
+
     void SendRequestPayload(Context& /*ctx*/,
                       write_buffers_t write_buffer) {
 
         static const auto timer_name = "SendRequestPayload"s;
         bool have_sent_headers = false;
 
+        // The plain writer used for fixed size bodies passes the data
+        // through unaltered, so the headers and the first part of the
+        // body can go out in one gather-write.
+        const bool gather = body_ && !compress_body_
+            && (body_->GetType() == RequestBody::Type::FIXED_SIZE);
+        if (gather) {
+            body_->GetData(write_buffer);
+        }
+
         if (properties_->beforeWriteFn) {
             properties_->beforeWriteFn();
         }
@@ -822,7 +1410,7 @@ private:
 
             try {
 
-                if (!have_sent_headers) {
+                if (!have_sent_headers && !gather) {
 
                     auto b = write_buffer[0];
 
@@ -867,34 +1455,168 @@ private:
         }
     }
 
-    DataWriter& SendRequest(Context& ctx) override {
-        bytes_sent_ = 0;
+    [[nodiscard]] Compression GetBodyCompression() const noexcept {
+        return body_compression_ ? *body_compression_ : properties_->bodyCompression;
+    }
 
-        connection_ = Connect(ctx);
-        DataWriter::WriteConfig cfg;
-        cfg.msWriteTimeout = properties_->sendTimeoutMs;
-        writer_ = DataWriter::CreateIoWriter(connection_, ctx, cfg);
+    [[nodiscard]] int GetBodyCompressionLevel() const noexcept {
+        return body_compression_ ? body_compression_level_ : properties_->bodyCompressionLevel;
+    }
 
-        if (body_) {
-            if (body_->GetType() == RequestBody::Type::FIXED_SIZE) {
-                writer_ = DataWriter::CreatePlainWriter(
-                    body_->GetFixedSize(), std::move(writer_));
-            } else {
-                writer_ = DataWriter::CreateChunkedWriter(nullptr, std::move(writer_));
-            }
-        } else {
-            static const string transfer_encoding{"Transfer-Encoding"};
-            static const string chunked{"chunked"};
-            auto h = properties_->headers.find(transfer_encoding);
-            if ((h != properties_->headers.end()) && ciEqLibC()(h->second, chunked)) {
+    bool ShouldCompressBody() const {
+        if (GetBodyCompression() == Request::Compression::NONE) {
+            return false;
+        }
+
+        if (FindHeader(header_names::content_encoding) != nullptr) {
+            // The caller has already encoded the body
+            return false;
+        }
+
+        if (body_ && (body_->GetType() == RequestBody::Type::FIXED_SIZE)) {
+            return body_->GetFixedSize() >= properties_->bodyCompressionMinSize;
+        }
+
+        return true;
+    }
+
+    void AddCompression() {
+#ifdef RESTC_CPP_WITH_ZLIB
+        if (GetBodyCompression() == Request::Compression::GZIP) {
+            writer_ = DataWriter::CreateGzipWriter(
+                std::move(writer_), GetBodyCompressionLevel());
+        } else {
+            writer_ = DataWriter::CreateZipWriter(
+                std::move(writer_), GetBodyCompressionLevel());
+        }
+#else
+        throw NotSupportedException("Compiled without zlib.");
+#endif
+    }
+
+    /* Coalesce small writes from push-style bodies into larger chunks
+     *
+     * Only for CHUNKED_LAZY_PUSH bodies, that are written by the library.
+     * The writer that SendRequest() returns to the caller is not
+     * buffered, so that each write is sent right away, as before.
+     */
+    void AddWriteBuffer() {
+        if (properties_->writeBufferSize > 0) {
+            writer_ = DataWriter::CreateBufferedWriter(
+                properties_->writeBufferSize, std::move(writer_));
+        }
+    }
+
+    DataWriter& SendRequest(Context& ctx) override {
+        Send(ctx);
+        assert(writer_);
+        return *writer_;
+    }
+
+    /*! Send the request
+     *
+     * \return false if we failed to connect, and the error is
+     *      reported in ec_.
+     */
+    bool Send(Context& ctx) {
+        // Give back the permit from an earlier attempt before we wait for a new one
+        permit_ = {};
+        lb_ticket_ = {};
+        if (properties_->concurrencyLimiter) {
+            permit_ = static_cast<ConcurrencyLimiterImpl&>(
+                *properties_->concurrencyLimiter).Acquire(GetOrigin(), ctx);
+        }
+
+        try {
+            if (SendImpl(ctx)) {
+                return true;
+            }
+        } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+            OnRequestFailed();
+            throw;
+        }
+        OnRequestFailed();
+        return false;
+    }
+
+    /*! Tell the limiter and load balancer that we got no response */
+    void OnRequestFailed() {
+        permit_.OnFailure();
+        lb_ticket_.OnFailure();
+    }
+
+    bool SendImpl(Context& ctx) {
+        bytes_sent_ = 0;
+        send_start_ = std::chrono::steady_clock::now();
+        stream_.reset();
+        pipelined_.reset();
+        connection_.reset();
+
+        if (WantHttp2()) {
+            stream_ = GetHttp2Stream(ctx);
+            if (stream_) {
+                RegisterWithHedge();
+                SendHttp2(ctx);
+                return true;
+            }
+            if (!connection_ && ec_ && *ec_) {
+                return false;
+            }
+            // Else HTTP/1.1, maybe on the connection where ALPN failed
+        }
+
+        if (!connection_ && WantPipelining()) {
+            pipelined_ = GetPipelinedRequest(ctx);
+            if (pipelined_) {
+                connection_ = pipelined_;
+            } else if (ec_ && *ec_) {
+                return false;
+            }
+        }
+
+        if (!connection_) {
+            connection_ = Connect(ctx);
+            if (!connection_) {
+                return false;
+            }
+        }
+        RegisterWithHedge();
+
+        DataWriter::WriteConfig cfg;
+        cfg.msWriteTimeout = properties_->sendTimeoutMs;
+        writer_ = DataWriter::CreateIoWriter(connection_, ctx, cfg);
+
+        compress_body_ = false;
+        if (body_) {
+            compress_body_ = ShouldCompressBody();
+            if ((body_->GetType() == RequestBody::Type::FIXED_SIZE) && !compress_body_) {
+                writer_ = DataWriter::CreatePlainWriter(
+                    body_->GetFixedSize(), std::move(writer_));
+            } else {
+                // The size of a compressed body is not known up front
                 writer_ = DataWriter::CreateChunkedWriter(nullptr, std::move(writer_));
+                if (compress_body_) {
+                    AddCompression();
+                }
+                if (body_->GetType() == RequestBody::Type::CHUNKED_LAZY_PUSH) {
+                    AddWriteBuffer();
+                }
+            }
+        } else {
+            static const string chunked{"chunked"};
+            const auto *te = FindHeader(header_names::transfer_encoding);
+            if ((te != nullptr) && ciEqLibC()(*te, chunked)) {
+                // The caller writes the body through the returned writer
+                writer_ = DataWriter::CreateChunkedWriter(nullptr, std::move(writer_));
+                compress_body_ = ShouldCompressBody();
+                if (compress_body_) {
+                    AddCompression();
+                }
             } else {
                 writer_ = DataWriter::CreatePlainWriter(0, std::move(writer_));
             }
         }
 
-        // TODO: Add compression
-
         write_buffers_t write_buffer;
         ToBuffer const headers(BuildOutgoingRequest());
         write_buffer.push_back(headers);
@@ -904,56 +1626,351 @@ private:
             << ' ' << *connection_);
 
         PrepareBody();
-        SendRequestPayload(ctx, write_buffer);
+        if (pipelined_) {
+            try {
+                SendRequestPayload(ctx, write_buffer);
+            } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+                pipelined_->Abort();
+                throw;
+            }
+            pipelined_->Sent();
+        } else {
+            SendRequestPayload(ctx, write_buffer);
+        }
         if (properties_->afterWriteFn) {
             properties_->afterWriteFn();
         }
 
-        RESTC_CPP_LOG_DEBUG_("Sent " << Verb(request_type_) << " request to '" << url_ << "' "
+        RESTC_CPP_LOG_DEBUG_("Sent " << Verb(request_type_) << " request to '" << GetUrlForLog() << "' "
             << *connection_);
 
-        assert(writer_);
-        return *writer_;
+        return true;
+    }
+
+    bool WantHttp2() const {
+        if (properties_->proxy.type != Proxy::Type::NONE) {
+            return false;
+        }
+
+        switch(properties_->httpVersion) {
+        case HttpVersion::HTTP_2:
+            return parsed_url_.GetProtocol() == Url::Protocol::HTTPS;
+        case HttpVersion::HTTP_2_PRIOR_KNOWLEDGE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /*! Get a stream on a HTTP/2 session to the server
+     *
+     * \return nullptr if HTTP/2 is not used. connection_ is then set
+     *      if we connected, and the server declined HTTP/2.
+     */
+    Http2Stream::ptr_t GetHttp2Stream(Context& ctx) {
+        const bool tls = parsed_url_.GetProtocol() == Url::Protocol::HTTPS;
+
+        return owner_.GetConnectionPool()->GetHttp2Sessions().GetStream(
+            GetOrigin(), tls, ctx, [this, &ctx] {
+                return Connect(ctx, true);
+            }, connection_);
+    }
+
+    /*! "scheme://host:port" */
+    std::string GetOrigin() const {
+        return ref_to_string(parsed_url_.GetProtocolName())
+            + ref_to_string(parsed_url_.GetHost()) + ':' + ref_to_string(parsed_url_.GetPort());
+    }
+
+    bool WantPipelining() const {
+        if ((properties_->pipelineDepth <= 1) || pipelining_disabled_
+            || (properties_->proxy.type != Proxy::Type::NONE) || body_
+            || (properties_->loadBalancer && !affinity_key_.empty())) {
+            return false;
+        }
+
+        if ((request_type_ != Type::GET) && (request_type_ != Type::HEAD)) {
+            return false;
+        }
+
+        // The caller writes a body through the returned writer
+        return FindHeader(header_names::transfer_encoding) == nullptr;
+    }
+
+    /*! Get our place in a pipeline to the server, and wait for our turn to send
+     *
+     * \return nullptr if we did not get a place. If we failed to
+     *      connect, the error is reported in ec_.
+     */
+    PipelinedRequest::ptr_t GetPipelinedRequest(Context& ctx) {
+        auto request = owner_.GetConnectionPool()->GetHttpPipelines().GetRequest(
+            GetOrigin(), properties_->pipelineDepth, [this, &ctx] {
+                return Connect(ctx);
+            });
+
+        if (request) {
+            try {
+                request->WaitForTurnToSend(ctx);
+            } catch(const PipelineBrokenException&) {
+                RESTC_CPP_LOG_DEBUG_("Send: The pipeline failed before our turn. "
+                                     "Sending without pipelining.");
+                return {};
+            }
+        }
+        return request;
+    }
+
+    /*! Send the request again on a connection of its own
+     *
+     * Used when a pipeline fails before we get the response.
+     */
+    unique_ptr<ReplyImpl> ResendWithoutPipelining(Context& ctx) {
+        RESTC_CPP_LOG_DEBUG_("GetReply: The pipeline failed. Sending "
+                             << Verb(request_type_) << " '" << GetUrlForLog()
+                             << "' again without pipelining.");
+        pipelined_.reset();
+        connection_.reset();
+        pipelining_disabled_ = true;
+        if (!Send(ctx)) {
+            throw boost::system::system_error(*ec_);
+        }
+        return GetReplyImpl(ctx);
+    }
+
+    /*! Send the request on stream_ */
+    void SendHttp2(Context& ctx) {
+        DataWriter::WriteConfig cfg;
+        cfg.msWriteTimeout = properties_->sendTimeoutMs;
+        writer_ = Http2Stream::CreateWriter(stream_, ctx, cfg);
+
+        // The DATA frames carry the body. There is no chunked encoding.
+        bool end_stream = false;
+        compress_body_ = false;
+        if (body_) {
+            compress_body_ = ShouldCompressBody();
+            if ((body_->GetType() == RequestBody::Type::FIXED_SIZE) && !compress_body_) {
+                writer_ = DataWriter::CreatePlainWriter(
+                    body_->GetFixedSize(), std::move(writer_));
+            } else {
+                if (compress_body_) {
+                    AddCompression();
+                }
+                if (body_->GetType() == RequestBody::Type::CHUNKED_LAZY_PUSH) {
+                    AddWriteBuffer();
+                }
+            }
+        } else {
+            static const string chunked{"chunked"};
+            const auto *te = FindHeader(header_names::transfer_encoding);
+            if ((te != nullptr) && ciEqLibC()(*te, chunked)) {
+                // The caller writes the body through the returned writer
+                compress_body_ = ShouldCompressBody();
+                if (compress_body_) {
+                    AddCompression();
+                }
+            } else {
+                end_stream = true;
+            }
+        }
+
+        const auto request = BuildOutgoingRequest();
+        header_size_ = 0;
+
+        RESTC_CPP_LOG_TRACE_("Request: " << request << " on HTTP/2 connection "
+            << stream_->GetConnectionId());
+
+        PrepareBody();
+        if (properties_->beforeWriteFn) {
+            properties_->beforeWriteFn();
+        }
+
+        stream_->Open(ToHttp2Headers(request), end_stream, ctx, properties_->sendTimeoutMs);
+
+        if (body_) {
+            write_buffers_t write_buffer;
+            switch(body_->GetType()) {
+                case RequestBody::Type::FIXED_SIZE:
+                case RequestBody::Type::CHUNKED_LAZY_PULL:
+                    while(body_->GetData(write_buffer)) {
+                        writer_->Write(write_buffer);
+                        bytes_sent_ += boost::asio::buffer_size(write_buffer);
+                        write_buffer.clear();
+                    }
+                    break;
+                case RequestBody::Type::CHUNKED_LAZY_PUSH:
+                    body_->PushData(*writer_);
+            }
+        }
+
+        if (properties_->afterWriteFn) {
+            properties_->afterWriteFn();
+        }
+
+        RESTC_CPP_LOG_DEBUG_("Sent " << Verb(request_type_) << " request to '" << GetUrlForLog()
+            << "' on HTTP/2 stream " << stream_->GetId() << " on connection "
+            << stream_->GetConnectionId());
+    }
+
+    /*! Translate a HTTP/1.1 request header to HTTP/2 fields (RFC 9113, section 8.3) */
+    Http2Session::header_list_t ToHttp2Headers(const std::string& request) const {
+        static const std::array<const char *, 5> connection_specific = {
+            "connection", "keep-alive", "proxy-connection", "transfer-encoding", "upgrade"
+        };
+
+        const auto line_end = request.find("\r\n");
+        const auto method_end = request.find(' ');
+        const auto target_end = request.rfind(' ', line_end);
+        assert((line_end != string::npos) && (method_end < target_end));
+
+        auto path = request.substr(method_end + 1, target_end - method_end - 1);
+        string authority;
+        Http2Session::header_list_t headers;
+
+        for(auto pos = line_end + 2; pos < request.size();) {
+            const auto end = request.find("\r\n", pos);
+            if ((end == string::npos) || (end == pos)) {
+                break; // End of the header section
+            }
+
+            const auto colon = request.find(':', pos);
+            if ((colon == string::npos) || (colon > end)) {
+                pos = end + 2;
+                continue;
+            }
+
+            auto name = request.substr(pos, colon - pos);
+            boost::algorithm::to_lower(name);
+            auto value = boost::algorithm::trim_copy(request.substr(colon + 1, end - colon - 1));
+            pos = end + 2;
+
+            if (name == "host") {
+                authority = std::move(value);
+                continue;
+            }
+            if (find(connection_specific.begin(), connection_specific.end(), name)
+                != connection_specific.end()) {
+                continue;
+            }
+            if ((name == "te") && (value != "trailers")) {
+                continue;
+            }
+            headers.emplace_back(std::move(name), std::move(value));
+        }
+
+        if (authority.empty()) {
+            authority = ref_to_string(parsed_url_.GetHost());
+        }
+
+        Http2Session::header_list_t fields = {
+            {":method", Verb(request_type_)},
+            {":scheme", (parsed_url_.GetProtocol() == Url::Protocol::HTTPS) ? "https" : "http"},
+            {":authority", std::move(authority)},
+            {":path", path.empty() ? "/"s : std::move(path)}
+        };
+        fields.insert(fields.end(), make_move_iterator(headers.begin()),
+                      make_move_iterator(headers.end()));
+        return fields;
     }
 
     unique_ptr<Reply> GetReply(Context& ctx) override {
-        constexpr auto http_301 = 301;
-        constexpr auto http_302 = 302;
+        auto reply = GetReplyImpl(ctx);
 
-        // We will not send more data regarding the current request
-        writer_->Finish();
-        writer_.reset();
+        const auto http_code = reply->GetResponseCode();
+        if (IsRedirect(http_code)) {
+            auto redirect_location = GetRedirectLocation(*reply);
+            RESTC_CPP_LOG_TRACE_("GetReply: RedirectException. location=" << redirect_location);
+            throw RedirectException(http_code, std::move(redirect_location), std::move(reply));
+        }
 
-        RESTC_CPP_LOG_TRACE_("GetReply: writer is reset.");
+        return reply;
+    }
+
+    /*! Get the reply. Redirects are returned as normal replies */
+    unique_ptr<ReplyImpl> GetReplyImpl(Context& ctx) {
+        constexpr auto http_304 = 304;
 
         DataReader::ReadConfig cfg;
         cfg.msReadTimeout = properties_->recvTimeout;
-        auto reply = ReplyImpl::Create(connection_, ctx, owner_, properties_,
-                                       request_type_);
+        unique_ptr<ReplyImpl> reply;
 
-        RESTC_CPP_LOG_TRACE_("GetReply: Calling StartReceiveFromServer");
         try {
-            reply->StartReceiveFromServer(
-                DataReader::CreateIoReader(connection_, ctx, cfg));
-        } catch (const exception& ex) {
-            RESTC_CPP_LOG_DEBUG_("GetReply: exception from StartReceiveFromServer: " << ex.what());
+            // We will not send more data regarding the current request
+            writer_->Finish();
+            writer_.reset();
+
+            RESTC_CPP_LOG_TRACE_("GetReply: writer is reset.");
+
+            if (stream_) {
+                Reply::HttpResponse response;
+                headers_t headers;
+                stream_->WaitForResponse(ctx, properties_->replyTimeoutMs, response, headers);
+
+                reply = make_unique<ReplyImpl>(stream_->GetConnectionId(), ctx, owner_,
+                                               properties_, request_type_);
+                reply->StartReceiveFromStream(std::move(response), std::move(headers),
+                                              Http2Stream::CreateReader(stream_, ctx, cfg));
+                stream_.reset();
+            } else if (pipelined_) {
+                try {
+                    pipelined_->WaitForTurnToRead(ctx, properties_->replyTimeoutMs);
+                    reply = ReplyImpl::Create(connection_, ctx, owner_, properties_,
+                                              request_type_);
+                    reply->StartReceiveFromServer(
+                        PipelinedRequest::CreateReader(pipelined_, ctx, cfg));
+                } catch (const PipelineBrokenException&) {
+                    reply.reset();
+                    return ResendWithoutPipelining(ctx);
+                } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+                    // We don't know where the next response starts
+                    pipelined_->Abort();
+                    throw;
+                }
+
+                // The reply owns our place in the pipeline now
+                pipelined_.reset();
+                connection_.reset();
+            } else {
+                reply = ReplyImpl::Create(connection_, ctx, owner_, properties_,
+                                          request_type_);
+
+                RESTC_CPP_LOG_TRACE_("GetReply: Calling StartReceiveFromServer");
+                try {
+                    reply->StartReceiveFromServer(
+                        DataReader::CreateIoReader(connection_, ctx, cfg));
+                } catch (const exception& ex) {
+                    RESTC_CPP_LOG_DEBUG_("GetReply: exception from StartReceiveFromServer: " << ex.what());
+                    throw;
+                }
+
+                // The reply releases the connection when it is done with it
+                connection_.reset();
+            }
+        } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+            OnRequestFailed();
             throw;
         }
 
+        if (permit_) {
+            permit_.OnResponse(reply->GetResponseCode());
+        }
+        if (lb_ticket_) {
+            lb_ticket_.OnResponse(reply->GetResponseCode());
+        }
+
+        if (properties_->hedging.percentile > 0) {
+            owner_.GetConnectionPool()->GetLatencies().Add(
+                GetOrigin(), std::chrono::steady_clock::now() - send_start_);
+        }
+
         RESTC_CPP_LOG_TRACE_("GetReply: Returned from StartReceiveFromServer. code=" << reply->GetResponseCode());
 
         const auto http_code = reply->GetResponseCode();
-        if (http_code == http_301 || http_code == http_302) {
-            auto redirect_location = reply->GetHeader("Location");
-            if (!redirect_location) {
-                throw ProtocolException(
-                    "No Location header in redirect reply");
-            }
-            RESTC_CPP_LOG_TRACE_("GetReply: RedirectException. location=" << *redirect_location);
-            throw RedirectException(http_code, *redirect_location, std::move(reply));
-        }
 
-        if (properties_->throwOnHttpError) {
+        // A 304 is the expected reply when we revalidate a cached response
+        const bool revalidated = (http_code == http_304) && !conditional_headers_.empty();
+
+        if (properties_->throwOnHttpError && !ec_ && !defer_http_errors_
+            && !revalidated && !IsRedirect(http_code)) {
             RESTC_CPP_LOG_TRACE_("GetReply: Calling ValidateReply");
             ValidateReply(*reply);
             RESTC_CPP_LOG_TRACE_("GetReply: returning from ValidateReply");
@@ -969,25 +1986,551 @@ private:
 
 
 
+    /*! Execute the request, and try again according to Properties::retryPolicy */
+    unique_ptr<Reply> ExecuteWithRetries(Context& ctx) {
+        auto *policy = static_cast<RetryPolicyImpl *>(properties_->retryPolicy.get());
+
+        // A body that is produced on the fly can not be sent again
+        if (!policy || (body_ && (body_->GetType() != RequestBody::Type::FIXED_SIZE))) {
+            return DoExecute(ctx);
+        }
+
+        auto reply = restc_cpp::ExecuteWithRetries(ctx, *policy, IsIdempotent(), [&] {
+            // The policy must see the response before HTTP errors are raised
+            defer_http_errors_ = true;
+            unique_ptr<Reply> attempt_reply;
+            try {
+                attempt_reply = DoExecute(ctx);
+            } catch(...) {
+                defer_http_errors_ = false;
+                throw;
+            }
+            defer_http_errors_ = false;
+            return attempt_reply;
+        }, ec_, [this] {
+            return Verb(request_type_) + " '" + GetUrlForLog() + "'";
+        });
+
+        if (reply && properties_->throwOnHttpError && !ec_
+            && !IsRedirect(reply->GetResponseCode())) {
+            ValidateReply(*reply);
+        }
+        return reply;
+    }
+
+    bool IsIdempotent() const noexcept {
+        switch(request_type_) {
+        case Type::GET:
+        case Type::HEAD:
+        case Type::OPTIONS:
+        case Type::PUT:
+        case Type::DELETE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
     unique_ptr<Reply> DoExecute(Context& ctx) {
-        SendRequest(ctx);
-        return GetReply(ctx);
+        conditional_headers_.clear();
+        if (properties_->responseCache) {
+            return CachedExecute(ctx, *properties_->responseCache);
+        }
+
+        return SendAndGetReply(ctx);
+    }
+
+    /*! Send the request and get the reply. Hedged, if hedging is enabled. */
+    unique_ptr<Reply> SendAndGetReply(Context& ctx) {
+        if (const auto delay = GetHedgeDelayMs()) {
+            return HedgedExecute(ctx, delay);
+        }
+
+        if (!Send(ctx)) {
+            return {};
+        }
+        return GetReplyImpl(ctx);
+    }
+
+    /*! The delay before a second request is sent, or 0 to not hedge the request */
+    int GetHedgeDelayMs() const {
+        const auto& hedging = properties_->hedging;
+        if ((hedging.delayMs <= 0) && (hedging.percentile <= 0)) {
+            return 0;
+        }
+
+        // Only idempotent requests can be sent twice
+        if ((hedge_ != nullptr) || body_ || ((request_type_ != Type::GET)
+            && (request_type_ != Type::HEAD) && (request_type_ != Type::OPTIONS))) {
+            return 0;
+        }
+
+        return Hedge::GetDelayMs(hedging, owner_.GetConnectionPool()->GetLatencies(),
+                                 GetOrigin());
+    }
+
+    /*! Send the request, and send it again if there is no response after delayMs
+     *
+     * If the body of the reply is too large to be read into memory, the
+     * request is sent again without hedging, and the reply is returned
+     * as it is received.
+     */
+    unique_ptr<Reply> HedgedExecute(Context& ctx, int delayMs) {
+        try {
+            return Hedge::Execute(ctx, delayMs, [this, delayMs](Hedge& hedge, size_t index) {
+                if (index > 0) {
+                    RESTC_CPP_LOG_DEBUG_("Hedging " << Verb(request_type_) << " '"
+                                         << GetUrlForLog() << "'. No response after "
+                                         << delayMs << " ms.");
+                }
+                return CreateHedgedAttempt(hedge, index);
+            }, ec_);
+        } catch(const HedgedReplyTooLargeException&) {
+            RESTC_CPP_LOG_DEBUG_("The reply to " << Verb(request_type_) << " '"
+                                 << GetUrlForLog() << "' is too large for hedging. "
+                                 << "Sending it again without hedging.");
+        }
+
+        if (!Send(ctx)) {
+            return {};
+        }
+        return GetReplyImpl(ctx);
+    }
+
+    /*! A copy of this request, as an attempt of a hedged request */
+    Hedge::attempt_fn_t CreateHedgedAttempt(Hedge& hedge, size_t index) const {
+        std::shared_ptr<RequestImpl> request;
+        if (prepared_) {
+            request = make_unique<RequestImpl>(prepared_, prepared_target_, nullptr);
+        } else {
+            request = make_unique<RequestImpl>(url_, request_type_, owner_, nullptr,
+                                               boost::none, boost::none);
+        }
+
+        request->request_type_ = request_type_;
+        request->properties_ = properties_;
+        request->headers_ = headers_;
+        request->args_ = args_;
+        request->add_url_args_ = add_url_args_;
+        request->use_prepared_headers_ = use_prepared_headers_;
+        request->affinity_key_ = affinity_key_;
+        request->body_compression_ = body_compression_;
+        request->body_compression_level_ = body_compression_level_;
+        request->defer_http_errors_ = defer_http_errors_;
+        request->conditional_headers_ = conditional_headers_; // When we revalidate
+        request->pipelining_disabled_ = true; // Head of line blocking is what we try to avoid
+        request->hedge_ = &hedge;
+        request->hedge_attempt_ = index;
+
+        return [request](Context& ctx, boost::system::error_code *ec) {
+            unique_ptr<Reply> reply;
+            request->ec_ = ec;
+            if (request->Send(ctx)) {
+                reply = request->GetReplyImpl(ctx);
+            }
+            request->ec_ = nullptr;
+            return reply;
+        };
+    }
+
+    /*! Let the other attempt of a hedged request cancel this one */
+    void RegisterWithHedge() {
+        if (hedge_ != nullptr) {
+            hedge_->Register(hedge_attempt_, stream_ ? nullptr : connection_, stream_);
+        }
+    }
+
+    /*! Execute the request through a private HTTP cache (RFC 9111) */
+    unique_ptr<Reply> CachedExecute(Context& ctx, ResponseCache& cache) {
+        constexpr auto http_304 = 304;
+        constexpr auto http_400 = 400;
+
+        const auto key = GetCacheKey();
+
+        if (request_type_ != Type::GET) {
+            auto reply = SendAndGetReply(ctx);
+
+            // Unsafe methods invalidates the stored response, RFC 9111, section 4.4
+            if (reply && (request_type_ != Type::HEAD) && (request_type_ != Type::OPTIONS)
+                && (reply->GetResponseCode() < http_400)) {
+                cache.Remove(key);
+            }
+            return reply;
+        }
+
+        CacheControl request_cc;
+        if (const auto *cc = FindHeader(header_names::cache_control)) {
+            request_cc.Parse(*cc);
+        }
+
+        // If the caller makes conditional requests, the caller deals with 304
+        const bool conditional = FindHeader(header_names::if_none_match)
+            || FindHeader(header_names::if_modified_since);
+
+        if (request_cc.noStore || conditional || body_) {
+            return SendAndGetReply(ctx);
+        }
+
+        const auto request_headers = [this](const std::string& name) {
+            return FindHeader(name);
+        };
+
+        auto stored = cache.Lookup(key);
+        if (stored && !VaryMatches(*stored, request_headers)) {
+            stored.reset();
+        }
+
+        if (stored) {
+            const bool must_validate = request_cc.noCache
+                || (request_cc.maxAge && (stored->GetAge() >= *request_cc.maxAge));
+
+            if (!must_validate && stored->IsFresh()) {
+                RESTC_CPP_LOG_TRACE_("Serving '" << GetUrlForLog() << "' from the cache");
+                return GetStoredReply(std::move(stored));
+            }
+
+            auto it = stored->headers.find(header_names::etag);
+            if (it != stored->headers.end()) {
+                conditional_headers_.emplace(header_names::if_none_match.str(), it->second);
+            }
+            it = stored->headers.find(header_names::last_modified);
+            if (it != stored->headers.end()) {
+                conditional_headers_.emplace(header_names::if_modified_since.str(), it->second);
+            }
+        }
+
+        // Misses and revalidations are hedged like any other request
+        auto reply = SendAndGetReply(ctx);
+        conditional_headers_.clear();
+        if (!reply) {
+            return reply;
+        }
+
+        if (stored && (reply->GetResponseCode() == http_304)) {
+            RESTC_CPP_LOG_TRACE_("Revalidated '" << GetUrlForLog() << "' in the cache");
+            reply->fetchAndIgnore();
+            auto updated = make_shared<CachedResponse>(*stored);
+            UpdateCacheEntry(*updated, GetAllHeaders(*reply));
+            cache.Store(key, updated);
+            return GetStoredReply(std::move(updated));
+        }
+
+        auto entry = CreateCacheEntry(reply->GetHttpResponse(),
+                                      GetAllHeaders(*reply),
+                                      request_headers);
+        if (!entry) {
+            if (stored) {
+                cache.Remove(key);
+            }
+            return reply;
+        }
+
+        const auto max_size = cache.GetMaxEntrySize();
+        const auto& reply_headers = GetAllHeaders(*reply);
+        const auto content_length = reply_headers.find(header_names::content_length);
+        if ((content_length != reply_headers.end())
+            && (strtoull(content_length->second.c_str(), nullptr, 10) > max_size)) {
+            return reply;
+        }
+
+        if (!ReadBody(*reply, *entry, max_size)) {
+            // Too large to be stored. The caller gets what we have read,
+            // and then the rest of the body from the server.
+            return make_unique<BufferedReplyImpl>(std::move(entry), std::move(reply));
+        }
+
+        cache.Store(key, entry);
+        return make_unique<BufferedReplyImpl>(std::move(entry));
+    }
+
+    /*! The headers of a reply from the server, or from a hedged request */
+    static const headers_t& GetAllHeaders(const Reply& reply) {
+        if (const auto *buffered = dynamic_cast<const BufferedReplyImpl *>(&reply)) {
+            return buffered->GetResponse()->headers;
+        }
+        return dynamic_cast<const ReplyImpl&>(reply).GetAllHeaders();
+    }
+
+    /*! Get a reply for a response that was received earlier
+     *
+     * The response may have been received by a request that
+     * reported HTTP errors in an error_code.
+     */
+    unique_ptr<Reply> GetStoredReply(ResponseCache::entry_t response) const {
+        auto reply = make_unique<BufferedReplyImpl>(std::move(response));
+        if (properties_->throwOnHttpError && !ec_ && !defer_http_errors_) {
+            ValidateReply(*reply);
+        }
+        return reply;
+    }
+
+    /*! Read the body of the reply into the response
+     *
+     * \return false if the body is larger than maxSize. The response
+     *      then has the part of the body that was read.
+     */
+    static bool ReadBody(Reply& reply, CachedResponse& response, const size_t maxSize) {
+        auto body = make_shared<std::string>();
+        bool complete = true;
+        while(reply.MoreDataToRead()) {
+            const auto data = reply.GetSomeData();
+            body->append(boost_buffer_cast(data), boost::asio::buffer_size(data));
+            if (body->size() > maxSize) {
+                complete = false;
+                break;
+            }
+        }
+
+        SetStoredBody(response, std::move(body), complete);
+        return complete;
+    }
+
+    /*! Execute the request, or wait for an identical request in flight */
+    unique_ptr<Reply> CoalescedExecute(Context& ctx, RequestCoalescerImpl& coalescer) {
+        const auto key = GetCoalescingKey();
+        auto flight = coalescer.Join(key);
+
+        if (!flight.second) {
+            RESTC_CPP_LOG_TRACE_("Waiting for '" << GetUrlForLog() << "' in flight");
+            if (auto response = RequestCoalescerImpl::Wait(
+                    *flight.first, ctx, properties_->replyTimeoutMs)) {
+                return GetStoredReply(std::move(response));
+            }
+            return ExecuteWithRedirects(ctx);
+        }
+
+        // Completes the flight if we leave without a result, also when
+        // the coroutine is unwound.
+        RequestCoalescerImpl::Leader leader{coalescer, key, std::move(flight.first)};
+
+        unique_ptr<Reply> reply;
+        try {
+            reply = ExecuteWithRedirects(ctx);
+        } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+            leader.Complete({}, std::current_exception());
+            throw;
+        }
+
+        if (!reply) {
+            // The error is reported in ec_. Let the waiters try for themselves.
+            return reply;
+        }
+
+        // A reply from the cache can be shared as it is
+        if (auto *buffered = dynamic_cast<BufferedReplyImpl *>(reply.get())) {
+            leader.Complete(buffered->HasTail() ? nullptr : buffered->GetResponse());
+            return reply;
+        }
+
+        auto& impl = dynamic_cast<ReplyImpl&>(*reply);
+        auto response = make_shared<CachedResponse>();
+        response->response = impl.GetHttpResponse();
+        response->headers = GetStoredHeaders(impl.GetAllHeaders());
+        response->responseTime = CachedResponse::clock_t::now();
+
+        bool complete = false;
+        try {
+            complete = ReadBody(impl, *response, coalescer.GetMaxBodySize());
+        } RESTC_CPP_IN_COROUTINE_CATCH_ALL {
+            leader.Complete({}, std::current_exception());
+            throw;
+        }
+
+        if (!complete) {
+            return make_unique<BufferedReplyImpl>(std::move(response), std::move(reply));
+        }
+
+        leader.Complete(response);
+        return make_unique<BufferedReplyImpl>(std::move(response));
     }
 
     std::string url_;
     Url parsed_url_;
-    const Type request_type_;
+    Type request_type_;
     std::unique_ptr<RequestBody> body_;
     Connection::ptr_t connection_;
+    Http2Stream::ptr_t stream_; // Instead of connection_ for HTTP/2
+    PipelinedRequest::ptr_t pipelined_; // Is connection_ when the request is pipelined
+    ConcurrencyLimiterImpl::Permit permit_; // From Send() until we have the response headers
+    LoadBalancerImpl::Ticket lb_ticket_; // From Connect() until we have the response headers
+    std::chrono::steady_clock::time_point send_start_;
+    Hedge *hedge_ = nullptr; // Owns us when we are an attempt of a hedged request
+    size_t hedge_attempt_ = 0;
+    std::string affinity_key_;
+    boost::optional<Compression> body_compression_; // Overrides the properties
+    int body_compression_level_ = -1;
     std::unique_ptr<DataWriter> writer_;
     Properties::ptr_t properties_;
+    headers_t headers_; // Request specific headers
+    args_t args_; // Request specific args
+    mutable Properties::ptr_t effective_properties_;
     RestClient &owner_;
     size_t header_size_ = 0;
+    size_t estimated_header_size_ = 512;
     std::uint64_t bytes_sent_ = 0;
     bool dirty_ = false;
+    bool compress_body_ = false;
+    bool pipelining_disabled_ = false;
+    bool defer_http_errors_ = false; // The retry policy looks at the response first
     bool add_url_args_ = true;
+    bool use_prepared_headers_ = true;
+    std::shared_ptr<const PreparedRequestImpl> prepared_;
+    std::string prepared_target_;
+    headers_t conditional_headers_; // Added when we revalidate a cached response
+    boost::system::error_code *ec_ = nullptr; // Set while Execute(ctx, ec) runs
 };
 
+PreparedRequestImpl::PreparedRequestImpl(
+    std::string url,
+    Type requestType,
+    RestClient& owner,
+    const boost::optional<Request::args_t>& args,
+    const boost::optional<Request::headers_t>& headers,
+    const boost::optional<Request::auth_t>& auth)
+    : url_{std::move(url)}, parsed_url_{url_.c_str()}, request_type_{requestType}
+    , owner_{owner}
+{
+    if (args || headers || auth) {
+        Properties::ptr_t const props = owner_.GetConnectionProperties();
+        assert(props);
+        properties_ = make_shared<Properties>(*props);
+
+        if (args) {
+            properties_->args.insert(properties_->args.end(), args->begin(), args->end());
+        }
+
+        merge_map(headers, properties_->headers);
+
+        if (auth) {
+            RequestImpl::SetAuth(*auth, properties_->headers);
+        }
+    } else {
+        properties_ = owner_.GetConnectionProperties();
+    }
+
+    origin_ = ref_to_string(parsed_url_.GetProtocolName());
+    origin_ += ref_to_string(parsed_url_.GetHost());
+    origin_ += ':';
+    origin_ += ref_to_string(parsed_url_.GetPort());
+
+    ParsePath();
+    BuildRequestLinePrefix();
+    BuildStaticQuery();
+    BuildHeaderBlock();
+}
+
+void PreparedRequestImpl::ParsePath() {
+    auto remains = parsed_url_.GetPath();
+    while(true) {
+        const auto start = remains.find('{');
+        if (start == boost::string_ref::npos) {
+            path_segments_.push_back(url_encode(remains));
+            return;
+        }
+
+        const auto end = remains.find('}');
+        if (end == boost::string_ref::npos || end < start) {
+            throw ParseException("Malformed placeholder in path template: "s + url_);
+        }
+
+        path_segments_.push_back(url_encode(remains.substr(0, start)));
+        remains = remains.substr(end + 1);
+    }
+}
+
+void PreparedRequestImpl::BuildRequestLinePrefix() {
+    RequestImpl::AppendRequestLinePrefix(request_line_prefix_, request_type_,
+                                         parsed_url_, *properties_);
+}
+
+void PreparedRequestImpl::BuildStaticQuery() {
+    // Arguments already present in the url are used as they are
+    const auto url_args = parsed_url_.GetArgs();
+    if (!url_args.empty()) {
+        static_query_ = '?';
+        static_query_ += ref_to_string(url_args);
+    }
+
+    for(const auto& arg : properties_->args) {
+        static_query_ += static_query_.empty() ? '?' : '&';
+        url_encode(arg.name, static_query_);
+        static_query_ += '=';
+        url_encode(arg.value, static_query_);
+    }
+}
+
+void PreparedRequestImpl::BuildHeaderBlock() {
+    using header_names::content_length;
+    using header_names::host;
+    using header_names::transfer_encoding;
+
+    if (properties_->headers.find(host) == properties_->headers.end()) {
+        header_block_ = host.str();
+        header_block_ += ": ";
+        header_block_ += ref_to_string(parsed_url_.GetHost());
+        header_block_ += "\r\n";
+    }
+
+    // The body headers are set by the writers for each request
+    for(const auto& it : properties_->headers) {
+        if (ciEqLibC()(it.first, content_length)
+            || ciEqLibC()(it.first, transfer_encoding)) {
+            continue;
+        }
+
+        RequestImpl::AppendHeader(header_block_, it);
+    }
+}
+
+std::unique_ptr<Request>
+PreparedRequestImpl::CreateRequest(const path_params_t& pathParams,
+                                   std::unique_ptr<RequestBody> body,
+                                   const boost::optional<Request::args_t>& args) const {
+
+    if (pathParams.size() != GetNumPathParams()) {
+        throw ConstraintException("Expected "s + to_string(GetNumPathParams())
+                                  + " path parameters, got "
+                                  + to_string(pathParams.size()));
+    }
+
+    std::string target;
+    target.reserve(url_.size() + static_query_.size() + 64);
+
+    target += path_segments_.front();
+    for(size_t i = 0; i < pathParams.size(); ++i) {
+        AppendPathSegment(pathParams[i], target);
+        target += path_segments_[i + 1];
+    }
+
+    target += static_query_;
+
+    if (args) {
+        bool first_arg = static_query_.empty();
+        for(const auto& arg : *args) {
+            target += first_arg ? '?' : '&';
+            first_arg = false;
+            url_encode(arg.name, target);
+            target += '=';
+            url_encode(arg.value, target);
+        }
+    }
+
+    return make_unique<RequestImpl>(shared_from_this(), std::move(target),
+                                    std::move(body));
+}
+
+PreparedRequest::ptr_t
+PreparedRequest::Create(const std::string& url,
+                        const Request::Type requestType,
+                        RestClient& owner,
+                        const boost::optional<Request::args_t>& args,
+                        const boost::optional<Request::headers_t>& headers,
+                        const boost::optional<Request::auth_t>& auth) {
+
+    return make_shared<PreparedRequestImpl>(url, requestType, owner, args,
+                                            headers, auth);
+}
+
 
 std::unique_ptr<Request>
 Request::Create(const std::string& url,
@@ -0,0 +1,139 @@
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/ResponseCache.h"
+#include "restc-cpp/logging.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+constexpr size_t entry_overhead = 256;
+constexpr size_t default_entry_fraction = 8;
+
+size_t SizeOf(const headers_t& headers) {
+    size_t rval = 0;
+    for(const auto& h : headers) {
+        rval += h.first.size() + h.second.size();
+    }
+    return rval;
+}
+
+} // anonymous namespace
+
+size_t CachedResponse::GetSize() const {
+    return entry_overhead + body.size() + response.reason_phrase.size()
+        + SizeOf(headers) + SizeOf(varyHeaders);
+}
+
+class MemoryResponseCache : public ResponseCache {
+public:
+    MemoryResponseCache(size_t maxBytes, size_t maxEntrySize)
+    : max_bytes_{maxBytes}
+    , max_entry_size_{maxEntrySize ? maxEntrySize : (maxBytes / default_entry_fraction)}
+    {
+    }
+
+    entry_t Lookup(const std::string& key) override {
+        std::lock_guard<std::mutex> const lock{mutex_};
+
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            return {};
+        }
+
+        // Most recently used first
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->response;
+    }
+
+    void Store(const std::string& key, entry_t response) override {
+        const auto size = response->GetSize();
+        if ((response->body.size() > max_entry_size_) || (size > max_bytes_)) {
+            Remove(key);
+            return;
+        }
+
+        std::lock_guard<std::mutex> const lock{mutex_};
+
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            size_ -= it->second->size;
+            it->second->response = std::move(response);
+            it->second->size = size;
+            lru_.splice(lru_.begin(), lru_, it->second);
+        } else {
+            lru_.push_front({key, std::move(response), size});
+            entries_.emplace(key, lru_.begin());
+        }
+
+        size_ += size;
+        Evict();
+    }
+
+    void Remove(const std::string& key) override {
+        std::lock_guard<std::mutex> const lock{mutex_};
+
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            size_ -= it->second->size;
+            lru_.erase(it->second);
+            entries_.erase(it);
+        }
+    }
+
+    void Clear() override {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        entries_.clear();
+        lru_.clear();
+        size_ = 0;
+    }
+
+    size_t GetMaxEntrySize() const noexcept override {
+        return max_entry_size_;
+    }
+
+    size_t GetSize() const override {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        return size_;
+    }
+
+private:
+    struct Item {
+        std::string key;
+        entry_t response;
+        size_t size = 0;
+    };
+
+    using lru_t = std::list<Item>;
+
+    // Must be called with the mutex locked
+    void Evict() {
+        while((size_ > max_bytes_) && !lru_.empty()) {
+            auto& victim = lru_.back();
+            RESTC_CPP_LOG_TRACE_("MemoryResponseCache: Evicting " << victim.key);
+            size_ -= victim.size;
+            entries_.erase(victim.key);
+            lru_.pop_back();
+        }
+    }
+
+    const size_t max_bytes_;
+    const size_t max_entry_size_;
+    size_t size_ = 0;
+    lru_t lru_;
+    std::unordered_map<std::string, lru_t::iterator> entries_;
+    mutable std::mutex mutex_;
+};
+
+ResponseCache::ptr_t
+ResponseCache::CreateMemoryCache(size_t maxBytes, size_t maxEntrySize) {
+    return make_shared<MemoryResponseCache>(maxBytes, maxEntrySize);
+}
+
+} // namespace
@@ -13,6 +13,7 @@
 #include "restc-cpp/restc-cpp.h"
 #include "restc-cpp/logging.h"
 #include "restc-cpp/ConnectionPool.h"
+#include "restc-cpp/RedirectCache.h"
 #include "restc-cpp/RequestBody.h"
 #include "restc-cpp/internals/helpers.h"
 
@@ -77,6 +78,11 @@ public:
             return Request(*req);
         }
 
+        unique_ptr<Reply> Get(string url, boost::system::error_code& ec) override {
+            auto req = Request::Create(url, restc_cpp::Request::Type::GET, rc_);
+            return Request(*req, ec);
+        }
+
         unique_ptr< Reply > Post(string url, string body) override {
             auto req = Request::Create(url, restc_cpp::Request::Type::POST, rc_,
                                        {RequestBody::CreateStringBody(std::move(body))});
@@ -89,6 +95,18 @@ public:
             return Request(*req);
         }
 
+        unique_ptr< Reply > Post(string url, unique_ptr<RequestBody> body) override {
+            auto req = Request::Create(url, restc_cpp::Request::Type::POST, rc_,
+                                       std::move(body));
+            return Request(*req);
+        }
+
+        unique_ptr< Reply > Put(string url, unique_ptr<RequestBody> body) override {
+            auto req = Request::Create(url, restc_cpp::Request::Type::PUT, rc_,
+                                       std::move(body));
+            return Request(*req);
+        }
+
         unique_ptr< Reply > Delete(string url) override {
             auto req = Request::Create(url, restc_cpp::Request::Type::DELETE, rc_);
             return Request(*req);
@@ -113,6 +131,11 @@ public:
             return req.Execute(*this);
         }
 
+        unique_ptr<Reply> Request(restc_cpp::Request& req,
+                                  boost::system::error_code& ec) override {
+            return req.Execute(*this, ec);
+        }
+
         void Sleep(const uint64_t microseconds) override {
             boost::asio::steady_timer timer(
                 GetClient().GetIoService(),
@@ -186,7 +209,7 @@ public:
     void Init(const boost::optional<Request::Properties>& properties,
               bool useMainThread) {
 
-        static const string content_type{"Content-Type"};
+        using header_names::content_type;
         static const string json_type{"application/json; charset=utf-8"};
 
         if (properties)
@@ -197,6 +220,10 @@ public:
             default_connection_properties_->headers[content_type] = json_type;
         }
 
+        if (!default_connection_properties_->redirectCache) {
+            default_connection_properties_->redirectCache = RedirectCache::Create();
+        }
+
         pool_ = ConnectionPool::Create(*this);
 
         if (useMainThread) {
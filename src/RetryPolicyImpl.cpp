@@ -0,0 +1,184 @@
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+#include <boost/asio/error.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/logging.h"
+
+#include "CachePolicy.h"
+#include "RetryPolicyImpl.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+constexpr int http_429 = 429;
+
+bool IsNetworkError(const boost::system::error_code& ec) noexcept {
+    return (ec == boost::asio::error::connection_reset)
+        || (ec == boost::asio::error::connection_aborted)
+        || (ec == boost::asio::error::broken_pipe)
+        || (ec == boost::asio::error::eof)
+        || (ec == Error::CONNECTION_EXPIRED);
+}
+
+} // anonymous namespace
+
+RetryPolicyImpl::RetryPolicyImpl(const Config& config)
+: config_{config}, random_{random_device{}()}
+{
+    if ((config_.baseDelayMs < 0) || (config_.maxDelayMs < config_.baseDelayMs)) {
+        throw ConstraintException("RetryPolicy: baseDelayMs must be >= 0 and <= maxDelayMs");
+    }
+    if (config_.budgetRatio < 0.0) {
+        throw ConstraintException("RetryPolicy: budgetRatio must be >= 0");
+    }
+    if (config_.budgetWindowMs < static_cast<int>(budget_slots)) {
+        throw ConstraintException("RetryPolicy: budgetWindowMs is too small");
+    }
+}
+
+RetryPolicy::Stats RetryPolicyImpl::GetStats() const {
+    std::lock_guard<std::mutex> const lock{mutex_};
+    return stats_;
+}
+
+void RetryPolicyImpl::OnRequest() {
+    const auto now = clock_t::now();
+    std::lock_guard<std::mutex> const lock{mutex_};
+    ++GetSlot(now).requests;
+    ++stats_.requests;
+}
+
+boost::optional<std::chrono::milliseconds>
+RetryPolicyImpl::GetRetryDelay(size_t retries, bool idempotent,
+                               const boost::system::error_code& ec,
+                               const boost::optional<std::string>& retryAfter) {
+    if ((retries >= config_.maxRetries) || !IsRetryable(idempotent, ec)) {
+        return {};
+    }
+
+    boost::optional<std::chrono::milliseconds> server_delay;
+    if (retryAfter) {
+        server_delay = ParseRetryAfter(*retryAfter);
+        if (server_delay && (server_delay->count() > config_.maxRetryAfterMs)) {
+            RESTC_CPP_LOG_DEBUG_("RetryPolicy: Not retrying. The server asks us to wait "
+                                 << server_delay->count() << " ms.");
+            return {};
+        }
+    }
+
+    if ((ec.category() == http_category()) && (ec.value() == http_429) && !server_delay) {
+        return {};
+    }
+
+    const auto now = clock_t::now();
+    std::lock_guard<std::mutex> const lock{mutex_};
+    if (!TakeFromBudget(now)) {
+        ++stats_.budgetExhausted;
+        RESTC_CPP_LOG_DEBUG_("RetryPolicy: Not retrying. The retry budget is spent.");
+        return {};
+    }
+    ++stats_.retries;
+
+    // Full jitter
+    const auto exponent = static_cast<int>(min<size_t>(retries, 30));
+    const auto cap = min<double>(config_.maxDelayMs, ldexp(config_.baseDelayMs, exponent));
+    uniform_int_distribution<int64_t> jitter(0, static_cast<int64_t>(cap));
+    const std::chrono::milliseconds delay{jitter(random_)};
+
+    if (server_delay) {
+        return max(delay, *server_delay);
+    }
+    return delay;
+}
+
+boost::optional<std::chrono::milliseconds>
+RetryPolicyImpl::ParseRetryAfter(const std::string& value) {
+    if (!value.empty() && all_of(value.begin(), value.end(),
+                                 [](char ch) { return isdigit(static_cast<unsigned char>(ch)); })) {
+        if (value.size() > 9) {
+            return std::chrono::milliseconds::max();
+        }
+        return std::chrono::milliseconds{std::chrono::seconds{stol(value)}};
+    }
+
+    if (const auto when = ParseHttpDate(value)) {
+        const auto now = CachedResponse::clock_t::now();
+        if (*when <= now) {
+            return std::chrono::milliseconds{0};
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(*when - now);
+    }
+
+    return {};
+}
+
+bool RetryPolicyImpl::IsRetryable(bool idempotent, const boost::system::error_code& ec) const {
+    if (ec == Error::FAILED_TO_CONNECT) {
+        return config_.retryConnectErrors; // The request was not sent
+    }
+
+    if (!idempotent && !config_.retryNonIdempotent) {
+        return false;
+    }
+
+    if (ec.category() == http_category()) {
+        if (ec.value() == http_429) {
+            return config_.retryTooManyRequests;
+        }
+        return config_.retryStatusCodes.count(ec.value()) != 0;
+    }
+
+    return config_.retryNetworkErrors && IsNetworkError(ec);
+}
+
+RetryPolicyImpl::Slot& RetryPolicyImpl::GetSlot(clock_t::time_point now) {
+    const auto slot_ms = config_.budgetWindowMs / static_cast<int>(budget_slots);
+    const auto id = std::chrono::duration_cast<std::chrono::milliseconds>(now - epoch_).count()
+        / slot_ms;
+    auto& slot = slots_.at(static_cast<size_t>(id) % budget_slots);
+    if (slot.id != id) {
+        slot = {};
+        slot.id = id;
+    }
+    return slot;
+}
+
+bool RetryPolicyImpl::TakeFromBudget(clock_t::time_point now) {
+    auto& current = GetSlot(now);
+
+    size_t requests = 0;
+    size_t retries = 0;
+    for(const auto& slot : slots_) {
+        if ((slot.id >= 0) && (slot.id > (current.id - static_cast<int64_t>(budget_slots)))) {
+            requests += slot.requests;
+            retries += slot.retries;
+        }
+    }
+
+    const auto budget = (config_.budgetRatio * static_cast<double>(requests))
+        + (static_cast<double>(config_.budgetMinRetriesPerSecond) * config_.budgetWindowMs / 1000.0);
+    if (static_cast<double>(retries + 1) > budget) {
+        return false;
+    }
+
+    ++current.retries;
+    return true;
+}
+
+RetryPolicy::ptr_t RetryPolicy::Create() {
+    return Create(Config{});
+}
+
+RetryPolicy::ptr_t RetryPolicy::Create(const Config& config) {
+    return make_shared<RetryPolicyImpl>(config);
+}
+
+} // namespace
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include <boost/optional.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RetryPolicy.h"
+
+namespace restc_cpp {
+
+class RetryPolicyImpl : public RetryPolicy {
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    explicit RetryPolicyImpl(const Config& config);
+
+    Stats GetStats() const override;
+
+    /*! A request starts. Each request adds to the retry budget. */
+    void OnRequest();
+
+    /*! Decide if a request is retried after a failed attempt
+     *
+     * \param retries The retries done so far
+     * \param idempotent If the request can safely be sent again
+     * \param ec The error. HTTP errors are in the http_category.
+     * \param retryAfter The Retry-After header of the response, if any
+     * \return The time to wait before the retry, or nothing to give up.
+     *      The retry is taken from the budget.
+     */
+    boost::optional<std::chrono::milliseconds>
+    GetRetryDelay(std::size_t retries, bool idempotent,
+                  const boost::system::error_code& ec,
+                  const boost::optional<std::string>& retryAfter);
+
+    /*! Parse a Retry-After header (seconds or a HTTP date)
+     *
+     * \return The time to wait, or nothing if the value is invalid.
+     */
+    static boost::optional<std::chrono::milliseconds>
+    ParseRetryAfter(const std::string& value);
+
+private:
+    // The budget is counted in slots of 1/budget_slots of the window
+    static constexpr std::size_t budget_slots = 10;
+
+    struct Slot {
+        std::int64_t id = -1;
+        std::size_t requests = 0;
+        std::size_t retries = 0;
+    };
+
+    bool IsRetryable(bool idempotent, const boost::system::error_code& ec) const;
+
+    // The methods below are called with the mutex locked
+    Slot& GetSlot(clock_t::time_point now);
+    bool TakeFromBudget(clock_t::time_point now);
+
+    const Config config_;
+    const clock_t::time_point epoch_ = clock_t::now();
+    std::array<Slot, budget_slots> slots_;
+    Stats stats_;
+    std::mt19937 random_;
+    mutable std::mutex mutex_;
+};
+
+/*! Execute a request, and try again as long as the policy allows it
+ *
+ * \param attempt Sends the request and gets the reply. HTTP errors must
+ *      be returned in the reply, not thrown.
+ * \param ec The error code of the request, if errors are reported in it.
+ *      It is cleared before each retry.
+ * \param describe The request, for the log
+ * \return The reply to the last attempt. nullptr if it failed, and the
+ *      error is reported in ec.
+ * \throws The exception from the last attempt.
+ */
+std::unique_ptr<Reply> ExecuteWithRetries(Context& ctx, RetryPolicyImpl& policy,
+                                          bool idempotent,
+                                          const std::function<std::unique_ptr<Reply> ()>& attempt,
+                                          boost::system::error_code *ec,
+                                          const std::function<std::string ()>& describe);
+
+} // namespace
@@ -35,6 +35,14 @@ public:
         });
     }
 
+    std::size_t AsyncReadSome(boost_mutable_buffer buffers,
+                              boost::asio::yield_context& yield,
+                              boost::system::error_code& ec) override {
+        const auto bytes = socket_.async_read_some(buffers, yield[ec]);
+        TranslateError(ec);
+        return bytes;
+    }
+
     std::size_t AsyncRead(boost_mutable_buffer buffers,
                         boost::asio::yield_context& yield) override {
         return WrapException<std::size_t>([&] {
@@ -59,11 +67,25 @@ public:
 					const std::string &host,
                     bool tcpNodelay,
                     boost::asio::yield_context& yield) override {
-        return WrapException<void>([&] {
-            socket_.async_connect(ep, yield);
-            socket_.lowest_layer().set_option(boost::asio::ip::tcp::no_delay(tcpNodelay));
-            OnAfterConnect();
-        });
+        boost::system::error_code ec;
+        AsyncConnect(ep, host, tcpNodelay, yield, ec);
+        ThrowOnError(ec);
+    }
+
+    void AsyncConnect(const boost::asio::ip::tcp::endpoint& ep,
+                    const std::string &host,
+                    bool tcpNodelay,
+                    boost::asio::yield_context& yield,
+                    boost::system::error_code& ec) override {
+        socket_.async_connect(ep, yield[ec]);
+        if (!ec) {
+            socket_.lowest_layer().set_option(boost::asio::ip::tcp::no_delay(tcpNodelay), ec);
+        }
+        if (ec) {
+            TranslateError(ec);
+            return;
+        }
+        OnAfterConnect();
     }
 
     void AsyncShutdown(boost::asio::yield_context& yield) override {
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "restc-cpp/restc-cpp.h"
+
+namespace restc_cpp {
+
+/*! Suspend the coroutine
+ *
+ * park() gets a function that resumes the coroutine. It must call it, or
+ * keep it for someone else to call, exactly once. It may be called from
+ * any thread, also before the coroutine is suspended.
+ */
+inline void Suspend(Context& ctx, const std::function<void (std::function<void ()>)>& park) {
+    struct Parked {
+        explicit Parked(boost_io_service& ioService)
+        : timer{ioService}
+        {
+            timer.expires_at(boost::asio::steady_timer::time_point::max());
+        }
+
+        std::mutex mutex;
+        boost::asio::steady_timer timer;
+    };
+
+    auto parked = std::make_shared<Parked>(ctx.GetClient().GetIoService());
+    park([parked] {
+        // Cancels the wait, or makes it complete at once if it has not started
+        std::lock_guard<std::mutex> const lock{parked->mutex};
+        parked->timer.expires_at(boost::asio::steady_timer::time_point::min());
+    });
+
+    const auto wait = [&parked](auto handler) {
+        std::lock_guard<std::mutex> const lock{parked->mutex};
+        parked->timer.async_wait(std::move(handler));
+    };
+
+    boost::system::error_code ec;
+    auto yield = ctx.GetYield()[ec];
+#if BOOST_VERSION >= 107000
+    boost::asio::async_initiate<boost::asio::yield_context, void(boost::system::error_code)>(
+        wait, yield);
+#else
+    boost::asio::async_completion<boost::asio::yield_context, void(boost::system::error_code)>
+        init{yield};
+    wait(std::move(init.completion_handler));
+    init.result.get();
+#endif
+}
+
+} // namespace
@@ -46,6 +46,14 @@ public:
         });
     }
 
+    std::size_t AsyncReadSome(boost_mutable_buffer buffers,
+                              boost::asio::yield_context& yield,
+                              boost::system::error_code& ec) override {
+        const auto bytes = ssl_socket_->async_read_some(buffers, yield[ec]);
+        TranslateError(ec);
+        return bytes;
+    }
+
     std::size_t AsyncRead(boost_mutable_buffer buffers,
                           boost::asio::yield_context& yield) override {
         return WrapException<std::size_t>([&] {
@@ -69,30 +77,46 @@ public:
                     const std::string &host,
                     bool tcpNodelay,
                     boost::asio::yield_context& yield) override {
-        return WrapException<void>([&] {
-            //TLS-SNI (without this option, handshakes attempts with hosts behind CDNs will fail,
-            //due to the fact that the CDN does not have enough information at the TLS layer
-            //to decide where to forward the handshake attempt).
+        boost::system::error_code ec;
+        AsyncConnect(ep, host, tcpNodelay, yield, ec);
+        ThrowOnError(ec);
+    }
 
-            RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling SSL_set_tlsext_host_name --> " << host);
-            SSL_set_tlsext_host_name(ssl_socket_->native_handle(), host.c_str());
+    void AsyncConnect(const boost::asio::ip::tcp::endpoint& ep,
+                    const std::string &host,
+                    bool tcpNodelay,
+                    boost::asio::yield_context& yield,
+                    boost::system::error_code& ec) override {
+        //TLS-SNI (without this option, handshakes attempts with hosts behind CDNs will fail,
+        //due to the fact that the CDN does not have enough information at the TLS layer
+        //to decide where to forward the handshake attempt).
 
-            RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling async_connect");
-            GetSocket().async_connect(ep, yield);
+        RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling SSL_set_tlsext_host_name --> " << host);
+        SSL_set_tlsext_host_name(ssl_socket_->native_handle(), host.c_str());
 
+        RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling async_connect");
+        GetSocket().async_connect(ep, yield[ec]);
+
+        if (!ec) {
             RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling lowest_layer().set_option");
             ssl_socket_->lowest_layer().set_option(
-                        boost::asio::ip::tcp::no_delay(tcpNodelay));
+                        boost::asio::ip::tcp::no_delay(tcpNodelay), ec);
+        }
 
-            RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling OnAfterConnect()");
-            OnAfterConnect();
+        if (ec) {
+            TranslateError(ec);
+            return;
+        }
 
-            RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling async_handshake");
-            ssl_socket_->async_handshake(boost::asio::ssl::stream_base::client,
-                                         yield);
+        RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling OnAfterConnect()");
+        OnAfterConnect();
 
-            RESTC_CPP_LOG_TRACE_("AsyncConnect - Done");
-        });
+        RESTC_CPP_LOG_TRACE_("AsyncConnect - Calling async_handshake");
+        ssl_socket_->async_handshake(boost::asio::ssl::stream_base::client,
+                                     yield[ec]);
+        TranslateError(ec);
+
+        RESTC_CPP_LOG_TRACE_("AsyncConnect - Done");
     }
 
     void AsyncShutdown(boost::asio::yield_context& yield) override {
@@ -113,6 +137,24 @@ public:
         return ssl_socket_->lowest_layer().is_open();
     }
 
+    void SetAlpnProtocols(const std::string& protocols) override {
+        if (SSL_set_alpn_protos(ssl_socket_->native_handle(),
+                                reinterpret_cast<const unsigned char *>(protocols.data()),
+                                static_cast<unsigned int>(protocols.size())) != 0) {
+            throw RestcCppException("Failed to set the ALPN protocols");
+        }
+    }
+
+    std::string GetAlpnProtocol() const override {
+        const unsigned char *protocol = nullptr;
+        unsigned int len = 0;
+        SSL_get0_alpn_selected(ssl_socket_->native_handle(), &protocol, &len);
+        if (!protocol) {
+            return {};
+        }
+        return {reinterpret_cast<const char *>(protocol), len};
+    }
+
 protected:
     std::ostream& Print(std::ostream& o) const override {
         if (IsOpen()) {
@@ -28,6 +28,13 @@ Url& Url::operator = (const char *url) {
     constexpr auto magic_7 = 7;
 
     assert(url != nullptr && "A valid URL is required");
+
+    // Nothing from a previous url can be used for this one
+    host_ = {};
+    port_ = {};
+    path_ = "/";
+    args_ = {};
+
     protocol_name_ = boost::string_ref(url);
     if (protocol_name_.find("https://") == 0) {
         protocol_name_ = boost::string_ref(url, magic_8);
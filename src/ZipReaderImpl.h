@@ -0,0 +1,160 @@
+#pragma once
+
+#include <zlib.h>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataReader.h"
+#include "restc-cpp/logging.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+namespace restc_cpp {
+
+/*! Decompresses the data from the source.
+ *
+ * SourceT is DataReader::ptr_t for the generic reader chain. For the
+ * common response shapes, SourceT is the concrete body reader, which is
+ * then held in place inside this object. That saves an allocation, and
+ * lets the compiler resolve the calls to the source statically.
+ */
+template <typename SourceT>
+class ZipReaderImpl final : public DataReader,
+                            public RecycledObject<ZipReaderImpl<SourceT>> {
+public:
+
+    template <typename... ArgsT>
+    ZipReaderImpl(const Compression format, ArgsT&&... args)
+    : source_{std::forward<ArgsT>(args)...}
+    {
+        const auto wsize = (format == Compression::GZIP) ? (MAX_WBITS | 16) : MAX_WBITS;
+
+        if (inflateInit2(&strm_, wsize) != Z_OK) {
+            throw DecompressException("Failed to initialize decompression");
+        }
+    }
+
+    ZipReaderImpl(const ZipReaderImpl&) = delete;
+    ZipReaderImpl(ZipReaderImpl&&) = delete;
+
+    ZipReaderImpl& operator = (const ZipReaderImpl&) = delete;
+    ZipReaderImpl& operator = (ZipReaderImpl&&) = delete;
+
+
+    ~ZipReaderImpl() override {
+        inflateEnd(&strm_);
+    }
+
+    [[nodiscard]] bool IsEof() const override { return done_; }
+
+    void Finish() override {
+        Source().Finish();
+    }
+
+    [[nodiscard]] bool HaveMoreBufferedInput() const noexcept { return strm_.avail_in > 0; }
+
+    ::restc_cpp::boost_const_buffer ReadSome() override {
+
+        size_t data_len = 0;
+
+        while(!done_) {
+            boost::string_ref src;
+            if (HaveMoreBufferedInput()) {
+                src = {};
+            } else {
+                const auto buffers = Source().ReadSome();
+                src = {
+                    boost_buffer_cast(buffers),
+                    boost::asio::buffer_size(buffers)};
+
+                if (src.empty()) {
+                    throw DecompressException("Decompression failed - premature end of stream.");
+                }
+            }
+
+            boost::string_ref out = {out_buffer_.data() + data_len,
+                out_buffer_.size() - data_len};
+
+            // Decompress sets leftover to cover unread input data
+            Decompress(src, out);
+            data_len += out.size();
+
+            if ((out_buffer_.size() - data_len) == 0) {
+                break;
+            }
+        }
+
+        return {out_buffer_.data(), data_len};
+    }
+
+private:
+    template <typename T>
+    static T& Deref(T& reader) noexcept { return reader; }
+
+    template <typename T>
+    static T& Deref(std::unique_ptr<T>& reader) noexcept { return *reader; }
+
+    auto& Source() noexcept { return Deref(source_); }
+
+    void Decompress(boost::string_ref& src,
+                    boost::string_ref& dst) {
+
+        RESTC_CPP_LOG_TRACE_("ZipReaderImpl::Decompress: " << src.size() << " bytes");
+
+        if (!HaveMoreBufferedInput()) {
+            strm_.next_in = const_cast<Bytef *>(
+                reinterpret_cast<const Bytef *>(src.data()));
+            strm_.avail_in
+                = static_cast<decltype(strm_.avail_in)>(src.size());
+        }
+
+        assert(strm_.avail_in > 0);
+
+        strm_.avail_out
+            = static_cast<decltype(strm_.avail_out)>(dst.size());
+        strm_.next_out = const_cast<Bytef *>(
+            reinterpret_cast<const Bytef *>(dst.data()));
+
+        assert(strm_.avail_out > 0);
+
+        const auto result = inflate(&strm_, Z_SYNC_FLUSH);
+        switch (result) {
+            case Z_OK:
+                break;
+            case Z_NEED_DICT:
+            case Z_DATA_ERROR:
+            case Z_MEM_ERROR:
+            case Z_STREAM_ERROR: {
+                std::string errmsg = "Decompression failed";
+                if (strm_.msg != nullptr) {
+                    errmsg += ": ";
+                    errmsg += strm_.msg;
+                }
+                throw DecompressException(errmsg);
+            }
+            case Z_STREAM_END:
+                RESTC_CPP_LOG_TRACE_("ZipReaderImpl::Decompress(): End Zstream. Done.");
+                done_ = true;
+                break;
+            default: {
+                std::string errmsg =
+                    std::string("Decompression failed with unexpected value ")
+                        + std::to_string(result);
+                if (strm_.msg != nullptr) {
+                    errmsg += ": ";
+                    errmsg += strm_.msg;
+                }
+                throw DecompressException(errmsg);
+            }
+        }
+
+        dst = {dst.data(), dst.size() - strm_.avail_out};
+        RESTC_CPP_LOG_TRACE_("ZipReaderImpl::Decompress: src=" << std::dec << src.size() << " bytes, dst=" << dst.size() << " bytes");
+    }
+
+    SourceT source_;
+    static constexpr size_t out_buffer_len_ = 1024*8;
+    std::array<char, out_buffer_len_> out_buffer_ = {};
+    z_stream strm_ = {};
+    bool done_ = false;
+};
+
+} // namepsace
@@ -0,0 +1,152 @@
+
+#include <array>
+
+#include <zlib.h>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataWriter.h"
+#include "restc-cpp/logging.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+
+class ZipWriterImpl : public DataWriter, public RecycledObject<ZipWriterImpl> {
+public:
+    ZipWriterImpl(const Request::Compression format, const int level, ptr_t&& source)
+    : next_{std::move(source)}, format_{format}
+    {
+        constexpr int mem_level = 8; // zlib's default
+        const auto wbits = (format == Request::Compression::GZIP) ? (MAX_WBITS | 16) : MAX_WBITS;
+
+        if (deflateInit2(&strm_, level, Z_DEFLATED, wbits, mem_level,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw CompressException("Failed to initialize compression");
+        }
+    }
+
+    ZipWriterImpl(const ZipWriterImpl&) = delete;
+    ZipWriterImpl(ZipWriterImpl&&) = delete;
+
+    ZipWriterImpl& operator = (const ZipWriterImpl&) = delete;
+    ZipWriterImpl& operator = (ZipWriterImpl&&) = delete;
+
+    ~ZipWriterImpl() override {
+        deflateEnd(&strm_);
+    }
+
+    void WriteDirect(::restc_cpp::boost_const_buffer buffers) override {
+        next_->WriteDirect(buffers);
+    }
+
+    void Write(::restc_cpp::boost_const_buffer buffers) override {
+        const auto len = boost::asio::buffer_size(buffers);
+        if (len == 0) {
+            return;
+        }
+
+        strm_.next_in = const_cast<Bytef *>(
+            reinterpret_cast<const Bytef *>(boost_buffer_cast(buffers)));
+        strm_.avail_in = static_cast<decltype(strm_.avail_in)>(len);
+
+        Compress(Z_NO_FLUSH);
+    }
+
+    void Write(const write_buffers_t& buffers) override {
+        for(const auto& b : buffers) {
+            Write(b);
+        }
+    }
+
+    void Finish() override {
+        Compress(Z_FINISH);
+        SendOutput();
+        next_->Finish();
+    }
+
+    void Flush() override {
+        Compress(Z_SYNC_FLUSH);
+        SendOutput();
+        next_->Flush();
+    }
+
+    void SetHeaders(Request::headers_t& headers) override {
+        static const string gzip{"gzip"};
+        static const string deflate{"deflate"};
+
+        headers[header_names::content_encoding]
+            = (format_ == Request::Compression::GZIP) ? gzip : deflate;
+
+        next_->SetHeaders(headers);
+    }
+
+private:
+    // Compress the pending input. The output is sent when the buffer is full.
+    void Compress(const int flush) {
+        while(true) {
+            strm_.next_out = reinterpret_cast<Bytef *>(out_buffer_.data() + out_len_);
+            strm_.avail_out = static_cast<decltype(strm_.avail_out)>(
+                out_buffer_.size() - out_len_);
+
+            const auto result = deflate(&strm_, flush);
+            if (result == Z_STREAM_ERROR) {
+                std::string errmsg = "Compression failed";
+                if (strm_.msg != nullptr) {
+                    errmsg += ": ";
+                    errmsg += strm_.msg;
+                }
+                throw CompressException(errmsg);
+            }
+
+            out_len_ = out_buffer_.size() - strm_.avail_out;
+
+            if (strm_.avail_out != 0) {
+                // All the input is consumed, and for a flush, all
+                // the output is produced.
+                assert(strm_.avail_in == 0);
+                return;
+            }
+
+            SendOutput();
+
+            if (result == Z_STREAM_END) {
+                return;
+            }
+        }
+    }
+
+    void SendOutput() {
+        if (out_len_ == 0) {
+            return;
+        }
+
+        RESTC_CPP_LOG_TRACE_("ZipWriterImpl: Sending #" << out_len_
+            << " compressed bytes");
+
+        next_->Write({out_buffer_.data(), out_len_});
+        out_len_ = 0;
+    }
+
+    unique_ptr<DataWriter> next_;
+    const Request::Compression format_;
+    z_stream strm_ = {};
+    size_t out_len_ = 0;
+    std::array<char, RESTC_CPP_IO_BUFFER_SIZE> out_buffer_ = {};
+};
+
+
+DataWriter::ptr_t
+DataWriter::CreateGzipWriter(std::unique_ptr<DataWriter>&& source, int level) {
+    return make_unique<ZipWriterImpl>(Request::Compression::GZIP, level,
+                                      std::move(source));
+}
+
+DataWriter::ptr_t
+DataWriter::CreateZipWriter(std::unique_ptr<DataWriter>&& source, int level) {
+    return make_unique<ZipWriterImpl>(Request::Compression::DEFLATE, level,
+                                      std::move(source));
+}
+
+} // namespace
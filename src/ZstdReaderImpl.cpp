@@ -0,0 +1,113 @@
+
+#include <array>
+
+#include <zstd.h>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataReader.h"
+#include "restc-cpp/logging.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+/*! Decompresses 'zstd' encoded data from the source.
+ *
+ * The body may contain several zstd frames.
+ */
+class ZstdReaderImpl : public DataReader, public RecycledObject<ZstdReaderImpl> {
+public:
+    ZstdReaderImpl(ptr_t&& source)
+    : source_{std::move(source)}, stream_{ZSTD_createDStream()}
+    {
+        if ((stream_ == nullptr) || ZSTD_isError(ZSTD_initDStream(stream_))) {
+            ZSTD_freeDStream(stream_);
+            throw DecompressException("Failed to initialize decompression");
+        }
+    }
+
+    ZstdReaderImpl(const ZstdReaderImpl&) = delete;
+    ZstdReaderImpl(ZstdReaderImpl&&) = delete;
+
+    ZstdReaderImpl& operator = (const ZstdReaderImpl&) = delete;
+    ZstdReaderImpl& operator = (ZstdReaderImpl&&) = delete;
+
+    ~ZstdReaderImpl() override {
+        ZSTD_freeDStream(stream_);
+    }
+
+    [[nodiscard]] bool IsEof() const override { return done_; }
+
+    void Finish() override {
+        source_->Finish();
+    }
+
+    ::restc_cpp::boost_const_buffer ReadSome() override {
+        while(!done_) {
+            if (need_input_) {
+                if (!got_input_ && source_->IsEof()) {
+                    // An empty body, like a reply with Content-Length: 0
+                    done_ = true;
+                    break;
+                }
+
+                const auto buffers = source_->ReadSome();
+                in_.src = boost_buffer_cast(buffers);
+                in_.size = boost::asio::buffer_size(buffers);
+                in_.pos = 0;
+
+                if (in_.size == 0) {
+                    if ((frame_complete_ || !got_input_) && source_->IsEof()) {
+                        done_ = true;
+                        break;
+                    }
+                    throw DecompressException("Decompression failed - premature end of stream.");
+                }
+                got_input_ = true;
+            }
+
+            ZSTD_outBuffer out = {out_buffer_.data(), out_buffer_.size(), 0};
+            const auto result = ZSTD_decompressStream(stream_, &out, &in_);
+            if (ZSTD_isError(result)) {
+                throw DecompressException(
+                    "Decompression failed: "s + ZSTD_getErrorName(result));
+            }
+
+            const bool input_consumed = in_.pos == in_.size;
+            frame_complete_ = result == 0;
+
+            // A full output buffer may mean that there is more output pending
+            need_input_ = input_consumed && (out.pos < out.size);
+
+            if (frame_complete_ && input_consumed && source_->IsEof()) {
+                // End of the last frame, and of the body
+                RESTC_CPP_LOG_TRACE_("ZstdReaderImpl::ReadSome(): End of stream. Done.");
+                done_ = true;
+            }
+
+            if (out.pos > 0) {
+                return {out_buffer_.data(), out.pos};
+            }
+        }
+
+        return {out_buffer_.data(), 0};
+    }
+
+private:
+    ptr_t source_;
+    ZSTD_DStream *stream_ = nullptr;
+    ZSTD_inBuffer in_ = {};
+    bool need_input_ = true;
+    bool got_input_ = false;
+    bool frame_complete_ = false;
+    bool done_ = false;
+    std::array<char, 1024 * 8> out_buffer_ = {};
+};
+
+DataReader::ptr_t
+DataReader::CreateZstdReader(ptr_t&& source) {
+    return make_unique<ZstdReaderImpl>(std::move(source));
+}
+
+} // namepsace
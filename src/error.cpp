@@ -0,0 +1,107 @@
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+
+using namespace std;
+
+namespace restc_cpp {
+
+namespace {
+
+class RestcCppCategory : public boost::system::error_category {
+public:
+    const char *name() const noexcept override {
+        return "restc-cpp";
+    }
+
+    std::string message(int ev) const override {
+        switch(static_cast<Error>(ev)) {
+            case Error::OK:
+                return "Success";
+            case Error::FAILED:
+                return "Failed";
+            case Error::FAILED_TO_CONNECT:
+                return "Failed to connect";
+            case Error::FAILED_TO_RESOLVE:
+                return "Failed to resolve endpoint";
+            case Error::TOO_MANY_CONNECTIONS:
+                return "Too many connections";
+            case Error::TOO_MANY_REDIRECTS:
+                return "Too many redirects";
+            case Error::TIME_OUT:
+                return "Request Timed Out";
+            case Error::PROTOCOL_ERROR:
+                return "Protocol error";
+            case Error::CONSTRAINT:
+                return "Constraint violated";
+            case Error::CONNECTION_EXPIRED:
+                return "Connection expired";
+            case Error::NOT_SUPPORTED:
+                return "Not supported";
+            case Error::CONCURRENCY_LIMIT:
+                return "Concurrency limit reached";
+        }
+        return "Unknown error";
+    }
+};
+
+class HttpCategory : public boost::system::error_category {
+public:
+    const char *name() const noexcept override {
+        return "http";
+    }
+
+    std::string message(int ev) const override {
+        return "Request failed with HTTP error: "s + to_string(ev);
+    }
+};
+
+} // anonymous namespace
+
+const boost::system::error_category& restc_cpp_category() noexcept {
+    static const RestcCppCategory category;
+    return category;
+}
+
+const boost::system::error_category& http_category() noexcept {
+    static const HttpCategory category;
+    return category;
+}
+
+boost::system::error_code ToErrorCode(const std::exception_ptr& exception) noexcept {
+    if (!exception) {
+        return {};
+    }
+
+    try {
+        rethrow_exception(exception);
+    } catch(const RequestFailedWithErrorException& ex) {
+        return make_http_error_code(ex.http_response.status_code);
+    } catch(const RequestTimeOutException&) {
+        return Error::TIME_OUT;
+    } catch(const FailedToConnectException&) {
+        return Error::FAILED_TO_CONNECT;
+    } catch(const FailedToResolveEndpointException&) {
+        return Error::FAILED_TO_RESOLVE;
+    } catch(const ProtocolException&) {
+        return Error::PROTOCOL_ERROR;
+    } catch(const ParseException&) {
+        return Error::PROTOCOL_ERROR;
+    } catch(const ConstraintException&) {
+        return Error::CONSTRAINT;
+    } catch(const ObjectExpiredException&) {
+        return Error::CONNECTION_EXPIRED;
+    } catch(const NotSupportedException&) {
+        return Error::NOT_SUPPORTED;
+    } catch(const ConcurrencyLimitException&) {
+        return Error::CONCURRENCY_LIMIT;
+    } catch(const boost::system::system_error& ex) {
+        return ex.code();
+    } catch(...) {
+        ;
+    }
+
+    return Error::FAILED;
+}
+
+} // namespace
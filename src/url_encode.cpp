@@ -1,8 +1,15 @@
 
-#include <bitset>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#   include <emmintrin.h>
+#   define RESTC_CPP_URL_ENCODE_SSE2 1
+#endif
 
 #include "restc-cpp/restc-cpp.h"
 #include "restc-cpp/url_encode.h"
+#include "restc-cpp/error.h"
 
 using namespace std;
 
@@ -10,12 +17,16 @@ namespace restc_cpp {
 
 namespace {
 
-constexpr size_t bitset_size = 255;
-using allchars_t = std::bitset<bitset_size>;
+constexpr size_t table_size = 256;
+using allchars_t = std::array<bool, table_size>;
 
+/* Characters that are passed through unchanged.
+ *
+ * If you change this, also change IsNormal16() below.
+ */
 allchars_t get_normal_ch() {
-    allchars_t bits;
-    for(size_t chv = 0; chv < bitset_size; ++chv) {
+    allchars_t bits = {};
+    for(size_t chv = 0; chv < table_size; ++chv) {
         const auto ch = static_cast<uint8_t>(chv);
         if ((ch >= '0' && ch <= '9')
             || (ch >= 'a' && ch <= 'z')
@@ -33,26 +44,147 @@ allchars_t get_normal_ch() {
     return bits;
 }
 
+const allchars_t& normal_ch() {
+    static const auto bits = get_normal_ch();
+    return bits;
+}
+
+#ifdef RESTC_CPP_URL_ENCODE_SSE2
+
+inline __m128i InRange(__m128i chars, char lo, char hi) {
+    // All the bounds are ASCII, so the signed compares reject
+    // bytes >= 0x80.
+    return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(chars, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+/*! Returns a bitmask with one bit set for each normal character */
+inline unsigned IsNormal16(const char *src) {
+    const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+    auto normal = InRange(chars, '\'', '*'); // ' ( ) *
+    normal = _mm_or_si128(normal, InRange(chars, '-', '9')); // - . / 0-9
+    normal = _mm_or_si128(normal, InRange(chars, 'A', 'Z'));
+    normal = _mm_or_si128(normal, InRange(chars, 'a', 'z'));
+    normal = _mm_or_si128(normal, _mm_cmpeq_epi8(chars, _mm_set1_epi8('!')));
+    normal = _mm_or_si128(normal, _mm_cmpeq_epi8(chars, _mm_set1_epi8('_')));
+    normal = _mm_or_si128(normal, _mm_cmpeq_epi8(chars, _mm_set1_epi8('~')));
+
+    return static_cast<unsigned>(_mm_movemask_epi8(normal));
+}
+
+#endif // RESTC_CPP_URL_ENCODE_SSE2
+
+/*! Length of the run of normal characters at the start of src */
+size_t NormalPrefixLen(const char *src, const size_t len) {
+    size_t pos = 0;
+
+#ifdef RESTC_CPP_URL_ENCODE_SSE2
+    constexpr size_t block_size = 16;
+    constexpr unsigned all_normal = 0xffff;
+
+    for(; (pos + block_size) <= len; pos += block_size) {
+        const auto mask = IsNormal16(src + pos);
+        if (mask != all_normal) {
+            return pos + static_cast<size_t>(__builtin_ctz(~mask));
+        }
+    }
+#endif
+
+    const auto& normal = normal_ch();
+    while((pos < len) && normal[static_cast<uint8_t>(src[pos])]) {
+        ++pos;
+    }
+
+    return pos;
+}
+
+int FromHex(const char ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+    if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    }
+    if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+    return -1;
+}
+
 } // anonymous namespace
 
-std::string url_encode(const boost::string_ref& src) {
+void url_encode(const boost::string_ref& src, std::string& dst) {
     constexpr auto magic_4 = 4;
     constexpr auto magic_0x0f = 0x0f;
 
-    static const string hex{"0123456789ABCDEF"};
-    static auto normal_ch = get_normal_ch();
+    static const char * const hex{"0123456789ABCDEF"};
+
+    const char *p = src.data();
+    size_t remaining = src.size();
+
+    while(remaining != 0u) {
+        // Copy the characters that need no escaping in one go
+        const auto run = NormalPrefixLen(p, remaining);
+        dst.append(p, run);
+        p += run;
+        remaining -= run;
+
+        // Then escape the characters that need it
+        const auto& normal = normal_ch();
+        while((remaining != 0u) && !normal[static_cast<uint8_t>(*p)]) {
+            const auto ch = static_cast<uint8_t>(*p);
+            const char escaped[3] = {'%', hex[(ch >> magic_4) & magic_0x0f],
+                                     hex[ch & magic_0x0f]};
+            dst.append(escaped, sizeof(escaped));
+            ++p;
+            --remaining;
+        }
+    }
+}
+
+std::string url_encode(const boost::string_ref& src) {
     std::string rval;
-    rval.reserve(src.size() * 2);
-
-    for(auto ch : src) {
-        if (normal_ch[static_cast<uint8_t>(ch)]) {
-            rval += ch;
-        } else {
-            rval += '%';
-            rval += hex[(ch >> magic_4) & magic_0x0f];
-            rval += hex[ch & magic_0x0f];
+    rval.reserve(src.size() + (src.size() / 2));
+    url_encode(src, rval);
+    return rval;
+}
+
+void url_decode(const boost::string_ref& src, std::string& dst) {
+    constexpr auto magic_4 = 4;
+
+    const char *p = src.data();
+    const char * const end = p + src.size();
+
+    while(p != end) {
+        const auto *pct = static_cast<const char *>(
+            memchr(p, '%', static_cast<size_t>(end - p)));
+        if (pct == nullptr) {
+            dst.append(p, static_cast<size_t>(end - p));
+            return;
+        }
+
+        dst.append(p, static_cast<size_t>(pct - p));
+
+        if ((end - pct) < 3) {
+            throw ParseException("url_decode: Truncated %-escape");
         }
+
+        const auto high = FromHex(pct[1]);
+        const auto low = FromHex(pct[2]);
+        if (high < 0 || low < 0) {
+            throw ParseException("url_decode: Invalid %-escape");
+        }
+
+        dst += static_cast<char>((high << magic_4) | low);
+        p = pct + 3;
     }
+}
+
+std::string url_decode(const boost::string_ref& src) {
+    std::string rval;
+    rval.reserve(src.size());
+    url_decode(src, rval);
     return rval;
 }
 
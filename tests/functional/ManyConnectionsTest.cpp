@@ -156,6 +156,33 @@ TEST(ManyConnections, CRUD) {
     rest_client->CloseWhenReady();
 }
 
+TEST(ManyConnections, ExecuteAll) {
+    Request::Properties properties;
+    properties.cacheMaxConnections = CONNECTIONS;
+    properties.cacheMaxConnectionsPerEndpoint = CONNECTIONS;
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        Context::requests_t requests;
+        for(int i = 0; i < CONNECTIONS; ++i) {
+            requests.push_back(Request::Create(GetDockerUrl(http_url),
+                                               Request::Type::GET, ctx.GetClient()));
+        }
+
+        const auto results = ctx.ExecuteAll(requests);
+
+        EXPECT_EQ(CONNECTIONS, static_cast<int>(results.size()));
+        for(const auto& result : results) {
+            EXPECT_FALSE(result.ec) << result.ec.message();
+            ASSERT_TRUE(result.reply);
+            EXPECT_EQ(200, result.reply->GetResponseCode());
+            EXPECT_FALSE(result.reply->GetBodyAsString().empty());
+        }
+    }).get();
+
+    rest_client->CloseWhenReady();
+}
+
 
 int main( int argc, char * argv[] )
 {
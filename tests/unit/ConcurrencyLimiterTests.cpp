@@ -0,0 +1,213 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+
+#include "../src/ConcurrencyLimiterImpl.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+using namespace std::literals::chrono_literals;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+const string server = "http://example.com:80";
+
+std::shared_ptr<ConcurrencyLimiterImpl> CreateLimiter(const ConcurrencyLimiter::Config& config) {
+    return std::static_pointer_cast<ConcurrencyLimiterImpl>(ConcurrencyLimiter::Create(config));
+}
+
+} // anonymous namespace
+
+TEST(ConcurrencyLimiter, PermitsUpToTheLimit) {
+    ConcurrencyLimiter::Config config;
+    config.initialLimit = 3;
+    config.maxQueued = 0;
+    auto limiter = CreateLimiter(config);
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ(3, limiter->GetLimit(server));
+
+        std::vector<ConcurrencyLimiterImpl::Permit> permits;
+        for(int i = 0; i < 3; ++i) {
+            permits.push_back(limiter->Acquire(server, ctx));
+        }
+        EXPECT_EQ(3, limiter->GetInFlight(server));
+
+        // The queue is disabled
+        EXPECT_THROW(limiter->Acquire(server, ctx), ConcurrencyLimitException);
+
+        // Other servers have their own limit
+        auto other = limiter->Acquire("http://example.com:8080", ctx);
+        EXPECT_TRUE(other);
+
+        // A permit without an outcome does not change the limit
+        permits.pop_back();
+        EXPECT_EQ(2, limiter->GetInFlight(server));
+        EXPECT_EQ(3, limiter->GetLimit(server));
+        EXPECT_TRUE(limiter->Acquire(server, ctx));
+    }).get();
+}
+
+TEST(ConcurrencyLimiter, WaitsForAPermit) {
+    ConcurrencyLimiter::Config config;
+    config.initialLimit = 1;
+    auto limiter = CreateLimiter(config);
+    auto rest_client = RestClient::Create();
+
+    std::atomic_int got{0};
+    std::vector<std::future<void>> waiters;
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto permit = limiter->Acquire(server, ctx);
+
+        for(int i = 0; i < 5; ++i) {
+            waiters.push_back(rest_client->ProcessWithPromise([&](Context& wctx) {
+                auto wpermit = limiter->Acquire(server, wctx);
+                EXPECT_EQ(1, limiter->GetInFlight(server));
+                ++got;
+                wctx.Sleep(1ms);
+            }));
+        }
+
+        // Let the waiters get in line
+        ctx.Sleep(100ms);
+        EXPECT_EQ(0, got);
+        EXPECT_EQ(5, limiter->GetQueued(server));
+    }).get();
+
+    for(auto& f : waiters) {
+        EXPECT_NO_THROW(f.get());
+    }
+
+    EXPECT_EQ(5, got);
+    EXPECT_EQ(0, limiter->GetInFlight(server));
+    EXPECT_EQ(0, limiter->GetQueued(server));
+}
+
+TEST(ConcurrencyLimiter, TimesOutInTheQueue) {
+    ConcurrencyLimiter::Config config;
+    config.initialLimit = 1;
+    config.maxQueueTimeMs = 50;
+    auto limiter = CreateLimiter(config);
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto permit = limiter->Acquire(server, ctx);
+        EXPECT_THROW(limiter->Acquire(server, ctx), ConcurrencyLimitException);
+        EXPECT_EQ(0, limiter->GetQueued(server));
+        EXPECT_EQ(Error::CONCURRENCY_LIMIT, ToErrorCode(make_exception_ptr(
+            ConcurrencyLimitException("test"))));
+    }).get();
+}
+
+TEST(ConcurrencyLimiter, DecreasesOnOverload) {
+    ConcurrencyLimiter::Config config;
+    config.initialLimit = 10;
+    config.minLimit = 2;
+    config.backoffRatio = 0.5;
+    auto limiter = CreateLimiter(config);
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        {
+            // Requests sent before the decrease don't decrease it again
+            auto first = limiter->Acquire(server, ctx);
+            auto second = limiter->Acquire(server, ctx);
+            ctx.Sleep(1ms);
+            first.OnResponse(503);
+            EXPECT_EQ(5, limiter->GetLimit(server));
+            second.OnFailure();
+            EXPECT_EQ(5, limiter->GetLimit(server));
+        }
+
+        for(int i = 0; i < 5; ++i) {
+            ctx.Sleep(1ms);
+            auto permit = limiter->Acquire(server, ctx);
+            permit.OnResponse(429);
+            EXPECT_FALSE(permit);
+        }
+        EXPECT_EQ(2, limiter->GetLimit(server));
+        EXPECT_EQ(0, limiter->GetInFlight(server));
+    }).get();
+}
+
+TEST(ConcurrencyLimiter, GrowsWhenTheLimitIsUsed) {
+    ConcurrencyLimiter::Config config;
+    config.initialLimit = 4;
+    config.maxLimit = 6;
+    config.latencyTolerance = 1000000.0; // Don't let timing noise decrease it
+    auto limiter = CreateLimiter(config);
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        // One request at a time does not use the limit
+        for(int i = 0; i < 20; ++i) {
+            limiter->Acquire(server, ctx).OnResponse(200);
+        }
+        EXPECT_EQ(4, limiter->GetLimit(server));
+
+        for(int round = 0; round < 20; ++round) {
+            std::vector<ConcurrencyLimiterImpl::Permit> permits;
+            const auto limit = limiter->GetLimit(server);
+            for(size_t i = 0; i < limit; ++i) {
+                permits.push_back(limiter->Acquire(server, ctx));
+            }
+            for(auto& permit : permits) {
+                permit.OnResponse(200);
+            }
+        }
+        EXPECT_EQ(6, limiter->GetLimit(server));
+    }).get();
+}
+
+TEST(ConcurrencyLimiter, DecreasesWhenTheLatencyGrows) {
+    ConcurrencyLimiter::Config config;
+    config.initialLimit = 10;
+    config.backoffRatio = 0.5;
+    auto limiter = CreateLimiter(config);
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto fast = limiter->Acquire(server, ctx);
+        fast.OnResponse(200);
+        EXPECT_EQ(10, limiter->GetLimit(server));
+
+        auto slow = limiter->Acquire(server, ctx);
+        ctx.Sleep(50ms);
+        slow.OnResponse(200);
+        EXPECT_EQ(5, limiter->GetLimit(server));
+    }).get();
+}
+
+TEST(ConcurrencyLimiter, InvalidConfig) {
+    ConcurrencyLimiter::Config config;
+    config.minLimit = 0;
+    EXPECT_THROW(ConcurrencyLimiter::Create(config), ConstraintException);
+
+    config = {};
+    config.backoffRatio = 1.0;
+    EXPECT_THROW(ConcurrencyLimiter::Create(config), ConstraintException);
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
@@ -0,0 +1,265 @@
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/DataWriter.h"
+#include "restc-cpp/RequestBodyWriter.h"
+
+#ifdef RESTC_CPP_WITH_ZLIB
+#   include <zlib.h>
+#endif
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace {
+
+// Records each write it receives
+class SinkWriter : public DataWriter {
+public:
+    SinkWriter(vector<string>& writes)
+    : writes_{writes} {}
+
+    void Write(boost_const_buffer buffers) override {
+        writes_.emplace_back(boost_buffer_cast(buffers),
+                             boost_buffer_size(buffers));
+    }
+
+    void WriteDirect(boost_const_buffer buffers) override {
+        Write(buffers);
+    }
+
+    void Write(const write_buffers_t& buffers) override {
+        string data;
+        for(const auto& b : buffers) {
+            data.append(boost_buffer_cast(b), boost_buffer_size(b));
+        }
+        writes_.push_back(std::move(data));
+    }
+
+    void Finish() override {}
+
+    void SetHeaders(Request::headers_t& /*headers*/) override {}
+
+private:
+    vector<string>& writes_;
+};
+
+} // anonymous namespace
+
+TEST(DataWriter, ChunkedWriter)
+{
+    vector<string> writes;
+    auto writer = DataWriter::CreateChunkedWriter(
+        nullptr, make_unique<SinkWriter>(writes));
+
+    writer->Write({"Hello", 5});
+    writer->Write({"0123456789abcdef0123456789", 26});
+    writer->Finish();
+
+    EXPECT_EQ(3, (int)writes.size());
+    EXPECT_EQ("5\r\nHello"s, writes[0]);
+    EXPECT_EQ("\r\n1a\r\n0123456789abcdef0123456789"s, writes[1]);
+    EXPECT_EQ("\r\n0\r\n\r\n"s, writes[2]);
+}
+
+TEST(DataWriter, BufferedWriterCoalesces)
+{
+    vector<string> writes;
+    auto writer = DataWriter::CreateBufferedWriter(
+        8, make_unique<SinkWriter>(writes));
+
+    writer->Write({"abc", 3});
+    writer->Write({"def", 3});
+    EXPECT_TRUE(writes.empty());
+
+    // Exceeds the high-water mark
+    writer->Write({"ghi", 3});
+    EXPECT_EQ(1, (int)writes.size());
+    EXPECT_EQ("abcdef"s, writes[0]);
+
+    writer->Finish();
+    EXPECT_EQ(2, (int)writes.size());
+    EXPECT_EQ("ghi"s, writes[1]);
+}
+
+TEST(DataWriter, BufferedWriterFlush)
+{
+    vector<string> writes;
+    auto writer = DataWriter::CreateBufferedWriter(
+        1024, make_unique<SinkWriter>(writes));
+
+    writer->Write({"abc", 3});
+    writer->Flush();
+    EXPECT_EQ(1, (int)writes.size());
+    EXPECT_EQ("abc"s, writes[0]);
+
+    // Nothing to flush
+    writer->Flush();
+    EXPECT_EQ(1, (int)writes.size());
+}
+
+TEST(DataWriter, BufferedWriterPassesLargeWrites)
+{
+    vector<string> writes;
+    auto writer = DataWriter::CreateBufferedWriter(
+        4, make_unique<SinkWriter>(writes));
+
+    writer->Write({"ab", 2});
+    writer->Write({"0123456789", 10});
+    writer->Finish();
+
+    EXPECT_EQ(2, (int)writes.size());
+    EXPECT_EQ("ab"s, writes[0]);
+    EXPECT_EQ("0123456789"s, writes[1]);
+}
+
+TEST(DataWriter, BufferedChunkedWriter)
+{
+    vector<string> writes;
+    auto writer = DataWriter::CreateBufferedWriter(1024,
+        DataWriter::CreateChunkedWriter(nullptr, make_unique<SinkWriter>(writes)));
+
+    for(auto i = 0; i < 10; ++i) {
+        writer->Write({"abc", 3});
+    }
+    writer->Finish();
+
+    EXPECT_EQ(2, (int)writes.size());
+    EXPECT_EQ("1e\r\nabcabcabcabcabcabcabcabcabcabc"s, writes[0]);
+    EXPECT_EQ("\r\n0\r\n\r\n"s, writes[1]);
+}
+
+#ifdef RESTC_CPP_WITH_ZLIB
+
+namespace {
+
+string Inflate(const string& compressed, bool gzip) {
+    z_stream strm = {};
+    EXPECT_EQ(Z_OK, inflateInit2(&strm, gzip ? (MAX_WBITS | 16) : MAX_WBITS));
+
+    array<char, 1024> buffer = {};
+    string rval;
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+    strm.avail_in = static_cast<uInt>(compressed.size());
+    int result = Z_OK;
+    while(result == Z_OK) {
+        strm.next_out = reinterpret_cast<Bytef *>(buffer.data());
+        strm.avail_out = static_cast<uInt>(buffer.size());
+        result = inflate(&strm, Z_NO_FLUSH);
+        rval.append(buffer.data(), buffer.size() - strm.avail_out);
+    }
+    EXPECT_EQ(Z_STREAM_END, result);
+    inflateEnd(&strm);
+    return rval;
+}
+
+string Join(const vector<string>& writes) {
+    string rval;
+    for(const auto& w : writes) {
+        rval += w;
+    }
+    return rval;
+}
+
+} // anonymous namespace
+
+TEST(DataWriter, BufferedBodyWriter)
+{
+    string buffer{"old"};
+    BufferedBodyWriter writer{buffer, 8};
+
+    writer.Write({"1234", 4});
+    writer.Write({"5678", 4});
+    EXPECT_EQ("12345678", buffer);
+}
+
+TEST(DataWriter, BufferedBodyWriterStopsOnOverflow)
+{
+    string buffer;
+    BufferedBodyWriter writer{buffer, 8};
+
+    int writes = 0;
+    EXPECT_THROW({
+        for(; writes < 100; ++writes) {
+            writer.Write({"1234", 4});
+        }
+    }, BufferedBodyWriter::Overflow);
+
+    // The third write overflows, and nothing more is written
+    EXPECT_EQ(2, writes);
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(DataWriter, GzipWriter)
+{
+    vector<string> writes;
+    auto writer = DataWriter::CreateGzipWriter(make_unique<SinkWriter>(writes));
+
+    Request::headers_t headers;
+    writer->SetHeaders(headers);
+    EXPECT_EQ("gzip"s, headers[header_names::content_encoding]);
+
+    string expect;
+    for(auto i = 0; i < 1000; ++i) {
+        const auto line = "{\"id\":"s + to_string(i) + "}\n";
+        writer->Write({line.data(), line.size()});
+        expect += line;
+    }
+    writer->Finish();
+
+    const auto compressed = Join(writes);
+    EXPECT_LT(compressed.size(), expect.size() / 4);
+    EXPECT_EQ(expect, Inflate(compressed, true));
+}
+
+TEST(DataWriter, ZipWriterFlush)
+{
+    vector<string> writes;
+    auto writer = DataWriter::CreateZipWriter(make_unique<SinkWriter>(writes), 9);
+
+    Request::headers_t headers;
+    writer->SetHeaders(headers);
+    EXPECT_EQ("deflate"s, headers[header_names::content_encoding]);
+
+    writer->Write({"Hello", 5});
+    writer->Flush();
+    EXPECT_FALSE(writes.empty());
+
+    writer->Write({" World", 6});
+    writer->Finish();
+
+    EXPECT_EQ("Hello World"s, Inflate(Join(writes), false));
+}
+
+TEST(DataWriter, GzipWriterLargeInput)
+{
+    vector<string> writes;
+    auto writer = DataWriter::CreateGzipWriter(make_unique<SinkWriter>(writes), 1);
+
+    // Random data does not compress, so the output buffer fills up
+    string data(RESTC_CPP_IO_BUFFER_SIZE * 4, '\0');
+    uint32_t seed = 1;
+    for(auto& ch : data) {
+        seed = seed * 1103515245 + 12345;
+        ch = static_cast<char>(seed >> 24);
+    }
+
+    writer->Write({data.data(), data.size()});
+    writer->Finish();
+
+    EXPECT_GT(writes.size(), 1u);
+    EXPECT_EQ(data, Inflate(Join(writes), true));
+}
+
+#endif // RESTC_CPP_WITH_ZLIB
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("debug");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
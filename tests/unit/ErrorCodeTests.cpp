@@ -0,0 +1,122 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/RequestBody.h"
+
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+// Nobody listens here
+const string closed_port_url = "http://127.0.0.1:1/";
+
+Reply::HttpResponse MakeResponse(int code) {
+    Reply::HttpResponse response;
+    response.status_code = code;
+    response.reason_phrase = "Error";
+    return response;
+}
+
+} // anonymous namespace
+
+TEST(ErrorCode, Categories) {
+    const boost::system::error_code ec = Error::TOO_MANY_REDIRECTS;
+    EXPECT_EQ(&restc_cpp_category(), &ec.category());
+    EXPECT_EQ("Too many redirects", ec.message());
+
+    const auto http = make_http_error_code(404);
+    EXPECT_EQ(&http_category(), &http.category());
+    EXPECT_EQ(404, http.value());
+    EXPECT_NE(http, boost::system::error_code(404, restc_cpp_category()));
+}
+
+TEST(ErrorCode, FromException) {
+    EXPECT_FALSE(ToErrorCode({}));
+    EXPECT_EQ(make_http_error_code(404),
+              ToErrorCode(make_exception_ptr(HttpNotFoundException(MakeResponse(404)))));
+    EXPECT_EQ(make_http_error_code(429),
+              ToErrorCode(make_exception_ptr(RequestFailedWithErrorException(MakeResponse(429)))));
+    EXPECT_EQ(Error::TIME_OUT, ToErrorCode(make_exception_ptr(RequestTimeOutException())));
+    EXPECT_EQ(Error::FAILED_TO_CONNECT,
+              ToErrorCode(make_exception_ptr(FailedToConnectException("x"))));
+    EXPECT_EQ(Error::PROTOCOL_ERROR, ToErrorCode(make_exception_ptr(ParseException("x"))));
+    EXPECT_EQ(Error::CONSTRAINT, ToErrorCode(make_exception_ptr(ConstraintException("x"))));
+    EXPECT_EQ(Error::FAILED, ToErrorCode(make_exception_ptr(std::runtime_error("x"))));
+
+    const boost::system::error_code eof = boost::asio::error::eof;
+    EXPECT_EQ(eof, ToErrorCode(make_exception_ptr(boost::system::system_error(eof))));
+}
+
+TEST(ErrorCode, FailedToConnect) {
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        boost::system::error_code ec;
+        auto reply = ctx.Get(closed_port_url, ec);
+        EXPECT_FALSE(reply);
+        EXPECT_EQ(Error::FAILED_TO_CONNECT, ec);
+
+        auto req = Request::Create(closed_port_url, Request::Type::GET, ctx.GetClient());
+        EXPECT_THROW(req->Execute(ctx), FailedToConnectException);
+    }).get();
+}
+
+TEST(ErrorCode, HttpError) {
+    TestServer server{[](const TestServer::Request&) {
+        return TestServer::Response(404, "Not Found", "No such thing");
+    }};
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto req = Request::Create(server.GetUrl("/missing"), Request::Type::GET,
+                                   ctx.GetClient());
+        boost::system::error_code ec;
+        auto reply = req->Execute(ctx, ec);
+        EXPECT_EQ(make_http_error_code(404), ec);
+        ASSERT_TRUE(reply);
+        EXPECT_EQ(404, reply->GetResponseCode());
+        EXPECT_EQ("No such thing", reply->GetBodyAsString());
+    }).get();
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(ErrorCode, RedirectLoop) {
+    TestServer server{[](const TestServer::Request& request) {
+        return TestServer::Response(302, "Found", {}, "Location: " + request.target + "\r\n");
+    }};
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto req = Request::Create(server.GetUrl("/loop"), Request::Type::GET,
+                                   ctx.GetClient());
+        boost::system::error_code ec;
+        EXPECT_FALSE(req->Execute(ctx, ec));
+        EXPECT_EQ(Error::TOO_MANY_REDIRECTS, ec);
+    }).get();
+
+    // The first request and the redirects it was allowed to follow
+    EXPECT_EQ(static_cast<size_t>(Request::Properties{}.maxRedirects + 1),
+              server.GetRequests().size());
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("debug");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
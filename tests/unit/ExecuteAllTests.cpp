@@ -0,0 +1,98 @@
+
+#include <set>
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/RequestBody.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+// Nobody listens here
+const string closed_port_url = "http://127.0.0.1:1/";
+
+Context::requests_t MakeRequests(RestClient& client, size_t count) {
+    Context::requests_t requests;
+    for(size_t i = 0; i < count; ++i) {
+        requests.push_back(Request::Create(closed_port_url, Request::Type::GET, client));
+    }
+    return requests;
+}
+
+} // anonymous namespace
+
+TEST(ExecuteAll, NoRequests) {
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_TRUE(ctx.ExecuteAll({}).empty());
+    }).get();
+}
+
+TEST(ExecuteAll, ResultsInOrder) {
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto requests = MakeRequests(ctx.GetClient(), 7);
+        const auto results = ctx.ExecuteAll(requests, 3);
+
+        ASSERT_EQ(requests.size(), results.size());
+        for(size_t i = 0; i < results.size(); ++i) {
+            EXPECT_EQ(i, results[i].index);
+            EXPECT_FALSE(results[i].reply);
+            EXPECT_EQ(Error::FAILED_TO_CONNECT, results[i].ec);
+        }
+
+        // The coroutine can still do IO
+        ctx.Sleep(1ms);
+    }).get();
+}
+
+TEST(ExecuteAll, AsCompleted) {
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto requests = MakeRequests(ctx.GetClient(), 5);
+        set<size_t> indexes;
+        ctx.ExecuteAsCompleted(requests, [&indexes](Context::BatchResult&& result) {
+            EXPECT_EQ(Error::FAILED_TO_CONNECT, result.ec);
+            indexes.insert(result.index);
+        });
+
+        EXPECT_EQ((set<size_t>{0, 1, 2, 3, 4}), indexes);
+    }).get();
+}
+
+TEST(ExecuteAll, StopsWhenTheCallbackThrows) {
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto requests = MakeRequests(ctx.GetClient(), 20);
+        size_t calls = 0;
+        EXPECT_THROW(ctx.ExecuteAsCompleted(requests, [&calls](Context::BatchResult&&) {
+            ++calls;
+            throw runtime_error("stop");
+        }, 1), runtime_error);
+
+        EXPECT_EQ(1, calls);
+    }).get();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("debug");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
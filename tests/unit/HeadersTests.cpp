@@ -0,0 +1,136 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/Headers.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+TEST(Headers, CaseInsensitiveFind)
+{
+    Headers headers;
+    headers["Content-Type"] = "text/plain";
+
+    EXPECT_EQ(1, (int)headers.size());
+    EXPECT_NE(headers.end(), headers.find("content-type"));
+    EXPECT_NE(headers.end(), headers.find(header_names::content_type));
+    EXPECT_EQ("text/plain"s, headers.find("CONTENT-TYPE")->second);
+    EXPECT_EQ(headers.end(), headers.find("Content-Length"));
+}
+
+TEST(Headers, IndexOperatorReplaces)
+{
+    Headers headers;
+    headers["Accept"] = "text/plain";
+    headers["accept"] = "application/json";
+
+    EXPECT_EQ(1, (int)headers.size());
+    EXPECT_EQ("Accept"s, headers.begin()->first);
+    EXPECT_EQ("application/json"s, headers.begin()->second);
+}
+
+TEST(Headers, InsertKeepsSameNamesTogether)
+{
+    Headers headers;
+    headers.insert({"Set-Cookie", "a=1"});
+    headers.insert({"Server", "test"});
+    headers.insert({"set-cookie", "b=2"});
+    headers.emplace("Set-Cookie", "c=3");
+
+    EXPECT_EQ(4, (int)headers.size());
+    EXPECT_EQ(3, (int)headers.count("SET-COOKIE"));
+
+    const auto range = headers.equal_range("Set-Cookie");
+    vector<string> values;
+    for(auto it = range.first; it != range.second; ++it) {
+        values.push_back(it->second);
+    }
+
+    EXPECT_EQ((vector<string>{"a=1", "b=2", "c=3"}), values);
+}
+
+TEST(Headers, Erase)
+{
+    Headers headers{{"A", "1"}, {"B", "2"}, {"a", "3"}};
+
+    EXPECT_EQ(2, (int)headers.erase("a"));
+    EXPECT_EQ(1, (int)headers.size());
+    EXPECT_EQ(headers.end(), headers.find("A"));
+
+    auto it = headers.erase(headers.find("b"));
+    EXPECT_EQ(headers.end(), it);
+    EXPECT_TRUE(headers.empty());
+}
+
+TEST(Headers, Merge)
+{
+    Headers headers{{"A", "1"}, {"B", "2"}};
+    const Headers more{{"b", "3"}, {"C", "4"}};
+
+    headers += more;
+
+    EXPECT_EQ(3, (int)headers.size());
+    EXPECT_EQ("3"s, headers["B"]);
+    EXPECT_EQ("4"s, headers["c"]);
+
+    merge_map(boost::optional<Headers>{Headers{{"a", "5"}}}, headers);
+    EXPECT_EQ(3, (int)headers.size());
+    EXPECT_EQ("5"s, headers["A"]);
+}
+
+TEST(Headers, LikeAMultimap)
+{
+    // The name is const, so its hash can't go stale. The value can be changed.
+    static_assert(is_same_v<pair<const string, string>, Headers::value_type>);
+    static_assert(is_const_v<remove_reference_t<decltype(declval<Headers&>().begin()->first)>>);
+    static_assert(!is_const_v<remove_reference_t<decltype(declval<Headers&>().begin()->second)>>);
+
+    Headers headers{{"B", "1"}, {"c", "2"}, {"A", "3"}, {"b", "4"}};
+    headers.find("C")->second = "5";
+    EXPECT_EQ("5"s, headers["c"]);
+
+    // Sorted by name, and in insertion order for the same name
+    vector<string> names;
+    for(auto& h : headers) {
+        names.push_back(h.first);
+    }
+    EXPECT_EQ((vector<string>{"A", "B", "b", "c"}), names);
+
+    EXPECT_EQ("B"s, headers.lower_bound("b")->first);
+    EXPECT_EQ("c"s, headers.upper_bound("B")->first);
+    EXPECT_EQ(headers.end(), headers.upper_bound("D"));
+
+    headers.emplace_hint(headers.end(), "a", "6");
+    EXPECT_EQ(2u, headers.count("A"));
+    EXPECT_EQ("6"s, next(headers.lower_bound("A"))->second);
+
+    const Headers& const_headers = headers;
+    Headers::const_iterator it = headers.begin();
+    EXPECT_EQ(it, const_headers.begin());
+    EXPECT_EQ(5, const_headers.end() - it);
+}
+
+TEST(Headers, ManyHeaders)
+{
+    Headers headers;
+    for(int i = 0; i < 100; ++i) {
+        headers["X-Header-" + to_string(i)] = to_string(i);
+    }
+
+    EXPECT_EQ(100, (int)headers.size());
+    for(int i = 0; i < 100; ++i) {
+        EXPECT_EQ(to_string(i), headers.find("x-header-" + to_string(i))->second);
+    }
+}
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("debug");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,207 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/RequestBody.h"
+#include "restc-cpp/ResponseCache.h"
+
+#include "../src/LatencyTracker.h"
+
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+using namespace std::literals::chrono_literals;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+/*! Responds with the number of the connection. Slow on the first connection. */
+TestServer::handler_t SlowFirst(std::chrono::milliseconds firstDelay,
+                                const std::string& headers = {}) {
+    return TestServer::Delay([firstDelay](const TestServer::Request& request) {
+        return (request.connection == 0) ? firstDelay : 0ms;
+    }, [headers](const TestServer::Request& request) {
+        return TestServer::Ok("connection-" + to_string(request.connection), headers);
+    });
+}
+
+} // anonymous namespace
+
+TEST(Hedging, SecondRequestWins) {
+    TestServer server{SlowFirst(1000ms)};
+
+    Request::Properties properties;
+    properties.hedging.delayMs = 50;
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto start = std::chrono::steady_clock::now();
+        auto reply = ctx.Get(server.GetUrl());
+        EXPECT_EQ("connection-1", reply->GetBodyAsString());
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 900ms);
+    }).get();
+
+    EXPECT_EQ(2, server.GetConnections());
+    rest_client->CloseWhenReady();
+}
+
+TEST(Hedging, FastResponseIsNotHedged) {
+    TestServer server{SlowFirst(0ms)};
+
+    Request::Properties properties;
+    properties.hedging.delayMs = 500;
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto reply = ctx.Get(server.GetUrl());
+        EXPECT_EQ("connection-0", reply->GetBodyAsString());
+    }).get();
+
+    EXPECT_EQ(1, server.GetConnections());
+    rest_client->CloseWhenReady();
+}
+
+TEST(Hedging, ErrorWithoutHedge) {
+    Request::Properties properties;
+    properties.hedging.delayMs = 500;
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        boost::system::error_code ec;
+        auto request = Request::Create("http://127.0.0.1:1/", Request::Type::GET,
+                                       ctx.GetClient());
+        EXPECT_FALSE(request->Execute(ctx, ec));
+        EXPECT_EQ(Error::FAILED_TO_CONNECT, ec);
+
+        EXPECT_THROW(ctx.Get("http://127.0.0.1:1/"), FailedToConnectException);
+    }).get();
+}
+
+TEST(Hedging, LargeReplyIsSentWithoutHedging) {
+    const std::string body(RESTC_CPP_SANE_DATA_LIMIT + 1024, 'x');
+    TestServer server{TestServer::Delay([](const TestServer::Request& request) {
+        return (request.connection == 0) ? 1000ms : 0ms;
+    }, [&body](const TestServer::Request&) {
+        return TestServer::Ok(body);
+    })};
+
+    Request::Properties properties;
+    properties.hedging.delayMs = 50;
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto reply = ctx.Get(server.GetUrl());
+        size_t received = 0;
+        while(reply->MoreDataToRead()) {
+            received += boost::asio::buffer_size(reply->GetSomeData());
+        }
+        EXPECT_EQ(body.size(), received);
+    }).get();
+
+    // The slow one, the winner that was too large, and the one we read
+    EXPECT_EQ(3u, server.GetRequests().size());
+    rest_client->CloseWhenReady();
+}
+
+TEST(Hedging, CacheMissIsHedged) {
+    TestServer server{SlowFirst(500ms, "Cache-Control: max-age=60\r\n")};
+
+    Request::Properties properties;
+    properties.hedging.delayMs = 50;
+    properties.responseCache = ResponseCache::CreateMemoryCache(1024 * 1024);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_EQ("connection-1", ctx.Get(server.GetUrl())->GetBodyAsString());
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 400ms);
+
+        // The winner is stored
+        EXPECT_EQ("connection-1", ctx.Get(server.GetUrl())->GetBodyAsString());
+    }).get();
+
+    EXPECT_EQ(2u, server.GetRequests().size());
+    rest_client->CloseWhenReady();
+}
+
+TEST(Hedging, RevalidationIsHedged) {
+    // The first revalidation is slow
+    TestServer server{TestServer::Delay([](const TestServer::Request& request) {
+        return (request.connection == 1) ? 500ms : 0ms;
+    }, [](const TestServer::Request& request) {
+        if (request.GetHeader("If-None-Match") == "\"v1\"") {
+            return TestServer::Response(304, "Not Modified", {}, "ETag: \"v1\"\r\n");
+        }
+        return TestServer::Ok("stored", "Cache-Control: no-cache\r\nETag: \"v1\"\r\n"
+                              "Connection: close\r\n");
+    })};
+
+    Request::Properties properties;
+    properties.hedging.delayMs = 50;
+    properties.responseCache = ResponseCache::CreateMemoryCache(1024 * 1024);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("stored", ctx.Get(server.GetUrl())->GetBodyAsString());
+
+        const auto start = std::chrono::steady_clock::now();
+        auto reply = ctx.Get(server.GetUrl());
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 400ms);
+        EXPECT_EQ(200, reply->GetResponseCode());
+        EXPECT_EQ("stored", reply->GetBodyAsString());
+    }).get();
+
+    // Both attempts revalidate
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(3u, requests.size());
+    EXPECT_EQ("\"v1\"", requests[1].GetHeader("If-None-Match"));
+    EXPECT_EQ("\"v1\"", requests[2].GetHeader("If-None-Match"));
+    rest_client->CloseWhenReady();
+}
+
+TEST(LatencyTracker, Percentile) {
+    LatencyTracker tracker{100, 10};
+    const string origin = "http://example.com:80";
+
+    for(int i = 1; i <= 9; ++i) {
+        tracker.Add(origin, std::chrono::milliseconds{i});
+    }
+    EXPECT_FALSE(tracker.GetPercentile(origin, 50));
+
+    tracker.Add(origin, 10ms);
+    EXPECT_EQ(5ms, *tracker.GetPercentile(origin, 50));
+    EXPECT_EQ(9ms, *tracker.GetPercentile(origin, 90));
+    EXPECT_EQ(10ms, *tracker.GetPercentile(origin, 100));
+    EXPECT_EQ(1ms, *tracker.GetPercentile(origin, 0));
+    EXPECT_FALSE(tracker.GetPercentile("http://example.com:8080", 50));
+}
+
+TEST(LatencyTracker, OldSamplesAreReplaced) {
+    LatencyTracker tracker{10, 10};
+    const string origin = "http://example.com:80";
+
+    for(int i = 0; i < 10; ++i) {
+        tracker.Add(origin, 1000ms);
+    }
+    for(int i = 0; i < 10; ++i) {
+        tracker.Add(origin, 1ms);
+    }
+    EXPECT_EQ(1ms, *tracker.GetPercentile(origin, 99));
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
@@ -0,0 +1,658 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/RequestBody.h"
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <map>
+#include <set>
+#include <thread>
+
+#include "../src/Hpack.h"
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+using namespace std::literals::chrono_literals;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+using headers_list_t = vector<pair<string, string>>;
+
+string FromHex(const string& hex) {
+    string bytes;
+    string digits;
+    for(const auto ch : hex) {
+        if (ch == ' ') {
+            continue;
+        }
+        digits += ch;
+        if (digits.size() == 2) {
+            bytes += static_cast<char>(stoi(digits, nullptr, 16));
+            digits.clear();
+        }
+    }
+    return bytes;
+}
+
+headers_list_t Decode(hpack::Decoder& decoder, const string& hex) {
+    const auto block = FromHex(hex);
+    headers_list_t headers;
+    decoder.Decode(reinterpret_cast<const uint8_t *>(block.data()), block.size(),
+                   [&headers](string&& name, string&& value) {
+        headers.emplace_back(std::move(name), std::move(value));
+    });
+    return headers;
+}
+
+string Encode(hpack::Encoder& encoder, const headers_list_t& headers) {
+    string block;
+    encoder.Begin(block);
+    for(const auto& [name, value] : headers) {
+        encoder.Encode(block, name, value);
+    }
+    return block;
+}
+
+// RFC 7541, Appendix C.3 and C.4
+const headers_list_t first_request = {
+    {":method", "GET"},
+    {":scheme", "http"},
+    {":path", "/"},
+    {":authority", "www.example.com"}
+};
+
+const headers_list_t second_request = {
+    {":method", "GET"},
+    {":scheme", "http"},
+    {":path", "/"},
+    {":authority", "www.example.com"},
+    {"cache-control", "no-cache"}
+};
+
+const headers_list_t third_request = {
+    {":method", "GET"},
+    {":scheme", "https"},
+    {":path", "/index.html"},
+    {":authority", "www.example.com"},
+    {"custom-key", "custom-value"}
+};
+
+// RFC 9113, section 6
+constexpr uint8_t FRAME_DATA = 0x0;
+constexpr uint8_t FRAME_HEADERS = 0x1;
+constexpr uint8_t FRAME_RST_STREAM = 0x3;
+constexpr uint8_t FRAME_SETTINGS = 0x4;
+constexpr uint8_t FRAME_GOAWAY = 0x7;
+constexpr uint8_t FRAME_WINDOW_UPDATE = 0x8;
+constexpr uint8_t FRAME_CONTINUATION = 0x9;
+
+constexpr uint8_t FLAG_END_STREAM = 0x1;
+constexpr uint8_t FLAG_ACK = 0x1;
+constexpr uint8_t FLAG_END_HEADERS = 0x4;
+
+constexpr uint16_t SETTINGS_INITIAL_WINDOW_SIZE = 0x4;
+
+constexpr uint32_t NO_ERROR = 0x0;
+constexpr uint32_t INTERNAL_ERROR = 0x2;
+
+constexpr size_t default_window_size = 65535;
+constexpr size_t max_frame_size = 16384;
+
+/*! The server side of a HTTP/2 connection (RFC 9113), to script the server
+ *
+ * The frames from the client are read one by one, and the requests in
+ * them are collected by stream id. Flow control is up to the script.
+ */
+class Http2Peer {
+public:
+    struct Request {
+        headers_list_t headers;
+        string body;
+        bool complete = false; // The client has sent END_STREAM
+
+        string Get(const string& name) const {
+            for(const auto& [n, v] : headers) {
+                if (n == name) {
+                    return v;
+                }
+            }
+            return {};
+        }
+    };
+
+    explicit Http2Peer(boost::asio::ip::tcp::socket& socket)
+    : socket_{socket}
+    {
+    }
+
+    /*! Read the connection preface, and send our SETTINGS */
+    bool Start() {
+        static const string preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+        string data(preface.size(), '\0');
+        boost::system::error_code ec;
+        boost::asio::read(socket_, boost::asio::buffer(data), ec);
+        if (ec || (data != preface)) {
+            return false;
+        }
+        Write(FRAME_SETTINGS, 0, 0, {});
+        return true;
+    }
+
+    /*! Read and handle frames until done() returns true
+     *
+     * \return false if the client closed the connection first
+     */
+    bool ReadUntil(const function<bool ()>& done) {
+        while(!done()) {
+            if (!ReadFrame()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*! Read and handle the frames the client has sent so far */
+    bool ReadAvailable() {
+        boost::system::error_code ec;
+        while(socket_.available(ec) > 0) {
+            if (!ReadFrame()) {
+                return false;
+            }
+        }
+        return !ec;
+    }
+
+    /*! The number of requests the client has sent in full */
+    size_t GetCompleteRequests() const {
+        size_t count = 0;
+        for(const auto& [id, request] : requests) {
+            count += request.complete ? 1 : 0;
+        }
+        return count;
+    }
+
+    void Write(uint8_t type, uint8_t flags, uint32_t streamId, const string& payload) {
+        string frame;
+        frame += static_cast<char>((payload.size() >> 16) & 0xff);
+        frame += static_cast<char>((payload.size() >> 8) & 0xff);
+        frame += static_cast<char>(payload.size() & 0xff);
+        frame += static_cast<char>(type);
+        frame += static_cast<char>(flags);
+        Append32(frame, streamId);
+        frame += payload;
+        boost::system::error_code ec;
+        boost::asio::write(socket_, boost::asio::buffer(frame), ec);
+    }
+
+    void WriteHeaders(uint32_t streamId, int status, bool endStream) {
+        string block;
+        encoder_.Begin(block);
+        encoder_.Encode(block, ":status", to_string(status));
+        encoder_.Encode(block, "content-type", "text/plain");
+        Write(FRAME_HEADERS, FLAG_END_HEADERS | (endStream ? FLAG_END_STREAM : 0),
+              streamId, block);
+    }
+
+    /*! Send the body in DATA frames of at most chunkSize bytes */
+    void WriteData(uint32_t streamId, const string& body, bool endStream,
+                   size_t chunkSize = max_frame_size) {
+        size_t offset = 0;
+        do {
+            const auto len = min(chunkSize, body.size() - offset);
+            const bool last = (offset + len) == body.size();
+            Write(FRAME_DATA, (last && endStream) ? FLAG_END_STREAM : 0, streamId,
+                  body.substr(offset, len));
+            offset += len;
+        } while(offset < body.size());
+    }
+
+    void Respond(uint32_t streamId, const string& body) {
+        WriteHeaders(streamId, 200, false);
+        WriteData(streamId, body, true);
+    }
+
+    void WriteResetStream(uint32_t streamId, uint32_t errorCode) {
+        string payload;
+        Append32(payload, errorCode);
+        Write(FRAME_RST_STREAM, 0, streamId, payload);
+    }
+
+    void WriteGoAway(uint32_t lastStreamId, uint32_t errorCode) {
+        string payload;
+        Append32(payload, lastStreamId);
+        Append32(payload, errorCode);
+        Write(FRAME_GOAWAY, 0, 0, payload);
+    }
+
+    void WriteWindowUpdate(uint32_t streamId, uint32_t increment) {
+        string payload;
+        Append32(payload, increment);
+        Write(FRAME_WINDOW_UPDATE, 0, streamId, payload);
+    }
+
+    map<uint32_t, Request> requests;
+    size_t client_initial_window = default_window_size;
+    size_t client_connection_window = default_window_size;
+
+private:
+    bool ReadFrame() {
+        array<uint8_t, 9> header = {};
+        boost::system::error_code ec;
+        boost::asio::read(socket_, boost::asio::buffer(header), ec);
+        if (ec) {
+            return false;
+        }
+        const auto len = (size_t{header[0]} << 16) | (size_t{header[1]} << 8) | header[2];
+        const auto type = header[3];
+        const auto flags = header[4];
+        const auto stream_id = Read32(&header[5]) & 0x7fffffff;
+
+        string payload(len, '\0');
+        if (len) {
+            boost::asio::read(socket_, boost::asio::buffer(payload), ec);
+            if (ec) {
+                return false;
+            }
+        }
+        const auto *p = reinterpret_cast<const uint8_t *>(payload.data());
+
+        switch(type) {
+        case FRAME_SETTINGS:
+            if (!(flags & FLAG_ACK)) {
+                for(size_t i = 0; i + 6 <= len; i += 6) {
+                    if (((p[i] << 8) | p[i + 1]) == SETTINGS_INITIAL_WINDOW_SIZE) {
+                        client_initial_window = Read32(p + i + 2);
+                    }
+                }
+                Write(FRAME_SETTINGS, FLAG_ACK, 0, {});
+            }
+            break;
+        case FRAME_WINDOW_UPDATE:
+            if (stream_id == 0) {
+                client_connection_window += Read32(p) & 0x7fffffff;
+            }
+            break;
+        case FRAME_HEADERS:
+        case FRAME_CONTINUATION:
+            // We don't expect padding or priority from the client
+            header_block_ += payload;
+            if (flags & FLAG_END_HEADERS) {
+                auto& request = requests[stream_id];
+                decoder_.Decode(reinterpret_cast<const uint8_t *>(header_block_.data()),
+                                header_block_.size(), [&request](string&& name, string&& value) {
+                    request.headers.emplace_back(std::move(name), std::move(value));
+                });
+                header_block_.clear();
+            }
+            if ((type == FRAME_HEADERS) && (flags & FLAG_END_STREAM)) {
+                requests[stream_id].complete = true;
+            }
+            break;
+        case FRAME_DATA:
+            requests[stream_id].body += payload;
+            if (flags & FLAG_END_STREAM) {
+                requests[stream_id].complete = true;
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    static uint32_t Read32(const uint8_t *p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+            | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    static void Append32(string& dst, uint32_t value) {
+        dst += static_cast<char>((value >> 24) & 0xff);
+        dst += static_cast<char>((value >> 16) & 0xff);
+        dst += static_cast<char>((value >> 8) & 0xff);
+        dst += static_cast<char>(value & 0xff);
+    }
+
+    boost::asio::ip::tcp::socket& socket_;
+    hpack::Encoder encoder_;
+    hpack::Decoder decoder_;
+    string header_block_;
+};
+
+std::unique_ptr<RestClient> CreateHttp2Client() {
+    Request::Properties properties;
+    properties.httpVersion = Request::HttpVersion::HTTP_2_PRIOR_KNOWLEDGE;
+    properties.replyTimeoutMs = 5000;
+    properties.sendTimeoutMs = 5000;
+    return RestClient::Create(properties);
+}
+
+} // anonymous namespace
+
+TEST(Hpack, DecodeRequestsWithoutHuffman) {
+    hpack::Decoder decoder;
+
+    EXPECT_EQ(first_request, Decode(decoder,
+        "8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"));
+    EXPECT_EQ(57, decoder.GetTable().GetSize());
+
+    EXPECT_EQ(second_request, Decode(decoder,
+        "8286 84be 5808 6e6f 2d63 6163 6865"));
+    EXPECT_EQ(110, decoder.GetTable().GetSize());
+
+    EXPECT_EQ(third_request, Decode(decoder,
+        "8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65"));
+    EXPECT_EQ(164, decoder.GetTable().GetSize());
+}
+
+TEST(Hpack, DecodeRequestsWithHuffman) {
+    hpack::Decoder decoder;
+
+    EXPECT_EQ(first_request, Decode(decoder,
+        "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"));
+    EXPECT_EQ(57, decoder.GetTable().GetSize());
+
+    EXPECT_EQ(second_request, Decode(decoder,
+        "8286 84be 5886 a8eb 1064 9cbf"));
+    EXPECT_EQ(110, decoder.GetTable().GetSize());
+
+    EXPECT_EQ(third_request, Decode(decoder,
+        "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"));
+    EXPECT_EQ(164, decoder.GetTable().GetSize());
+}
+
+TEST(Hpack, DecodeResponsesWithEviction) {
+    // RFC 7541, Appendix C.5
+    hpack::Decoder decoder{256};
+
+    const headers_list_t first_response = {
+        {":status", "302"},
+        {"cache-control", "private"},
+        {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+        {"location", "https://www.example.com"}
+    };
+
+    EXPECT_EQ(first_response, Decode(decoder,
+        "4803 3330 3258 0770 7269 7661 7465 611d 4d6f 6e2c 2032 3120 4f63 7420 "
+        "3230 3133 2032 303a 3133 3a32 3120 474d 546e 1768 7474 7073 3a2f 2f77 "
+        "7777 2e65 7861 6d70 6c65 2e63 6f6d"));
+    EXPECT_EQ(222, decoder.GetTable().GetSize());
+
+    auto second_response = first_response;
+    second_response[0].second = "307";
+    EXPECT_EQ(second_response, Decode(decoder, "4803 3330 37c1 c0bf"));
+    EXPECT_EQ(222, decoder.GetTable().GetSize());
+    ASSERT_NE(nullptr, decoder.GetTable().Get(62));
+    EXPECT_EQ(":status", decoder.GetTable().Get(62)->first);
+    EXPECT_EQ("307", decoder.GetTable().Get(62)->second);
+    EXPECT_EQ(nullptr, decoder.GetTable().Get(66));
+}
+
+TEST(Hpack, RejectsMalformedBlocks) {
+    hpack::Decoder decoder;
+
+    // Index 0
+    EXPECT_THROW(Decode(decoder, "80"), ProtocolException);
+    // Index past the end of the dynamic table
+    EXPECT_THROW(Decode(decoder, "be"), ProtocolException);
+    // Truncated string
+    EXPECT_THROW(Decode(decoder, "4005 6162"), ProtocolException);
+    // Table size update larger than we allow
+    EXPECT_THROW(Decode(decoder, "3fe2 1f"), ProtocolException);
+    // Huffman padding that is not all ones
+    EXPECT_THROW(Decode(decoder, "4081 0081 00"), ProtocolException);
+}
+
+TEST(Hpack, EncodeRequests) {
+    hpack::Encoder encoder;
+
+    // Without Huffman, the encoder produces the same blocks as in C.3
+    EXPECT_EQ(FromHex("8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"),
+              Encode(encoder, first_request));
+    EXPECT_EQ(FromHex("8286 84be 5808 6e6f 2d63 6163 6865"),
+              Encode(encoder, second_request));
+    EXPECT_EQ(FromHex("8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65"),
+              Encode(encoder, third_request));
+}
+
+TEST(Hpack, RoundTrip) {
+    hpack::Encoder encoder;
+    hpack::Decoder decoder;
+
+    const headers_list_t headers = {
+        {":method", "POST"},
+        {":path", "/upload?id=12345"},
+        {"authorization", "Bearer secret"},
+        {"content-type", "application/json"},
+        {"x-long", string(3000, 'x')}
+    };
+
+    for(auto i = 0; i < 3; ++i) {
+        const auto block = Encode(encoder, headers);
+        headers_list_t decoded;
+        decoder.Decode(reinterpret_cast<const uint8_t *>(block.data()), block.size(),
+                       [&decoded](string&& name, string&& value) {
+            decoded.emplace_back(std::move(name), std::move(value));
+        });
+        EXPECT_EQ(headers, decoded);
+        EXPECT_EQ(encoder.GetTable().GetSize(), decoder.GetTable().GetSize());
+    }
+
+    // The authorization header is never added to the table
+    EXPECT_FALSE(encoder.GetTable().Find("authorization", "Bearer secret").second);
+
+    // A smaller table is signalled to the peer
+    encoder.SetMaxTableSize(0);
+    const auto block = Encode(encoder, {{"content-type", "text/plain"}});
+    EXPECT_EQ('\x20', block.front());
+    decoder.Decode(reinterpret_cast<const uint8_t *>(block.data()), block.size(),
+                   [](string&&, string&&) {});
+    EXPECT_EQ(0, decoder.GetTable().GetMaxSize());
+    EXPECT_EQ(0, decoder.GetTable().GetSize());
+}
+
+TEST(Http2, MultiplexedStreams) {
+    TestServer server{[](boost::asio::ip::tcp::socket& socket, int) {
+        Http2Peer peer{socket};
+        // All the requests must be in flight before we respond to any of them
+        if (!peer.Start() || !peer.ReadUntil([&] { return peer.GetCompleteRequests() == 3; })) {
+            return;
+        }
+
+        // Respond in reverse order, and interleave the DATA frames
+        for(auto it = peer.requests.rbegin(); it != peer.requests.rend(); ++it) {
+            peer.WriteHeaders(it->first, 200, false);
+        }
+        for(const auto half : {0, 1}) {
+            for(auto it = peer.requests.rbegin(); it != peer.requests.rend(); ++it) {
+                const auto body = it->second.Get(":path") + " on stream " + to_string(it->first);
+                const auto mid = body.size() / 2;
+                peer.WriteData(it->first, half ? body.substr(mid) : body.substr(0, mid), half);
+            }
+        }
+        peer.ReadUntil([] { return false; });
+    }};
+
+    auto rest_client = CreateHttp2Client();
+
+    std::vector<std::future<string>> replies;
+    for(const auto *path : {"/a", "/b", "/c"}) {
+        replies.push_back(rest_client->ProcessWithPromiseT<string>([&, path](Context& ctx) {
+            auto reply = ctx.Get(server.GetUrl(path));
+            EXPECT_EQ(Reply::HttpResponse::HttpVersion::HTTP_2,
+                      reply->GetHttpResponse().http_version);
+            return reply->GetBodyAsString();
+        }));
+    }
+
+    std::set<string> streams;
+    for(size_t i = 0; i < replies.size(); ++i) {
+        const auto body = replies[i].get();
+        const string path = string{"/"} + static_cast<char>('a' + i);
+        EXPECT_EQ(0u, body.find(path + " on stream ")) << body;
+        streams.insert(body.substr(body.rfind(' ') + 1));
+    }
+    EXPECT_EQ((std::set<string>{"1", "3", "5"}), streams);
+    EXPECT_EQ(1, server.GetConnections());
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(Http2, FlowControl) {
+    const string request_body(100 * 1000, 'q');
+    const string response_body(600 * 1000, 'r');
+    std::atomic_bool blocked{false};
+    std::atomic_bool windows_ok{false};
+
+    TestServer server{[&](boost::asio::ip::tcp::socket& socket, int) {
+        Http2Peer peer{socket};
+        if (!peer.Start()) {
+            return;
+        }
+
+        // Our windows are the default 65535 bytes. The client must stop there.
+        auto& request = peer.requests[1];
+        if (!peer.ReadUntil([&] {
+                return request.complete || (request.body.size() >= default_window_size);
+            })) {
+            return;
+        }
+        std::this_thread::sleep_for(100ms);
+        peer.ReadAvailable();
+        blocked = !request.complete && (request.body.size() == default_window_size);
+
+        peer.WriteWindowUpdate(0, 1024 * 1024);
+        peer.WriteWindowUpdate(1, 1024 * 1024);
+        if (!peer.ReadUntil([&] { return request.complete; })) {
+            return;
+        }
+
+        // The response is larger than our windows, but the client has
+        // given us room for it.
+        windows_ok = (peer.client_initial_window >= response_body.size())
+            && (peer.client_connection_window >= response_body.size());
+        peer.WriteHeaders(1, 200, false);
+        peer.WriteData(1, response_body, true);
+        peer.ReadUntil([] { return false; });
+    }};
+
+    auto rest_client = CreateHttp2Client();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto request = Request::Create(server.GetUrl("/upload"), Request::Type::POST,
+                                       ctx.GetClient(),
+                                       RequestBody::CreateStringBody(request_body));
+        auto reply = request->Execute(ctx);
+        EXPECT_EQ(200, reply->GetResponseCode());
+        EXPECT_EQ(response_body, reply->GetBodyAsString());
+    }).get();
+
+    EXPECT_TRUE(blocked);
+    EXPECT_TRUE(windows_ok);
+    rest_client->CloseWhenReady();
+}
+
+TEST(Http2, ResetStream) {
+    TestServer server{[](boost::asio::ip::tcp::socket& socket, int) {
+        Http2Peer peer{socket};
+        if (!peer.Start() || !peer.ReadUntil([&] { return peer.requests[1].complete; })) {
+            return;
+        }
+        peer.WriteResetStream(1, INTERNAL_ERROR);
+
+        // The connection is still good for the next request
+        if (peer.ReadUntil([&] { return peer.requests[3].complete; })) {
+            peer.Respond(3, "OK");
+            peer.ReadUntil([] { return false; });
+        }
+    }};
+
+    auto rest_client = CreateHttp2Client();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        try {
+            ctx.Get(server.GetUrl("/reset"));
+            ADD_FAILURE() << "Expected an exception";
+        } catch(const ProtocolException& ex) {
+            EXPECT_NE(string{ex.what()}.find("reset with error code 2"), string::npos)
+                << ex.what();
+        }
+
+        EXPECT_EQ("OK", ctx.Get(server.GetUrl("/next"))->GetBodyAsString());
+    }).get();
+
+    EXPECT_EQ(1, server.GetConnections());
+    rest_client->CloseWhenReady();
+}
+
+TEST(Http2, GoAway) {
+    TestServer server{[](boost::asio::ip::tcp::socket& socket, int connection) {
+        Http2Peer peer{socket};
+        if (!peer.Start()) {
+            return;
+        }
+
+        if (connection == 0) {
+            if (!peer.ReadUntil([&] { return peer.GetCompleteRequests() == 3; })) {
+                return;
+            }
+            // Only the first stream will be processed
+            peer.WriteGoAway(1, NO_ERROR);
+            peer.Respond(1, "first");
+        } else if (peer.ReadUntil([&] { return peer.requests[1].complete; })) {
+            peer.Respond(1, "again");
+        }
+        peer.ReadUntil([] { return false; });
+    }};
+
+    auto rest_client = CreateHttp2Client();
+
+    std::atomic_int refused{0};
+    std::vector<std::future<string>> replies;
+    for(int i = 0; i < 3; ++i) {
+        replies.push_back(rest_client->ProcessWithPromiseT<string>([&](Context& ctx) {
+            try {
+                return ctx.Get(server.GetUrl("/"))->GetBodyAsString();
+            } catch(const ProtocolException& ex) {
+                EXPECT_NE(string{ex.what()}.find("refused"), string::npos) << ex.what();
+                ++refused;
+            }
+            return string{};
+        }));
+    }
+
+    std::multiset<string> bodies;
+    for(auto& reply : replies) {
+        bodies.insert(reply.get());
+    }
+    EXPECT_EQ((std::multiset<string>{"", "", "first"}), bodies);
+    EXPECT_EQ(2, refused);
+
+    // The session is going away, so a new request gets a new connection
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("again", ctx.Get(server.GetUrl("/"))->GetBodyAsString());
+    }).get();
+    EXPECT_EQ(2, server.GetConnections());
+
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("debug");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
@@ -0,0 +1,162 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RequestBody.h"
+
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+std::unique_ptr<RestClient> CreateClient(size_t pipelineDepth = 4) {
+    Request::Properties properties;
+    properties.pipelineDepth = pipelineDepth;
+    return RestClient::Create(properties);
+}
+
+/*! Start the requests together, so that they share a pipeline
+ *
+ * \return The bodies of the replies, in the order of the targets.
+ */
+std::vector<std::string> ExecuteConcurrently(RestClient& client, const TestServer& server,
+                                             const std::vector<std::pair<Request::Type, std::string>>& requests) {
+    std::vector<std::future<std::string>> replies;
+    for(const auto& [type, target] : requests) {
+        replies.push_back(client.ProcessWithPromiseT<std::string>(
+            [&server, type = type, target = target](Context& ctx) {
+                auto request = Request::Create(server.GetUrl(target), type, ctx.GetClient());
+                auto reply = request->Execute(ctx);
+                return std::to_string(reply->GetResponseCode()) + " "
+                    + reply->GetBodyAsString();
+            }));
+    }
+
+    std::vector<std::string> bodies;
+    for(auto& reply : replies) {
+        bodies.push_back(reply.get());
+    }
+    return bodies;
+}
+
+std::vector<std::pair<Request::Type, std::string>> Gets(int count) {
+    std::vector<std::pair<Request::Type, std::string>> requests;
+    for(int i = 0; i < count; ++i) {
+        requests.emplace_back(Request::Type::GET, "/" + std::to_string(i));
+    }
+    return requests;
+}
+
+} // anonymous namespace
+
+TEST(HttpPipeline, RepliesInOrder) {
+    TestServer server{[](const TestServer::Request& request) {
+        if (request.index == 0) {
+            // Let the other requests be written before the first response
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        }
+        return TestServer::Ok(request.target);
+    }};
+    auto rest_client = CreateClient();
+
+    const auto bodies = ExecuteConcurrently(*rest_client, server, Gets(4));
+    for(size_t i = 0; i < bodies.size(); ++i) {
+        EXPECT_EQ("200 /" + std::to_string(i), bodies[i]);
+    }
+
+    // All on one connection
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(4u, requests.size());
+    for(const auto& request : requests) {
+        EXPECT_EQ(0, request.connection);
+    }
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(HttpPipeline, ServerClosesMidPipeline) {
+    TestServer server{[](const TestServer::Request& request) {
+        if (request.index == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        }
+        if ((request.connection == 0) && (request.index == 1)) {
+            // Like a server that takes a limited number of requests per connection
+            return TestServer::Ok(request.target, "Connection: close\r\n");
+        }
+        return TestServer::Ok(request.target);
+    }};
+    auto rest_client = CreateClient();
+
+    const auto bodies = ExecuteConcurrently(*rest_client, server, Gets(4));
+    for(size_t i = 0; i < bodies.size(); ++i) {
+        EXPECT_EQ("200 /" + std::to_string(i), bodies[i]);
+    }
+
+    // The requests without responses are sent again, on other connections
+    const auto requests = server.GetRequests();
+    size_t resent = 0;
+    for(const auto& request : requests) {
+        if (request.connection != 0) {
+            EXPECT_TRUE((request.target == "/2") || (request.target == "/3"));
+            ++resent;
+        }
+    }
+    EXPECT_EQ(2u, resent);
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(HttpPipeline, HeadInPipeline) {
+    TestServer server{[](const TestServer::Request& request) {
+        if (request.index == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        }
+        if (request.method == "HEAD") {
+            // The length of the body we would have sent, but no body
+            return std::string{"HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n"};
+        }
+        return TestServer::Ok(request.target);
+    }};
+    auto rest_client = CreateClient();
+
+    const auto bodies = ExecuteConcurrently(*rest_client, server, {
+        {Request::Type::GET, "/0"},
+        {Request::Type::HEAD, "/1"},
+        {Request::Type::GET, "/2"},
+        {Request::Type::HEAD, "/3"}});
+
+    EXPECT_EQ("200 /0", bodies[0]);
+    EXPECT_EQ("200 ", bodies[1]);
+    EXPECT_EQ("200 /2", bodies[2]);
+    EXPECT_EQ("200 ", bodies[3]);
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(4u, requests.size());
+    for(const auto& request : requests) {
+        EXPECT_EQ(0, request.connection);
+    }
+
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
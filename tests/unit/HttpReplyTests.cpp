@@ -4,6 +4,10 @@
 
 #include "../src/ReplyImpl.h"
 
+#ifdef RESTC_CPP_WITH_ZLIB
+#   include <zlib.h>
+#endif
+
 #include "gtest/gtest.h"
 #include "restc-cpp/test_helper.h"
 
@@ -16,8 +20,8 @@ using test_buffers_t = std::list<std::string>;
 
 class MockReader : public DataReader {
 public:
-    MockReader(test_buffers_t& buffers)
-    : test_buffers_{buffers} {
+    MockReader(test_buffers_t& buffers, std::string *unread = nullptr)
+    : test_buffers_{buffers}, unread_{unread} {
 
         next_buffer_ = test_buffers_.begin();
     }
@@ -38,26 +42,59 @@ public:
         return {data, data_len};
     }
 
+    void Unread(::restc_cpp::boost_const_buffer data) override {
+        if (unread_) {
+            unread_->append(boost_buffer_cast(data), boost::asio::buffer_size(data));
+        }
+    }
+
     test_buffers_t& test_buffers_;
     test_buffers_t::iterator next_buffer_;
+    std::string *unread_;
 };
 
 class TestReply : public ReplyImpl
 {
 public:
-    TestReply(Context& ctx, RestClient& owner, test_buffers_t& buffers)
+    TestReply(Context& ctx, RestClient& owner, test_buffers_t& buffers,
+              std::string *unread = nullptr)
     : ReplyImpl(nullptr, ctx, owner, Request::Type::GET), buffers_{buffers}
+    , unread_{unread}
     {
     }
 
     void SimulateServerReply() {
-        StartReceiveFromServer(make_unique<MockReader>(buffers_));
+        StartReceiveFromServer(make_unique<MockReader>(buffers_, unread_));
     }
 
 private:
     test_buffers_t& buffers_;
+    std::string *unread_;
 };
 
+#ifdef RESTC_CPP_WITH_ZLIB
+std::string Gzip(const std::string& data) {
+    z_stream strm = {};
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                     MAX_WBITS | 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+
+    std::string out(deflateBound(&strm, data.size()), '\0');
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    strm.avail_in = static_cast<uInt>(data.size());
+    strm.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    strm.avail_out = static_cast<uInt>(out.size());
+    const auto result = deflate(&strm, Z_FINISH);
+    deflateEnd(&strm);
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error("deflate failed");
+    }
+    out.resize(strm.total_out);
+    return out;
+}
+#endif // RESTC_CPP_WITH_ZLIB
+
 } // namespace restc_cpp::unittests
 // restc_cpp
 
@@ -280,6 +317,45 @@ TEST(HttpReply, SimpleBody4)
     EXPECT_NO_THROW(f.get());
 }
 
+TEST(HttpReply, PipelinedResponses)
+{
+    // The responses to pipelined requests, received in one read
+    std::string received = "HTTP/1.1 200 OK\r\n"
+                           "Content-Length: 5\r\n"
+                           "\r\n"
+                           "first"
+                           "HTTP/1.1 200 OK\r\n"
+                           "Transfer-Encoding: chunked\r\n"
+                           "\r\n"
+                           "6\r\nsecond\r\n"
+                           "0\r\n\r\n"
+                           "HTTP/1.1 204 No Content\r\n"
+                           "\r\n"
+                           "HTTP/1.1 200 OK\r\n"
+                           "Content-Length: 6\r\n"
+                           "\r\n"
+                           "fourth";
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        std::vector<std::string> bodies;
+        while(!received.empty() && (bodies.size() < 10)) {
+            ::restc_cpp::unittests::test_buffers_t buffer{received};
+            std::string unread;
+            ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer, &unread);
+
+            reply.SimulateServerReply();
+            bodies.push_back(reply.GetBodyAsString());
+            received = unread;
+        }
+
+        const std::vector<std::string> expected = {"first", "second", "", "fourth"};
+        EXPECT_EQ(expected, bodies);
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
 TEST(HttpReply, ChunkedBody)
 {
     ::restc_cpp::unittests::test_buffers_t buffer;
@@ -461,6 +537,369 @@ TEST(HttpReply, ChunkedParameterAndTrailer)
     EXPECT_NO_THROW(f.get());
 }
 
+#ifdef RESTC_CPP_WITH_ZLIB
+TEST(HttpReply, GzipBody)
+{
+    const std::string payload = "The quick brown fox jumps over the lazy dog. "
+                                "The quick brown fox jumps over the lazy dog.";
+    const auto zipped = ::restc_cpp::unittests::Gzip(payload);
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+
+    buffer.emplace_back("HTTP/1.1 200 OK\r\n"
+                        "Server: Cowboy\r\n"
+                        "Connection: keep-alive\r\n"
+                        "Content-Type: text/plain\r\n"
+                        "Content-Encoding: gzip\r\n"
+                        "Content-Length: " + to_string(zipped.size()) + "\r\n"
+                        "\r\n");
+    buffer.emplace_back(zipped.substr(0, zipped.size() / 2));
+    buffer.emplace_back(zipped.substr(zipped.size() / 2));
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+        auto body = reply.GetBodyAsString();
+
+        EXPECT_EQ("gzip", *reply.GetHeader("Content-Encoding"));
+        EXPECT_EQ(payload, body);
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
+TEST(HttpReply, GzipChunkedBody)
+{
+    const std::string payload = "The quick brown fox jumps over the lazy dog. "
+                                "The quick brown fox jumps over the lazy dog.";
+    const auto zipped = ::restc_cpp::unittests::Gzip(payload);
+    const auto first = zipped.substr(0, zipped.size() / 2);
+    const auto second = zipped.substr(zipped.size() / 2);
+
+    auto to_hex = [](size_t value) {
+        std::ostringstream hex;
+        hex << std::hex << value;
+        return hex.str();
+    };
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+
+    buffer.emplace_back("HTTP/1.1 200 OK\r\n"
+                        "Server: Cowboy\r\n"
+                        "Connection: keep-alive\r\n"
+                        "Content-Type: text/plain\r\n"
+                        "Content-Encoding: gzip\r\n"
+                        "Transfer-Encoding: chunked\r\n"
+                        "\r\n");
+    buffer.emplace_back(to_hex(first.size()) + "\r\n" + first + "\r\n");
+    buffer.emplace_back(to_hex(second.size()) + "\r\n" + second + "\r\n");
+    buffer.emplace_back("0\r\n\r\n");
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+        auto body = reply.GetBodyAsString();
+
+        EXPECT_EQ("chunked", *reply.GetHeader("Transfer-Encoding"));
+        EXPECT_EQ(payload, body);
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
+namespace {
+
+std::string GzipReply(const std::string& zipped) {
+    return "HTTP/1.1 200 OK\r\n"
+           "Server: Cowboy\r\n"
+           "Content-Type: text/plain\r\n"
+           "Content-Encoding: gzip\r\n"
+           "Content-Length: " + to_string(zipped.size()) + "\r\n"
+           "\r\n";
+}
+
+std::string LargePayload() {
+    std::string payload;
+    for(auto i = 0; i < 20000; ++i) {
+        payload += "{\"id\":" + to_string(i) + "}\n";
+    }
+    return payload;
+}
+
+} // anonymous namespace
+
+TEST(HttpReply, GzipBodyStreamed)
+{
+    const auto payload = LargePayload();
+    const auto zipped = ::restc_cpp::unittests::Gzip(payload);
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+    buffer.emplace_back(GzipReply(zipped));
+    buffer.emplace_back(zipped);
+
+    Request::Properties properties;
+    properties.oneShotDecompressLimit = 0;
+    auto rest_client = RestClient::Create(properties);
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+        EXPECT_EQ(payload, reply.GetBodyAsString());
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
+TEST(HttpReply, GzipBodyOneShot)
+{
+    const auto payload = LargePayload();
+    const auto zipped = ::restc_cpp::unittests::Gzip(payload);
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+    buffer.emplace_back(GzipReply(zipped));
+    for(size_t i = 0; i < zipped.size(); i += 1000) {
+        buffer.emplace_back(zipped.substr(i, 1000));
+    }
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+
+        // All the data in one buffer
+        const auto data = reply.GetSomeData();
+        EXPECT_EQ(payload.size(), boost::asio::buffer_size(data));
+        EXPECT_FALSE(reply.MoreDataToRead());
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
+TEST(HttpReply, GzipBodyOneShotTooLargeIsStreamed)
+{
+    // Compresses very well, and inflates to more than one buffer can hold
+    const std::string payload(RESTC_CPP_SANE_DATA_LIMIT + 1024 * 1024, 'x');
+    const auto zipped = ::restc_cpp::unittests::Gzip(payload);
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+    buffer.emplace_back(GzipReply(zipped));
+    buffer.emplace_back(zipped);
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+
+        size_t bytes = 0;
+        bool all_x = true;
+        while(reply.MoreDataToRead()) {
+            const auto data = reply.GetSomeData();
+            const boost::string_ref view{boost_buffer_cast(data), boost::asio::buffer_size(data)};
+            all_x = all_x && (view.find_first_not_of('x') == boost::string_ref::npos);
+            bytes += view.size();
+        }
+
+        EXPECT_EQ(payload.size(), bytes);
+        EXPECT_TRUE(all_x);
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
+TEST(HttpReply, DeflateBodyOneShot)
+{
+    const auto payload = LargePayload();
+    std::string zipped(compressBound(payload.size()), '\0');
+    auto zipped_len = static_cast<uLongf>(zipped.size());
+    ASSERT_EQ(Z_OK, compress(reinterpret_cast<Bytef *>(&zipped[0]), &zipped_len,
+                             reinterpret_cast<const Bytef *>(payload.data()),
+                             static_cast<uLong>(payload.size())));
+    zipped.resize(zipped_len);
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+    buffer.emplace_back("HTTP/1.1 200 OK\r\n"
+                        "Content-Type: text/plain\r\n"
+                        "Content-Encoding: deflate\r\n"
+                        "Content-Length: " + to_string(zipped.size()) + "\r\n"
+                        "\r\n");
+    buffer.emplace_back(zipped);
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+        EXPECT_EQ(payload, reply.GetBodyAsString());
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
+TEST(HttpReply, GzipBodyOneShotTruncated)
+{
+    const auto payload = LargePayload();
+    auto zipped = ::restc_cpp::unittests::Gzip(payload);
+    zipped.resize(zipped.size() / 2);
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+    buffer.emplace_back(GzipReply(zipped));
+    buffer.emplace_back(zipped);
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+        EXPECT_THROW(reply.GetBodyAsString(), DecompressException);
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+#endif // RESTC_CPP_WITH_ZLIB
+
+#ifdef RESTC_CPP_WITH_BROTLI
+TEST(HttpReply, BrotliBody)
+{
+    const std::string payload = "The quick brown fox jumps over the lazy dog. "
+                                "The quick brown fox jumps over the lazy dog.";
+
+    // payload, compressed with brotli
+    const std::string compressed{
+        "\x1b\x58\x00\x00\x44\xdb\x46\xa9\x2e\x24\x5b\x32\x14\xc5\x53\x91\x67"
+        "\x72\xf2\xe7\x28\x46\x41\x95\x57\xb6\xb2\x59\xd0\x7c\xe1\x95\xa7\x23"
+        "\xf2\xa2\xac\x36\x26\xb8\x45\x1f\x18\xc3\xaa\xfb\x0f\x81\xc9\x00\x00", 51};
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+
+    buffer.emplace_back("HTTP/1.1 200 OK\r\n"
+                        "Server: Cowboy\r\n"
+                        "Connection: keep-alive\r\n"
+                        "Content-Type: text/plain\r\n"
+                        "Content-Encoding: br\r\n"
+                        "Content-Length: " + to_string(compressed.size()) + "\r\n"
+                        "\r\n");
+    buffer.emplace_back(compressed.substr(0, compressed.size() / 2));
+    buffer.emplace_back(compressed.substr(compressed.size() / 2));
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+        auto body = reply.GetBodyAsString();
+
+        EXPECT_EQ("br", *reply.GetHeader("Content-Encoding"));
+        EXPECT_EQ(payload, body);
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
+TEST(HttpReply, BrotliEmptyBody)
+{
+    ::restc_cpp::unittests::test_buffers_t buffer;
+
+    buffer.emplace_back("HTTP/1.1 200 OK\r\n"
+                        "Connection: keep-alive\r\n"
+                        "Content-Encoding: br\r\n"
+                        "Content-Length: 0\r\n"
+                        "\r\n");
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+        EXPECT_EQ("", reply.GetBodyAsString());
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+#endif // RESTC_CPP_WITH_BROTLI
+
+#ifdef RESTC_CPP_WITH_ZSTD
+TEST(HttpReply, ZstdChunkedBody)
+{
+    const std::string first_part = "The quick brown fox ";
+    const std::string second_part = "jumps over the lazy dog.";
+
+    // A zstd frame with the data in one uncompressed (raw) block
+    auto frame = [](const std::string& data) {
+        std::string rval{"\x28\xb5\x2f\xfd", 4}; // Magic number
+        rval += '\x20'; // Single segment, 1 byte content size
+        rval += static_cast<char>(data.size());
+        const auto block_header = static_cast<uint32_t>((data.size() << 3) | 1); // Last block, raw
+        rval += static_cast<char>(block_header & 0xff);
+        rval += static_cast<char>((block_header >> 8) & 0xff);
+        rval += static_cast<char>((block_header >> 16) & 0xff);
+        rval += data;
+        return rval;
+    };
+
+    const auto first = frame(first_part);
+    const auto second = frame(second_part);
+
+    auto to_hex = [](size_t value) {
+        std::ostringstream hex;
+        hex << std::hex << value;
+        return hex.str();
+    };
+
+    ::restc_cpp::unittests::test_buffers_t buffer;
+
+    buffer.emplace_back("HTTP/1.1 200 OK\r\n"
+                        "Server: Cowboy\r\n"
+                        "Connection: keep-alive\r\n"
+                        "Content-Type: text/plain\r\n"
+                        "Content-Encoding: zstd\r\n"
+                        "Transfer-Encoding: chunked\r\n"
+                        "\r\n");
+    buffer.emplace_back(to_hex(first.size()) + "\r\n" + first + "\r\n");
+    buffer.emplace_back(to_hex(second.size()) + "\r\n" + second + "\r\n");
+    buffer.emplace_back("0\r\n\r\n");
+
+    auto rest_client = RestClient::Create();
+    auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+        ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+        reply.SimulateServerReply();
+        auto body = reply.GetBodyAsString();
+
+        EXPECT_EQ(first_part + second_part, body);
+    });
+
+    EXPECT_NO_THROW(f.get());
+}
+
+TEST(HttpReply, ZstdEmptyBody)
+{
+    for(const auto *framing : {"Content-Length: 0\r\n\r\n",
+                               "Transfer-Encoding: chunked\r\n\r\n0\r\n\r\n"}) {
+        ::restc_cpp::unittests::test_buffers_t buffer;
+
+        buffer.emplace_back("HTTP/1.1 200 OK\r\n"
+                            "Connection: keep-alive\r\n"
+                            "Content-Encoding: zstd\r\n"s + framing);
+
+        auto rest_client = RestClient::Create();
+        auto f = rest_client->ProcessWithPromise([&](Context &ctx) {
+            ::restc_cpp::unittests::TestReply reply(ctx, *rest_client, buffer);
+
+            reply.SimulateServerReply();
+            EXPECT_EQ("", reply.GetBodyAsString());
+        });
+
+        EXPECT_NO_THROW(f.get());
+    }
+}
+#endif // RESTC_CPP_WITH_ZSTD
+
 int main( int argc, char * argv[] )
 {
     RESTC_CPP_TEST_LOGGING_SETUP("debug");
@@ -0,0 +1,261 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/RequestBody.h"
+
+#include "../src/LoadBalancerImpl.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+using namespace std::literals::chrono_literals;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+using endpoint_t = LoadBalancerImpl::endpoint_t;
+
+const string host = "example.com";
+
+LoadBalancerImpl::endpoints_t MakeEndpoints(size_t count) {
+    LoadBalancerImpl::endpoints_t endpoints;
+    for(size_t i = 0; i < count; ++i) {
+        endpoints.emplace_back(boost::asio::ip::address_v4{static_cast<uint32_t>(0x0a000001 + i)},
+                               80);
+    }
+    return endpoints;
+}
+
+std::shared_ptr<LoadBalancerImpl> CreateBalancer(const LoadBalancer::Config& config) {
+    return std::static_pointer_cast<LoadBalancerImpl>(LoadBalancer::Create(config));
+}
+
+} // anonymous namespace
+
+TEST(LoadBalancer, RoundRobin) {
+    LoadBalancer::Config config;
+    config.strategy = LoadBalancer::Strategy::ROUND_ROBIN;
+    auto balancer = CreateBalancer(config);
+    const auto endpoints = MakeEndpoints(3);
+
+    std::map<endpoint_t, int> chosen;
+    for(int i = 0; i < 9; ++i) {
+        const auto order = balancer->Order(host, endpoints);
+        EXPECT_EQ(endpoints.size(), order.size());
+        ++chosen[order.front()];
+    }
+
+    EXPECT_EQ(3u, chosen.size());
+    for(const auto& it : chosen) {
+        EXPECT_EQ(3, it.second);
+    }
+}
+
+TEST(LoadBalancer, LeastOutstanding) {
+    LoadBalancer::Config config;
+    config.strategy = LoadBalancer::Strategy::LEAST_OUTSTANDING;
+    auto balancer = CreateBalancer(config);
+    const auto endpoints = MakeEndpoints(3);
+
+    std::vector<LoadBalancerImpl::Ticket> tickets;
+    tickets.push_back(balancer->Start(endpoints[0]));
+    tickets.push_back(balancer->Start(endpoints[0]));
+    tickets.push_back(balancer->Start(endpoints[2]));
+
+    for(int i = 0; i < 5; ++i) {
+        EXPECT_EQ(endpoints[1], balancer->Order(host, endpoints).front());
+    }
+
+    tickets.push_back(balancer->Start(endpoints[1]));
+    tickets.push_back(balancer->Start(endpoints[1]));
+    for(int i = 0; i < 5; ++i) {
+        EXPECT_EQ(endpoints[2], balancer->Order(host, endpoints).front());
+    }
+
+    tickets.clear();
+    for(const auto& stats : balancer->GetStats()) {
+        EXPECT_EQ(0u, stats.outstanding);
+    }
+}
+
+TEST(LoadBalancer, PowerOfTwoChoicesAvoidsTheSlowOne) {
+    LoadBalancer::Config config;
+    config.strategy = LoadBalancer::Strategy::P2C_EWMA;
+    auto balancer = CreateBalancer(config);
+    const auto endpoints = MakeEndpoints(2);
+
+    balancer->Start(endpoints[0]).OnResponse(200);
+    {
+        auto slow = balancer->Start(endpoints[1]);
+        std::this_thread::sleep_for(20ms);
+        slow.OnResponse(200);
+    }
+
+    // With two addresses, both are always the candidates
+    for(int i = 0; i < 10; ++i) {
+        EXPECT_EQ(endpoints[0], balancer->Order(host, endpoints).front());
+    }
+}
+
+TEST(LoadBalancer, EjectsFailingEndpoints) {
+    LoadBalancer::Config config;
+    config.strategy = LoadBalancer::Strategy::ROUND_ROBIN;
+    config.ejectAfterFailures = 3;
+    config.ejectionTimeMs = 100;
+    auto balancer = CreateBalancer(config);
+    const auto endpoints = MakeEndpoints(3);
+
+    balancer->OnConnectFailed(endpoints[1]);
+    balancer->Start(endpoints[1]).OnResponse(503);
+    // A success resets the count
+    balancer->Start(endpoints[1]).OnResponse(200);
+    balancer->OnConnectFailed(endpoints[1]);
+    balancer->Start(endpoints[1]).OnFailure();
+    for(const auto& stats : balancer->GetStats()) {
+        EXPECT_FALSE(stats.ejected);
+    }
+
+    balancer->Start(endpoints[1]).OnResponse(500);
+    for(int i = 0; i < 6; ++i) {
+        const auto order = balancer->Order(host, endpoints);
+        EXPECT_NE(endpoints[1], order.front());
+        // Still a fallback
+        EXPECT_EQ(endpoints[1], order.back());
+    }
+
+    std::this_thread::sleep_for(150ms);
+    std::map<endpoint_t, int> chosen;
+    for(int i = 0; i < 6; ++i) {
+        ++chosen[balancer->Order(host, endpoints).front()];
+    }
+    EXPECT_EQ(2, chosen[endpoints[1]]);
+}
+
+TEST(LoadBalancer, AffinityKeyIsSticky) {
+    LoadBalancer::Config config;
+    config.strategy = LoadBalancer::Strategy::ROUND_ROBIN;
+    auto balancer = CreateBalancer(config);
+    const auto endpoints = MakeEndpoints(5);
+
+    std::map<endpoint_t, int> chosen;
+    for(int key = 0; key < 100; ++key) {
+        const auto first = balancer->Order(host, endpoints, "user-" + to_string(key)).front();
+        ++chosen[first];
+        for(int i = 0; i < 3; ++i) {
+            EXPECT_EQ(first, balancer->Order(host, endpoints, "user-" + to_string(key)).front());
+        }
+
+        // The order of the addresses does not matter
+        auto reversed = endpoints;
+        std::reverse(reversed.begin(), reversed.end());
+        EXPECT_EQ(first, balancer->Order(host, reversed, "user-" + to_string(key)).front());
+    }
+
+    // The keys are spread over all the addresses
+    EXPECT_EQ(endpoints.size(), chosen.size());
+}
+
+TEST(LoadBalancer, AffinityOnlyMovesTheKeysOfARemovedAddress) {
+    LoadBalancer::Config config;
+    config.ejectAfterFailures = 1;
+    auto balancer = CreateBalancer(config);
+    const auto endpoints = MakeEndpoints(4);
+    auto fewer = endpoints;
+    fewer.erase(fewer.begin() + 2);
+
+    for(int key = 0; key < 100; ++key) {
+        const auto name = "key-" + to_string(key);
+        const auto before = balancer->Order(host, endpoints, name);
+        const auto after = balancer->Order(host, fewer, name);
+        if (before.front() == endpoints[2]) {
+            // Moves to its second choice
+            EXPECT_EQ(before[1], after.front());
+        } else {
+            EXPECT_EQ(before.front(), after.front());
+        }
+    }
+
+    // An ejected address is treated the same way, but remains a fallback
+    balancer->OnConnectFailed(endpoints[2]);
+    for(int key = 0; key < 100; ++key) {
+        const auto name = "key-" + to_string(key);
+        const auto order = balancer->Order(host, endpoints, name);
+        EXPECT_EQ(balancer->Order(host, fewer, name).front(), order.front());
+        EXPECT_EQ(endpoints[2], order.back());
+    }
+}
+
+TEST(LoadBalancer, ForgetsStaleEndpoints) {
+    LoadBalancer::Config config;
+    config.endpointTtlMs = 100;
+    auto balancer = CreateBalancer(config);
+    const auto endpoints = MakeEndpoints(3);
+
+    for(const auto& endpoint : endpoints) {
+        balancer->Start(endpoint).OnResponse(200);
+    }
+    auto busy = balancer->Start(endpoints[2]);
+    EXPECT_EQ(3u, balancer->GetStats().size());
+
+    // The first is still resolved, the second is gone, and the third is in use
+    std::this_thread::sleep_for(60ms);
+    balancer->Order(host, {endpoints[0], endpoints[2]});
+    std::this_thread::sleep_for(60ms);
+    balancer->Order(host, {endpoints[0], endpoints[2]});
+
+    const auto stats = balancer->GetStats();
+    ASSERT_EQ(2u, stats.size());
+    EXPECT_EQ("10.0.0.1:80", stats[0].endpoint);
+    EXPECT_EQ("10.0.0.3:80", stats[1].endpoint);
+    EXPECT_EQ(1u, stats[1].outstanding);
+}
+
+TEST(LoadBalancer, UsesTheStaticUpstreams) {
+    LoadBalancer::Config config;
+    config.strategy = LoadBalancer::Strategy::ROUND_ROBIN;
+    // Nobody listens on these ports
+    config.upstreams["upstream.example.com"] = {"127.0.0.1:1", "127.0.0.1:2"};
+    auto balancer = CreateBalancer(config);
+
+    ASSERT_TRUE(balancer->GetUpstreams("upstream.example.com"));
+    EXPECT_FALSE(balancer->GetUpstreams("example.com"));
+
+    Request::Properties properties;
+    properties.loadBalancer = balancer;
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        boost::system::error_code ec;
+        auto request = Request::Create("http://upstream.example.com/", Request::Type::GET,
+                                       ctx.GetClient());
+        EXPECT_FALSE(request->Execute(ctx, ec));
+        EXPECT_EQ(Error::FAILED_TO_CONNECT, ec);
+    }).get();
+
+    // Both were tried
+    const auto stats = balancer->GetStats();
+    ASSERT_EQ(2u, stats.size());
+    EXPECT_EQ("127.0.0.1:1", stats[0].endpoint);
+    EXPECT_EQ("127.0.0.1:2", stats[1].endpoint);
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
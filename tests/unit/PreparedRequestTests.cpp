@@ -0,0 +1,169 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/PreparedRequest.h"
+#include "restc-cpp/RequestBody.h"
+
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace restc_cpp::unittests {
+
+TEST(PreparedRequest, PathParams) {
+    TestServer server;
+    auto rest_client = RestClient::Create();
+
+    auto tmpl = PreparedRequest::Create(server.GetUrl("/users/{id}/posts/{post}"),
+                                        Request::Type::GET, *rest_client);
+    EXPECT_EQ(2u, tmpl->GetNumPathParams());
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("OK", tmpl->Execute(ctx, {"42", "a b&c"})->GetBodyAsString());
+        EXPECT_EQ("OK", tmpl->Execute(ctx, {"43", "x"})->GetBodyAsString());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(2u, requests.size());
+    EXPECT_EQ("/users/42/posts/a%20b%26c", requests[0].target);
+    EXPECT_EQ("/users/43/posts/x", requests[1].target);
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(PreparedRequest, PathParamsAreOneSegment) {
+    TestServer server;
+    auto rest_client = RestClient::Create();
+
+    auto tmpl = PreparedRequest::Create(server.GetUrl("/files/{name}/info"),
+                                        Request::Type::GET, *rest_client);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        for(const std::string name : {"a/b", "../admin", "..", ".", "a?b#c", "..."}) {
+            EXPECT_EQ("OK", tmpl->Execute(ctx, {name})->GetBodyAsString());
+        }
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(6u, requests.size());
+    EXPECT_EQ("/files/a%2Fb/info", requests[0].target);
+    EXPECT_EQ("/files/..%2Fadmin/info", requests[1].target);
+    EXPECT_EQ("/files/%2E%2E/info", requests[2].target);
+    EXPECT_EQ("/files/%2E/info", requests[3].target);
+    EXPECT_EQ("/files/a%3Fb%23c/info", requests[4].target);
+    EXPECT_EQ("/files/.../info", requests[5].target);
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(PreparedRequest, WrongNumberOfPathParams) {
+    auto rest_client = RestClient::Create();
+    auto tmpl = PreparedRequest::Create("http://127.0.0.1/users/{id}",
+                                        Request::Type::GET, *rest_client);
+
+    EXPECT_THROW(tmpl->CreateRequest(), ConstraintException);
+    EXPECT_THROW(tmpl->CreateRequest({"1", "2"}), ConstraintException);
+    EXPECT_NO_THROW(tmpl->CreateRequest({"1"}));
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(PreparedRequest, Args) {
+    TestServer server;
+    auto rest_client = RestClient::Create();
+
+    auto tmpl = PreparedRequest::Create(server.GetUrl("/search?lang=en"),
+                                        Request::Type::GET, *rest_client,
+                                        Request::args_t{{"static", "1"}});
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        tmpl->Execute(ctx, {}, {}, Request::args_t{{"q", "a b"}, {"page", "2"}})
+            ->GetBodyAsString();
+        tmpl->Execute(ctx)->GetBodyAsString();
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(2u, requests.size());
+    EXPECT_EQ("/search?lang=en&static=1&q=a%20b&page=2", requests[0].target);
+    // The per-call arguments are not kept in the template
+    EXPECT_EQ("/search?lang=en&static=1", requests[1].target);
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(PreparedRequest, Headers) {
+    TestServer server;
+    auto rest_client = RestClient::Create();
+
+    Request::headers_t headers;
+    headers["X-Static"] = "yes";
+    // Set by the body, so they are not part of the pre-built block
+    headers["Content-Length"] = "999";
+    headers["Transfer-Encoding"] = "chunked";
+
+    auto tmpl = PreparedRequest::Create(server.GetUrl("/upload"),
+                                        Request::Type::POST, *rest_client,
+                                        {}, headers);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        tmpl->Execute(ctx, {}, RequestBody::CreateStringBody("hello"))->GetBodyAsString();
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(1u, requests.size());
+    const auto& request = requests[0];
+    EXPECT_EQ("POST", request.method);
+    EXPECT_TRUE(request.HasHeader("X-Static: yes"));
+    EXPECT_EQ(1u, request.CountHeader("Host"));
+    EXPECT_EQ(1u, request.CountHeader("Content-Length"));
+    EXPECT_EQ("5", request.GetHeader("Content-Length"));
+    EXPECT_EQ(0u, request.CountHeader("Transfer-Encoding"));
+    EXPECT_EQ("hello", request.body);
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(PreparedRequest, Redirect) {
+    TestServer server{[](const TestServer::Request& request) {
+        if (request.target == "/old?a=1") {
+            return TestServer::Response(302, "Found", {}, "Location: /moved?x=1\r\n");
+        }
+        return TestServer::Ok("Moved");
+    }};
+    auto rest_client = RestClient::Create();
+
+    Request::headers_t headers;
+    headers["X-Static"] = "yes";
+    auto tmpl = PreparedRequest::Create(server.GetUrl("/old"), Request::Type::GET,
+                                        *rest_client, Request::args_t{{"a", "1"}}, headers);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("Moved", tmpl->Execute(ctx)->GetBodyAsString());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(2u, requests.size());
+    EXPECT_EQ("/old?a=1", requests[0].target);
+    // The new URL is used as is, without the arguments from the template
+    EXPECT_EQ("/moved?x=1", requests[1].target);
+    EXPECT_TRUE(requests[1].HasHeader("X-Static: yes"));
+    EXPECT_EQ(1u, requests[1].CountHeader("Host"));
+
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
@@ -0,0 +1,93 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/internals/RecycledObject.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace {
+
+std::atomic_int destroyed{0};
+
+struct Probe : public RecycledObject<Probe> {
+    ~Probe() {
+        ++destroyed;
+    }
+
+    int value = 0;
+};
+
+struct BiggerProbe : public Probe {
+    char padding[64] = {};
+};
+
+/*! Releases the probe when the thread exits, after the pool is gone */
+struct LateRelease {
+    ~LateRelease() {
+        delete probe;
+    }
+
+    Probe *probe = nullptr;
+};
+
+} // anonymous namespace
+
+TEST(RecycledObject, MemoryIsReused)
+{
+    auto *first = new Probe;
+    void *address = first;
+    delete first;
+
+    auto *second = new Probe;
+    EXPECT_EQ(address, static_cast<void *>(second));
+    delete second;
+}
+
+TEST(RecycledObject, DerivedClassesUseTheGlobalAllocator)
+{
+    std::unique_ptr<Probe> probe = make_unique<BiggerProbe>();
+    probe->value = 1;
+    EXPECT_EQ(1, probe->value);
+}
+
+TEST(RecycledObject, ReleasedInAnotherThread)
+{
+    auto *probe = new Probe;
+    std::thread{[probe] {
+        delete probe;
+        // Goes to this thread's pool
+        auto *again = new Probe;
+        EXPECT_EQ(static_cast<void *>(probe), static_cast<void *>(again));
+        delete again;
+    }}.join();
+}
+
+TEST(RecycledObject, ReleasedAfterThePoolIsDestroyed)
+{
+    destroyed = 0;
+    std::thread{[] {
+        // Constructed before the pool, so it is destroyed after it
+        thread_local LateRelease late;
+        delete new Probe; // Creates the pool
+        late.probe = new Probe;
+    }}.join();
+
+    EXPECT_EQ(2, destroyed);
+}
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
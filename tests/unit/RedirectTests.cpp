@@ -0,0 +1,160 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RedirectCache.h"
+#include "restc-cpp/RequestBody.h"
+
+#include <mutex>
+
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+/*! Redirects "/r<code>/<location>" to "/<location>" with the status code,
+ *  and echoes everything else.
+ */
+std::string Redirector(const TestServer::Request& request) {
+    if ((request.target.size() > 5) && (request.target[1] == 'r')
+        && std::isdigit(request.target[2])) {
+        return TestServer::Response(std::stoi(request.target.substr(2, 3)), "Redirect", {},
+                                    "Location: " + request.target.substr(5) + "\r\n");
+    }
+    return TestServer::Ok(request.method + " " + request.target + " " + request.body);
+}
+
+} // anonymous namespace
+
+TEST(Redirect, SeeOtherSwitchesToGet) {
+    TestServer server{Redirector};
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto request = Request::Create(server.GetUrl("/r303/result"),
+                                       Request::Type::POST, ctx.GetClient(),
+                                       RequestBody::CreateStringBody("data"));
+        EXPECT_EQ("GET /result ", request->Execute(ctx)->GetBodyAsString());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(2u, requests.size());
+    EXPECT_EQ("POST", requests[0].method);
+    EXPECT_EQ("data", requests[0].body);
+    EXPECT_EQ("GET", requests[1].method);
+    EXPECT_EQ("", requests[1].body);
+    EXPECT_EQ("0", requests[1].GetHeader("Content-Length"));
+    EXPECT_EQ(0u, requests[1].CountHeader("Transfer-Encoding"));
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(Redirect, TemporaryAndPermanentKeepTheMethodAndBody) {
+    TestServer server{Redirector};
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        for(const std::string code : {"307", "308"}) {
+            auto request = Request::Create(server.GetUrl("/r" + code + "/to/" + code),
+                                           Request::Type::PUT, ctx.GetClient(),
+                                           RequestBody::CreateStringBody("data"));
+            EXPECT_EQ("PUT /to/" + code + " data", request->Execute(ctx)->GetBodyAsString());
+        }
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(4u, requests.size());
+    for(const auto& request : requests) {
+        EXPECT_EQ("PUT", request.method);
+        EXPECT_EQ("data", request.body);
+    }
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(Redirect, RelativeLocation) {
+    std::mutex mutex;
+    std::string location;
+    TestServer server{[&](const TestServer::Request& request) {
+        if (request.target == "/from/dir/page") {
+            std::lock_guard<std::mutex> const lock{mutex};
+            return TestServer::Response(302, "Found", {}, "Location: " + location + "\r\n");
+        }
+        return TestServer::Ok(request.target);
+    }};
+    auto rest_client = RestClient::Create();
+
+    const auto host = server.GetUrl("").substr(std::string{"http://"}.size());
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto get = [&](const std::string& to) {
+            {
+                std::lock_guard<std::mutex> const lock{mutex};
+                location = to;
+            }
+            return ctx.Get(server.GetUrl("/from/dir/page"))->GetBodyAsString();
+        };
+
+        EXPECT_EQ("/from/dir/sibling", get("sibling"));
+        EXPECT_EQ("/from/dir/sibling?a=1", get("sibling?a=1"));
+        EXPECT_EQ("/from/other", get("../other"));
+        EXPECT_EQ("/other", get("./../../../other"));
+        EXPECT_EQ("/from/dir/", get("."));
+        EXPECT_EQ("/from/dir/page?a=1", get("?a=1"));
+        EXPECT_EQ("/root", get("/root"));
+        EXPECT_EQ("/net", get("//" + host + "/net"));
+    }).get();
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(Redirect, PermanentRedirectIsCached) {
+    TestServer server{Redirector};
+    Request::Properties properties;
+    properties.redirectCache = RedirectCache::Create();
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("GET /c ", ctx.Get(server.GetUrl("/r301/r308/c"))->GetBodyAsString());
+        EXPECT_EQ(3u, server.GetRequests().size());
+
+        // Both hops are taken from the cache
+        EXPECT_EQ("GET /c ", ctx.Get(server.GetUrl("/r301/r308/c"))->GetBodyAsString());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(4u, requests.size());
+    EXPECT_EQ("/c", requests[3].target);
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(Redirect, TemporaryRedirectIsNotCached) {
+    TestServer server{Redirector};
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("GET /b ", ctx.Get(server.GetUrl("/r307/b"))->GetBodyAsString());
+        EXPECT_EQ("GET /b ", ctx.Get(server.GetUrl("/r307/b"))->GetBodyAsString());
+    }).get();
+
+    EXPECT_EQ(4u, server.GetRequests().size());
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
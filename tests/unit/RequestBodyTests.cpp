@@ -0,0 +1,217 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RequestBody.h"
+
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+/*! Get all the data from a body, as the writer would */
+std::string Drain(RequestBody& body) {
+    std::string data;
+    write_buffers_t buffers;
+    while(body.GetData(buffers)) {
+        for(const auto& b : buffers) {
+            data.append(static_cast<const char *>(b.data()), b.size());
+        }
+        buffers.clear();
+    }
+    return data;
+}
+
+} // anonymous namespace
+
+TEST(RequestBody, ViewBody) {
+    const std::string data{"Hello world"};
+    auto body = RequestBody::CreateViewBody(data);
+
+    EXPECT_EQ(RequestBody::Type::FIXED_SIZE, body->GetType());
+    EXPECT_EQ(data.size(), body->GetFixedSize());
+
+    // The data is not copied
+    write_buffers_t buffers;
+    ASSERT_TRUE(body->GetData(buffers));
+    ASSERT_EQ(1u, buffers.size());
+    EXPECT_EQ(static_cast<const void *>(data.data()), buffers[0].data());
+    EXPECT_EQ(data.size(), buffers[0].size());
+
+    buffers.clear();
+    EXPECT_FALSE(body->GetData(buffers));
+
+    body->Reset();
+    EXPECT_EQ(data, Drain(*body));
+    EXPECT_EQ(data, body->GetCopyOfData());
+}
+
+TEST(RequestBody, SharedBody) {
+    auto data = make_shared<const std::string>("Hello world");
+    auto body = RequestBody::CreateSharedBody(data);
+
+    // The body keeps the buffer alive
+    EXPECT_EQ(2, data.use_count());
+    EXPECT_EQ(data->size(), body->GetFixedSize());
+
+    write_buffers_t buffers;
+    ASSERT_TRUE(body->GetData(buffers));
+    EXPECT_EQ(static_cast<const void *>(data->data()), buffers[0].data());
+
+    body->Reset();
+    EXPECT_EQ(*data, Drain(*body));
+
+    body.reset();
+    EXPECT_EQ(1, data.use_count());
+}
+
+TEST(RequestBody, GatherBody) {
+    auto storage = make_shared<std::array<std::string, 3>>(
+        std::array<std::string, 3>{"Hello", " ", "world"});
+    write_buffers_t buffers;
+    for(const auto& part : *storage) {
+        buffers.emplace_back(part.data(), part.size());
+    }
+
+    auto body = RequestBody::CreateGatherBody(buffers, storage);
+    EXPECT_EQ(2, storage.use_count());
+    EXPECT_EQ(11u, body->GetFixedSize());
+
+    // All the buffers in one go, for one gather-write
+    write_buffers_t out;
+    ASSERT_TRUE(body->GetData(out));
+    EXPECT_EQ(3u, out.size());
+    out.clear();
+    EXPECT_FALSE(body->GetData(out));
+
+    body->Reset();
+    EXPECT_EQ("Hello world", Drain(*body));
+    EXPECT_EQ("Hello world", body->GetCopyOfData());
+
+    body.reset();
+    EXPECT_EQ(1, storage.use_count());
+}
+
+TEST(RequestBody, SentAgainAfterRedirect) {
+    TestServer server{[](const TestServer::Request& request) {
+        if (request.target == "/old") {
+            // 307 keeps the method and the body
+            return TestServer::Response(307, "Temporary Redirect", {}, "Location: /new\r\n");
+        }
+        return TestServer::Ok(request.body);
+    }};
+    auto rest_client = RestClient::Create();
+
+    const std::string view_data{"view"};
+    auto shared_data = make_shared<const std::string>("shared");
+    auto gather_data = make_shared<std::array<std::string, 2>>(
+        std::array<std::string, 2>{"gath", "er"});
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto post = [&](std::unique_ptr<RequestBody> body) {
+            auto request = Request::Create(server.GetUrl("/old"), Request::Type::POST,
+                                           ctx.GetClient(), std::move(body));
+            return request->Execute(ctx)->GetBodyAsString();
+        };
+
+        EXPECT_EQ("view", post(RequestBody::CreateViewBody(view_data)));
+        EXPECT_EQ("shared", post(RequestBody::CreateSharedBody(shared_data)));
+        EXPECT_EQ("gather", post(RequestBody::CreateGatherBody(
+            {{(*gather_data)[0].data(), (*gather_data)[0].size()},
+             {(*gather_data)[1].data(), (*gather_data)[1].size()}}, gather_data)));
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(6u, requests.size());
+    for(size_t i = 0; i < requests.size(); i += 2) {
+        EXPECT_EQ("/old", requests[i].target);
+        EXPECT_EQ("/new", requests[i + 1].target);
+        EXPECT_EQ("POST", requests[i + 1].method);
+        EXPECT_EQ(requests[i].body, requests[i + 1].body);
+    }
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(RequestBody, PermanentRedirectOnlyForTheMethod) {
+    TestServer server{[](const TestServer::Request& request) {
+        if ((request.target == "/old") && (request.method == "POST")) {
+            return TestServer::Response(308, "Permanent Redirect", {}, "Location: /new\r\n");
+        }
+        return TestServer::Ok(request.method + " " + request.target);
+    }};
+    auto rest_client = RestClient::Create();
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto execute = [&](Request::Type type) {
+            auto request = Request::Create(server.GetUrl("/old"), type, ctx.GetClient(),
+                                           RequestBody::CreateStringBody("data"));
+            return request->Execute(ctx)->GetBodyAsString();
+        };
+
+        EXPECT_EQ("POST /new", execute(Request::Type::POST));
+        // The cached redirect is used
+        EXPECT_EQ("POST /new", execute(Request::Type::POST));
+        // But not for another method
+        EXPECT_EQ("PUT /old", execute(Request::Type::PUT));
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(4u, requests.size());
+    EXPECT_EQ("/old", requests[0].target);
+    EXPECT_EQ("/new", requests[1].target);
+    EXPECT_EQ("/new", requests[2].target);
+    EXPECT_EQ("data", requests[2].body);
+    EXPECT_EQ("PUT", requests[3].method);
+    EXPECT_EQ("/old", requests[3].target);
+
+    rest_client->CloseWhenReady();
+}
+
+#ifdef RESTC_CPP_WITH_ZLIB
+TEST(RequestBody, CompressionForOneRequest) {
+    TestServer server;
+    auto rest_client = RestClient::Create();
+    const std::string data(2048, 'a');
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto request = Request::Create(server.GetUrl(), Request::Type::POST,
+                                       ctx.GetClient(), RequestBody::CreateStringBody(data));
+        request->SetBodyCompression(Request::Compression::GZIP);
+        request->Execute(ctx)->GetBodyAsString();
+
+        // Not for the next request
+        request = Request::Create(server.GetUrl(), Request::Type::POST,
+                                  ctx.GetClient(), RequestBody::CreateStringBody(data));
+        request->Execute(ctx)->GetBodyAsString();
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(2u, requests.size());
+    EXPECT_EQ("gzip", requests[0].GetHeader("Content-Encoding"));
+    EXPECT_LT(requests[0].body.size(), data.size());
+    EXPECT_EQ(0u, requests[1].CountHeader("Content-Encoding"));
+    EXPECT_EQ(data, requests[1].body);
+    EXPECT_EQ(Request::Compression::NONE,
+              rest_client->GetConnectionProperties()->bodyCompression);
+
+    rest_client->CloseWhenReady();
+}
+#endif
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
@@ -12,6 +12,17 @@
 using namespace std;
 using namespace restc_cpp;
 
+struct Post {
+    int id = 0;
+    string title;
+};
+
+BOOST_FUSION_ADAPT_STRUCT(
+    Post,
+    (int, id)
+    (string, title)
+)
+
 TEST(RequestBuilder, DataWithCString)
 {
     RequestBuilder rb;
@@ -39,6 +50,41 @@ TEST(RequestBuilder, DataWithString)
 
 }
 
+TEST(RequestBuilder, DataWithSharedString)
+{
+    auto data = make_shared<string>("{}");
+
+    RequestBuilder rb;
+    rb.Data(data);
+    // Sent as it is, not serialized as Json
+    EXPECT_EQ("{}", rb.GetData());
+    EXPECT_EQ(2, data.use_count());
+}
+
+TEST(RequestBuilder, DataWithObjectIsBuffered)
+{
+    Post post;
+    post.id = 1;
+    post.title = "Hi";
+
+    RequestBuilder rb;
+    rb.Data(post);
+    EXPECT_EQ(R"({"id":1,"title":"Hi"})", rb.GetData());
+}
+
+TEST(RequestBuilder, DataWithObjectOverLimitIsStreamed)
+{
+    Post post;
+    post.id = 1;
+    post.title = "Hi";
+
+    RequestBuilder rb;
+    rb.JsonBufferLimit(8).Data(post);
+
+    // Streamed bodies are not available as a string
+    EXPECT_EQ("", rb.GetData());
+}
+
 int main( int argc, char * argv[] )
 {
     RESTC_CPP_TEST_LOGGING_SETUP("debug");
@@ -0,0 +1,219 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+
+#include "../src/RequestCoalescerImpl.h"
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+using namespace std::literals::chrono_literals;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+constexpr int wait_ms = 5000;
+
+ResponseCache::entry_t MakeResponse(const std::string& body) {
+    auto response = make_shared<CachedResponse>();
+    auto data = make_shared<std::string>(body);
+    response->response.status_code = 200;
+    response->body = *data;
+    response->bodyOwner = std::move(data);
+    return response;
+}
+
+} // anonymous namespace
+
+TEST(RequestCoalescer, WaitersGetTheResponse) {
+    RequestCoalescerImpl coalescer{RESTC_CPP_SANE_DATA_LIMIT};
+    auto rest_client = RestClient::Create();
+
+    auto leader = coalescer.Join("key");
+    EXPECT_TRUE(leader.second);
+    EXPECT_EQ(1, coalescer.GetInFlightCount());
+
+    std::atomic_int got{0};
+    std::vector<std::future<void>> waiters;
+    for(int i = 0; i < 10; ++i) {
+        waiters.push_back(rest_client->ProcessWithPromise([&](Context& ctx) {
+            auto flight = coalescer.Join("key");
+            EXPECT_FALSE(flight.second);
+            auto response = RequestCoalescerImpl::Wait(*flight.first, ctx, wait_ms);
+            ASSERT_TRUE(response);
+            EXPECT_EQ("Hello", response->body);
+            ++got;
+        }));
+    }
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        // Let the waiters get in line
+        ctx.Sleep(100ms);
+        EXPECT_EQ(0, got);
+        coalescer.Complete("key", *leader.first, MakeResponse("Hello"));
+    }).get();
+
+    for(auto& f : waiters) {
+        EXPECT_NO_THROW(f.get());
+    }
+
+    EXPECT_EQ(10, got);
+    EXPECT_EQ(0, coalescer.GetInFlightCount());
+
+    // The next request starts a new flight
+    EXPECT_TRUE(coalescer.Join("key").second);
+}
+
+TEST(RequestCoalescer, WaitersGetTheError) {
+    RequestCoalescerImpl coalescer{RESTC_CPP_SANE_DATA_LIMIT};
+    auto rest_client = RestClient::Create();
+
+    auto leader = coalescer.Join("key");
+
+    auto waiter = rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto flight = coalescer.Join("key");
+        RequestCoalescerImpl::Wait(*flight.first, ctx, wait_ms);
+    });
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        ctx.Sleep(50ms);
+        coalescer.Complete("key", *leader.first, {},
+                           make_exception_ptr(ProtocolException("Failed")));
+    }).get();
+
+    EXPECT_THROW(waiter.get(), ProtocolException);
+}
+
+TEST(RequestCoalescer, WaitAfterComplete) {
+    RequestCoalescerImpl coalescer{RESTC_CPP_SANE_DATA_LIMIT};
+    auto rest_client = RestClient::Create();
+
+    auto leader = coalescer.Join("key");
+    coalescer.Complete("key", *leader.first, {});
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        // nullptr means that the waiter must send the request itself
+        EXPECT_FALSE(RequestCoalescerImpl::Wait(*leader.first, ctx, wait_ms));
+    }).get();
+}
+
+TEST(RequestCoalescer, CoroutineContinuesAfterWait) {
+    RequestCoalescerImpl coalescer{RESTC_CPP_SANE_DATA_LIMIT};
+    auto rest_client = RestClient::Create();
+
+    const std::vector<std::string> keys = {"first", "second", "third"};
+    std::vector<RequestCoalescerImpl::flight_ptr_t> leaders;
+    for(const auto& key : keys) {
+        leaders.push_back(coalescer.Join(key).first);
+    }
+
+    // The same coroutine waits for several flights, and does other IO in between
+    auto waiter = rest_client->ProcessWithPromise([&](Context& ctx) {
+        for(const auto& key : keys) {
+            auto flight = coalescer.Join(key);
+            EXPECT_FALSE(flight.second);
+            EXPECT_TRUE(RequestCoalescerImpl::Wait(*flight.first, ctx, wait_ms));
+            ctx.Sleep(1ms);
+        }
+    });
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        for(size_t i = 0; i < keys.size(); ++i) {
+            ctx.Sleep(50ms);
+            coalescer.Complete(keys[i], *leaders[i], MakeResponse("Hello"));
+        }
+    }).get();
+
+    EXPECT_NO_THROW(waiter.get());
+}
+
+TEST(RequestCoalescer, WaitTimesOut) {
+    RequestCoalescerImpl coalescer{RESTC_CPP_SANE_DATA_LIMIT};
+    auto rest_client = RestClient::Create();
+
+    auto leader = coalescer.Join("key");
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto flight = coalescer.Join("key");
+        EXPECT_FALSE(flight.second);
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_FALSE(RequestCoalescerImpl::Wait(*flight.first, ctx, 50));
+        EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+    }).get();
+
+    // Completing it later is harmless
+    coalescer.Complete("key", *leader.first, MakeResponse("Hello"));
+    EXPECT_EQ(0, coalescer.GetInFlightCount());
+}
+
+TEST(RequestCoalescer, LeaderCompletesWhenDestroyed) {
+    RequestCoalescerImpl coalescer{RESTC_CPP_SANE_DATA_LIMIT};
+    auto rest_client = RestClient::Create();
+
+    auto flight = coalescer.Join("key");
+    auto leader = make_unique<RequestCoalescerImpl::Leader>(coalescer, "key", flight.first);
+
+    auto waiter = rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_FALSE(RequestCoalescerImpl::Wait(*flight.first, ctx, wait_ms));
+    });
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        ctx.Sleep(50ms);
+        leader.reset();
+    }).get();
+
+    EXPECT_NO_THROW(waiter.get());
+    EXPECT_EQ(0, coalescer.GetInFlightCount());
+}
+
+TEST(RequestCoalescer, ExecuteSendsOneRequest) {
+    TestServer server{[](const TestServer::Request&) {
+        // Keep the request in flight while the others join it
+        std::this_thread::sleep_for(200ms);
+        return TestServer::Ok("Hello");
+    }};
+
+    Request::Properties properties;
+    properties.requestCoalescer = RequestCoalescer::Create();
+    auto rest_client = RestClient::Create(properties);
+
+    std::vector<std::future<void>> requests;
+    for(int i = 0; i < 5; ++i) {
+        requests.push_back(rest_client->ProcessWithPromise([&](Context& ctx) {
+            auto reply = ctx.Get(server.GetUrl());
+            EXPECT_EQ(200, reply->GetResponseCode());
+            EXPECT_EQ("Hello", reply->GetBodyAsString());
+        }));
+    }
+
+    for(auto& f : requests) {
+        EXPECT_NO_THROW(f.get());
+    }
+
+    EXPECT_EQ(1u, server.GetRequests().size());
+    EXPECT_EQ(0, static_cast<RequestCoalescerImpl&>(
+        *properties.requestCoalescer).GetInFlightCount());
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("debug");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
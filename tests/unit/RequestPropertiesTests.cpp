@@ -0,0 +1,152 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RequestBody.h"
+#include "restc-cpp/RetryPolicy.h"
+
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+Request::Properties ClientProperties() {
+    Request::Properties properties;
+    properties.headers["X-A"] = "client";
+    properties.headers["X-B"] = "client";
+    properties.args.emplace_back("a", "1");
+    return properties;
+}
+
+const Request::headers_t request_headers{{"x-a", "request"}};
+const Request::args_t request_args{{"b", "2"}};
+
+/*! The client headers, with X-A from the request, and both sets of arguments */
+void ExpectMerged(const TestServer::Request& request, const std::string& target) {
+    EXPECT_EQ(target, request.target);
+    EXPECT_EQ(1u, request.CountHeader("X-A"));
+    EXPECT_EQ("request", request.GetHeader("X-A"));
+    EXPECT_EQ("client", request.GetHeader("X-B"));
+}
+
+} // anonymous namespace
+
+TEST(RequestProperties, RequestOverridesClient) {
+    TestServer server;
+    auto rest_client = RestClient::Create(ClientProperties());
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto request = Request::Create(server.GetUrl(), Request::Type::GET,
+                                       ctx.GetClient(), {}, request_args, request_headers);
+
+        const auto& merged = request->GetProperties();
+        EXPECT_EQ(1u, merged.headers.count("X-A"));
+        EXPECT_EQ("request", merged.headers.find("X-A")->second);
+        EXPECT_EQ("client", merged.headers.find("X-B")->second);
+        ASSERT_EQ(2u, merged.args.size());
+        EXPECT_EQ("a", merged.args[0].name);
+        EXPECT_EQ("b", merged.args[1].name);
+
+        request->Execute(ctx)->GetBodyAsString();
+
+        // The client properties are not changed
+        const auto& client = *ctx.GetClient().GetConnectionProperties();
+        EXPECT_EQ("client", client.headers.find("X-A")->second);
+        EXPECT_EQ(1u, client.args.size());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(1u, requests.size());
+    ExpectMerged(requests[0], "/?a=1&b=2");
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(RequestProperties, SetPropertiesUpdatesTheMergedView) {
+    auto rest_client = RestClient::Create(ClientProperties());
+
+    auto request = Request::Create("http://127.0.0.1/", Request::Type::GET,
+                                   *rest_client, {}, request_args, request_headers);
+    EXPECT_EQ("client", request->GetProperties().headers.find("X-B")->second);
+
+    auto properties = make_shared<Request::Properties>(ClientProperties());
+    properties->headers["X-B"] = "replaced";
+    properties->headers["X-A"] = "replaced";
+    request->SetProperties(properties);
+
+    // The request specific headers still apply on top of the new properties
+    EXPECT_EQ("replaced", request->GetProperties().headers.find("X-B")->second);
+    EXPECT_EQ("request", request->GetProperties().headers.find("X-A")->second);
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(RequestProperties, RedirectKeepsTheMergedHeaders) {
+    TestServer server{[](const TestServer::Request& request) {
+        if (request.target.rfind("/old", 0) == 0) {
+            return TestServer::Response(302, "Found", {}, "Location: /new\r\n");
+        }
+        return TestServer::Ok("OK");
+    }};
+    auto rest_client = RestClient::Create(ClientProperties());
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto request = Request::Create(server.GetUrl("/old"), Request::Type::GET,
+                                       ctx.GetClient(), {}, request_args, request_headers);
+        EXPECT_EQ("OK", request->Execute(ctx)->GetBodyAsString());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(2u, requests.size());
+    ExpectMerged(requests[0], "/old?a=1&b=2");
+    // The arguments in the Location are used as they are
+    ExpectMerged(requests[1], "/new");
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(RequestProperties, RetryKeepsTheMergedHeadersAndArgs) {
+    std::atomic_int count{0};
+    TestServer server{[&](const TestServer::Request&) {
+        if (count++ == 0) {
+            return TestServer::Response(503, "Service Unavailable", {});
+        }
+        return TestServer::Ok("OK");
+    }};
+
+    auto properties = ClientProperties();
+    RetryPolicy::Config config;
+    config.baseDelayMs = 1;
+    properties.retryPolicy = RetryPolicy::Create(config);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto request = Request::Create(server.GetUrl(), Request::Type::GET,
+                                       ctx.GetClient(), {}, request_args, request_headers);
+        EXPECT_EQ("OK", request->Execute(ctx)->GetBodyAsString());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(2u, requests.size());
+    ExpectMerged(requests[0], "/?a=1&b=2");
+    ExpectMerged(requests[1], "/?a=1&b=2");
+
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
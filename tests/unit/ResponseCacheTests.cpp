@@ -0,0 +1,594 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/RedirectCache.h"
+#include "restc-cpp/RequestBody.h"
+#include "restc-cpp/ResponseCache.h"
+
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "../src/BufferedReplyImpl.h"
+#include "../src/CachePolicy.h"
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+const auto no_request_headers = [](const std::string&) -> const std::string * {
+    return nullptr;
+};
+
+ResponseCache::entry_t MakeEntry(const std::string& body) {
+    auto entry = make_shared<CachedResponse>();
+    auto data = make_shared<std::string>(body);
+    entry->response.status_code = 200;
+    entry->body = *data;
+    entry->bodyOwner = std::move(data);
+    entry->responseTime = CachedResponse::clock_t::now();
+    entry->freshnessLifetime = std::chrono::seconds{60};
+    return entry;
+}
+
+Reply::HttpResponse Ok() {
+    Reply::HttpResponse response;
+    response.status_code = 200;
+    response.reason_phrase = "OK";
+    return response;
+}
+
+} // anonymous namespace
+
+TEST(ResponseCache, StoreAndLookup) {
+    auto cache = ResponseCache::CreateMemoryCache(1024 * 64);
+
+    EXPECT_FALSE(cache->Lookup("http://localhost/a"));
+
+    cache->Store("http://localhost/a", MakeEntry("Hello"));
+    auto entry = cache->Lookup("http://localhost/a");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ("Hello", entry->body);
+    EXPECT_GT(cache->GetSize(), 0);
+
+    cache->Remove("http://localhost/a");
+    EXPECT_FALSE(cache->Lookup("http://localhost/a"));
+    EXPECT_EQ(0, cache->GetSize());
+}
+
+TEST(ResponseCache, EvictsLeastRecentlyUsed) {
+    const std::string body(1000, 'x');
+    const auto entry_size = MakeEntry(body)->GetSize();
+    auto cache = ResponseCache::CreateMemoryCache(entry_size * 3, body.size());
+
+    cache->Store("a", MakeEntry(body));
+    cache->Store("b", MakeEntry(body));
+    cache->Store("c", MakeEntry(body));
+
+    // Touch a, so that b is the oldest
+    EXPECT_TRUE(cache->Lookup("a"));
+
+    cache->Store("d", MakeEntry(body));
+    EXPECT_TRUE(cache->Lookup("a"));
+    EXPECT_FALSE(cache->Lookup("b"));
+    EXPECT_TRUE(cache->Lookup("c"));
+    EXPECT_TRUE(cache->Lookup("d"));
+    EXPECT_LE(cache->GetSize(), entry_size * 3);
+}
+
+TEST(ResponseCache, TooLargeIsNotStored) {
+    auto cache = ResponseCache::CreateMemoryCache(1024 * 64, 10);
+
+    cache->Store("a", MakeEntry("small"));
+    EXPECT_TRUE(cache->Lookup("a"));
+
+    // Replacing with a too large body removes the old one
+    cache->Store("a", MakeEntry("This is too large"));
+    EXPECT_FALSE(cache->Lookup("a"));
+}
+
+class DiskResponseCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    }
+
+    void TearDown() override {
+        boost::filesystem::remove_all(dir_);
+    }
+
+    boost::filesystem::path dir_;
+};
+
+TEST_F(DiskResponseCacheTest, SurvivesRestart) {
+    {
+        auto cache = ResponseCache::CreateDiskCache(dir_, 1024 * 64);
+        auto entry = make_shared<CachedResponse>(*MakeEntry("Hello disk"));
+        entry->headers.emplace("Content-Type", "text/plain");
+        entry->varyHeaders.emplace("Accept-Encoding", "gzip");
+        entry->initialAge = std::chrono::seconds{3};
+        cache->Store("http://localhost/a", entry);
+    }
+
+    auto cache = ResponseCache::CreateDiskCache(dir_, 1024 * 64);
+    EXPECT_GT(cache->GetSize(), 0);
+
+    auto entry = cache->Lookup("http://localhost/a");
+    ASSERT_TRUE(entry);
+    EXPECT_EQ("Hello disk", entry->body);
+    EXPECT_EQ(200, entry->response.status_code);
+    EXPECT_EQ("text/plain", entry->headers.find("Content-Type")->second);
+    EXPECT_EQ("gzip", entry->varyHeaders.find("Accept-Encoding")->second);
+    EXPECT_EQ(3, entry->initialAge.count());
+    EXPECT_EQ(60, entry->freshnessLifetime.count());
+    EXPECT_TRUE(entry->IsFresh());
+
+    // The mapping is shared while the response is in use
+    auto again = cache->Lookup("http://localhost/a");
+    EXPECT_EQ(entry->body.data(), again->body.data());
+
+    EXPECT_FALSE(cache->Lookup("http://localhost/b"));
+}
+
+TEST_F(DiskResponseCacheTest, RemoveAndEvict) {
+    const std::string body(1000, 'x');
+    auto cache = ResponseCache::CreateDiskCache(dir_, 2500, body.size());
+
+    cache->Store("a", MakeEntry(body));
+    cache->Store("b", MakeEntry(body));
+    EXPECT_TRUE(cache->Lookup("a"));
+    cache->Store("c", MakeEntry(body));
+
+    EXPECT_TRUE(cache->Lookup("a"));
+    EXPECT_FALSE(cache->Lookup("b"));
+    EXPECT_TRUE(cache->Lookup("c"));
+
+    cache->Remove("a");
+    EXPECT_FALSE(cache->Lookup("a"));
+
+    cache->Clear();
+    EXPECT_EQ(0, cache->GetSize());
+    EXPECT_TRUE(boost::filesystem::is_empty(dir_));
+}
+
+TEST_F(DiskResponseCacheTest, IgnoresInvalidSegments) {
+    boost::filesystem::create_directories(dir_);
+    {
+        std::ofstream junk{(dir_ / "0000000000000000.rcc").string()};
+        junk << "This is not a cache segment";
+    }
+
+    auto cache = ResponseCache::CreateDiskCache(dir_, 1024 * 64);
+    EXPECT_EQ(0, cache->GetSize());
+    EXPECT_FALSE(boost::filesystem::exists(dir_ / "0000000000000000.rcc"));
+}
+
+TEST_F(DiskResponseCacheTest, RemovesTruncatedSegments) {
+    {
+        auto cache = ResponseCache::CreateDiskCache(dir_, 1024 * 64);
+        cache->Store("a", MakeEntry(std::string(1000, 'x')));
+    }
+
+    // As if the system went down before the segment was written out
+    const auto path = boost::filesystem::directory_iterator(dir_)->path();
+    boost::filesystem::resize_file(path, boost::filesystem::file_size(path) - 10);
+
+    auto cache = ResponseCache::CreateDiskCache(dir_, 1024 * 64);
+    EXPECT_EQ(0, cache->GetSize());
+    EXPECT_FALSE(cache->Lookup("a"));
+    EXPECT_FALSE(boost::filesystem::exists(path));
+}
+
+TEST_F(DiskResponseCacheTest, RemovesCorruptSegments) {
+    {
+        auto cache = ResponseCache::CreateDiskCache(dir_, 1024 * 64);
+        cache->Store("a", MakeEntry(std::string(1000, 'x')));
+    }
+
+    // As if the pages of the body never reached the disk
+    const auto path = boost::filesystem::directory_iterator(dir_)->path();
+    const auto size = boost::filesystem::file_size(path);
+    {
+        std::fstream file{path.string(), ios::in | ios::out | ios::binary};
+        file.seekp(static_cast<std::streamoff>(size - 100));
+        const std::string zeros(100, '\0');
+        file.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+    EXPECT_EQ(size, boost::filesystem::file_size(path));
+
+    auto cache = ResponseCache::CreateDiskCache(dir_, 1024 * 64);
+    EXPECT_EQ(0, cache->GetSize());
+    EXPECT_FALSE(cache->Lookup("a"));
+    EXPECT_FALSE(boost::filesystem::exists(path));
+}
+
+TEST_F(DiskResponseCacheTest, ConcurrentLookupAndStore) {
+    auto cache = ResponseCache::CreateDiskCache(dir_, 1024 * 1024);
+    for(const auto& key : {"a", "b"}) {
+        cache->Store(key, MakeEntry(key));
+    }
+
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 4; ++i) {
+        threads.emplace_back([&cache, i] {
+            const std::string key{(i % 2) ? "a" : "b"};
+            for(int j = 0; j < 200; ++j) {
+                if (auto entry = cache->Lookup(key)) {
+                    EXPECT_EQ(key, entry->body);
+                }
+                if (j % 10 == i) {
+                    cache->Store(key, MakeEntry(key));
+                }
+            }
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ("a", cache->Lookup("a")->body);
+    EXPECT_EQ("b", cache->Lookup("b")->body);
+}
+
+TEST(RedirectCache, AddLookupAndEvict) {
+    auto cache = RedirectCache::Create(2);
+
+    EXPECT_FALSE(cache->Lookup("GET http://localhost/a"));
+    cache->Add("GET http://localhost/a", "http://localhost/b");
+    EXPECT_EQ("http://localhost/b", *cache->Lookup("GET http://localhost/a"));
+
+    // Only for the same method
+    EXPECT_FALSE(cache->Lookup("POST http://localhost/a"));
+
+    // Redirects to itself are ignored
+    cache->Add("GET http://localhost/c", "http://localhost/c");
+    EXPECT_FALSE(cache->Lookup("GET http://localhost/c"));
+
+    cache->Add("GET http://localhost/a", "http://localhost/d");
+    EXPECT_EQ("http://localhost/d", *cache->Lookup("GET http://localhost/a"));
+
+    // The least recently used is evicted
+    cache->Add("GET http://localhost/e", "http://localhost/f");
+    EXPECT_TRUE(cache->Lookup("GET http://localhost/a"));
+    cache->Add("GET http://localhost/g", "http://localhost/h");
+    EXPECT_EQ(2, cache->GetSize());
+    EXPECT_TRUE(cache->Lookup("GET http://localhost/a"));
+    EXPECT_FALSE(cache->Lookup("GET http://localhost/e"));
+
+    cache->Remove("GET http://localhost/g");
+    EXPECT_FALSE(cache->Lookup("GET http://localhost/g"));
+
+    cache->Clear();
+    EXPECT_EQ(0, cache->GetSize());
+
+    auto disabled = RedirectCache::Create(0);
+    disabled->Add("GET http://localhost/a", "http://localhost/b");
+    EXPECT_FALSE(disabled->Lookup("GET http://localhost/a"));
+}
+
+TEST(RedirectCache, Expires) {
+    auto cache = RedirectCache::Create(2, std::chrono::seconds{0});
+    cache->Add("GET http://localhost/a", "http://localhost/b");
+    EXPECT_FALSE(cache->Lookup("GET http://localhost/a"));
+    EXPECT_EQ(0, cache->GetSize());
+}
+
+TEST(CachePolicy, ParseCacheControl) {
+    headers_t headers{{"Cache-Control", "public, max-age=120"},
+                      {"Cache-Control", "no-cache"}};
+    auto cc = CacheControl::Parse(headers);
+    EXPECT_FALSE(cc.noStore);
+    EXPECT_TRUE(cc.noCache);
+    ASSERT_TRUE(cc.maxAge);
+    EXPECT_EQ(120, cc.maxAge->count());
+
+    cc = CacheControl::Parse(headers_t{{"Cache-Control", "No-Store, max-age=\"10\""}});
+    EXPECT_TRUE(cc.noStore);
+    ASSERT_TRUE(cc.maxAge);
+    EXPECT_EQ(10, cc.maxAge->count());
+
+    cc = CacheControl::Parse(headers_t{{"Cache-Control", "max-age=bad"}});
+    ASSERT_TRUE(cc.maxAge);
+    EXPECT_EQ(0, cc.maxAge->count());
+
+    cc = CacheControl::Parse(headers_t{{"Pragma", "no-cache"}});
+    EXPECT_TRUE(cc.noCache);
+    EXPECT_FALSE(cc.isPublic);
+
+    cc = CacheControl::Parse(headers_t{{"Cache-Control", "Public, must-revalidate, s-maxage=30"}});
+    EXPECT_TRUE(cc.isPublic);
+    EXPECT_TRUE(cc.mustRevalidate);
+    ASSERT_TRUE(cc.sMaxAge);
+    EXPECT_EQ(30, cc.sMaxAge->count());
+}
+
+TEST(CachePolicy, ParseHttpDate) {
+    auto date = ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT");
+    ASSERT_TRUE(date);
+    EXPECT_EQ(784111777, CachedResponse::clock_t::to_time_t(*date));
+
+    EXPECT_FALSE(ParseHttpDate("0"));
+    EXPECT_FALSE(ParseHttpDate("Sun, 06 Foo 1994 08:49:37 GMT"));
+}
+
+TEST(CachePolicy, MaxAgeFreshness) {
+    headers_t headers{{"Cache-Control", "max-age=60"}, {"Age", "10"}};
+    const auto now = CachedResponse::clock_t::now();
+
+    auto entry = CreateCacheEntry(Ok(), headers, no_request_headers, now);
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(60, entry->freshnessLifetime.count());
+    EXPECT_EQ(10, entry->initialAge.count());
+    EXPECT_TRUE(entry->IsFresh(now + std::chrono::seconds{49}));
+    EXPECT_FALSE(entry->IsFresh(now + std::chrono::seconds{50}));
+}
+
+TEST(CachePolicy, ExpiresFreshness) {
+    headers_t headers{{"Date", "Sun, 06 Nov 1994 08:49:37 GMT"},
+                      {"Expires", "Sun, 06 Nov 1994 08:59:37 GMT"}};
+
+    auto entry = CreateCacheEntry(Ok(), headers, no_request_headers,
+                                  *ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"));
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(600, entry->freshnessLifetime.count());
+}
+
+TEST(CachePolicy, HeuristicFreshness) {
+    headers_t headers{{"Date", "Sun, 06 Nov 1994 08:49:37 GMT"},
+                      {"Last-Modified", "Sun, 06 Nov 1994 07:49:37 GMT"}};
+
+    auto entry = CreateCacheEntry(Ok(), headers, no_request_headers,
+                                  *ParseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT"));
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(360, entry->freshnessLifetime.count());
+}
+
+TEST(CachePolicy, NotStorable) {
+    EXPECT_FALSE(CreateCacheEntry(Ok(), headers_t{}, no_request_headers));
+    EXPECT_FALSE(CreateCacheEntry(Ok(), headers_t{{"Cache-Control", "no-store, max-age=60"}},
+                                  no_request_headers));
+    EXPECT_FALSE(CreateCacheEntry(Ok(), headers_t{{"Cache-Control", "max-age=60"},
+                                                  {"Vary", "*"}},
+                                  no_request_headers));
+
+    auto response = Ok();
+    response.status_code = 206;
+    EXPECT_FALSE(CreateCacheEntry(response, headers_t{{"Cache-Control", "max-age=60"}},
+                                  no_request_headers));
+
+    // no-cache can be stored, but must be revalidated
+    auto entry = CreateCacheEntry(Ok(), headers_t{{"Cache-Control", "no-cache"},
+                                                  {"ETag", "\"1\""}},
+                                  no_request_headers);
+    ASSERT_TRUE(entry);
+    EXPECT_FALSE(entry->IsFresh());
+}
+
+TEST(CachePolicy, Credentials) {
+    const std::string token{"Bearer 1"};
+    const auto authorized = [&token](const std::string& name) -> const std::string * {
+        return (name == "Authorization") ? &token : nullptr;
+    };
+    const auto with_cookie = [&token](const std::string& name) -> const std::string * {
+        return (name == "Cookie") ? &token : nullptr;
+    };
+
+    const headers_t private_headers{{"Cache-Control", "max-age=60"}};
+    EXPECT_FALSE(CreateCacheEntry(Ok(), private_headers, authorized));
+    EXPECT_FALSE(CreateCacheEntry(Ok(), private_headers, with_cookie));
+    EXPECT_TRUE(CreateCacheEntry(Ok(), private_headers, no_request_headers));
+
+    // The server says that the response can be shared
+    for(const auto *cc : {"public, max-age=60", "s-maxage=60, max-age=60", "max-age=60, must-revalidate"}) {
+        EXPECT_TRUE(CreateCacheEntry(Ok(), headers_t{{"Cache-Control", cc}}, authorized)) << cc;
+    }
+}
+
+TEST(CachePolicy, Vary) {
+    const std::string gzip{"gzip"};
+    const auto gzip_request = [&gzip](const std::string& name) -> const std::string * {
+        return (name == "Accept-Encoding") ? &gzip : nullptr;
+    };
+
+    auto entry = CreateCacheEntry(Ok(), headers_t{{"Cache-Control", "max-age=60"},
+                                                  {"Vary", "Accept-Encoding, X-Foo"}},
+                                  gzip_request);
+    ASSERT_TRUE(entry);
+    EXPECT_TRUE(VaryMatches(*entry, gzip_request));
+    EXPECT_FALSE(VaryMatches(*entry, no_request_headers));
+}
+
+TEST(CachePolicy, UpdateFromNotModified) {
+    const auto then = CachedResponse::clock_t::now() - std::chrono::seconds{600};
+    auto entry = CreateCacheEntry(Ok(), headers_t{{"Cache-Control", "max-age=60"},
+                                                  {"ETag", "\"1\""}},
+                                  no_request_headers, then);
+    ASSERT_TRUE(entry);
+    SetStoredBody(*entry, make_shared<std::string>("Hello"));
+    EXPECT_FALSE(entry->IsFresh());
+
+    UpdateCacheEntry(*entry, headers_t{{"Cache-Control", "max-age=120"},
+                                       {"ETag", "\"2\""},
+                                       {"Content-Length", "0"}});
+    EXPECT_TRUE(entry->IsFresh());
+    EXPECT_EQ(120, entry->freshnessLifetime.count());
+    EXPECT_EQ("\"2\"", entry->headers.find("ETag")->second);
+    EXPECT_EQ("5", entry->headers.find("Content-Length")->second);
+}
+
+TEST(CachePolicy, StoresTheDecodedBody) {
+    auto entry = CreateCacheEntry(Ok(), headers_t{{"Cache-Control", "max-age=60"},
+                                                  {"Content-Encoding", "gzip"},
+                                                  {"Content-Length", "25"},
+                                                  {"Content-Type", "text/plain"}},
+                                  no_request_headers);
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(0u, entry->headers.count("Content-Encoding"));
+    EXPECT_EQ(0u, entry->headers.count("Content-Length"));
+    EXPECT_EQ("text/plain", entry->headers.find("Content-Type")->second);
+
+    // The length of what we read, not what was sent
+    SetStoredBody(*entry, make_shared<std::string>("Hello world"));
+    EXPECT_EQ("11", entry->headers.find("Content-Length")->second);
+    EXPECT_EQ("Hello world", entry->body);
+
+    // Only the first part of the body
+    SetStoredBody(*entry, make_shared<std::string>("Hello"), false);
+    EXPECT_EQ(0u, entry->headers.count("Content-Length"));
+}
+
+TEST(BufferedReply, ServesStoredResponse) {
+    auto stored = make_shared<CachedResponse>(*MakeEntry("Hello"));
+    stored->headers.emplace("Content-Type", "text/plain");
+    stored->initialAge = std::chrono::seconds{5};
+
+    BufferedReplyImpl reply{stored};
+    EXPECT_EQ(200, reply.GetResponseCode());
+    EXPECT_EQ("text/plain", *reply.GetHeader("content-type"));
+    EXPECT_EQ("5", *reply.GetHeader("Age"));
+    EXPECT_TRUE(reply.MoreDataToRead());
+    EXPECT_EQ("Hello", reply.GetBodyAsString());
+    EXPECT_FALSE(reply.MoreDataToRead());
+}
+
+TEST(CachedRequest, FreshHitIsNotSent) {
+    TestServer server{[](const TestServer::Request&) {
+        return TestServer::Ok("cached", "Cache-Control: max-age=60\r\n");
+    }};
+    Request::Properties properties;
+    properties.responseCache = ResponseCache::CreateMemoryCache(1024 * 1024);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("cached", ctx.Get(server.GetUrl())->GetBodyAsString());
+        auto reply = ctx.Get(server.GetUrl());
+        EXPECT_EQ(200, reply->GetResponseCode());
+        EXPECT_EQ("cached", reply->GetBodyAsString());
+    }).get();
+
+    EXPECT_EQ(1u, server.GetRequests().size());
+    rest_client->CloseWhenReady();
+}
+
+TEST(CachedRequest, StaleIsRevalidated) {
+    TestServer server{[](const TestServer::Request& request) {
+        if (request.GetHeader("If-None-Match") == "\"v1\"") {
+            return TestServer::Response(304, "Not Modified", {}, "ETag: \"v1\"\r\n");
+        }
+        return TestServer::Ok("stored", "Cache-Control: no-cache\r\nETag: \"v1\"\r\n");
+    }};
+    Request::Properties properties;
+    properties.responseCache = ResponseCache::CreateMemoryCache(1024 * 1024);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("stored", ctx.Get(server.GetUrl())->GetBodyAsString());
+        auto reply = ctx.Get(server.GetUrl());
+        EXPECT_EQ(200, reply->GetResponseCode());
+        EXPECT_EQ("stored", reply->GetBodyAsString());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(2u, requests.size());
+    EXPECT_EQ(0u, requests[0].CountHeader("If-None-Match"));
+    EXPECT_EQ("\"v1\"", requests[1].GetHeader("If-None-Match"));
+    rest_client->CloseWhenReady();
+}
+
+TEST(CachedRequest, VaryMismatchIsSent) {
+    TestServer server{[](const TestServer::Request& request) {
+        return TestServer::Ok(request.GetHeader("X-Lang"),
+                              "Cache-Control: max-age=60\r\nVary: X-Lang\r\n");
+    }};
+    Request::Properties properties;
+    properties.responseCache = ResponseCache::CreateMemoryCache(1024 * 1024);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto get = [&](const std::string& lang) {
+            auto request = Request::Create(server.GetUrl(), Request::Type::GET, ctx.GetClient(),
+                                           {}, {}, Request::headers_t{{"X-Lang", lang}});
+            return request->Execute(ctx)->GetBodyAsString();
+        };
+
+        EXPECT_EQ("en", get("en"));
+        EXPECT_EQ("en", get("en"));
+        EXPECT_EQ("nb", get("nb"));
+    }).get();
+
+    EXPECT_EQ(2u, server.GetRequests().size());
+    rest_client->CloseWhenReady();
+}
+
+TEST(CachedRequest, PostInvalidates) {
+    TestServer server{[](const TestServer::Request& request) {
+        return TestServer::Ok(request.method, "Cache-Control: max-age=60\r\n");
+    }};
+    Request::Properties properties;
+    properties.responseCache = ResponseCache::CreateMemoryCache(1024 * 1024);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_EQ("GET", ctx.Get(server.GetUrl())->GetBodyAsString());
+        EXPECT_EQ("GET", ctx.Get(server.GetUrl())->GetBodyAsString());
+        EXPECT_EQ("POST", ctx.Post(server.GetUrl(), "{}")->GetBodyAsString());
+        EXPECT_EQ("GET", ctx.Get(server.GetUrl())->GetBodyAsString());
+    }).get();
+
+    const auto requests = server.GetRequests();
+    ASSERT_EQ(3u, requests.size());
+    EXPECT_EQ("GET", requests[0].method);
+    EXPECT_EQ("POST", requests[1].method);
+    EXPECT_EQ("GET", requests[2].method);
+    rest_client->CloseWhenReady();
+}
+
+TEST(CachedRequest, CredentialsDontShareEntries) {
+    TestServer server{[](const TestServer::Request& request) {
+        const auto cc = (request.target == "/public")
+            ? "Cache-Control: public, max-age=60\r\n" : "Cache-Control: max-age=60\r\n";
+        return TestServer::Ok(request.GetHeader("Authorization"), cc);
+    }};
+    Request::Properties properties;
+    properties.responseCache = ResponseCache::CreateMemoryCache(1024 * 1024);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        const auto get = [&](const std::string& path, const std::string& user) {
+            auto request = Request::Create(server.GetUrl(path), Request::Type::GET,
+                                           ctx.GetClient(), {}, {},
+                                           Request::headers_t{{"Authorization", user}});
+            return request->Execute(ctx)->GetBodyAsString();
+        };
+
+        EXPECT_EQ("alice", get("/", "alice"));
+        EXPECT_EQ("bob", get("/", "bob"));
+        EXPECT_EQ("alice", get("/", "alice"));
+
+        // The server says that it can be shared
+        EXPECT_EQ("alice", get("/public", "alice"));
+        EXPECT_EQ("alice", get("/public", "bob"));
+    }).get();
+
+    EXPECT_EQ(4u, server.GetRequests().size());
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("debug");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
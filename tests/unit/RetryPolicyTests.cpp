@@ -0,0 +1,210 @@
+
+// Include before boost::log headers
+#include "restc-cpp/logging.h"
+
+#include "restc-cpp/restc-cpp.h"
+#include "restc-cpp/error.h"
+#include "restc-cpp/RequestBody.h"
+
+#include "../src/RetryPolicyImpl.h"
+#include "TestServer.h"
+
+#include "gtest/gtest.h"
+#include "restc-cpp/test_helper.h"
+
+using namespace std;
+using namespace restc_cpp;
+
+using namespace std::literals::chrono_literals;
+
+namespace restc_cpp::unittests {
+
+namespace {
+
+const auto unavailable = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n"s;
+
+RetryPolicy::Config FastConfig() {
+    RetryPolicy::Config config;
+    config.baseDelayMs = 1;
+    config.maxDelayMs = 10;
+    return config;
+}
+
+boost::system::error_code HttpError(int code) {
+    return make_http_error_code(code);
+}
+
+} // anonymous namespace
+
+TEST(RetryPolicy, WhatIsRetried) {
+    RetryPolicyImpl policy{FastConfig()};
+
+    // Not sent, so safe for all requests
+    EXPECT_TRUE(policy.GetRetryDelay(0, false, Error::FAILED_TO_CONNECT, {}));
+
+    EXPECT_TRUE(policy.GetRetryDelay(0, true, HttpError(503), {}));
+    EXPECT_TRUE(policy.GetRetryDelay(0, true, HttpError(502), {}));
+    EXPECT_FALSE(policy.GetRetryDelay(0, false, HttpError(503), {}));
+    EXPECT_FALSE(policy.GetRetryDelay(0, true, HttpError(500), {}));
+    EXPECT_FALSE(policy.GetRetryDelay(0, true, HttpError(404), {}));
+
+    EXPECT_FALSE(policy.GetRetryDelay(0, true, HttpError(429), {}));
+    EXPECT_TRUE(policy.GetRetryDelay(0, true, HttpError(429), "0"s));
+
+    EXPECT_TRUE(policy.GetRetryDelay(0, true, boost::asio::error::connection_reset, {}));
+    EXPECT_FALSE(policy.GetRetryDelay(0, false, boost::asio::error::connection_reset, {}));
+    EXPECT_FALSE(policy.GetRetryDelay(0, true, Error::TIME_OUT, {}));
+
+    EXPECT_FALSE(policy.GetRetryDelay(3, false, Error::FAILED_TO_CONNECT, {}));
+}
+
+TEST(RetryPolicy, Backoff) {
+    auto config = FastConfig();
+    config.baseDelayMs = 10;
+    config.maxDelayMs = 50;
+    config.budgetMinRetriesPerSecond = 1000;
+    RetryPolicyImpl policy{config};
+
+    for(int i = 0; i < 50; ++i) {
+        EXPECT_LE(*policy.GetRetryDelay(0, true, HttpError(503), {}), 10ms);
+        EXPECT_LE(*policy.GetRetryDelay(1, true, HttpError(503), {}), 20ms);
+        EXPECT_LE(*policy.GetRetryDelay(2, true, HttpError(503), {}), 40ms);
+    }
+
+    config.maxRetries = 100;
+    RetryPolicyImpl capped{config};
+    EXPECT_LE(*capped.GetRetryDelay(80, true, HttpError(503), {}), 50ms);
+}
+
+TEST(RetryPolicy, RetryAfter) {
+    RetryPolicyImpl policy{FastConfig()};
+
+    EXPECT_EQ(2000ms, *policy.GetRetryDelay(0, true, HttpError(429), "2"s));
+    EXPECT_GE(*policy.GetRetryDelay(0, true, HttpError(503), "1"s), 1000ms);
+    // Longer than maxRetryAfterMs
+    EXPECT_FALSE(policy.GetRetryDelay(0, true, HttpError(429), "3600"s));
+
+    EXPECT_EQ(5000ms, *RetryPolicyImpl::ParseRetryAfter("5"));
+    EXPECT_EQ(0ms, *RetryPolicyImpl::ParseRetryAfter("Sun, 06 Nov 1994 08:49:37 GMT"));
+    EXPECT_FALSE(RetryPolicyImpl::ParseRetryAfter("soon"));
+}
+
+TEST(RetryPolicy, Budget) {
+    auto config = FastConfig();
+    config.budgetMinRetriesPerSecond = 0;
+    config.budgetRatio = 0.1;
+    RetryPolicyImpl policy{config};
+
+    for(int i = 0; i < 100; ++i) {
+        policy.OnRequest();
+    }
+
+    int retries = 0;
+    for(int i = 0; i < 100; ++i) {
+        if (policy.GetRetryDelay(0, true, HttpError(503), {})) {
+            ++retries;
+        }
+    }
+    EXPECT_EQ(10, retries);
+
+    const auto stats = policy.GetStats();
+    EXPECT_EQ(100u, stats.requests);
+    EXPECT_EQ(10u, stats.retries);
+    EXPECT_EQ(90u, stats.budgetExhausted);
+}
+
+TEST(RetryPolicy, RetriesUntilSuccess) {
+    TestServer server{TestServer::Script({unavailable, unavailable})};
+
+    Request::Properties properties;
+    properties.retryPolicy = RetryPolicy::Create(FastConfig());
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto reply = ctx.Get(server.GetUrl());
+        EXPECT_EQ(200, reply->GetResponseCode());
+        EXPECT_EQ("OK", reply->GetBodyAsString());
+    }).get();
+
+    EXPECT_EQ(3u, server.GetRequests().size());
+    EXPECT_EQ(2u, properties.retryPolicy->GetStats().retries);
+    rest_client->CloseWhenReady();
+}
+
+TEST(RetryPolicy, FollowsRedirects) {
+    TestServer server{TestServer::Script({"HTTP/1.1 302 Found\r\nLocation: /new\r\n"
+                                         "Content-Length: 0\r\n\r\n"s})};
+
+    Request::Properties properties;
+    properties.retryPolicy = RetryPolicy::Create(FastConfig());
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        auto reply = ctx.Get(server.GetUrl());
+        EXPECT_EQ(200, reply->GetResponseCode());
+        EXPECT_EQ("OK", reply->GetBodyAsString());
+    }).get();
+
+    EXPECT_EQ(2u, server.GetRequests().size());
+    EXPECT_EQ(0u, properties.retryPolicy->GetStats().retries);
+    rest_client->CloseWhenReady();
+}
+
+TEST(RetryPolicy, GivesUpWithTheLastError) {
+    TestServer server{TestServer::Script({unavailable, unavailable, unavailable, unavailable})};
+
+    auto config = FastConfig();
+    config.maxRetries = 2;
+    Request::Properties properties;
+    properties.retryPolicy = RetryPolicy::Create(config);
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        EXPECT_THROW(ctx.Get(server.GetUrl()), RequestFailedWithErrorException);
+    }).get();
+    EXPECT_EQ(3u, server.GetRequests().size());
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        // Not idempotent
+        EXPECT_THROW(ctx.Post(server.GetUrl(), "{}"), RequestFailedWithErrorException);
+    }).get();
+    EXPECT_EQ(4u, server.GetRequests().size());
+
+    rest_client->CloseWhenReady();
+}
+
+TEST(RetryPolicy, ErrorCodes) {
+    TestServer server{TestServer::Script({"HTTP/1.1 429 Too Many Requests\r\nRetry-After: 0\r\n"
+                                         "Content-Length: 0\r\n\r\n"s})};
+
+    Request::Properties properties;
+    properties.retryPolicy = RetryPolicy::Create(FastConfig());
+    auto rest_client = RestClient::Create(properties);
+
+    rest_client->ProcessWithPromise([&](Context& ctx) {
+        boost::system::error_code ec;
+        auto request = Request::Create(server.GetUrl(), Request::Type::GET, ctx.GetClient());
+        auto reply = request->Execute(ctx, ec);
+        EXPECT_FALSE(ec);
+        ASSERT_TRUE(reply);
+        EXPECT_EQ(200, reply->GetResponseCode());
+
+        request = Request::Create("http://127.0.0.1:1/", Request::Type::GET, ctx.GetClient());
+        EXPECT_FALSE(request->Execute(ctx, ec));
+        EXPECT_EQ(Error::FAILED_TO_CONNECT, ec);
+    }).get();
+
+    EXPECT_EQ(2u, server.GetRequests().size());
+    // One for the 429, and three to connect
+    EXPECT_EQ(4u, properties.retryPolicy->GetStats().retries);
+    rest_client->CloseWhenReady();
+}
+
+} // namespace
+
+int main( int argc, char * argv[] )
+{
+    RESTC_CPP_TEST_LOGGING_SETUP("info");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();;
+}
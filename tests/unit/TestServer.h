@@ -0,0 +1,271 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+namespace restc_cpp::unittests {
+
+/*! A minimal HTTP/1.1 server for the unit tests
+ *
+ * It serves each connection in a thread of its own, and reads the
+ * requests on it one by one (so pipelined requests are answered in
+ * order). The handler returns the raw response for each request. An
+ * empty response closes the connection without responding. The
+ * connection is also closed after a response with "Connection: close".
+ *
+ * All the requests are recorded.
+ *
+ * A connection handler can be given instead, to script the server
+ * side of a connection with another protocol, like HTTP/2.
+ */
+class TestServer {
+public:
+    struct Request {
+        std::string method;
+        std::string target;
+        std::string head; // The request line and the headers
+        std::string body; // Decoded, if it was chunked
+        int connection = 0; // 0 for the first connection
+        int index = 0; // 0 for the first request on the connection
+
+        bool HasHeader(const std::string& line) const {
+            return head.find("\r\n" + line + "\r\n") != std::string::npos;
+        }
+
+        /*! The number of headers with the name */
+        size_t CountHeader(const std::string& name) const {
+            size_t count = 0;
+            for(size_t pos = 0; (pos = FindHeader(name, pos)) != std::string::npos; ++pos) {
+                ++count;
+            }
+            return count;
+        }
+
+        /*! The value of a header, or an empty string */
+        std::string GetHeader(const std::string& name) const {
+            const auto pos = FindHeader(name, 0);
+            if (pos == std::string::npos) {
+                return {};
+            }
+            const auto start = pos + name.size() + 4;
+            return head.substr(start, head.find("\r\n", start) - start);
+        }
+
+    private:
+        size_t FindHeader(const std::string& name, size_t from) const {
+            return boost::algorithm::to_lower_copy(head).find(
+                "\r\n" + boost::algorithm::to_lower_copy(name) + ": ", from);
+        }
+    };
+
+    using handler_t = std::function<std::string (const Request& request)>;
+
+    /*! Serves a connection. The connection is closed when it returns. */
+    using connection_handler_t = std::function<void (boost::asio::ip::tcp::socket& socket,
+                                                     int connection)>;
+
+    explicit TestServer(handler_t handler = {})
+    : acceptor_{io_service_, boost::asio::ip::tcp::endpoint{
+        boost::asio::ip::address_v4::loopback(), 0}}
+    , handler_{std::move(handler)}
+    {
+        if (!handler_) {
+            handler_ = [](const Request&) { return Ok("OK"); };
+        }
+        Start();
+    }
+
+    explicit TestServer(connection_handler_t handler)
+    : acceptor_{io_service_, boost::asio::ip::tcp::endpoint{
+        boost::asio::ip::address_v4::loopback(), 0}}
+    , connection_handler_{std::move(handler)}
+    {
+        Start();
+    }
+
+    ~TestServer() {
+        done_ = true;
+        boost::system::error_code ec;
+        boost::asio::ip::tcp::socket wake{io_service_};
+        wake.connect(acceptor_.local_endpoint(), ec);
+        thread_.join();
+        for(auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    std::string GetUrl(const std::string& path = "/") const {
+        return "http://127.0.0.1:" + std::to_string(acceptor_.local_endpoint().port()) + path;
+    }
+
+    std::vector<Request> GetRequests() const {
+        std::lock_guard<std::mutex> const lock{mutex_};
+        return requests_;
+    }
+
+    /*! A 200 OK response */
+    static std::string Ok(const std::string& body, const std::string& headers = {}) {
+        return Response(200, "OK", body, headers);
+    }
+
+    static std::string Response(int code, const std::string& reason,
+                                const std::string& body, const std::string& headers = {}) {
+        return "HTTP/1.1 " + std::to_string(code) + " " + reason + "\r\n"
+            + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            + headers + "\r\n" + body;
+    }
+
+    /*! A handler that sends the responses in order, one per request, and then `then` */
+    static handler_t Script(std::vector<std::string> responses, std::string then = Ok("OK")) {
+        auto next = std::make_shared<std::atomic_size_t>(0);
+        return [responses = std::move(responses), then = std::move(then), next](const Request&) {
+            const size_t index = (*next)++;
+            return (index < responses.size()) ? responses[index] : then;
+        };
+    }
+
+    /*! A handler that waits for delay(request) before it calls handler */
+    static handler_t Delay(std::function<std::chrono::milliseconds (const Request& request)> delay,
+                           handler_t handler) {
+        return [delay = std::move(delay), handler = std::move(handler)](const Request& request) {
+            std::this_thread::sleep_for(delay(request));
+            return handler(request);
+        };
+    }
+
+    /*! The number of connections accepted */
+    int GetConnections() const {
+        return connections_;
+    }
+
+private:
+    void Start() {
+        thread_ = std::thread{[this] {
+            for(int connection = 0;; ++connection) {
+                auto socket = std::make_shared<boost::asio::ip::tcp::socket>(io_service_);
+                boost::system::error_code ec;
+                acceptor_.accept(*socket, ec);
+                if (ec || done_) {
+                    return;
+                }
+                ++connections_;
+                std::lock_guard<std::mutex> const lock{mutex_};
+                workers_.emplace_back([this, socket, connection] {
+                    if (connection_handler_) {
+                        connection_handler_(*socket, connection);
+                    } else {
+                        Serve(*socket, connection);
+                    }
+                });
+            }
+        }};
+    }
+
+    void Serve(boost::asio::ip::tcp::socket& socket, int connection) {
+        boost::asio::streambuf buffer;
+        for(int index = 0;; ++index) {
+            Request request;
+            request.connection = connection;
+            request.index = index;
+            if (!ReadRequest(socket, buffer, request)) {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> const lock{mutex_};
+                requests_.push_back(request);
+            }
+
+            const auto response = handler_(request);
+            if (response.empty()) {
+                return;
+            }
+
+            boost::system::error_code ec;
+            boost::asio::write(socket, boost::asio::buffer(response), ec);
+            if (ec || boost::algorithm::to_lower_copy(
+                    response.substr(0, response.find("\r\n\r\n")))
+                        .find("\r\nconnection: close") != std::string::npos) {
+                return;
+            }
+        }
+    }
+
+    static bool ReadRequest(boost::asio::ip::tcp::socket& socket,
+                            boost::asio::streambuf& buffer, Request& request) {
+        boost::system::error_code ec;
+        const auto head_len = boost::asio::read_until(socket, buffer, "\r\n\r\n", ec);
+        if (ec) {
+            return false;
+        }
+
+        request.head.assign(boost::asio::buffers_begin(buffer.data()),
+                            boost::asio::buffers_begin(buffer.data()) + head_len);
+        buffer.consume(head_len);
+
+        const auto sp = request.head.find(' ');
+        request.method = request.head.substr(0, sp);
+        request.target = request.head.substr(sp + 1, request.head.find(' ', sp + 1) - sp - 1);
+
+        if (const auto len = request.GetHeader("Content-Length"); !len.empty()) {
+            request.body = Read(socket, buffer, std::stoul(len));
+        } else if (boost::algorithm::iequals(request.GetHeader("Transfer-Encoding"), "chunked")) {
+            while(true) {
+                const auto line_len = boost::asio::read_until(socket, buffer, "\r\n", ec);
+                if (ec) {
+                    return false;
+                }
+                const std::string line(boost::asio::buffers_begin(buffer.data()),
+                                       boost::asio::buffers_begin(buffer.data()) + line_len);
+                buffer.consume(line_len);
+                const auto chunk_len = std::stoul(line, nullptr, 16);
+                request.body += Read(socket, buffer, chunk_len);
+                Read(socket, buffer, 2); // CRLF
+                if (chunk_len == 0) {
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    static std::string Read(boost::asio::ip::tcp::socket& socket,
+                            boost::asio::streambuf& buffer, size_t len) {
+        if (buffer.size() < len) {
+            boost::system::error_code ec;
+            boost::asio::read(socket, buffer,
+                              boost::asio::transfer_exactly(len - buffer.size()), ec);
+        }
+        len = std::min(len, buffer.size());
+        std::string data(boost::asio::buffers_begin(buffer.data()),
+                         boost::asio::buffers_begin(buffer.data()) + len);
+        buffer.consume(len);
+        return data;
+    }
+
+    boost::asio::io_service io_service_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+    handler_t handler_;
+    connection_handler_t connection_handler_;
+    std::thread thread_;
+    std::vector<std::thread> workers_;
+    std::vector<Request> requests_;
+    std::atomic_int connections_{0};
+    std::atomic_bool done_{false};
+    mutable std::mutex mutex_;
+};
+
+} // namespace
@@ -6,6 +6,8 @@
 
 #include "restc-cpp/restc-cpp.h"
 #include "restc-cpp/Url.h"
+#include "restc-cpp/url_encode.h"
+#include "restc-cpp/error.h"
 
 #include "gtest/gtest.h"
 #include "restc-cpp/test_helper.h"
@@ -228,6 +230,71 @@ TEST(Url, HttpsWithArgsOnly)
     EXPECT_EQ(args.size(), url.GetArgs().size());
 }
 
+TEST(UrlEncode, Normal)
+{
+    EXPECT_EQ("abcXYZ019-_.!~*'()/"s, url_encode("abcXYZ019-_.!~*'()/"));
+    EXPECT_EQ(""s, url_encode(""));
+}
+
+TEST(UrlEncode, Escaped)
+{
+    EXPECT_EQ("a%20b%26c%3Dd%3F"s, url_encode("a b&c=d?"));
+    EXPECT_EQ("%C3%A6%C3%B8%C3%A5"s, url_encode("\xC3\xA6\xC3\xB8\xC3\xA5"));
+    EXPECT_EQ("%00%FF"s, url_encode(boost::string_ref("\x00\xFF", 2)));
+}
+
+TEST(UrlEncode, LongInput)
+{
+    // Exercise the 16 byte blocks, with escapes at all positions
+    const std::string normal = "abcdefghijklmnopqrstuvwxyz0123456789";
+    for(size_t i = 0; i < normal.size(); ++i) {
+        auto src = normal;
+        src[i] = ' ';
+        auto expected = normal.substr(0, i) + "%20" + normal.substr(i + 1);
+        EXPECT_EQ(expected, url_encode(src));
+    }
+
+    // All byte values
+    std::string all;
+    for(int ch = 0; ch < 256; ++ch) {
+        all += static_cast<char>(ch);
+    }
+    EXPECT_EQ(all, url_decode(url_encode(all)));
+}
+
+TEST(Url, Reassign)
+{
+    Url url("https://github.com:8080/jgaa/restc-cpp?a=b");
+    url = "http://example.com";
+    EXPECT_EQ("example.com"s, url.GetHost());
+    EXPECT_EQ("80"s, url.GetPort());
+    EXPECT_EQ("/"s, url.GetPath());
+    EXPECT_EQ(""s, url.GetArgs());
+}
+
+TEST(UrlEncode, Append)
+{
+    std::string dst = "/path?";
+    url_encode("a b", dst);
+    dst += '=';
+    url_encode("c", dst);
+    EXPECT_EQ("/path?a%20b=c"s, dst);
+}
+
+TEST(UrlDecode, Simple)
+{
+    EXPECT_EQ("a b&c=d?"s, url_decode("a%20b%26c%3dd%3F"));
+    EXPECT_EQ("no escapes"s, url_decode("no escapes"));
+    EXPECT_EQ("a+b"s, url_decode("a+b"));
+}
+
+TEST(UrlDecode, Invalid)
+{
+    EXPECT_THROW(url_decode("abc%"), ParseException);
+    EXPECT_THROW(url_decode("abc%2"), ParseException);
+    EXPECT_THROW(url_decode("abc%zz"), ParseException);
+}
+
 int main( int argc, char * argv[] )
 {
     RESTC_CPP_TEST_LOGGING_SETUP("debug");